@@ -0,0 +1,99 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#include "estc_aggregate.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "app_error.h"
+#include "app_util.h"
+
+void estc_aggregate_init(estc_aggregate_t *aggregate, estc_aggregate_init_t const *init)
+{
+    ASSERT(NULL != aggregate)
+    ASSERT(NULL != init)
+    ASSERT(init->deadband >= 0.0f)
+
+    memset(aggregate, 0, sizeof(*aggregate));
+    aggregate->config        = *init;
+    aggregate->config.window = MAX(init->window, 1);
+}
+
+bool estc_aggregate_add(estc_aggregate_t *aggregate, float value, estc_aggregate_result_t *result)
+{
+    ASSERT(NULL != aggregate)
+    ASSERT(NULL != result)
+
+    if (0 == aggregate->count)
+    {
+        aggregate->min = value;
+        aggregate->max = value;
+        aggregate->sum = 0.0f;
+    }
+    else
+    {
+        aggregate->min = fminf(aggregate->min, value);
+        aggregate->max = fmaxf(aggregate->max, value);
+    }
+    aggregate->sum += value;
+    aggregate->count++;
+
+    if (aggregate->count < aggregate->config.window)
+    {
+        return false;
+    }
+
+    result->min  = aggregate->min;
+    result->max  = aggregate->max;
+    result->mean = aggregate->sum / (float)aggregate->count;
+    result->last = value;
+
+    aggregate->count = 0;
+    aggregate->windows++;
+
+    if (aggregate->has_reported && fabsf(result->mean - aggregate->reported) < aggregate->config.deadband)
+    {
+        aggregate->suppressed++;
+        return false;
+    }
+
+    aggregate->reported     = result->mean;
+    aggregate->has_reported = true;
+    return true;
+}
+
+void estc_aggregate_reset(estc_aggregate_t *aggregate)
+{
+    ASSERT(NULL != aggregate)
+
+    aggregate->count        = 0;
+    aggregate->has_reported = false;
+}
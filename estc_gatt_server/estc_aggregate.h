@@ -0,0 +1,97 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#ifndef ESTC_AGGREGATE_H__
+#define ESTC_AGGREGATE_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**@brief Summary of one window of samples. */
+typedef struct
+{
+    float min;      /**< Smallest sample of the window. */
+    float max;      /**< Largest sample of the window. */
+    float mean;     /**< Average of the window. */
+    float last;     /**< Newest sample of the window. */
+} estc_aggregate_result_t;
+
+/**@brief Aggregation initialization parameters. */
+typedef struct
+{
+    uint16_t window;    /**< Samples summarized into one result, 0 and 1 pass every sample on. */
+    float    deadband;  /**< Change of the mean needed before another result is reported, 0 reports every window. */
+} estc_aggregate_init_t;
+
+/**@brief Windowed aggregation with a deadband.
+ *
+ * @details Samples are folded into min/max/sum on the FPU as they arrive, so no window buffer is
+ *          kept. A completed window is reported only when its mean moved at least deadband away
+ *          from the last reported mean.
+ */
+typedef struct
+{
+    estc_aggregate_init_t config;       /**< Window length and deadband. */
+    uint16_t              count;        /**< Samples in the current window. */
+    float                 min;          /**< Smallest sample of the current window. */
+    float                 max;          /**< Largest sample of the current window. */
+    float                 sum;          /**< Sum of the current window. */
+    float                 reported;     /**< Mean of the last reported window. */
+    bool                  has_reported; /**< reported is valid. */
+    uint32_t              windows;      /**< Windows completed. */
+    uint32_t              suppressed;   /**< Windows within the deadband, not reported. */
+} estc_aggregate_t;
+
+/**@brief Function for initializing an aggregation stage.
+ *
+ * @param[out] aggregate  Aggregation instance.
+ * @param[in]  init       Initialization parameters.
+ */
+void estc_aggregate_init(estc_aggregate_t *aggregate, estc_aggregate_init_t const *init);
+
+/**@brief Function for adding a sample to the current window.
+ *
+ * @param[in]  aggregate  Aggregation instance.
+ * @param[in]  value      Sample.
+ * @param[out] result     Summary of the window, set when true is returned.
+ *
+ * @return True if the sample completed a window that has to be reported.
+ */
+bool estc_aggregate_add(estc_aggregate_t *aggregate, float value, estc_aggregate_result_t *result);
+
+/**@brief Function for dropping the current window and the deadband reference.
+ *
+ * @details The next completed window is reported regardless of the deadband.
+ *
+ * @param[in] aggregate  Aggregation instance.
+ */
+void estc_aggregate_reset(estc_aggregate_t *aggregate);
+
+#endif /* ESTC_AGGREGATE_H__ */
@@ -0,0 +1,428 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#include "estc_arq.h"
+
+#include <string.h>
+
+#include "app_error.h"
+#include "app_timer.h"
+#include "app_util.h"
+#include "app_util_platform.h"
+#include "nrf_log.h"
+
+#include "ble.h"
+#include "ble_conn_state.h"
+#include "ble_gatts.h"
+
+STATIC_ASSERT(IS_POWER_OF_TWO(ESTC_ARQ_WINDOW_LEN));
+STATIC_ASSERT(ESTC_ARQ_WINDOW_LEN <= 16);
+
+#define ESTC_ARQ_WINDOW_MASK    (ESTC_ARQ_WINDOW_LEN - 1)
+
+APP_TIMER_DEF(m_arq_timer);                     /**< Looks for frames to retransmit while any window is in use. */
+
+static estc_arq_link_t * estc_arq_link_get(estc_arq_t *arq, uint16_t conn_handle)
+{
+    uint16_t index = ble_conn_state_conn_idx(conn_handle);
+    if (index >= ESTC_ARQ_LINK_COUNT)
+    {
+        return NULL;
+    }
+
+    return &arq->links[index];
+}
+
+static void estc_arq_link_reset(estc_arq_link_t *link, uint16_t conn_handle)
+{
+    link->conn_handle     = conn_handle;
+    link->max_segment     = BLE_GATT_ATT_MTU_DEFAULT - ESTC_TX_ATT_HEADER_LEN - ESTC_ARQ_SEQ_LEN;
+    link->base            = 0;
+    link->next            = 0;
+    link->frames_sent     = 0;
+    link->retransmissions = 0;
+    link->acks            = 0;
+    link->bytes_acked     = 0;
+}
+
+static estc_arq_frame_t * estc_arq_frame(estc_arq_link_t *link, uint16_t seq)
+{
+    return &link->window[seq & ESTC_ARQ_WINDOW_MASK];
+}
+
+/**@brief Function for handing the pending frames of a link to the SoftDevice.
+ */
+static void estc_arq_link_send(estc_arq_t *arq, estc_arq_link_t *link)
+{
+    if (BLE_CONN_HANDLE_INVALID == link->conn_handle)
+    {
+        return;
+    }
+
+    for (uint16_t seq = link->base; seq != link->next; seq++)
+    {
+        estc_arq_frame_t *frame = estc_arq_frame(link, seq);
+        if (frame->acked || !frame->pending)
+        {
+            continue;
+        }
+
+        uint16_t hvx_len = frame->len;
+        ret_code_t error_code = estc_tx_notify(arq->tx, arq->tx_client, link->conn_handle,
+                                               arq->value_handle, frame->data, &hvx_len);
+        if (NRF_SUCCESS == error_code)
+        {
+            frame->pending    = false;
+            frame->sent_ticks = app_timer_cnt_get();
+            frame->sent_order = link->frames_sent++;
+            continue;
+        }
+        if (NRF_ERROR_RESOURCES == error_code)
+        {
+            // Continued when notifications of the link were transmitted
+            return;
+        }
+        if (NRF_ERROR_INVALID_STATE == error_code ||
+            BLE_ERROR_GATTS_SYS_ATTR_MISSING == error_code ||
+            BLE_ERROR_INVALID_CONN_HANDLE == error_code)
+        {
+            // Notifications are disabled, the retransmission timer tries again
+            return;
+        }
+        APP_ERROR_CHECK(error_code);
+    }
+}
+
+/**@brief Function for sending pending frames of all links.
+ *
+ * @details Called from the main loop, the BLE event handler and the timer. A call that finds
+ *          another one sending only asks it for another pass.
+ */
+static void estc_arq_pump(estc_arq_t *arq)
+{
+    bool owner;
+    bool again;
+
+    CRITICAL_REGION_ENTER();
+    owner        = !arq->pumping;
+    arq->pumping = true;
+    arq->repump  = true;
+    CRITICAL_REGION_EXIT();
+
+    if (!owner)
+    {
+        return;
+    }
+
+    do
+    {
+        CRITICAL_REGION_ENTER();
+        arq->repump = false;
+        CRITICAL_REGION_EXIT();
+
+        for (uint8_t i = 0; i < ESTC_ARQ_LINK_COUNT; i++)
+        {
+            estc_arq_link_send(arq, &arq->links[i]);
+        }
+
+        CRITICAL_REGION_ENTER();
+        again = arq->repump;
+        if (!again)
+        {
+            arq->pumping = false;
+        }
+        CRITICAL_REGION_EXIT();
+    } while (again);
+}
+
+/**@brief Function for sending pending frames after notifications of a link were transmitted.
+ */
+static void estc_arq_on_tx_complete(void *ctx, uint16_t conn_handle, uint8_t completed)
+{
+    estc_arq_t *arq = (estc_arq_t *)ctx;
+
+    estc_arq_link_t *link = estc_arq_link_get(arq, conn_handle);
+    if (NULL != link && conn_handle == link->conn_handle && link->base != link->next)
+    {
+        estc_arq_pump(arq);
+    }
+}
+
+static void estc_arq_timer_start(estc_arq_t *arq)
+{
+    bool start;
+
+    CRITICAL_REGION_ENTER();
+    start = !arq->timer_running;
+    arq->timer_running = true;
+    CRITICAL_REGION_EXIT();
+
+    if (start)
+    {
+        ret_code_t error_code = app_timer_start(m_arq_timer, APP_TIMER_TICKS(ESTC_ARQ_RTO_MS / 2), arq);
+        APP_ERROR_CHECK(error_code);
+    }
+}
+
+static void estc_arq_timeout_handler(void *ctx)
+{
+    estc_arq_t *arq = (estc_arq_t *)ctx;
+    uint32_t now = app_timer_cnt_get();
+    bool in_use = false;
+
+    for (uint8_t i = 0; i < ESTC_ARQ_LINK_COUNT; i++)
+    {
+        estc_arq_link_t *link = &arq->links[i];
+        if (BLE_CONN_HANDLE_INVALID == link->conn_handle)
+        {
+            continue;
+        }
+
+        for (uint16_t seq = link->base; seq != link->next; seq++)
+        {
+            estc_arq_frame_t *frame = estc_arq_frame(link, seq);
+            in_use = true;
+            if (!frame->acked && !frame->pending &&
+                app_timer_cnt_diff_compute(now, frame->sent_ticks) >= APP_TIMER_TICKS(ESTC_ARQ_RTO_MS))
+            {
+                frame->pending = true;
+                link->retransmissions++;
+            }
+        }
+    }
+
+    if (!in_use)
+    {
+        ret_code_t error_code = app_timer_stop(m_arq_timer);
+        APP_ERROR_CHECK(error_code);
+        arq->timer_running = false;
+        return;
+    }
+
+    estc_arq_pump(arq);
+}
+
+ret_code_t estc_arq_init(estc_arq_t *arq, estc_tx_t *tx, uint16_t value_handle,
+                         estc_arq_space_handler_t space_handler)
+{
+    ASSERT(NULL != arq)
+    ASSERT(NULL != tx)
+
+    arq->tx            = tx;
+    arq->value_handle  = value_handle;
+    arq->space_handler = space_handler;
+    arq->timer_running = false;
+    arq->pumping       = false;
+    arq->repump        = false;
+
+    for (uint8_t i = 0; i < ESTC_ARQ_LINK_COUNT; i++)
+    {
+        estc_arq_link_reset(&arq->links[i], BLE_CONN_HANDLE_INVALID);
+    }
+
+    ret_code_t error_code = estc_tx_client_register(tx, estc_arq_on_tx_complete, arq, &arq->tx_client);
+    if (NRF_SUCCESS != error_code)
+    {
+        return error_code;
+    }
+
+    return app_timer_create(&m_arq_timer, APP_TIMER_MODE_REPEATED, estc_arq_timeout_handler);
+}
+
+void estc_arq_att_mtu_set(estc_arq_t *arq, uint16_t conn_handle, uint16_t att_mtu)
+{
+    ASSERT(NULL != arq)
+    ASSERT(att_mtu >= BLE_GATT_ATT_MTU_DEFAULT)
+
+    estc_arq_link_t *link = estc_arq_link_get(arq, conn_handle);
+    if (NULL == link)
+    {
+        return;
+    }
+
+    // Frames already in the window keep their size
+    link->max_segment = MIN(att_mtu - ESTC_TX_ATT_HEADER_LEN - ESTC_ARQ_SEQ_LEN, ESTC_ARQ_SEGMENT_MAX_LEN);
+}
+
+uint32_t estc_arq_write(estc_arq_t *arq, uint16_t conn_handle, uint8_t const *data, uint32_t len)
+{
+    ASSERT(NULL != arq)
+    ASSERT(NULL != data)
+    uint32_t accepted = 0;
+
+    estc_arq_link_t *link = estc_arq_link_get(arq, conn_handle);
+    if (NULL == link || conn_handle != link->conn_handle)
+    {
+        return 0;
+    }
+
+    // Only this function moves next, the event handler only moves base towards it
+    while (accepted < len && (uint16_t)(link->next - link->base) < ESTC_ARQ_WINDOW_LEN)
+    {
+        uint16_t segment_len = (uint16_t)MIN(len - accepted, link->max_segment);
+        estc_arq_frame_t *frame = estc_arq_frame(link, link->next);
+
+        (void)uint16_encode(link->next, frame->data);
+        memcpy(&frame->data[ESTC_ARQ_SEQ_LEN], &data[accepted], segment_len);
+        frame->len     = ESTC_ARQ_SEQ_LEN + segment_len;
+        frame->acked   = false;
+        frame->pending = true;
+
+        CRITICAL_REGION_ENTER();
+        link->next++;
+        CRITICAL_REGION_EXIT();
+        accepted += segment_len;
+    }
+
+    if (0 != accepted)
+    {
+        estc_arq_timer_start(arq);
+        estc_arq_pump(arq);
+    }
+
+    return accepted;
+}
+
+bool estc_arq_on_ack(estc_arq_t *arq, uint16_t conn_handle, uint8_t const *data, uint16_t len)
+{
+    ASSERT(NULL != arq)
+
+    estc_arq_link_t *link = estc_arq_link_get(arq, conn_handle);
+    if (NULL == link || conn_handle != link->conn_handle || link->base == link->next ||
+        ESTC_ARQ_ACK_LEN != len || ESTC_ARQ_ACK_OPCODE != data[0])
+    {
+        return false;
+    }
+
+    uint16_t cumulative = uint16_decode(&data[1]);
+    uint16_t selective  = uint16_decode(&data[3]);
+    uint16_t in_flight  = link->next - link->base;
+    link->acks++;
+
+    if ((uint16_t)(cumulative - link->base) > in_flight)
+    {
+        // Stale or corrupt, the next acknowledgement supersedes it
+        return true;
+    }
+
+    // Everything before the cumulative sequence number, and the frames in the bitmap
+    for (uint16_t seq = link->base; seq != cumulative; seq++)
+    {
+        estc_arq_frame(link, seq)->acked = true;
+    }
+    for (uint16_t bit = 0; bit < 16; bit++)
+    {
+        uint16_t seq = cumulative + 1 + bit;
+        if (0 != (selective & (1u << bit)) && (uint16_t)(seq - link->base) < in_flight)
+        {
+            estc_arq_frame(link, seq)->acked = true;
+        }
+    }
+
+    // Notifications of a link arrive in the order they were sent, so a frame still missing while
+    // one sent after it was received is lost, not delayed. A retransmission is only judged by
+    // frames sent after it, which keeps the acknowledgements already on their way from sending
+    // the frame once more.
+    bool     received = false;
+    uint32_t latest   = 0;
+    for (uint16_t seq = link->base; seq != link->next; seq++)
+    {
+        estc_arq_frame_t *frame = estc_arq_frame(link, seq);
+        if (frame->acked && !frame->pending &&
+            (!received || (int32_t)(frame->sent_order - latest) > 0))
+        {
+            received = true;
+            latest   = frame->sent_order;
+        }
+    }
+    for (uint16_t seq = link->base; received && seq != link->next; seq++)
+    {
+        estc_arq_frame_t *frame = estc_arq_frame(link, seq);
+        if (!frame->acked && !frame->pending && (int32_t)(latest - frame->sent_order) > 0)
+        {
+            frame->pending = true;
+            link->retransmissions++;
+        }
+    }
+
+    bool freed = false;
+    while (link->base != link->next && estc_arq_frame(link, link->base)->acked)
+    {
+        link->bytes_acked += estc_arq_frame(link, link->base)->len - ESTC_ARQ_SEQ_LEN;
+        link->base++;
+        freed = true;
+    }
+
+    estc_arq_pump(arq);
+    if (freed && NULL != arq->space_handler)
+    {
+        arq->space_handler(conn_handle);
+    }
+
+    return true;
+}
+
+void estc_arq_on_ble_event(const ble_evt_t *ble_evt, void *ctx)
+{
+    estc_arq_t *arq = (estc_arq_t *)ctx;
+
+    // Every BLE event starts with the handle of its connection
+    estc_arq_link_t *link = estc_arq_link_get(arq, ble_evt->evt.gap_evt.conn_handle);
+    if (NULL == link)
+    {
+        return;
+    }
+
+    switch (ble_evt->header.evt_id)
+    {
+        case BLE_GAP_EVT_CONNECTED:
+            estc_arq_link_reset(link, ble_evt->evt.gap_evt.conn_handle);
+            break;
+
+        case BLE_GAP_EVT_DISCONNECTED:
+            if (ble_evt->evt.gap_evt.conn_handle == link->conn_handle)
+            {
+                NRF_LOG_INFO("Reliable delivery: %d bytes acknowledged, %d frames sent, %d retransmitted (conn_handle: %d)",
+                             link->bytes_acked, link->frames_sent, link->retransmissions, link->conn_handle);
+                if (link->base != link->next)
+                {
+                    NRF_LOG_WARNING("%d frames not acknowledged before disconnect", (uint16_t)(link->next - link->base));
+                }
+                CRITICAL_REGION_ENTER();
+                link->conn_handle = BLE_CONN_HANDLE_INVALID;
+                link->base        = link->next;
+                CRITICAL_REGION_EXIT();
+            }
+            break;
+
+        default:
+            break;
+    }
+}
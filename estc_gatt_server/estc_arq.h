@@ -0,0 +1,161 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#ifndef ESTC_ARQ_H__
+#define ESTC_ARQ_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ble.h"
+#include "sdk_errors.h"
+#include "nrf_sdh_ble.h"
+#include "sdk_config.h"
+
+#include "estc_tx.h"
+
+// Sequence number at the start of every data frame (uint16, little-endian)
+#define ESTC_ARQ_SEQ_LEN            2
+
+// Largest segment in one data frame (in bytes)
+#define ESTC_ARQ_SEGMENT_MAX_LEN    (NRF_SDH_BLE_GATT_MAX_MTU_SIZE - ESTC_TX_ATT_HEADER_LEN - ESTC_ARQ_SEQ_LEN)
+
+// Frames kept per link until they are acknowledged (must be a power of 2, at most 16)
+#define ESTC_ARQ_WINDOW_LEN         8
+
+// Time after which an unacknowledged frame is sent again
+#define ESTC_ARQ_RTO_MS             400
+
+// First byte of an acknowledgement written by the central
+#define ESTC_ARQ_ACK_OPCODE         0xAC
+
+// Acknowledgement: opcode, next expected sequence number (uint16) and a bitmap of the frames
+// received after it (uint16, bit n for sequence number + 1 + n), little-endian
+#define ESTC_ARQ_ACK_LEN            5
+
+// Number of links with their own window, one per connection index
+#define ESTC_ARQ_LINK_COUNT         NRF_SDH_BLE_TOTAL_LINK_COUNT
+
+/**@brief Frame kept for retransmission. */
+typedef struct
+{
+    uint8_t  data[ESTC_ARQ_SEQ_LEN + ESTC_ARQ_SEGMENT_MAX_LEN];    /**< Sequence number followed by the segment. */
+    uint16_t len;                       /**< Length of the frame (in bytes). */
+    uint32_t sent_ticks;                /**< RTC counter of the last transmission. */
+    uint32_t sent_order;                /**< frames_sent of the link when the frame was last sent. */
+    bool     pending;                   /**< The frame waits to be (re)transmitted. */
+    bool     acked;                     /**< The central received the frame. */
+} estc_arq_frame_t;
+
+/**@brief Sliding window of one link. */
+typedef struct
+{
+    uint16_t         conn_handle;       /**< Connection of the link, BLE_CONN_HANDLE_INVALID when unused. */
+    uint16_t         max_segment;       /**< Largest segment that fits into a notification of the link. */
+    uint16_t         base;              /**< Sequence number of the oldest unacknowledged frame. */
+    uint16_t         next;              /**< Sequence number of the next new frame. */
+    estc_arq_frame_t window[ESTC_ARQ_WINDOW_LEN];
+    uint32_t         frames_sent;       /**< Notifications accepted by the SoftDevice, retransmissions included. */
+    uint32_t         retransmissions;   /**< Frames sent again after a gap or a timeout. */
+    uint32_t         acks;              /**< Acknowledgements received. */
+    uint32_t         bytes_acked;       /**< Segment bytes confirmed by the central. */
+} estc_arq_link_t;
+
+/**@brief Handler called when acknowledgements free frames in the window of a link. */
+typedef void (*estc_arq_space_handler_t)(uint16_t conn_handle);
+
+/**@brief Reliable delivery over notifications.
+ *
+ * @details Data is cut into frames of [sequence number][segment] and notified without waiting
+ *          for each other, like any stream. The frames stay in a window until the central
+ *          acknowledges them. Acknowledgements are cumulative with a selective bitmap. A frame
+ *          is sent again once the central received a frame sent after it, so a retransmission
+ *          waits a round trip for the acknowledgements that can have seen it, and frames not
+ *          acknowledged within ESTC_ARQ_RTO_MS are sent again as well. Delivery is as reliable
+ *          as indications while many frames are in flight per connection event.
+ */
+typedef struct
+{
+    estc_tx_t               *tx;                /**< Notification credits of the links. */
+    uint8_t                  tx_client;         /**< Client identifier of the reliable delivery in tx. */
+    uint16_t                 value_handle;      /**< Handle of the notified characteristic value. */
+    estc_arq_space_handler_t space_handler;     /**< Handler for freed window space, may be NULL. */
+    bool                     timer_running;     /**< The retransmission timer is started. */
+    bool                     pumping;           /**< Frames are being handed to the SoftDevice. */
+    bool                     repump;            /**< Frames became pending while pumping. */
+    estc_arq_link_t          links[ESTC_ARQ_LINK_COUNT];
+} estc_arq_t;
+
+/**@brief Function for initializing reliable delivery on a notifiable characteristic.
+ *
+ * @param[out] arq            Instance to initialize. Only one instance is supported.
+ * @param[in]  tx             Notification credits to send with.
+ * @param[in]  value_handle   Handle of the characteristic value to notify.
+ * @param[in]  space_handler  Handler for freed window space, may be NULL.
+ */
+ret_code_t estc_arq_init(estc_arq_t *arq, estc_tx_t *tx, uint16_t value_handle,
+                         estc_arq_space_handler_t space_handler);
+
+/**@brief Function for setting the segment size of a link from the negotiated ATT MTU.
+ *
+ * @param[in] arq          Instance.
+ * @param[in] conn_handle  Connection of the link.
+ * @param[in] att_mtu      Effective ATT MTU of the connection.
+ */
+void estc_arq_att_mtu_set(estc_arq_t *arq, uint16_t conn_handle, uint16_t att_mtu);
+
+/**@brief Function for sending data reliably to the central of a link.
+ *
+ * @details Call from the main loop only.
+ *
+ * @return Number of bytes accepted. Less than @p len if the window is full, the rest can be
+ *         written again after the space handler was called.
+ */
+uint32_t estc_arq_write(estc_arq_t *arq, uint16_t conn_handle, uint8_t const *data, uint32_t len);
+
+/**@brief Function for handling a write that may be an acknowledgement.
+ *
+ * @param[in] arq          Instance.
+ * @param[in] conn_handle  Connection the write came from.
+ * @param[in] data         Written data.
+ * @param[in] len          Length of the data.
+ *
+ * @return True if the write was an acknowledgement for a link with frames in flight.
+ */
+bool estc_arq_on_ack(estc_arq_t *arq, uint16_t conn_handle, uint8_t const *data, uint16_t len);
+
+/**@brief Function for handling BLE events relevant to reliable delivery.
+ *
+ * @param[in] ble_evt  Bluetooth stack event.
+ * @param[in] ctx      Instance.
+ */
+void estc_arq_on_ble_event(const ble_evt_t *ble_evt, void *ctx);
+
+#endif /* ESTC_ARQ_H__ */
@@ -0,0 +1,248 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#include "estc_bench.h"
+
+#include <string.h>
+
+#include "app_error.h"
+#include "app_timer.h"
+#include "app_util.h"
+#include "crc16.h"
+#include "nrf_log.h"
+#include "sdk_config.h"
+
+#include "ble.h"
+#include "ble_gatts.h"
+
+
+// Packet overhead of the benchmark framing (in bytes)
+#define ESTC_BENCH_FRAME_LEN        (ESTC_BENCH_SEQ_LEN + ESTC_BENCH_CRC_LEN)
+
+static void estc_bench_finish(estc_bench_t *bench, bool completed)
+{
+    bench->running = false;
+
+    if (completed)
+    {
+        uint32_t ticks = app_timer_cnt_diff_compute(bench->end_ticks, bench->start_ticks);
+        // APP_TIMER_CLOCK_FREQ is the RTC input clock, the counter runs behind the prescaler
+        uint32_t elapsed_ms = (uint32_t)(((uint64_t)ticks * 1000) / APP_TIMER_TICKS(1000));
+
+        bench->report.bytes                 = bench->bytes_total;
+        bench->report.packets               = bench->packets_acked;
+        bench->report.elapsed_ms            = elapsed_ms;
+        bench->report.bytes_per_second      = (0 != elapsed_ms) ? (uint32_t)(((uint64_t)bench->bytes_total * 1000) / elapsed_ms) : 0;
+        bench->report.packets_per_event_x10 = (0 != bench->tx_events) ? (uint16_t)((bench->packets_acked * 10) / bench->tx_events) : 0;
+
+        NRF_LOG_INFO("Benchmark: %d bytes in %d packets, %d ms, %d bytes/s",
+                     bench->report.bytes, bench->report.packets, bench->report.elapsed_ms, bench->report.bytes_per_second);
+    }
+    else
+    {
+        NRF_LOG_WARNING("Benchmark aborted after %d of %d bytes", bench->bytes_queued, bench->bytes_total);
+    }
+
+    if (NULL != bench->done_handler)
+    {
+        bench->done_handler(bench, completed);
+    }
+}
+
+/**@brief Function for building the next packet of a run.
+ *
+ * @return Length of the packet.
+ */
+static uint16_t estc_bench_packet_build(estc_bench_t *bench, uint8_t *packet)
+{
+    uint32_t remaining = bench->bytes_total - bench->bytes_queued;
+    uint16_t data_len  = (uint16_t)MIN(remaining, (uint32_t)(bench->max_payload - ESTC_BENCH_FRAME_LEN));
+
+    uint16_t len = uint16_encode(bench->seq, packet);
+    for (uint16_t i = 0; i < data_len; i++)
+    {
+        // Pattern derived from the sequence number, so a receiver can check every byte
+        packet[len++] = (uint8_t)(bench->seq + i);
+    }
+
+    uint16_t crc = crc16_compute(packet, len, NULL);
+    len += uint16_encode(crc, &packet[len]);
+
+    return len;
+}
+
+/**@brief Function for handing packets to the SoftDevice until its TX queue is full.
+ */
+static void estc_bench_send(estc_bench_t *bench)
+{
+    uint8_t packet[NRF_SDH_BLE_GATT_MAX_MTU_SIZE - ESTC_TX_ATT_HEADER_LEN];
+
+    while (bench->running && bench->bytes_queued < bench->bytes_total)
+    {
+        uint16_t len = estc_bench_packet_build(bench, packet);
+
+        ret_code_t error_code = estc_tx_notify(bench->tx, bench->tx_client, bench->conn_handle,
+                                               bench->value_handle, packet, &len);
+        if (NRF_SUCCESS == error_code)
+        {
+            bench->bytes_queued += len - ESTC_BENCH_FRAME_LEN;
+            bench->packets_sent++;
+            bench->seq++;
+            continue;
+        }
+        if (NRF_ERROR_RESOURCES == error_code)
+        {
+            // The packet is built again when the next one is acknowledged
+            return;
+        }
+        if (NRF_ERROR_INVALID_STATE == error_code ||
+            BLE_ERROR_GATTS_SYS_ATTR_MISSING == error_code ||
+            BLE_ERROR_INVALID_CONN_HANDLE == error_code)
+        {
+            // Notifications are disabled or the link is gone
+            estc_bench_finish(bench, false);
+            return;
+        }
+        APP_ERROR_CHECK(error_code);
+    }
+}
+
+/**@brief Function for counting the transmitted packets of a run and sending the next ones.
+ */
+static void estc_bench_on_tx_complete(void *ctx, uint16_t conn_handle, uint8_t completed)
+{
+    estc_bench_t *bench = (estc_bench_t *)ctx;
+
+    if (!bench->running || conn_handle != bench->conn_handle)
+    {
+        return;
+    }
+
+    if (0 != completed)
+    {
+        bench->packets_acked += completed;
+        bench->tx_events++;
+        bench->end_ticks = app_timer_cnt_get();
+    }
+
+    if (bench->bytes_queued == bench->bytes_total && bench->packets_acked == bench->packets_sent)
+    {
+        estc_bench_finish(bench, true);
+    }
+    else
+    {
+        estc_bench_send(bench);
+    }
+}
+
+ret_code_t estc_bench_init(estc_bench_t *bench, estc_tx_t *tx, uint16_t value_handle,
+                           estc_bench_done_handler_t done_handler)
+{
+    ASSERT(NULL != bench)
+    ASSERT(NULL != tx)
+
+    memset(bench, 0, sizeof(*bench));
+    bench->done_handler = done_handler;
+    bench->tx           = tx;
+    bench->conn_handle  = BLE_CONN_HANDLE_INVALID;
+    bench->value_handle = value_handle;
+    bench->max_payload  = ESTC_TX_DEFAULT_PAYLOAD;
+
+    return estc_tx_client_register(tx, estc_bench_on_tx_complete, bench, &bench->tx_client);
+}
+
+ret_code_t estc_bench_start(estc_bench_t *bench, uint16_t conn_handle, uint32_t bytes)
+{
+    ASSERT(NULL != bench)
+
+    if (bench->running)
+    {
+        return NRF_ERROR_BUSY;
+    }
+    if (0 == bytes)
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+
+    bench->conn_handle   = conn_handle;
+    bench->seq           = 0;
+    bench->bytes_total   = bytes;
+    bench->bytes_queued  = 0;
+    bench->packets_sent  = 0;
+    bench->packets_acked = 0;
+    bench->tx_events     = 0;
+    bench->start_ticks   = app_timer_cnt_get();
+    bench->end_ticks     = bench->start_ticks;
+    bench->running       = true;
+
+    NRF_LOG_INFO("Benchmark started: %d bytes, %d bytes per packet", bytes, bench->max_payload);
+
+    estc_bench_send(bench);
+    return NRF_SUCCESS;
+}
+
+void estc_bench_att_mtu_set(estc_bench_t *bench, uint16_t att_mtu)
+{
+    ASSERT(NULL != bench)
+    ASSERT(att_mtu >= BLE_GATT_ATT_MTU_DEFAULT)
+
+    bench->max_payload = att_mtu - ESTC_TX_ATT_HEADER_LEN;
+}
+
+uint16_t estc_bench_report_encode(estc_bench_report_t const *report, uint8_t *buffer)
+{
+    ASSERT(NULL != report)
+    ASSERT(NULL != buffer)
+    uint16_t len = 0;
+
+    len += uint32_encode(report->bytes, &buffer[len]);
+    len += uint32_encode(report->packets, &buffer[len]);
+    len += uint32_encode(report->elapsed_ms, &buffer[len]);
+    len += uint32_encode(report->bytes_per_second, &buffer[len]);
+    len += uint16_encode(report->packets_per_event_x10, &buffer[len]);
+
+    return len;
+}
+
+void estc_bench_on_ble_event(const ble_evt_t *ble_evt, void *ctx)
+{
+    estc_bench_t *bench = (estc_bench_t *)ctx;
+
+    if (!bench->running)
+    {
+        return;
+    }
+
+    if (BLE_GAP_EVT_DISCONNECTED == ble_evt->header.evt_id &&
+        ble_evt->evt.gap_evt.conn_handle == bench->conn_handle)
+    {
+        estc_bench_finish(bench, false);
+    }
+}
@@ -0,0 +1,140 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#ifndef ESTC_BENCH_H__
+#define ESTC_BENCH_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ble.h"
+#include "sdk_errors.h"
+
+#include "estc_tx.h"
+
+// Sequence number at the start of every benchmark packet (in bytes)
+#define ESTC_BENCH_SEQ_LEN          2
+
+// CRC16-CCITT of the sequence number and the data at the end of every benchmark packet (in bytes)
+#define ESTC_BENCH_CRC_LEN          2
+
+// Length of an encoded benchmark report (in bytes)
+#define ESTC_BENCH_REPORT_LEN       18
+
+/**@brief Result of a benchmark run. */
+typedef struct
+{
+    uint32_t bytes;                 /**< Data bytes acknowledged by the link layer. */
+    uint32_t packets;               /**< Notifications acknowledged by the link layer. */
+    uint32_t elapsed_ms;            /**< Time from the first notification to the last acknowledgement. */
+    uint32_t bytes_per_second;      /**< Data throughput, without sequence numbers and CRCs. */
+    uint16_t packets_per_event_x10; /**< Average notifications per connection event, times 10. */
+} estc_bench_report_t;
+
+typedef struct estc_bench_s estc_bench_t;
+
+/**@brief Handler called when a benchmark run completed or was aborted. */
+typedef void (*estc_bench_done_handler_t)(estc_bench_t *bench, bool completed);
+
+/**@brief Notification throughput benchmark.
+ *
+ * @details A run notifies a requested number of data bytes in packets of the form
+ *          [sequence number][data][CRC16], each filling one notification. Packets are generated
+ *          on the fly and handed to the SoftDevice until its TX queue is full, then one packet is
+ *          added for every acknowledged one, so the queue never runs dry while the run lasts.
+ *          Only the completions estc_tx_t attributes to the benchmark are counted, and every
+ *          completion with at least one of them as one connection event with traffic.
+ */
+struct estc_bench_s
+{
+    estc_bench_done_handler_t done_handler;     /**< Handler for finished runs, may be NULL. */
+    estc_tx_t            *tx;                   /**< Notification credits of the links. */
+    uint8_t               tx_client;            /**< Client identifier of the benchmark in tx. */
+    uint16_t              conn_handle;          /**< Connection of the current run. */
+    uint16_t              value_handle;         /**< Handle of the notified characteristic value. */
+    uint16_t              max_payload;          /**< Maximum number of bytes in one notification. */
+    uint16_t              seq;                  /**< Sequence number of the next packet. */
+    uint32_t              bytes_total;          /**< Data bytes requested for the run. */
+    uint32_t              bytes_queued;         /**< Data bytes handed to the SoftDevice. */
+    uint32_t              packets_sent;         /**< Notifications handed to the SoftDevice. */
+    uint32_t              packets_acked;        /**< Notifications acknowledged by the peer link layer. */
+    uint32_t              tx_events;            /**< BLE_GATTS_EVT_HVN_TX_COMPLETE events during the run. */
+    uint32_t              start_ticks;          /**< RTC counter when the run started. */
+    uint32_t              end_ticks;            /**< RTC counter of the last acknowledgement. */
+    bool                  running;              /**< A run is in progress. */
+    estc_bench_report_t   report;               /**< Result of the last completed run. */
+};
+
+/**@brief Function for initializing a benchmark on a notifiable characteristic.
+ *
+ * @param[out] bench         Benchmark to initialize.
+ * @param[in]  tx            Notification credits to send with.
+ * @param[in]  value_handle  Handle of the characteristic value to notify.
+ * @param[in]  done_handler  Handler for finished runs, may be NULL.
+ */
+ret_code_t estc_bench_init(estc_bench_t *bench, estc_tx_t *tx, uint16_t value_handle,
+                           estc_bench_done_handler_t done_handler);
+
+/**@brief Function for starting a run.
+ *
+ * @param[in] bench        Benchmark instance.
+ * @param[in] conn_handle  Connection to run on. The peer must have enabled notifications.
+ * @param[in] bytes        Number of data bytes to send.
+ *
+ * @retval NRF_SUCCESS              The run started.
+ * @retval NRF_ERROR_BUSY           A run is in progress.
+ * @retval NRF_ERROR_INVALID_PARAM  Zero bytes were requested.
+ */
+ret_code_t estc_bench_start(estc_bench_t *bench, uint16_t conn_handle, uint32_t bytes);
+
+/**@brief Function for setting the packet size from the negotiated ATT MTU.
+ *
+ * @param[in] bench    Benchmark instance.
+ * @param[in] att_mtu  Effective ATT MTU of the connection.
+ */
+void estc_bench_att_mtu_set(estc_bench_t *bench, uint16_t att_mtu);
+
+/**@brief Function for encoding a report as little-endian fields in the order of estc_bench_report_t.
+ *
+ * @param[in]  report  Report to encode.
+ * @param[out] buffer  Buffer of at least ESTC_BENCH_REPORT_LEN bytes.
+ *
+ * @return Number of bytes written.
+ */
+uint16_t estc_bench_report_encode(estc_bench_report_t const *report, uint8_t *buffer);
+
+/**@brief Function for handling BLE events relevant to the benchmark.
+ *
+ * @param[in] ble_evt  Bluetooth stack event.
+ * @param[in] ctx      Benchmark instance.
+ */
+void estc_bench_on_ble_event(const ble_evt_t *ble_evt, void *ctx);
+
+#endif /* ESTC_BENCH_H__ */
@@ -0,0 +1,138 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#include "estc_codec.h"
+
+#include <string.h>
+
+uint8_t estc_codec_bit_width(uint32_t value)
+{
+    return (0 == value) ? 0 : (uint8_t)(32 - __builtin_clz(value));
+}
+
+uint8_t estc_codec_varint_len(uint32_t value)
+{
+    // 7 payload bits per byte, at least one byte
+    return (estc_codec_bit_width(value) + 6) / 7 + (0 == value);
+}
+
+uint8_t estc_codec_varint_encode(uint32_t value, uint8_t *out)
+{
+    uint8_t len = 0;
+
+    while (value >= 0x80)
+    {
+        out[len++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    out[len++] = (uint8_t)value;
+
+    return len;
+}
+
+uint8_t estc_codec_varint_decode(uint8_t const *in, uint16_t len, uint32_t *value)
+{
+    uint32_t result = 0;
+
+    for (uint8_t i = 0; i < len && i < ESTC_CODEC_VARINT_MAX_LEN; i++)
+    {
+        result |= (uint32_t)(in[i] & 0x7F) << (7 * i);
+        if (0 == (in[i] & 0x80))
+        {
+            *value = result;
+            return i + 1;
+        }
+    }
+
+    return 0;
+}
+
+uint16_t estc_codec_block_len(uint8_t width, uint16_t count)
+{
+    return 1 + ((uint32_t)width * count + 7) / 8;
+}
+
+uint16_t estc_codec_block_encode(uint32_t const *values, uint16_t count, uint8_t width, uint8_t *out)
+{
+    uint16_t len = estc_codec_block_len(width, count);
+    uint64_t bits = 0;
+    uint8_t  pending = 0;
+    uint16_t pos = 1;
+
+    memset(out, 0, len);
+    out[0] = width;
+
+    for (uint16_t i = 0; i < count; i++)
+    {
+        // 32 value bits and at most 7 pending bits fit into the accumulator
+        bits |= (uint64_t)values[i] << pending;
+        pending += width;
+        while (pending >= 8)
+        {
+            out[pos++] = (uint8_t)bits;
+            bits >>= 8;
+            pending -= 8;
+        }
+    }
+    if (pending > 0)
+    {
+        out[pos] = (uint8_t)bits;
+    }
+
+    return len;
+}
+
+uint16_t estc_codec_block_decode(uint8_t const *in, uint16_t len, uint32_t *values, uint16_t count)
+{
+    if (len < 1 || in[0] > 32 || len < estc_codec_block_len(in[0], count))
+    {
+        return 0;
+    }
+
+    uint8_t  width = in[0];
+    uint64_t mask = ((uint64_t)1 << width) - 1;
+    uint64_t bits = 0;
+    uint8_t  pending = 0;
+    uint16_t pos = 1;
+
+    for (uint16_t i = 0; i < count; i++)
+    {
+        while (pending < width)
+        {
+            bits |= (uint64_t)in[pos++] << pending;
+            pending += 8;
+        }
+        values[i] = (uint32_t)(bits & mask);
+        bits >>= width;
+        pending -= width;
+    }
+
+    return estc_codec_block_len(width, count);
+}
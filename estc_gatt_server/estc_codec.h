@@ -0,0 +1,117 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#ifndef ESTC_CODEC_H__
+#define ESTC_CODEC_H__
+
+#include <stdint.h>
+
+/**@brief Compact integer coding of ESTC payloads.
+ *
+ * @details Slowly changing values are sent as differences to the previous value. Zigzag coding
+ *          maps small negative and positive differences to small unsigned numbers, which are
+ *          then written either as varints (7 bits per byte, low groups first, the top bit set on
+ *          all bytes but the last) or as a bit-packed block: one byte with the bit width of the
+ *          widest number, followed by all numbers at that width, LSB first.
+ *
+ *          The module only depends on the C library, so a central can build the same file to
+ *          decode the payloads.
+ */
+
+// Longest varint of a 32-bit value (in bytes)
+#define ESTC_CODEC_VARINT_MAX_LEN   5
+
+/**@brief Function for mapping a signed value to an unsigned one, small magnitudes to small numbers. */
+static inline uint32_t estc_codec_zigzag_encode(int32_t value)
+{
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+/**@brief Function for reversing estc_codec_zigzag_encode. */
+static inline int32_t estc_codec_zigzag_decode(uint32_t value)
+{
+    return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+/**@brief Function for getting the number of significant bits of a value, 0 for 0. */
+uint8_t estc_codec_bit_width(uint32_t value);
+
+/**@brief Function for getting the length of the varint of a value (in bytes). */
+uint8_t estc_codec_varint_len(uint32_t value);
+
+/**@brief Function for writing a value as a varint.
+ *
+ * @param[in]  value  Value to write.
+ * @param[out] out    Buffer with room for estc_codec_varint_len(value) bytes.
+ *
+ * @return Number of bytes written.
+ */
+uint8_t estc_codec_varint_encode(uint32_t value, uint8_t *out);
+
+/**@brief Function for reading a varint.
+ *
+ * @param[in]  in     Encoded data.
+ * @param[in]  len    Bytes available in @p in.
+ * @param[out] value  Decoded value.
+ *
+ * @return Number of bytes read, 0 if the varint is truncated or longer than ESTC_CODEC_VARINT_MAX_LEN.
+ */
+uint8_t estc_codec_varint_decode(uint8_t const *in, uint16_t len, uint32_t *value);
+
+/**@brief Function for getting the length of a bit-packed block (in bytes).
+ *
+ * @param[in] width  Bit width of the values.
+ * @param[in] count  Number of values.
+ */
+uint16_t estc_codec_block_len(uint8_t width, uint16_t count);
+
+/**@brief Function for writing values as a bit-packed block.
+ *
+ * @param[in]  values  Values to write, none wider than @p width bits.
+ * @param[in]  count   Number of values.
+ * @param[in]  width   Bit width, estc_codec_bit_width of all values OR-ed together.
+ * @param[out] out     Buffer with room for estc_codec_block_len(width, count) bytes.
+ *
+ * @return Number of bytes written.
+ */
+uint16_t estc_codec_block_encode(uint32_t const *values, uint16_t count, uint8_t width, uint8_t *out);
+
+/**@brief Function for reading a bit-packed block.
+ *
+ * @param[in]  in      Encoded data.
+ * @param[in]  len     Bytes available in @p in.
+ * @param[out] values  Decoded values.
+ * @param[in]  count   Number of values in the block.
+ *
+ * @return Number of bytes read, 0 if the block is truncated or its width is invalid.
+ */
+uint16_t estc_codec_block_decode(uint8_t const *in, uint16_t len, uint32_t *values, uint16_t count);
+
+#endif /* ESTC_CODEC_H__ */
@@ -0,0 +1,212 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#include "estc_conn_policy.h"
+
+#include "app_error.h"
+#include "app_timer.h"
+#include "app_util.h"
+#include "ble_conn_params.h"
+#include "nrf_log.h"
+
+#include "ble.h"
+#include "ble_gap.h"
+
+static char const * estc_conn_policy_profile_name(estc_conn_policy_profile_t profile)
+{
+    return (ESTC_CONN_POLICY_PROFILE_BUSY == profile) ? "busy" : "idle";
+}
+
+/**@brief Function for requesting the parameters of a profile from the peer.
+ */
+static void estc_conn_policy_apply(estc_conn_policy_t *policy, estc_conn_policy_profile_t profile)
+{
+    if (BLE_CONN_HANDLE_INVALID == policy->conn_handle || profile == policy->profile)
+    {
+        return;
+    }
+    if (policy->profiles_rejected & (1u << profile))
+    {
+        // Asking again would only run into the same failure
+        return;
+    }
+
+    ble_gap_conn_params_t params = (ESTC_CONN_POLICY_PROFILE_BUSY == profile) ? policy->config.busy_params
+                                                                               : policy->config.idle_params;
+
+    ret_code_t error_code = ble_conn_params_change_conn_params(policy->conn_handle, &params);
+    if (NRF_ERROR_BUSY == error_code || NRF_ERROR_INVALID_STATE == error_code)
+    {
+        // Another procedure is running, the next check retries
+        return;
+    }
+    if (BLE_ERROR_INVALID_CONN_HANDLE == error_code)
+    {
+        return;
+    }
+    APP_ERROR_CHECK(error_code);
+
+    policy->profile = profile;
+    policy->updates_requested++;
+    NRF_LOG_INFO("Connection parameters: %s profile requested (%d updates)",
+                 estc_conn_policy_profile_name(profile), policy->updates_requested);
+}
+
+/**@brief Function for arming the idle timeout, unless it is armed or a stream keeps the link busy.
+ *
+ * @param[in] policy  Policy instance.
+ * @param[in] ticks   Time until the link counts as quiet.
+ */
+static void estc_conn_policy_timer_start(estc_conn_policy_t *policy, uint32_t ticks)
+{
+    if (policy->timer_running || policy->stream_active || BLE_CONN_HANDLE_INVALID == policy->conn_handle)
+    {
+        return;
+    }
+
+    ret_code_t error_code = app_timer_start(policy->timer_id, MAX(ticks, APP_TIMER_MIN_TIMEOUT_TICKS), policy);
+    APP_ERROR_CHECK(error_code);
+    policy->timer_running = true;
+}
+
+static void estc_conn_policy_timeout_handler(void *ctx)
+{
+    estc_conn_policy_t *policy = (estc_conn_policy_t *)ctx;
+    policy->timer_running = false;
+
+    // The end of the stream arms the timeout again
+    if (policy->stream_active)
+    {
+        return;
+    }
+
+    // Traffic since the timer was armed moved the deadline, wait for the rest of the timeout
+    uint32_t quiet_ticks   = app_timer_cnt_diff_compute(app_timer_cnt_get(), policy->last_activity);
+    uint32_t timeout_ticks = APP_TIMER_TICKS(policy->config.idle_timeout_ms);
+    if (quiet_ticks < timeout_ticks)
+    {
+        estc_conn_policy_timer_start(policy, timeout_ticks - quiet_ticks);
+        return;
+    }
+
+    estc_conn_policy_apply(policy, ESTC_CONN_POLICY_PROFILE_IDLE);
+}
+
+ret_code_t estc_conn_policy_init(estc_conn_policy_t *policy, estc_conn_policy_init_t const *init)
+{
+    ASSERT(NULL != policy)
+    ASSERT(NULL != init)
+    ASSERT(APP_TIMER_TICKS(init->idle_timeout_ms) >= APP_TIMER_MIN_TIMEOUT_TICKS)
+
+    policy->config            = *init;
+    policy->conn_handle       = BLE_CONN_HANDLE_INVALID;
+    policy->profile           = ESTC_CONN_POLICY_PROFILE_NONE;
+    policy->profiles_rejected = 0;
+    policy->stream_active     = false;
+    policy->timer_running     = false;
+    policy->last_activity     = 0;
+    policy->updates_requested = 0;
+
+    // Every connection has its own timeout, so the timer lives in the instance. It only runs
+    // until the link goes quiet, so an idle link does not wake the CPU.
+    policy->timer_id = &policy->timer_data;
+    return app_timer_create(&policy->timer_id, APP_TIMER_MODE_SINGLE_SHOT, estc_conn_policy_timeout_handler);
+}
+
+void estc_conn_policy_activity(estc_conn_policy_t *policy)
+{
+    ASSERT(NULL != policy)
+
+    policy->last_activity = app_timer_cnt_get();
+    estc_conn_policy_apply(policy, ESTC_CONN_POLICY_PROFILE_BUSY);
+    estc_conn_policy_timer_start(policy, APP_TIMER_TICKS(policy->config.idle_timeout_ms));
+}
+
+void estc_conn_policy_stream_set(estc_conn_policy_t *policy, bool active)
+{
+    ASSERT(NULL != policy)
+
+    if (policy->stream_active == active)
+    {
+        return;
+    }
+
+    // The idle timeout counts from the end of the stream
+    policy->stream_active = active;
+    estc_conn_policy_activity(policy);
+}
+
+bool estc_conn_policy_on_conn_params_failed(estc_conn_policy_t *policy)
+{
+    ASSERT(NULL != policy)
+
+    if (ESTC_CONN_POLICY_PROFILE_NONE == policy->profile)
+    {
+        return false;
+    }
+
+    // The Connection Parameters module stopped negotiating, so the link stays on the parameters
+    // of the peer until the policy requests the other profile
+    policy->profiles_rejected |= (uint8_t)(1u << policy->profile);
+    NRF_LOG_WARNING("Connection parameters: %s profile rejected, keeping the parameters of the peer",
+                    estc_conn_policy_profile_name(policy->profile));
+    return true;
+}
+
+void estc_conn_policy_on_ble_event(const ble_evt_t *ble_evt, void *ctx)
+{
+    estc_conn_policy_t *policy = (estc_conn_policy_t *)ctx;
+    ret_code_t error_code;
+
+    switch (ble_evt->header.evt_id)
+    {
+        case BLE_GAP_EVT_CONNECTED:
+            policy->conn_handle   = ble_evt->evt.gap_evt.conn_handle;
+            policy->profile           = ESTC_CONN_POLICY_PROFILE_NONE;
+            policy->profiles_rejected = 0;
+            policy->stream_active     = false;
+            policy->last_activity = app_timer_cnt_get();
+            estc_conn_policy_timer_start(policy, APP_TIMER_TICKS(policy->config.idle_timeout_ms));
+            break;
+
+        case BLE_GAP_EVT_DISCONNECTED:
+            if (ble_evt->evt.gap_evt.conn_handle == policy->conn_handle)
+            {
+                policy->conn_handle   = BLE_CONN_HANDLE_INVALID;
+                policy->timer_running = false;
+                error_code = app_timer_stop(policy->timer_id);
+                APP_ERROR_CHECK(error_code);
+            }
+            break;
+
+        default:
+            break;
+    }
+}
@@ -0,0 +1,120 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#ifndef ESTC_CONN_POLICY_H__
+#define ESTC_CONN_POLICY_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "app_timer.h"
+#include "ble.h"
+#include "ble_gap.h"
+#include "sdk_errors.h"
+
+/**@brief Connection parameter profiles of the policy. */
+typedef enum
+{
+    ESTC_CONN_POLICY_PROFILE_NONE,  /**< The policy has not requested parameters on this connection yet. */
+    ESTC_CONN_POLICY_PROFILE_IDLE,  /**< Long interval with slave latency, for low current. */
+    ESTC_CONN_POLICY_PROFILE_BUSY,  /**< Short interval without latency, for low latency and high throughput. */
+} estc_conn_policy_profile_t;
+
+/**@brief Connection parameter policy initialization parameters. */
+typedef struct
+{
+    ble_gap_conn_params_t idle_params;      /**< Parameters requested while the link is quiet. */
+    ble_gap_conn_params_t busy_params;      /**< Parameters requested while there is traffic. */
+    uint32_t              idle_timeout_ms;  /**< Time without traffic before falling back to idle_params. */
+} estc_conn_policy_init_t;
+
+/**@brief Traffic-adaptive connection parameter policy.
+ *
+ * @details Any traffic switches the link to the busy profile at once. The idle profile is only
+ *          requested after idle_timeout_ms without traffic and with no stream running, so
+ *          short pauses in a burst do not cause an update each. Requests go through the
+ *          Connection Parameters module, which keeps negotiating the latest profile with the peer.
+ *          A profile the peer does not grant is not requested again on the connection.
+ */
+typedef struct
+{
+    estc_conn_policy_init_t     config;             /**< Profiles and hysteresis. */
+    uint16_t                    conn_handle;        /**< Connection the policy applies to. */
+    estc_conn_policy_profile_t  profile;            /**< Last profile requested from the peer. */
+    uint8_t                     profiles_rejected;  /**< Bit per profile the peer did not grant on this connection. */
+    bool                        stream_active;      /**< A stream is running on the connection. */
+    bool                        timer_running;      /**< The idle timeout is armed. */
+    uint32_t                    last_activity;      /**< RTC counter of the last traffic. */
+    uint32_t                    updates_requested;  /**< Connection parameter updates requested by the policy. */
+    app_timer_t                 timer_data;         /**< Single-shot timer expiring when the link may have gone quiet. */
+    app_timer_id_t              timer_id;           /**< Identifier of timer_data. */
+} estc_conn_policy_t;
+
+/**@brief Function for initializing the connection parameter policy.
+ *
+ * @details Call after ble_conn_params_init.
+ *
+ * @param[out] policy  Policy instance.
+ * @param[in]  init    Profiles and hysteresis.
+ */
+ret_code_t estc_conn_policy_init(estc_conn_policy_t *policy, estc_conn_policy_init_t const *init);
+
+/**@brief Function for reporting a command or data burst on the connection.
+ *
+ * @param[in] policy  Policy instance.
+ */
+void estc_conn_policy_activity(estc_conn_policy_t *policy);
+
+/**@brief Function for telling the policy that a stream started or stopped.
+ *
+ * @param[in] policy  Policy instance.
+ * @param[in] active  True while the stream has data pending or in flight.
+ */
+void estc_conn_policy_stream_set(estc_conn_policy_t *policy, bool active);
+
+/**@brief Function for handling a negotiation of the Connection Parameters module that ran out of attempts.
+ *
+ * @details The profile is marked as rejected and the link keeps the parameters the peer chose.
+ *
+ * @param[in] policy  Policy instance.
+ *
+ * @return True if the negotiation was for a profile of the policy, false if it was the initial
+ *         one of the Connection Parameters module.
+ */
+bool estc_conn_policy_on_conn_params_failed(estc_conn_policy_t *policy);
+
+/**@brief Function for handling BLE events relevant to the policy.
+ *
+ * @param[in] ble_evt  Bluetooth stack event.
+ * @param[in] ctx      Policy instance.
+ */
+void estc_conn_policy_on_ble_event(const ble_evt_t *ble_evt, void *ctx);
+
+#endif /* ESTC_CONN_POLICY_H__ */
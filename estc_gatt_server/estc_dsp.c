@@ -0,0 +1,263 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#include "estc_dsp.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "app_error.h"
+#include "app_util.h"
+#include "sdk_macros.h"
+
+// FFT bins of each band, DC and Nyquist are left out
+#define ESTC_DSP_BAND_BINS      ((ESTC_DSP_FFT_LEN / 2) / ESTC_DSP_BAND_COUNT)
+
+STATIC_ASSERT(0 == (ESTC_DSP_FFT_LEN / 2) % ESTC_DSP_BAND_COUNT);
+
+static uint16_t estc_dsp_value_encode(float32_t value)
+{
+    return (uint16_t)MIN(value + 0.5f, (float32_t)UINT16_MAX);
+}
+
+/**@brief Function for reducing a full float window to its features.
+ */
+static void estc_dsp_f32_analyze(estc_dsp_f32_t *dsp, estc_dsp_features_t *features)
+{
+    float32_t max;
+    float32_t min;
+    float32_t mean;
+    uint32_t  index;
+
+    arm_rms_f32(dsp->samples, ESTC_DSP_FFT_LEN, &features->rms);
+    arm_max_f32(dsp->samples, ESTC_DSP_FFT_LEN, &max, &index);
+    arm_min_f32(dsp->samples, ESTC_DSP_FFT_LEN, &min, &index);
+    features->peak = fmaxf(fabsf(max), fabsf(min));
+
+    arm_mean_f32(dsp->samples, ESTC_DSP_FFT_LEN, &mean);
+    arm_offset_f32(dsp->samples, -mean, dsp->samples, ESTC_DSP_FFT_LEN);
+
+    arm_rfft_fast_f32(&dsp->rfft, dsp->samples, dsp->spectrum, 0);
+
+    // The first pair holds the real DC and Nyquist bins instead of one complex bin
+    arm_cmplx_mag_squared_f32(dsp->spectrum, dsp->power, ESTC_DSP_FFT_LEN / 2);
+    dsp->power[0] = 0.0f;
+
+    for (uint8_t band = 0; band < ESTC_DSP_BAND_COUNT; band++)
+    {
+        float32_t energy = 0.0f;
+        for (uint16_t bin = 0; bin < ESTC_DSP_BAND_BINS; bin++)
+        {
+            energy += dsp->power[band * ESTC_DSP_BAND_BINS + bin];
+        }
+        features->band_energy[band] = energy;
+    }
+}
+
+/**@brief Function for reducing a full Q15 window to its features.
+ *
+ * @details The features are scaled back to the units of the samples, so both formats encode the
+ *          same packet.
+ */
+static void estc_dsp_q15_analyze(estc_dsp_q15_t *dsp, estc_dsp_features_t *features)
+{
+    // Sample units of one Q15 step
+    float32_t const unit = (float32_t)ESTC_DSP_Q15_FULL_SCALE / 32768.0f;
+    q15_t    rms;
+    q15_t    max;
+    q15_t    min;
+    q15_t    mean;
+    uint32_t index;
+
+    arm_rms_q15(dsp->samples, ESTC_DSP_FFT_LEN, &rms);
+    arm_max_q15(dsp->samples, ESTC_DSP_FFT_LEN, &max, &index);
+    arm_min_q15(dsp->samples, ESTC_DSP_FFT_LEN, &min, &index);
+    features->rms  = rms * unit;
+    features->peak = MAX(abs(max), abs(min)) * unit;
+
+    arm_mean_q15(dsp->samples, ESTC_DSP_FFT_LEN, &mean);
+    arm_offset_q15(dsp->samples, -mean, dsp->samples, ESTC_DSP_FFT_LEN);
+
+    // Scaled down by ESTC_DSP_FFT_LEN so the bins cannot overflow, the input is overwritten
+    arm_rfft_q15(&dsp->rfft, dsp->samples, dsp->spectrum);
+
+    // 1.15 bins squared into 3.13, the first bin is DC
+    arm_cmplx_mag_squared_q15(dsp->spectrum, dsp->power, ESTC_DSP_FFT_LEN / 2);
+    dsp->power[0] = 0;
+
+    // Undo the 3.13 format, the FFT scaling and the Q15 units
+    float32_t const scale = ((float32_t)ESTC_DSP_FFT_LEN * ESTC_DSP_FFT_LEN / 8192.0f) * 32768.0f * 32768.0f * unit * unit;
+    for (uint8_t band = 0; band < ESTC_DSP_BAND_COUNT; band++)
+    {
+        q31_t energy = 0;
+        for (uint16_t bin = 0; bin < ESTC_DSP_BAND_BINS; bin++)
+        {
+            energy += dsp->power[band * ESTC_DSP_BAND_BINS + bin];
+        }
+        features->band_energy[band] = energy * scale;
+    }
+}
+
+/**@brief Function for converting a sample to Q15, saturating outside ESTC_DSP_Q15_FULL_SCALE.
+ */
+static q15_t estc_dsp_q15_convert(float32_t sample)
+{
+    float32_t value = sample * (32768.0f / ESTC_DSP_Q15_FULL_SCALE);
+
+    return (q15_t)MAX(MIN(lroundf(value), INT16_MAX), INT16_MIN);
+}
+
+ret_code_t estc_dsp_init(estc_dsp_t *dsp, estc_dsp_format_t format)
+{
+    ASSERT(NULL != dsp)
+    arm_status status;
+
+    memset(dsp, 0, sizeof(*dsp));
+    dsp->format = format;
+    if (ESTC_DSP_FORMAT_Q15 == format)
+    {
+        status = arm_rfft_init_q15(&dsp->q15.rfft, ESTC_DSP_FFT_LEN, 0, 1);
+    }
+    else
+    {
+        status = arm_rfft_fast_init_f32(&dsp->f32.rfft, ESTC_DSP_FFT_LEN);
+    }
+
+    return (ARM_MATH_SUCCESS == status) ? NRF_SUCCESS : NRF_ERROR_INVALID_PARAM;
+}
+
+void estc_dsp_reset(estc_dsp_t *dsp)
+{
+    ASSERT(NULL != dsp)
+
+    dsp->count = 0;
+}
+
+bool estc_dsp_add(estc_dsp_t *dsp, float32_t sample, estc_dsp_features_t *features)
+{
+    ASSERT(NULL != dsp)
+    ASSERT(NULL != features)
+
+    if (ESTC_DSP_FORMAT_Q15 == dsp->format)
+    {
+        dsp->q15.samples[dsp->count++] = estc_dsp_q15_convert(sample);
+    }
+    else
+    {
+        dsp->f32.samples[dsp->count++] = sample;
+    }
+    if (dsp->count < ESTC_DSP_FFT_LEN)
+    {
+        return false;
+    }
+
+    if (ESTC_DSP_FORMAT_Q15 == dsp->format)
+    {
+        estc_dsp_q15_analyze(&dsp->q15, features);
+    }
+    else
+    {
+        estc_dsp_f32_analyze(&dsp->f32, features);
+    }
+    dsp->count = 0;
+    dsp->windows++;
+    return true;
+}
+
+uint16_t estc_dsp_features_encode(estc_dsp_features_t const *features, uint8_t seq, uint8_t *buffer)
+{
+    ASSERT(NULL != features)
+    ASSERT(NULL != buffer)
+    uint16_t len = 0;
+    float32_t total = 0.0f;
+
+    buffer[len++] = seq;
+    len += uint16_encode(estc_dsp_value_encode(features->rms), &buffer[len]);
+    len += uint16_encode(estc_dsp_value_encode(features->peak), &buffer[len]);
+
+    for (uint8_t band = 0; band < ESTC_DSP_BAND_COUNT; band++)
+    {
+        total += features->band_energy[band];
+    }
+    for (uint8_t band = 0; band < ESTC_DSP_BAND_COUNT; band++)
+    {
+        // A constant window has no AC energy at all
+        float32_t share = (total > 0.0f) ? features->band_energy[band] / total : 0.0f;
+        buffer[len++] = (uint8_t)(share * UINT8_MAX + 0.5f);
+    }
+
+    return len;
+}
+
+/**@brief Function for counting the cycles of one window in the current format.
+ */
+static uint32_t estc_dsp_window_cycles(estc_dsp_t *dsp)
+{
+    estc_dsp_features_t features;
+    uint32_t            start = 0;
+
+    // A full period of the simulated sensor's triangle, so both formats see the same input
+    for (uint16_t i = 0; i < ESTC_DSP_FFT_LEN; i++)
+    {
+        uint32_t  phase  = i * (2 * ESTC_DSP_Q15_FULL_SCALE / ESTC_DSP_FFT_LEN);
+        float32_t sample = (phase < ESTC_DSP_Q15_FULL_SCALE) ? phase : 2 * ESTC_DSP_Q15_FULL_SCALE - 1 - phase;
+
+        if (ESTC_DSP_FFT_LEN - 1 == i)
+        {
+            // Only the analysis of the full window is counted
+            start = DWT->CYCCNT;
+        }
+        (void)estc_dsp_add(dsp, sample, &features);
+    }
+
+    return DWT->CYCCNT - start;
+}
+
+ret_code_t estc_dsp_benchmark(estc_dsp_t *dsp, estc_dsp_benchmark_t *result)
+{
+    ASSERT(NULL != dsp)
+    ASSERT(NULL != result)
+    estc_dsp_format_t format = dsp->format;
+    ret_code_t        error_code;
+
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL        |= DWT_CTRL_CYCCNTENA_Msk;
+
+    error_code = estc_dsp_init(dsp, ESTC_DSP_FORMAT_F32);
+    VERIFY_SUCCESS(error_code);
+    result->f32_cycles = estc_dsp_window_cycles(dsp);
+
+    error_code = estc_dsp_init(dsp, ESTC_DSP_FORMAT_Q15);
+    VERIFY_SUCCESS(error_code);
+    result->q15_cycles = estc_dsp_window_cycles(dsp);
+
+    return estc_dsp_init(dsp, format);
+}
@@ -0,0 +1,173 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#ifndef ESTC_DSP_H__
+#define ESTC_DSP_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "arm_math.h"
+#include "sdk_errors.h"
+
+// Samples per analysis window, a power of 2 supported by arm_rfft_fast_f32
+#define ESTC_DSP_FFT_LEN        256
+
+// Frequency bands of the spectrum summary, of equal width between DC and half the sampling rate
+#define ESTC_DSP_BAND_COUNT     8
+
+// Features packet: sequence number (1 byte), RMS (2 bytes), peak (2 bytes),
+// share of the AC energy in each band (1 byte each, 255 for all of it)
+#define ESTC_DSP_FEATURES_LEN   (1 + 2 + 2 + ESTC_DSP_BAND_COUNT)
+
+// Samples mapped to the top of the Q15 range, larger ones saturate (12-bit ADC range)
+#ifndef ESTC_DSP_Q15_FULL_SCALE
+#define ESTC_DSP_Q15_FULL_SCALE 4096
+#endif
+
+// Measure the cycles of a window analysis in each format with the DWT cycle counter when the
+// sampler starts, see estc_dsp_benchmark
+#ifndef ESTC_DSP_BENCHMARK
+#define ESTC_DSP_BENCHMARK 0
+#endif
+
+/**@brief Arithmetic of the feature extraction. */
+typedef enum
+{
+    ESTC_DSP_FORMAT_F32,    /**< Single precision float on the FPU. */
+    ESTC_DSP_FORMAT_Q15,    /**< 16-bit fixed point, half the buffer memory, loses the weakest bins. */
+} estc_dsp_format_t;
+
+/**@brief Features of one analysis window. */
+typedef struct
+{
+    float32_t rms;                              /**< Root mean square of the samples. */
+    float32_t peak;                             /**< Largest magnitude of the samples. */
+    float32_t band_energy[ESTC_DSP_BAND_COUNT]; /**< Spectral energy of each band, without DC. */
+} estc_dsp_features_t;
+
+/**@brief Buffers of the float feature extraction. */
+typedef struct
+{
+    arm_rfft_fast_instance_f32 rfft;                        /**< Real FFT of ESTC_DSP_FFT_LEN points. */
+    float32_t                  samples[ESTC_DSP_FFT_LEN];   /**< Window being collected, overwritten by the FFT. */
+    float32_t                  spectrum[ESTC_DSP_FFT_LEN];  /**< Packed complex FFT output. */
+    float32_t                  power[ESTC_DSP_FFT_LEN / 2]; /**< Energy of each FFT bin. */
+} estc_dsp_f32_t;
+
+/**@brief Buffers of the Q15 feature extraction. */
+typedef struct
+{
+    arm_rfft_instance_q15      rfft;                        /**< Real FFT of ESTC_DSP_FFT_LEN points. */
+    q15_t                      samples[ESTC_DSP_FFT_LEN];   /**< Window being collected, in units of ESTC_DSP_Q15_FULL_SCALE. */
+    q15_t                      spectrum[2 * ESTC_DSP_FFT_LEN]; /**< Complex FFT output, scaled down by ESTC_DSP_FFT_LEN. */
+    q15_t                      power[ESTC_DSP_FFT_LEN / 2]; /**< Energy of each FFT bin, in 3.13 format. */
+} estc_dsp_q15_t;
+
+/**@brief CMSIS-DSP feature extraction over windows of samples.
+ *
+ * @details Samples are collected until a window is full. The window is then reduced to its RMS,
+ *          its peak and the energy of ESTC_DSP_BAND_COUNT bands of a real FFT, so a few bytes
+ *          replace the whole waveform. The mean is removed before the FFT, so an offset does not
+ *          end up in the lowest band.
+ *
+ *          Both formats report the features in the units of the samples. Q15 trades bins below
+ *          its resolution for the integer kernels, see estc_dsp_benchmark for their cost.
+ */
+typedef struct
+{
+    estc_dsp_format_t format;       /**< Arithmetic of the analysis. */
+    union
+    {
+        estc_dsp_f32_t f32;         /**< Buffers with ESTC_DSP_FORMAT_F32. */
+        estc_dsp_q15_t q15;         /**< Buffers with ESTC_DSP_FORMAT_Q15. */
+    };
+    uint16_t          count;        /**< Samples in the current window. */
+    uint32_t          windows;      /**< Windows analyzed. */
+} estc_dsp_t;
+
+/**@brief Cycles of one window analysis in each format. */
+typedef struct
+{
+    uint32_t f32_cycles;    /**< Cycles with ESTC_DSP_FORMAT_F32. */
+    uint32_t q15_cycles;    /**< Cycles with ESTC_DSP_FORMAT_Q15. */
+} estc_dsp_benchmark_t;
+
+/**@brief Function for initializing the feature extraction.
+ *
+ * @param[out] dsp     Feature extraction instance.
+ * @param[in]  format  Arithmetic of the analysis.
+ *
+ * @retval NRF_ERROR_INVALID_PARAM  CMSIS-DSP does not support ESTC_DSP_FFT_LEN.
+ */
+ret_code_t estc_dsp_init(estc_dsp_t *dsp, estc_dsp_format_t format);
+
+/**@brief Function for dropping the samples of the current window.
+ *
+ * @details Call when the samples stop, so the next window does not join samples across the gap.
+ *
+ * @param[in] dsp  Feature extraction instance.
+ */
+void estc_dsp_reset(estc_dsp_t *dsp);
+
+/**@brief Function for measuring the cycles of a window analysis in each format.
+ *
+ * @details Analyzes the same test window in both formats, counted by the DWT cycle counter.
+ *          The instance is initialized again in its format afterwards, so the current window is
+ *          lost. Call before sampling starts.
+ *
+ * @param[in]  dsp     Feature extraction instance.
+ * @param[out] result  Cycles of each format.
+ */
+ret_code_t estc_dsp_benchmark(estc_dsp_t *dsp, estc_dsp_benchmark_t *result);
+
+/**@brief Function for adding a sample to the current window.
+ *
+ * @details Analyzing a window takes a while, call from the main loop.
+ *
+ * @param[in]  dsp       Feature extraction instance.
+ * @param[in]  sample    Sample.
+ * @param[out] features  Features of the window, set when true is returned.
+ *
+ * @return True if the sample completed a window.
+ */
+bool estc_dsp_add(estc_dsp_t *dsp, float32_t sample, estc_dsp_features_t *features);
+
+/**@brief Function for encoding the features of a window into a packet.
+ *
+ * @param[in]  features  Features of a window.
+ * @param[in]  seq       Sequence number of the packet.
+ * @param[out] buffer    Buffer of at least ESTC_DSP_FEATURES_LEN bytes.
+ *
+ * @return Length of the packet.
+ */
+uint16_t estc_dsp_features_encode(estc_dsp_features_t const *features, uint8_t seq, uint8_t *buffer);
+
+#endif /* ESTC_DSP_H__ */
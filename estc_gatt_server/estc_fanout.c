@@ -0,0 +1,385 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#include "estc_fanout.h"
+
+#include <string.h>
+
+#include "app_error.h"
+#include "app_util.h"
+#include "app_util_platform.h"
+#include "nrf_log.h"
+
+#include "ble.h"
+#include "ble_conn_state.h"
+#include "ble_gatts.h"
+
+STATIC_ASSERT(IS_POWER_OF_TWO(ESTC_FANOUT_QUEUE_LEN));
+
+#define ESTC_FANOUT_QUEUE_MASK  (ESTC_FANOUT_QUEUE_LEN - 1)
+
+static estc_fanout_link_t * estc_fanout_link_get(estc_fanout_t *fanout, uint16_t conn_handle)
+{
+    uint16_t index = ble_conn_state_conn_idx(conn_handle);
+    if (index >= ESTC_FANOUT_LINK_COUNT)
+    {
+        return NULL;
+    }
+
+    return &fanout->links[index];
+}
+
+static void estc_fanout_run(estc_fanout_t *fanout);
+
+static void estc_fanout_link_reset(estc_fanout_link_t *link, uint16_t conn_handle)
+{
+    link->conn_handle = conn_handle;
+    link->subscribed  = false;
+    link->max_payload = ESTC_TX_DEFAULT_PAYLOAD;
+    link->head        = 0;
+    link->count       = 0;
+    link->delivered   = 0;
+    link->dropped     = 0;
+}
+
+/**@brief Function for sending again after notifications of a link were transmitted.
+ */
+static void estc_fanout_on_tx_complete(void *ctx, uint16_t conn_handle, uint8_t completed)
+{
+    estc_fanout_run((estc_fanout_t *)ctx);
+}
+
+ret_code_t estc_fanout_init(estc_fanout_t *fanout, estc_tx_t *tx, uint16_t value_handle)
+{
+    ASSERT(NULL != fanout)
+    ASSERT(NULL != tx)
+
+    fanout->tx           = tx;
+    fanout->value_handle = value_handle;
+    fanout->cursor       = 0;
+    fanout->running      = false;
+    fanout->rerun        = false;
+
+    for (uint8_t i = 0; i < ESTC_FANOUT_LINK_COUNT; i++)
+    {
+        estc_fanout_link_reset(&fanout->links[i], BLE_CONN_HANDLE_INVALID);
+    }
+
+    return estc_tx_client_register(tx, estc_fanout_on_tx_complete, fanout, &fanout->tx_client);
+}
+
+/**@brief Function for handing the oldest sample of a link to the SoftDevice.
+ *
+ * @return True if a notification was queued.
+ */
+static bool estc_fanout_send_one(estc_fanout_t *fanout, estc_fanout_link_t *link)
+{
+    estc_fanout_sample_t sample;
+    bool found = false;
+
+    if (BLE_CONN_HANDLE_INVALID == link->conn_handle || !link->subscribed)
+    {
+        return false;
+    }
+
+    // Samples stay queued, and keep being replaced by newer ones, until the link has a credit
+    if (0 == estc_tx_credits(fanout->tx, link->conn_handle))
+    {
+        return false;
+    }
+
+    CRITICAL_REGION_ENTER();
+    if (0 != link->count)
+    {
+        sample = link->queue[link->head];
+        link->head = (link->head + 1) & ESTC_FANOUT_QUEUE_MASK;
+        link->count--;
+        found = true;
+    }
+    CRITICAL_REGION_EXIT();
+
+    if (!found)
+    {
+        return false;
+    }
+
+    ret_code_t error_code = estc_tx_notify(fanout->tx, fanout->tx_client, link->conn_handle,
+                                           fanout->value_handle, sample.data, &sample.len);
+    if (NRF_SUCCESS == error_code)
+    {
+        CRITICAL_REGION_ENTER();
+        link->delivered++;
+        CRITICAL_REGION_EXIT();
+        return true;
+    }
+
+    // Another sender took the last credit, the sample goes with the next completion
+    if (NRF_ERROR_RESOURCES != error_code &&
+        NRF_ERROR_INVALID_STATE != error_code &&
+             BLE_ERROR_GATTS_SYS_ATTR_MISSING != error_code &&
+             BLE_ERROR_INVALID_CONN_HANDLE != error_code)
+    {
+        APP_ERROR_CHECK(error_code);
+    }
+
+    // Put the sample back in front, unless newer samples filled the queue meanwhile
+    CRITICAL_REGION_ENTER();
+    if (link->count < ESTC_FANOUT_QUEUE_LEN)
+    {
+        link->head = (link->head - 1) & ESTC_FANOUT_QUEUE_MASK;
+        link->queue[link->head] = sample;
+        link->count++;
+    }
+    else
+    {
+        link->dropped++;
+    }
+    CRITICAL_REGION_EXIT();
+
+    return false;
+}
+
+/**@brief Function for serving the link queues round-robin while TX credits are available.
+ *
+ * @details Called from the producer and from the BLE event handler. A call that finds the
+ *          scheduler running only asks it for another pass, so links are never served twice
+ *          at the same time.
+ */
+static void estc_fanout_run(estc_fanout_t *fanout)
+{
+    bool owner;
+    bool again;
+
+    CRITICAL_REGION_ENTER();
+    owner           = !fanout->running;
+    fanout->running = true;
+    fanout->rerun   = true;
+    CRITICAL_REGION_EXIT();
+
+    if (!owner)
+    {
+        return;
+    }
+
+    do
+    {
+        CRITICAL_REGION_ENTER();
+        fanout->rerun = false;
+        CRITICAL_REGION_EXIT();
+
+        uint8_t first  = fanout->cursor;
+        fanout->cursor = (first + 1) % ESTC_FANOUT_LINK_COUNT;
+
+        // One notification per link per round, until no link can take more
+        bool progress;
+        do
+        {
+            progress = false;
+            for (uint8_t i = 0; i < ESTC_FANOUT_LINK_COUNT; i++)
+            {
+                estc_fanout_link_t *link = &fanout->links[(first + i) % ESTC_FANOUT_LINK_COUNT];
+                if (estc_fanout_send_one(fanout, link))
+                {
+                    progress = true;
+                }
+            }
+        } while (progress);
+
+        CRITICAL_REGION_ENTER();
+        again = fanout->rerun;
+        if (!again)
+        {
+            fanout->running = false;
+        }
+        CRITICAL_REGION_EXIT();
+    } while (again);
+}
+
+void estc_fanout_subscribe_set(estc_fanout_t *fanout, uint16_t conn_handle, bool subscribed)
+{
+    ASSERT(NULL != fanout)
+
+    estc_fanout_link_t *link = estc_fanout_link_get(fanout, conn_handle);
+    if (NULL == link || conn_handle != link->conn_handle)
+    {
+        return;
+    }
+
+    link->subscribed = subscribed;
+    if (!subscribed)
+    {
+        CRITICAL_REGION_ENTER();
+        link->count = 0;
+        CRITICAL_REGION_EXIT();
+    }
+}
+
+void estc_fanout_att_mtu_set(estc_fanout_t *fanout, uint16_t conn_handle, uint16_t att_mtu)
+{
+    ASSERT(NULL != fanout)
+    ASSERT(att_mtu >= BLE_GATT_ATT_MTU_DEFAULT)
+
+    estc_fanout_link_t *link = estc_fanout_link_get(fanout, conn_handle);
+    if (NULL == link || conn_handle != link->conn_handle)
+    {
+        return;
+    }
+
+    link->max_payload = MIN(att_mtu - ESTC_TX_ATT_HEADER_LEN, ESTC_FANOUT_SAMPLE_MAX_LEN);
+}
+
+uint16_t estc_fanout_max_len(estc_fanout_t const *fanout)
+{
+    ASSERT(NULL != fanout)
+    uint16_t max_len = ESTC_FANOUT_SAMPLE_MAX_LEN;
+    bool subscribed = false;
+
+    for (uint8_t i = 0; i < ESTC_FANOUT_LINK_COUNT; i++)
+    {
+        estc_fanout_link_t const *link = &fanout->links[i];
+        if (BLE_CONN_HANDLE_INVALID != link->conn_handle && link->subscribed)
+        {
+            max_len = MIN(max_len, link->max_payload);
+            subscribed = true;
+        }
+    }
+
+    return subscribed ? max_len : ESTC_TX_DEFAULT_PAYLOAD;
+}
+
+ret_code_t estc_fanout_publish(estc_fanout_t *fanout, uint8_t const *data, uint16_t len)
+{
+    ASSERT(NULL != fanout)
+    ASSERT(NULL != data)
+
+    if (0 == len || len > ESTC_FANOUT_SAMPLE_MAX_LEN)
+    {
+        return NRF_ERROR_INVALID_LENGTH;
+    }
+
+    for (uint8_t i = 0; i < ESTC_FANOUT_LINK_COUNT; i++)
+    {
+        estc_fanout_link_t *link = &fanout->links[i];
+        if (BLE_CONN_HANDLE_INVALID == link->conn_handle || !link->subscribed)
+        {
+            continue;
+        }
+        if (len > link->max_payload)
+        {
+            // The ATT MTU of the link is too small for the sample
+            link->dropped++;
+            continue;
+        }
+
+        CRITICAL_REGION_ENTER();
+        if (ESTC_FANOUT_QUEUE_LEN == link->count)
+        {
+            // The link fell behind, the newest sample replaces the oldest
+            link->head = (link->head + 1) & ESTC_FANOUT_QUEUE_MASK;
+            link->count--;
+            link->dropped++;
+        }
+        estc_fanout_sample_t *slot = &link->queue[(link->head + link->count) & ESTC_FANOUT_QUEUE_MASK];
+        memcpy(slot->data, data, len);
+        slot->len = len;
+        link->count++;
+        CRITICAL_REGION_EXIT();
+    }
+
+    estc_fanout_run(fanout);
+    return NRF_SUCCESS;
+}
+
+ret_code_t estc_fanout_stats_get(estc_fanout_t const *fanout, uint16_t conn_handle, estc_fanout_stats_t *stats)
+{
+    ASSERT(NULL != fanout)
+    ASSERT(NULL != stats)
+
+    uint16_t index = ble_conn_state_conn_idx(conn_handle);
+    if (index >= ESTC_FANOUT_LINK_COUNT || conn_handle != fanout->links[index].conn_handle)
+    {
+        return NRF_ERROR_NOT_FOUND;
+    }
+
+    // The producer may count a drop at the same time
+    CRITICAL_REGION_ENTER();
+    stats->delivered = fanout->links[index].delivered;
+    stats->dropped   = fanout->links[index].dropped;
+    CRITICAL_REGION_EXIT();
+
+    return NRF_SUCCESS;
+}
+
+void estc_fanout_stats_log(estc_fanout_t const *fanout, uint16_t conn_handle)
+{
+    ASSERT(NULL != fanout)
+
+    estc_fanout_stats_t stats;
+    if (NRF_SUCCESS != estc_fanout_stats_get(fanout, conn_handle, &stats))
+    {
+        return;
+    }
+
+    NRF_LOG_INFO("Fan-out: %d samples delivered, %d dropped (conn_handle: %d)",
+                 stats.delivered, stats.dropped, conn_handle);
+}
+
+void estc_fanout_on_ble_event(const ble_evt_t *ble_evt, void *ctx)
+{
+    estc_fanout_t *fanout = (estc_fanout_t *)ctx;
+
+    // Every BLE event starts with the handle of its connection
+    estc_fanout_link_t *link = estc_fanout_link_get(fanout, ble_evt->evt.gap_evt.conn_handle);
+    if (NULL == link)
+    {
+        return;
+    }
+
+    switch (ble_evt->header.evt_id)
+    {
+        case BLE_GAP_EVT_CONNECTED:
+            estc_fanout_link_reset(link, ble_evt->evt.gap_evt.conn_handle);
+            break;
+
+        case BLE_GAP_EVT_DISCONNECTED:
+            if (ble_evt->evt.gap_evt.conn_handle == link->conn_handle)
+            {
+                estc_fanout_stats_log(fanout, link->conn_handle);
+                CRITICAL_REGION_ENTER();
+                link->conn_handle = BLE_CONN_HANDLE_INVALID;
+                link->count       = 0;
+                CRITICAL_REGION_EXIT();
+            }
+            break;
+
+        default:
+            break;
+    }
+}
@@ -0,0 +1,168 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#ifndef ESTC_FANOUT_H__
+#define ESTC_FANOUT_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ble.h"
+#include "sdk_errors.h"
+#include "nrf_sdh_ble.h"
+#include "sdk_config.h"
+
+#include "estc_tx.h"
+
+// Largest sample, fits into a notification with the maximum ATT MTU (in bytes)
+#define ESTC_FANOUT_SAMPLE_MAX_LEN  (NRF_SDH_BLE_GATT_MAX_MTU_SIZE - ESTC_TX_ATT_HEADER_LEN)
+
+// Samples waiting per link, the oldest is dropped when a new one does not fit (must be a power of 2)
+#define ESTC_FANOUT_QUEUE_LEN       4
+
+// Number of links a sample is shared across, one queue per connection index
+#define ESTC_FANOUT_LINK_COUNT      NRF_SDH_BLE_TOTAL_LINK_COUNT
+
+/**@brief Sample queued for one link. */
+typedef struct
+{
+    uint8_t  data[ESTC_FANOUT_SAMPLE_MAX_LEN];
+    uint16_t len;
+} estc_fanout_sample_t;
+
+/**@brief Delivery counters of one link, since it connected. */
+typedef struct
+{
+    uint32_t delivered;     /**< Samples accepted by the SoftDevice. */
+    uint32_t dropped;       /**< Samples overwritten before they were sent, or too long for the link. */
+} estc_fanout_stats_t;
+
+/**@brief Fan-out state of one link. */
+typedef struct
+{
+    uint16_t              conn_handle;      /**< Connection of the link, BLE_CONN_HANDLE_INVALID when unused. */
+    bool                  subscribed;       /**< The peer enabled notifications. */
+    uint16_t              max_payload;      /**< Maximum number of bytes in one notification of the link. */
+    uint8_t               head;             /**< Index of the oldest queued sample. */
+    uint8_t               count;            /**< Number of queued samples. */
+    estc_fanout_sample_t  queue[ESTC_FANOUT_QUEUE_LEN];
+    uint32_t              delivered;        /**< Samples accepted by the SoftDevice. */
+    uint32_t              dropped;          /**< Samples overwritten before they were sent, or too long for the link. */
+} estc_fanout_link_t;
+
+/**@brief Fair fan-out of samples to every subscribed central.
+ *
+ * @details Publishing copies a sample into the queue of each subscribed link and never blocks:
+ *          a link that cannot keep up loses its oldest samples, and the loss is counted. The
+ *          queues are served round-robin, one notification per link per round, and the link
+ *          served first rotates with every run, so no central is always last when TX buffers
+ *          run out. Credits come from the estc_tx_t shared by every sender, and queues
+ *          waiting for one are served again when notifications of the link were transmitted.
+ */
+typedef struct
+{
+    estc_tx_t          *tx;                 /**< Notification credits of the links. */
+    uint8_t             tx_client;          /**< Client identifier of the fan-out in tx. */
+    uint16_t            value_handle;       /**< Handle of the notified characteristic value. */
+    uint8_t             cursor;             /**< Link served first in the next run. */
+    bool                running;            /**< The scheduler is sending. */
+    bool                rerun;              /**< Samples or credits arrived while the scheduler was sending. */
+    estc_fanout_link_t  links[ESTC_FANOUT_LINK_COUNT];
+} estc_fanout_t;
+
+/**@brief Function for initializing a fan-out on a notifiable characteristic.
+ *
+ * @param[out] fanout        Fan-out to initialize.
+ * @param[in]  tx            Notification credits to send with.
+ * @param[in]  value_handle  Handle of the characteristic value to notify.
+ */
+ret_code_t estc_fanout_init(estc_fanout_t *fanout, estc_tx_t *tx, uint16_t value_handle);
+
+/**@brief Function for telling the fan-out whether a peer enabled notifications.
+ *
+ * @param[in] fanout       Fan-out instance.
+ * @param[in] conn_handle  Connection of the peer.
+ * @param[in] subscribed   True if notifications are enabled.
+ */
+void estc_fanout_subscribe_set(estc_fanout_t *fanout, uint16_t conn_handle, bool subscribed);
+
+/**@brief Function for setting the notification payload size of a link from the negotiated ATT MTU.
+ *
+ * @param[in] fanout       Fan-out instance.
+ * @param[in] conn_handle  Connection of the link.
+ * @param[in] att_mtu      Effective ATT MTU of the connection.
+ */
+void estc_fanout_att_mtu_set(estc_fanout_t *fanout, uint16_t conn_handle, uint16_t att_mtu);
+
+/**@brief Function for getting the longest sample every subscribed link can take in one notification.
+ *
+ * @param[in] fanout  Fan-out instance.
+ *
+ * @return Smallest notification payload of the subscribed links, ESTC_TX_DEFAULT_PAYLOAD if none.
+ */
+uint16_t estc_fanout_max_len(estc_fanout_t const *fanout);
+
+/**@brief Function for sharing a sample with every subscribed link and sending what the links accept.
+ *
+ * @param[in] fanout  Fan-out instance.
+ * @param[in] data    Sample.
+ * @param[in] len     Length of the sample, at most ESTC_FANOUT_SAMPLE_MAX_LEN.
+ *
+ * @retval NRF_SUCCESS              The sample was queued for every subscribed link.
+ * @retval NRF_ERROR_INVALID_LENGTH The sample is empty or too long.
+ */
+ret_code_t estc_fanout_publish(estc_fanout_t *fanout, uint8_t const *data, uint16_t len);
+
+/**@brief Function for getting the delivered and dropped samples of a link.
+ *
+ * @param[in]  fanout       Fan-out instance.
+ * @param[in]  conn_handle  Connection of the link.
+ * @param[out] stats        Counters of the link.
+ *
+ * @retval NRF_SUCCESS          The counters were copied.
+ * @retval NRF_ERROR_NOT_FOUND  The connection is not a link of the fan-out.
+ */
+ret_code_t estc_fanout_stats_get(estc_fanout_t const *fanout, uint16_t conn_handle, estc_fanout_stats_t *stats);
+
+/**@brief Function for logging the delivered and dropped samples of a link.
+ *
+ * @param[in] fanout       Fan-out instance.
+ * @param[in] conn_handle  Connection of the link.
+ */
+void estc_fanout_stats_log(estc_fanout_t const *fanout, uint16_t conn_handle);
+
+/**@brief Function for handling BLE events relevant to the fan-out.
+ *
+ * @param[in] ble_evt  Bluetooth stack event.
+ * @param[in] ctx      Fan-out instance.
+ */
+void estc_fanout_on_ble_event(const ble_evt_t *ble_evt, void *ctx);
+
+#endif /* ESTC_FANOUT_H__ */
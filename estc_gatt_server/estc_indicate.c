@@ -0,0 +1,332 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#include "estc_indicate.h"
+
+#include <string.h>
+
+#include "app_error.h"
+#include "app_timer.h"
+#include "app_util.h"
+#include "app_util_platform.h"
+#include "nrf_log.h"
+
+#include "ble.h"
+#include "ble_conn_state.h"
+#include "ble_gatts.h"
+
+STATIC_ASSERT(IS_POWER_OF_TWO(ESTC_INDICATE_QUEUE_LEN));
+
+#define ESTC_INDICATE_QUEUE_MASK    (ESTC_INDICATE_QUEUE_LEN - 1)
+
+static estc_indicate_link_t * estc_indicate_link_get(estc_indicate_t *indicate, uint16_t conn_handle)
+{
+    uint16_t index = ble_conn_state_conn_idx(conn_handle);
+    if (index >= ESTC_INDICATE_LINK_COUNT)
+    {
+        return NULL;
+    }
+
+    return &indicate->links[index];
+}
+
+static void estc_indicate_link_reset(estc_indicate_link_t *link, uint16_t conn_handle)
+{
+    link->conn_handle = conn_handle;
+    link->subscribed  = false;
+    link->outstanding = false;
+    link->head        = 0;
+    link->count       = 0;
+    memset(&link->stats, 0, sizeof(link->stats));
+}
+
+ret_code_t estc_indicate_init(estc_indicate_t *indicate, uint16_t value_handle)
+{
+    ASSERT(NULL != indicate)
+
+    indicate->value_handle = value_handle;
+    for (uint8_t i = 0; i < ESTC_INDICATE_LINK_COUNT; i++)
+    {
+        estc_indicate_link_reset(&indicate->links[i], BLE_CONN_HANDLE_INVALID);
+    }
+
+    return NRF_SUCCESS;
+}
+
+/**@brief Function for sending the item at the head of the queue if no indication is in flight.
+ */
+static void estc_indicate_kick(estc_indicate_t *indicate, estc_indicate_link_t *link)
+{
+    estc_indicate_item_t item;
+    bool send = false;
+
+    CRITICAL_REGION_ENTER();
+    if (BLE_CONN_HANDLE_INVALID != link->conn_handle && link->subscribed &&
+        !link->outstanding && 0 != link->count)
+    {
+        item = link->queue[link->head];
+        link->outstanding = true;
+        send = true;
+    }
+    CRITICAL_REGION_EXIT();
+
+    if (!send)
+    {
+        return;
+    }
+
+    ble_gatts_hvx_params_t hvx_params = { 0 };
+    hvx_params.handle = indicate->value_handle;
+    hvx_params.type   = BLE_GATT_HVX_INDICATION;
+    hvx_params.p_len  = &item.len;
+    hvx_params.p_data = item.data;
+
+    link->sent_ticks = app_timer_cnt_get();
+    ret_code_t error_code = sd_ble_gatts_hvx(link->conn_handle, &hvx_params);
+    if (NRF_SUCCESS == error_code)
+    {
+        return;
+    }
+
+    // The item stays queued and is sent with the next confirmation or subscription
+    link->outstanding = false;
+    if (NRF_ERROR_BUSY != error_code &&
+        NRF_ERROR_INVALID_STATE != error_code &&
+        BLE_ERROR_GATTS_SYS_ATTR_MISSING != error_code &&
+        BLE_ERROR_INVALID_CONN_HANDLE != error_code)
+    {
+        APP_ERROR_CHECK(error_code);
+    }
+}
+
+void estc_indicate_subscribe_set(estc_indicate_t *indicate, uint16_t conn_handle, bool subscribed)
+{
+    ASSERT(NULL != indicate)
+
+    estc_indicate_link_t *link = estc_indicate_link_get(indicate, conn_handle);
+    if (NULL == link || conn_handle != link->conn_handle)
+    {
+        return;
+    }
+
+    // Queued items are kept, the peer gets them when it subscribes again
+    link->subscribed = subscribed;
+    estc_indicate_kick(indicate, link);
+}
+
+/**@brief Function for adding an item to the queue of a link.
+ *
+ * @return NRF_SUCCESS if the item was queued or merged, NRF_ERROR_NO_MEM if the queue is full.
+ */
+static ret_code_t estc_indicate_enqueue(estc_indicate_link_t *link, uint8_t const *data, uint16_t len, uint8_t key)
+{
+    ret_code_t error_code = NRF_SUCCESS;
+    estc_indicate_item_t *slot = NULL;
+
+    CRITICAL_REGION_ENTER();
+    if (ESTC_INDICATE_KEY_NONE != key)
+    {
+        // The item in flight was already sent and cannot be replaced
+        for (uint8_t i = link->outstanding ? 1 : 0; i < link->count; i++)
+        {
+            estc_indicate_item_t *item = &link->queue[(link->head + i) & ESTC_INDICATE_QUEUE_MASK];
+            if (key == item->key)
+            {
+                slot = item;
+                link->stats.merged++;
+                break;
+            }
+        }
+    }
+    if (NULL == slot && link->count < ESTC_INDICATE_QUEUE_LEN)
+    {
+        slot = &link->queue[(link->head + link->count) & ESTC_INDICATE_QUEUE_MASK];
+        link->count++;
+        link->stats.depth_max = MAX(link->stats.depth_max, link->count);
+    }
+    if (NULL != slot)
+    {
+        memcpy(slot->data, data, len);
+        slot->len = len;
+        slot->key = key;
+    }
+    else
+    {
+        link->stats.rejected++;
+        error_code = NRF_ERROR_NO_MEM;
+    }
+    CRITICAL_REGION_EXIT();
+
+    return error_code;
+}
+
+ret_code_t estc_indicate_send(estc_indicate_t *indicate, uint8_t const *data, uint16_t len, uint8_t key)
+{
+    ASSERT(NULL != indicate)
+    ASSERT(NULL != data)
+    ret_code_t result = NRF_ERROR_INVALID_STATE;
+
+    if (0 == len || len > ESTC_INDICATE_MAX_LEN)
+    {
+        return NRF_ERROR_INVALID_LENGTH;
+    }
+
+    for (uint8_t i = 0; i < ESTC_INDICATE_LINK_COUNT; i++)
+    {
+        estc_indicate_link_t *link = &indicate->links[i];
+        if (BLE_CONN_HANDLE_INVALID == link->conn_handle || !link->subscribed)
+        {
+            continue;
+        }
+
+        ret_code_t error_code = estc_indicate_enqueue(link, data, len, key);
+        if (NRF_ERROR_NO_MEM != result)
+        {
+            result = error_code;
+        }
+        estc_indicate_kick(indicate, link);
+    }
+
+    return result;
+}
+
+uint8_t estc_indicate_depth(estc_indicate_t const *indicate, uint16_t conn_handle)
+{
+    ASSERT(NULL != indicate)
+
+    uint16_t index = ble_conn_state_conn_idx(conn_handle);
+    if (index >= ESTC_INDICATE_LINK_COUNT)
+    {
+        return 0;
+    }
+
+    return indicate->links[index].count;
+}
+
+void estc_indicate_stats_log(estc_indicate_t const *indicate, uint16_t conn_handle)
+{
+    ASSERT(NULL != indicate)
+
+    uint16_t index = ble_conn_state_conn_idx(conn_handle);
+    if (index >= ESTC_INDICATE_LINK_COUNT)
+    {
+        return;
+    }
+
+    NRF_LOG_INFO("Indications: %d confirmed, %d merged, %d rejected, %d timed out (conn_handle: %d)",
+                 indicate->links[index].stats.confirmed, indicate->links[index].stats.merged,
+                 indicate->links[index].stats.rejected, indicate->links[index].stats.timeouts, conn_handle);
+    NRF_LOG_INFO("Indications: confirmed in %d ms on average, %d ms at most, queue depth at most %d",
+                 indicate->links[index].stats.latency_sum_ms / MAX(indicate->links[index].stats.confirmed, 1),
+                 indicate->links[index].stats.latency_max_ms, indicate->links[index].stats.depth_max);
+}
+
+/**@brief Function for handling the confirmation of the indication in flight.
+ */
+static void estc_indicate_on_hvc(estc_indicate_t *indicate, estc_indicate_link_t *link)
+{
+    if (!link->outstanding)
+    {
+        return;
+    }
+
+    uint32_t ticks = app_timer_cnt_diff_compute(app_timer_cnt_get(), link->sent_ticks);
+    // APP_TIMER_CLOCK_FREQ is the RTC input clock, the counter runs behind the prescaler
+    uint32_t latency_ms = (uint32_t)(((uint64_t)ticks * 1000) / APP_TIMER_TICKS(1000));
+
+    CRITICAL_REGION_ENTER();
+    link->head = (link->head + 1) & ESTC_INDICATE_QUEUE_MASK;
+    link->count--;
+    link->outstanding = false;
+    CRITICAL_REGION_EXIT();
+
+    link->stats.confirmed++;
+    link->stats.latency_last_ms = latency_ms;
+    link->stats.latency_max_ms  = MAX(link->stats.latency_max_ms, latency_ms);
+    link->stats.latency_sum_ms += latency_ms;
+
+    estc_indicate_kick(indicate, link);
+}
+
+void estc_indicate_on_ble_event(const ble_evt_t *ble_evt, void *ctx)
+{
+    estc_indicate_t *indicate = (estc_indicate_t *)ctx;
+
+    // Every BLE event starts with the handle of its connection
+    estc_indicate_link_t *link = estc_indicate_link_get(indicate, ble_evt->evt.gap_evt.conn_handle);
+    if (NULL == link)
+    {
+        return;
+    }
+
+    switch (ble_evt->header.evt_id)
+    {
+        case BLE_GAP_EVT_CONNECTED:
+            estc_indicate_link_reset(link, ble_evt->evt.gap_evt.conn_handle);
+            break;
+
+        case BLE_GAP_EVT_DISCONNECTED:
+            if (ble_evt->evt.gap_evt.conn_handle == link->conn_handle)
+            {
+                if (0 != link->count)
+                {
+                    NRF_LOG_WARNING("%d indications not confirmed before disconnect", link->count);
+                }
+                estc_indicate_stats_log(indicate, link->conn_handle);
+                CRITICAL_REGION_ENTER();
+                link->conn_handle = BLE_CONN_HANDLE_INVALID;
+                link->outstanding = false;
+                link->count       = 0;
+                CRITICAL_REGION_EXIT();
+            }
+            break;
+
+        case BLE_GATTS_EVT_HVC:
+            if (ble_evt->evt.gatts_evt.conn_handle == link->conn_handle &&
+                ble_evt->evt.gatts_evt.params.hvc.handle == indicate->value_handle)
+            {
+                estc_indicate_on_hvc(indicate, link);
+            }
+            break;
+
+        case BLE_GATTS_EVT_TIMEOUT:
+            if (ble_evt->evt.gatts_evt.conn_handle == link->conn_handle && link->outstanding)
+            {
+                // No ATT traffic is possible on the link anymore, the application disconnects it
+                link->stats.timeouts++;
+                NRF_LOG_WARNING("Indication not confirmed in time, %d queued (conn_handle: %d)",
+                                link->count, link->conn_handle);
+            }
+            break;
+
+        default:
+            break;
+    }
+}
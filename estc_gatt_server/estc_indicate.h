@@ -0,0 +1,154 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#ifndef ESTC_INDICATE_H__
+#define ESTC_INDICATE_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ble.h"
+#include "sdk_errors.h"
+#include "nrf_sdh_ble.h"
+#include "sdk_config.h"
+
+#include "estc_tx.h"
+
+// Largest indication, fits into one packet with the default ATT MTU on every link (in bytes)
+#define ESTC_INDICATE_MAX_LEN       ESTC_TX_DEFAULT_PAYLOAD
+
+// Indications waiting per link behind the one in flight (must be a power of 2)
+#define ESTC_INDICATE_QUEUE_LEN     8
+
+// Number of links indications are sent to, one queue per connection index
+#define ESTC_INDICATE_LINK_COUNT    NRF_SDH_BLE_TOTAL_LINK_COUNT
+
+// Merge key of items that are never merged
+#define ESTC_INDICATE_KEY_NONE      0
+
+/**@brief Indication waiting for its turn. */
+typedef struct
+{
+    uint8_t  data[ESTC_INDICATE_MAX_LEN];
+    uint16_t len;
+    uint8_t  key;                           /**< Queued items with the same key are replaced, see ESTC_INDICATE_KEY_NONE. */
+} estc_indicate_item_t;
+
+/**@brief Delivery statistics of one link. */
+typedef struct
+{
+    uint32_t confirmed;                     /**< Indications confirmed by the peer. */
+    uint32_t merged;                        /**< Items that replaced a queued item with the same key. */
+    uint32_t rejected;                      /**< Items refused because the queue was full. */
+    uint32_t timeouts;                      /**< Confirmations that never came, see BLE_GATTS_EVT_TIMEOUT. */
+    uint32_t latency_last_ms;               /**< Time from sending to confirmation of the last indication. */
+    uint32_t latency_max_ms;                /**< Longest confirmation time. */
+    uint32_t latency_sum_ms;                /**< Sum of all confirmation times, for the average. */
+    uint8_t  depth_max;                     /**< Most items that were queued at once, including the one in flight. */
+} estc_indicate_stats_t;
+
+/**@brief Indication state of one link. */
+typedef struct
+{
+    uint16_t              conn_handle;      /**< Connection of the link, BLE_CONN_HANDLE_INVALID when unused. */
+    bool                  subscribed;       /**< The peer enabled indications. */
+    bool                  outstanding;      /**< The item at the head of the queue waits for its confirmation. */
+    uint8_t               head;             /**< Index of the oldest queued item. */
+    uint8_t               count;            /**< Number of queued items, including the one in flight. */
+    estc_indicate_item_t  queue[ESTC_INDICATE_QUEUE_LEN];
+    uint32_t              sent_ticks;       /**< RTC counter when the item in flight was sent. */
+    estc_indicate_stats_t stats;
+} estc_indicate_link_t;
+
+/**@brief Reliable indication pipeline.
+ *
+ * @details ATT allows one unconfirmed indication per connection. Each link keeps a bounded
+ *          queue behind it, and the next item is sent when BLE_GATTS_EVT_HVC confirms the
+ *          previous one. Items are only removed when confirmed, so nothing is dropped while the
+ *          link is up. A new item with the key of a queued one replaces it instead of taking
+ *          another slot, so the peer sees the latest state of an alarm without the backlog.
+ */
+typedef struct
+{
+    uint16_t              value_handle;     /**< Handle of the indicated characteristic value. */
+    estc_indicate_link_t  links[ESTC_INDICATE_LINK_COUNT];
+} estc_indicate_t;
+
+/**@brief Function for initializing the pipeline on an indicatable characteristic.
+ *
+ * @param[out] indicate      Pipeline to initialize.
+ * @param[in]  value_handle  Handle of the characteristic value to indicate.
+ */
+ret_code_t estc_indicate_init(estc_indicate_t *indicate, uint16_t value_handle);
+
+/**@brief Function for telling the pipeline whether a peer enabled indications.
+ *
+ * @param[in] indicate     Pipeline instance.
+ * @param[in] conn_handle  Connection of the peer.
+ * @param[in] subscribed   True if indications are enabled.
+ */
+void estc_indicate_subscribe_set(estc_indicate_t *indicate, uint16_t conn_handle, bool subscribed);
+
+/**@brief Function for queueing an indication for every subscribed link.
+ *
+ * @param[in] indicate  Pipeline instance.
+ * @param[in] data      Value to indicate.
+ * @param[in] len       Length of the value, at most ESTC_INDICATE_MAX_LEN.
+ * @param[in] key       Merge key, ESTC_INDICATE_KEY_NONE to always queue.
+ *
+ * @retval NRF_SUCCESS              The item was queued for every subscribed link.
+ * @retval NRF_ERROR_NO_MEM         The queue of at least one link was full.
+ * @retval NRF_ERROR_INVALID_STATE  No link is subscribed.
+ * @retval NRF_ERROR_INVALID_LENGTH The value is empty or too long.
+ */
+ret_code_t estc_indicate_send(estc_indicate_t *indicate, uint8_t const *data, uint16_t len, uint8_t key);
+
+/**@brief Function for getting the number of items queued on a link, including the one in flight.
+ *
+ * @param[in] indicate     Pipeline instance.
+ * @param[in] conn_handle  Connection of the link.
+ */
+uint8_t estc_indicate_depth(estc_indicate_t const *indicate, uint16_t conn_handle);
+
+/**@brief Function for logging the statistics of a link.
+ *
+ * @param[in] indicate     Pipeline instance.
+ * @param[in] conn_handle  Connection of the link.
+ */
+void estc_indicate_stats_log(estc_indicate_t const *indicate, uint16_t conn_handle);
+
+/**@brief Function for handling BLE events relevant to the pipeline.
+ *
+ * @param[in] ble_evt  Bluetooth stack event.
+ * @param[in] ctx      Pipeline instance.
+ */
+void estc_indicate_on_ble_event(const ble_evt_t *ble_evt, void *ctx);
+
+#endif /* ESTC_INDICATE_H__ */
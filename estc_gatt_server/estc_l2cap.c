@@ -0,0 +1,329 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#include "estc_l2cap.h"
+
+#include <string.h>
+
+#include "app_error.h"
+#include "app_timer.h"
+#include "app_util.h"
+#include "nrf_log.h"
+
+#include "ble.h"
+#include "ble_l2cap.h"
+
+static void estc_l2cap_reset(estc_l2cap_t *l2cap)
+{
+    l2cap->conn_handle = BLE_CONN_HANDLE_INVALID;
+    l2cap->cid         = BLE_L2CAP_CID_INVALID;
+    l2cap->tx_mtu      = BLE_L2CAP_MTU_MIN;
+    l2cap->connected   = false;
+
+    for (uint8_t i = 0; i < ESTC_L2CAP_RX_SDU_COUNT; i++)
+    {
+        l2cap->rx_pool[i].busy = false;
+    }
+    for (uint8_t i = 0; i < ESTC_L2CAP_TX_SDU_COUNT; i++)
+    {
+        l2cap->tx_pool[i].busy = false;
+    }
+}
+
+ret_code_t estc_l2cap_init(estc_l2cap_t *l2cap, estc_l2cap_rx_handler_t rx_handler, estc_l2cap_tx_handler_t tx_handler)
+{
+    ASSERT(NULL != l2cap)
+
+    l2cap->rx_handler = rx_handler;
+    l2cap->tx_handler = tx_handler;
+    estc_l2cap_reset(l2cap);
+
+    return NRF_SUCCESS;
+}
+
+/**@brief Function for finding the pool buffer the SoftDevice returned.
+ */
+static estc_l2cap_sdu_t * estc_l2cap_sdu_find(estc_l2cap_sdu_t *pool, uint8_t count, uint8_t const *p_data)
+{
+    for (uint8_t i = 0; i < count; i++)
+    {
+        if (pool[i].data == p_data)
+        {
+            return &pool[i];
+        }
+    }
+
+    return NULL;
+}
+
+/**@brief Function for handing a free RX buffer to the SoftDevice.
+ */
+static void estc_l2cap_rx_give(estc_l2cap_t *l2cap, estc_l2cap_sdu_t *sdu)
+{
+    ble_data_t sdu_buf = { .p_data = sdu->data, .len = ESTC_L2CAP_SDU_LEN };
+
+    sdu->busy = true;
+    ret_code_t error_code = sd_ble_l2cap_ch_rx(l2cap->conn_handle, l2cap->cid, &sdu_buf);
+    if (NRF_SUCCESS != error_code)
+    {
+        // The channel is being released, its SDU buffers are returned anyway
+        sdu->busy = false;
+    }
+}
+
+uint32_t estc_l2cap_send(estc_l2cap_t *l2cap, uint8_t const *data, uint32_t len)
+{
+    ASSERT(NULL != l2cap)
+    ASSERT(NULL != data)
+    uint32_t accepted = 0;
+
+    if (!l2cap->connected)
+    {
+        return 0;
+    }
+
+    uint16_t max_sdu = MIN(l2cap->tx_mtu, ESTC_L2CAP_SDU_LEN);
+    for (uint8_t i = 0; i < ESTC_L2CAP_TX_SDU_COUNT && accepted < len; i++)
+    {
+        estc_l2cap_sdu_t *sdu = &l2cap->tx_pool[i];
+        if (sdu->busy)
+        {
+            continue;
+        }
+
+        uint16_t sdu_len = (uint16_t)MIN(len - accepted, max_sdu);
+        memcpy(sdu->data, &data[accepted], sdu_len);
+        ble_data_t sdu_buf = { .p_data = sdu->data, .len = sdu_len };
+
+        // Owned by the SoftDevice from here, BLE_L2CAP_EVT_CH_TX may arrive before the call returns
+        sdu->busy = true;
+        ret_code_t error_code = sd_ble_l2cap_ch_tx(l2cap->conn_handle, l2cap->cid, &sdu_buf);
+        if (NRF_SUCCESS != error_code)
+        {
+            sdu->busy = false;
+            if (NRF_ERROR_RESOURCES != error_code && NRF_ERROR_INVALID_STATE != error_code)
+            {
+                APP_ERROR_CHECK(error_code);
+            }
+            break;
+        }
+
+        if (0 == l2cap->bytes_sent && 0 == accepted)
+        {
+            l2cap->start_ticks = app_timer_cnt_get();
+        }
+        accepted += sdu_len;
+    }
+
+    return accepted;
+}
+
+/**@brief Function for getting the time from the first queued to the last transmitted SDU.
+ */
+static uint32_t estc_l2cap_elapsed_ms(estc_l2cap_t const *l2cap)
+{
+    uint32_t ticks = app_timer_cnt_diff_compute(l2cap->end_ticks, l2cap->start_ticks);
+    // APP_TIMER_CLOCK_FREQ is the RTC input clock, the counter runs behind the prescaler
+    return (uint32_t)(((uint64_t)ticks * 1000) / APP_TIMER_TICKS(1000));
+}
+
+void estc_l2cap_stats_log(estc_l2cap_t const *l2cap)
+{
+    ASSERT(NULL != l2cap)
+
+    NRF_LOG_INFO("L2CAP: %d bytes in %d SDUs, %d ms, %d bytes/s",
+                 l2cap->bytes_sent, l2cap->sdus_sent, estc_l2cap_elapsed_ms(l2cap),
+                 (uint32_t)(((uint64_t)l2cap->bytes_sent * 1000) / MAX(estc_l2cap_elapsed_ms(l2cap), 1)));
+}
+
+/**@brief Function for answering a channel request of the central.
+ */
+static void estc_l2cap_on_setup_request(estc_l2cap_t *l2cap, ble_l2cap_evt_t const *l2cap_evt)
+{
+    ble_l2cap_ch_setup_params_t params = { 0 };
+    uint16_t cid = l2cap_evt->local_cid;
+
+    if (ESTC_L2CAP_PSM != l2cap_evt->params.ch_setup_request.le_psm)
+    {
+        params.status = BLE_L2CAP_CH_STATUS_CODE_LE_PSM_NOT_SUPPORTED;
+    }
+    else if (BLE_CONN_HANDLE_INVALID != l2cap->conn_handle)
+    {
+        // The pool serves one channel
+        params.status = BLE_L2CAP_CH_STATUS_CODE_NO_RESOURCES;
+    }
+    else
+    {
+        params.status                   = BLE_L2CAP_CH_STATUS_CODE_SUCCESS;
+        params.rx_params.rx_mtu         = ESTC_L2CAP_SDU_LEN;
+        params.rx_params.rx_mps         = ESTC_L2CAP_MPS;
+        params.rx_params.sdu_buf.p_data = l2cap->rx_pool[0].data;
+        params.rx_params.sdu_buf.len    = ESTC_L2CAP_SDU_LEN;
+    }
+
+    ret_code_t error_code = sd_ble_l2cap_ch_setup(l2cap_evt->conn_handle, &cid, &params);
+    if (NRF_SUCCESS != error_code)
+    {
+        NRF_LOG_WARNING("L2CAP channel setup failed, error 0x%x", error_code);
+        return;
+    }
+    if (BLE_L2CAP_CH_STATUS_CODE_SUCCESS == params.status)
+    {
+        l2cap->conn_handle      = l2cap_evt->conn_handle;
+        l2cap->cid              = cid;
+        l2cap->rx_pool[0].busy  = true;
+    }
+}
+
+static void estc_l2cap_on_setup(estc_l2cap_t *l2cap, ble_l2cap_evt_t const *l2cap_evt)
+{
+    l2cap->tx_mtu           = l2cap_evt->params.ch_setup.tx_params.tx_mtu;
+    l2cap->credits_received = l2cap_evt->params.ch_setup.tx_params.credits;
+    l2cap->connected        = true;
+    l2cap->sdus_sent        = 0;
+    l2cap->bytes_sent       = 0;
+    l2cap->bytes_received   = 0;
+    l2cap->start_ticks      = app_timer_cnt_get();
+    l2cap->end_ticks        = l2cap->start_ticks;
+
+    // Let the peer send as many PDUs as the SoftDevice can buffer
+    uint16_t credits = 0;
+    ret_code_t error_code = sd_ble_l2cap_ch_flow_control(l2cap->conn_handle, l2cap->cid, ESTC_L2CAP_RX_CREDITS, &credits);
+    APP_ERROR_CHECK(error_code);
+
+    for (uint8_t i = 0; i < ESTC_L2CAP_RX_SDU_COUNT; i++)
+    {
+        if (!l2cap->rx_pool[i].busy)
+        {
+            estc_l2cap_rx_give(l2cap, &l2cap->rx_pool[i]);
+        }
+    }
+
+    NRF_LOG_INFO("L2CAP channel 0x%04x set up, peer MTU %d, %d credits (conn_handle: %d)",
+                 l2cap->cid, l2cap->tx_mtu, l2cap->credits_received, l2cap->conn_handle);
+
+    if (NULL != l2cap->tx_handler)
+    {
+        l2cap->tx_handler(l2cap);
+    }
+}
+
+void estc_l2cap_on_ble_event(const ble_evt_t *ble_evt, void *ctx)
+{
+    estc_l2cap_t *l2cap = (estc_l2cap_t *)ctx;
+    ble_l2cap_evt_t const *l2cap_evt = &ble_evt->evt.l2cap_evt;
+    estc_l2cap_sdu_t *sdu;
+
+    if (BLE_L2CAP_EVT_CH_SETUP_REQUEST == ble_evt->header.evt_id)
+    {
+        estc_l2cap_on_setup_request(l2cap, l2cap_evt);
+        return;
+    }
+
+    if (BLE_GAP_EVT_DISCONNECTED == ble_evt->header.evt_id)
+    {
+        if (ble_evt->evt.gap_evt.conn_handle == l2cap->conn_handle)
+        {
+            estc_l2cap_reset(l2cap);
+        }
+        return;
+    }
+
+    // Every L2CAP event starts with the handle of its connection and the channel
+    if (l2cap_evt->conn_handle != l2cap->conn_handle || l2cap_evt->local_cid != l2cap->cid)
+    {
+        return;
+    }
+
+    switch (ble_evt->header.evt_id)
+    {
+        case BLE_L2CAP_EVT_CH_SETUP:
+            estc_l2cap_on_setup(l2cap, l2cap_evt);
+            break;
+
+        case BLE_L2CAP_EVT_CH_SETUP_REFUSED:
+            estc_l2cap_reset(l2cap);
+            break;
+
+        case BLE_L2CAP_EVT_CH_RELEASED:
+            estc_l2cap_stats_log(l2cap);
+            estc_l2cap_reset(l2cap);
+            break;
+
+        case BLE_L2CAP_EVT_CH_SDU_BUF_RELEASED:
+            sdu = estc_l2cap_sdu_find(l2cap->rx_pool, ESTC_L2CAP_RX_SDU_COUNT,
+                                      l2cap_evt->params.ch_sdu_buf_released.sdu_buf.p_data);
+            if (NULL == sdu)
+            {
+                sdu = estc_l2cap_sdu_find(l2cap->tx_pool, ESTC_L2CAP_TX_SDU_COUNT,
+                                          l2cap_evt->params.ch_sdu_buf_released.sdu_buf.p_data);
+            }
+            if (NULL != sdu)
+            {
+                sdu->busy = false;
+            }
+            break;
+
+        case BLE_L2CAP_EVT_CH_CREDIT:
+            l2cap->credits_received += l2cap_evt->params.credit.credits;
+            break;
+
+        case BLE_L2CAP_EVT_CH_RX:
+            l2cap->bytes_received += l2cap_evt->params.rx.sdu_len;
+            if (NULL != l2cap->rx_handler)
+            {
+                l2cap->rx_handler(l2cap, l2cap_evt->params.rx.sdu_buf.p_data, l2cap_evt->params.rx.sdu_len);
+            }
+            sdu = estc_l2cap_sdu_find(l2cap->rx_pool, ESTC_L2CAP_RX_SDU_COUNT, l2cap_evt->params.rx.sdu_buf.p_data);
+            if (NULL != sdu)
+            {
+                estc_l2cap_rx_give(l2cap, sdu);
+            }
+            break;
+
+        case BLE_L2CAP_EVT_CH_TX:
+            sdu = estc_l2cap_sdu_find(l2cap->tx_pool, ESTC_L2CAP_TX_SDU_COUNT, l2cap_evt->params.tx.sdu_buf.p_data);
+            if (NULL != sdu)
+            {
+                sdu->busy = false;
+            }
+            l2cap->sdus_sent++;
+            l2cap->bytes_sent += l2cap_evt->params.tx.sdu_buf.len;
+            l2cap->end_ticks   = app_timer_cnt_get();
+            if (NULL != l2cap->tx_handler)
+            {
+                l2cap->tx_handler(l2cap);
+            }
+            break;
+
+        default:
+            break;
+    }
+}
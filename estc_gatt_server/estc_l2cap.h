@@ -0,0 +1,129 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#ifndef ESTC_L2CAP_H__
+#define ESTC_L2CAP_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ble.h"
+#include "ble_l2cap.h"
+#include "sdk_errors.h"
+
+// LE Protocol/Service Multiplexer of the channel, from the dynamic range
+#define ESTC_L2CAP_PSM              0x0080
+
+// Largest SDU in either direction (in bytes)
+#define ESTC_L2CAP_SDU_LEN          512
+
+// Largest PDU payload, one PDU fills an LL packet with the maximum data length (in bytes)
+#define ESTC_L2CAP_MPS              247
+
+// PDUs the SoftDevice buffers per connection in each direction, see BLE_CONN_CFG_L2CAP
+#define ESTC_L2CAP_RX_QUEUE_SIZE    4
+#define ESTC_L2CAP_TX_QUEUE_SIZE    4
+
+// Credits the SoftDevice keeps granted to the peer, one per PDU it can buffer
+#define ESTC_L2CAP_RX_CREDITS       ESTC_L2CAP_RX_QUEUE_SIZE
+
+// SDU buffers of the statically allocated pool
+#define ESTC_L2CAP_RX_SDU_COUNT     2
+#define ESTC_L2CAP_TX_SDU_COUNT     3
+
+typedef struct estc_l2cap_s estc_l2cap_t;
+
+/**@brief Handler for an SDU received from the peer. The data is only valid during the call. */
+typedef void (*estc_l2cap_rx_handler_t)(estc_l2cap_t *l2cap, uint8_t const *data, uint16_t len);
+
+/**@brief Handler called when the channel opened or a TX buffer became free. */
+typedef void (*estc_l2cap_tx_handler_t)(estc_l2cap_t *l2cap);
+
+/**@brief SDU buffer of the pool. */
+typedef struct
+{
+    uint8_t data[ESTC_L2CAP_SDU_LEN];
+    bool    busy;                               /**< The buffer is owned by the SoftDevice. */
+} estc_l2cap_sdu_t;
+
+/**@brief LE credit-based L2CAP channel endpoint.
+ *
+ * @details Accepts one channel on ESTC_L2CAP_PSM at a time, opened by a central. Data written
+ *          to the endpoint is cut into SDUs of at most the peer's MTU; the SoftDevice segments
+ *          the SDUs into PDUs and spends the credits the peer grants. SDU buffers come from a
+ *          static pool and are owned by the SoftDevice until their TX or RX event.
+ */
+struct estc_l2cap_s
+{
+    estc_l2cap_rx_handler_t rx_handler;         /**< Handler for received SDUs, may be NULL. */
+    estc_l2cap_tx_handler_t tx_handler;         /**< Handler for TX space, may be NULL. */
+    uint16_t                conn_handle;        /**< Connection of the channel, BLE_CONN_HANDLE_INVALID when closed. */
+    uint16_t                cid;                /**< Local channel identifier. */
+    uint16_t                tx_mtu;             /**< Largest SDU the peer accepts. */
+    bool                    connected;          /**< The channel is set up. */
+    estc_l2cap_sdu_t        rx_pool[ESTC_L2CAP_RX_SDU_COUNT];
+    estc_l2cap_sdu_t        tx_pool[ESTC_L2CAP_TX_SDU_COUNT];
+    uint32_t                credits_received;   /**< Credits granted by the peer. */
+    uint32_t                sdus_sent;          /**< SDUs transmitted to the peer. */
+    uint32_t                bytes_sent;         /**< SDU bytes transmitted to the peer. */
+    uint32_t                bytes_received;     /**< SDU bytes received from the peer. */
+    uint32_t                start_ticks;        /**< RTC counter when the first SDU was queued. */
+    uint32_t                end_ticks;          /**< RTC counter when the last SDU was transmitted. */
+};
+
+/**@brief Function for initializing the endpoint.
+ *
+ * @param[out] l2cap       Endpoint to initialize.
+ * @param[in]  rx_handler  Handler for received SDUs, may be NULL.
+ * @param[in]  tx_handler  Handler for TX space, may be NULL.
+ */
+ret_code_t estc_l2cap_init(estc_l2cap_t *l2cap, estc_l2cap_rx_handler_t rx_handler, estc_l2cap_tx_handler_t tx_handler);
+
+/**@brief Function for sending data over the channel.
+ *
+ * @return Number of bytes accepted. Less than @p len if no SDU buffer is free, the rest can be
+ *         sent after the TX handler was called.
+ */
+uint32_t estc_l2cap_send(estc_l2cap_t *l2cap, uint8_t const *data, uint32_t len);
+
+/**@brief Function for logging the throughput of the channel since it was set up.
+ *
+ * @param[in] l2cap  Endpoint.
+ */
+void estc_l2cap_stats_log(estc_l2cap_t const *l2cap);
+
+/**@brief Function for handling BLE events relevant to the endpoint.
+ *
+ * @param[in] ble_evt  Bluetooth stack event.
+ * @param[in] ctx      Endpoint.
+ */
+void estc_l2cap_on_ble_event(const ble_evt_t *ble_evt, void *ctx);
+
+#endif /* ESTC_L2CAP_H__ */
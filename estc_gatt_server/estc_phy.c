@@ -0,0 +1,213 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#include "estc_phy.h"
+
+#include "app_error.h"
+#include "nrf_log.h"
+
+#include "ble.h"
+#include "ble_gap.h"
+#include "ble_hci.h"
+
+static char const * estc_phy_name(uint8_t phy)
+{
+    switch (phy)
+    {
+        case BLE_GAP_PHY_1MBPS:
+            return "1M";
+        case BLE_GAP_PHY_2MBPS:
+            return "2M";
+        case BLE_GAP_PHY_CODED:
+            return "Coded";
+        default:
+            return "Auto";
+    }
+}
+
+/**@brief Function for getting the PHY the policy wants for the connection.
+ */
+static uint8_t estc_phy_preferred(estc_phy_t const *phy)
+{
+    if (phy->degraded)
+    {
+        return BLE_GAP_PHY_1MBPS;
+    }
+
+    return phy->bulk ? BLE_GAP_PHY_2MBPS : BLE_GAP_PHY_AUTO;
+}
+
+static void estc_phy_request(estc_phy_t *phy)
+{
+    if (BLE_CONN_HANDLE_INVALID == phy->conn_handle)
+    {
+        return;
+    }
+
+    uint8_t preferred = estc_phy_preferred(phy);
+    if (BLE_GAP_PHY_AUTO == preferred || (preferred == phy->tx_phy && preferred == phy->rx_phy))
+    {
+        return;
+    }
+
+    ble_gap_phys_t const phys =
+    {
+        .rx_phys = preferred,
+        .tx_phys = preferred,
+    };
+
+    NRF_LOG_DEBUG("Requesting %s PHY (conn_handle: %d)", estc_phy_name(preferred), phy->conn_handle);
+    ret_code_t error_code = sd_ble_gap_phy_update(phy->conn_handle, &phys);
+    if (NRF_ERROR_BUSY == error_code || NRF_ERROR_INVALID_STATE == error_code)
+    {
+        // A PHY procedure is already running, its outcome is handled in BLE_GAP_EVT_PHY_UPDATE
+        return;
+    }
+    APP_ERROR_CHECK(error_code);
+}
+
+void estc_phy_init(estc_phy_t *phy)
+{
+    ASSERT(NULL != phy)
+
+    phy->conn_handle = BLE_CONN_HANDLE_INVALID;
+    phy->tx_phy      = BLE_GAP_PHY_1MBPS;
+    phy->rx_phy      = BLE_GAP_PHY_1MBPS;
+    phy->bulk        = false;
+    phy->degraded    = false;
+}
+
+void estc_phy_bulk_set(estc_phy_t *phy, bool active)
+{
+    ASSERT(NULL != phy)
+
+    if (phy->bulk == active)
+    {
+        return;
+    }
+
+    phy->bulk = active;
+    estc_phy_request(phy);
+}
+
+void estc_phy_on_ble_event(const ble_evt_t *ble_evt, void *ctx)
+{
+    estc_phy_t *phy = (estc_phy_t *)ctx;
+    ble_gap_evt_t const *gap_evt = &ble_evt->evt.gap_evt;
+    ret_code_t error_code = NRF_SUCCESS;
+
+    switch (ble_evt->header.evt_id)
+    {
+        case BLE_GAP_EVT_CONNECTED:
+            phy->conn_handle = gap_evt->conn_handle;
+            phy->tx_phy      = BLE_GAP_PHY_1MBPS;
+            phy->rx_phy      = BLE_GAP_PHY_1MBPS;
+            phy->bulk        = false;
+            phy->degraded    = false;
+
+            // Watch the link quality to know when 2M PHY is no longer reliable
+            error_code = sd_ble_gap_rssi_start(phy->conn_handle, ESTC_PHY_RSSI_THRESHOLD_DBM, ESTC_PHY_RSSI_SKIP_COUNT);
+            APP_ERROR_CHECK(error_code);
+
+            estc_phy_request(phy);
+            break;
+
+        case BLE_GAP_EVT_DISCONNECTED:
+            if (gap_evt->conn_handle == phy->conn_handle)
+            {
+                // A stream of the next connection on this slot has to raise bulk again
+                phy->conn_handle = BLE_CONN_HANDLE_INVALID;
+                phy->bulk        = false;
+            }
+            break;
+
+        case BLE_GAP_EVT_PHY_UPDATE_REQUEST:
+        {
+            if (gap_evt->conn_handle != phy->conn_handle)
+            {
+                break;
+            }
+
+            NRF_LOG_DEBUG("PHY update request (conn_handle: %d)", gap_evt->conn_handle);
+            uint8_t preferred = estc_phy_preferred(phy);
+            ble_gap_phys_t const phys =
+            {
+                .rx_phys = preferred,
+                .tx_phys = preferred,
+            };
+            error_code = sd_ble_gap_phy_update(gap_evt->conn_handle, &phys);
+            APP_ERROR_CHECK(error_code);
+        } break;
+
+        case BLE_GAP_EVT_PHY_UPDATE:
+            if (gap_evt->conn_handle != phy->conn_handle)
+            {
+                break;
+            }
+
+            if (BLE_HCI_STATUS_CODE_SUCCESS != gap_evt->params.phy_update.status)
+            {
+                NRF_LOG_INFO("PHY update failed with status 0x%02x (conn_handle: %d)",
+                             gap_evt->params.phy_update.status, gap_evt->conn_handle);
+                break;
+            }
+
+            phy->tx_phy = gap_evt->params.phy_update.tx_phy;
+            phy->rx_phy = gap_evt->params.phy_update.rx_phy;
+            NRF_LOG_INFO("PHY updated to TX %s, RX %s (conn_handle: %d)",
+                         estc_phy_name(phy->tx_phy), estc_phy_name(phy->rx_phy), gap_evt->conn_handle);
+            break;
+
+        case BLE_GAP_EVT_RSSI_CHANGED:
+        {
+            if (gap_evt->conn_handle != phy->conn_handle)
+            {
+                break;
+            }
+
+            int8_t rssi = gap_evt->params.rssi_changed.rssi;
+            if (!phy->degraded && rssi < ESTC_PHY_RSSI_DEGRADED_DBM)
+            {
+                NRF_LOG_INFO("Link degraded, RSSI %d dBm (conn_handle: %d)", rssi, gap_evt->conn_handle);
+                phy->degraded = true;
+                estc_phy_request(phy);
+            }
+            else if (phy->degraded && rssi > ESTC_PHY_RSSI_RECOVERED_DBM)
+            {
+                NRF_LOG_INFO("Link recovered, RSSI %d dBm (conn_handle: %d)", rssi, gap_evt->conn_handle);
+                phy->degraded = false;
+                estc_phy_request(phy);
+            }
+        } break;
+
+        default:
+            break;
+    }
+}
@@ -0,0 +1,78 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#ifndef ESTC_PHY_H__
+#define ESTC_PHY_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ble.h"
+#include "ble_gap.h"
+
+#define ESTC_PHY_RSSI_DEGRADED_DBM      (-80)   /**< Below this RSSI the link falls back to 1M PHY. */
+#define ESTC_PHY_RSSI_RECOVERED_DBM     (-70)   /**< Above this RSSI the link may use 2M PHY again. */
+#define ESTC_PHY_RSSI_THRESHOLD_DBM     2       /**< Minimum RSSI change that produces an RSSI event. */
+#define ESTC_PHY_RSSI_SKIP_COUNT        4       /**< Number of RSSI samples that must differ before an RSSI event. */
+
+/**@brief PHY policy of one connection.
+ *
+ * @details 2M PHY is requested while a bulk stream is running, which roughly halves the airtime
+ *          per byte. When the RSSI drops below ESTC_PHY_RSSI_DEGRADED_DBM the link falls back to
+ *          the more robust 1M PHY until it recovers past ESTC_PHY_RSSI_RECOVERED_DBM.
+ */
+typedef struct
+{
+    uint16_t conn_handle;   /**< Connection the policy applies to. */
+    uint8_t  tx_phy;        /**< Current TX PHY (BLE_GAP_PHY_*). */
+    uint8_t  rx_phy;        /**< Current RX PHY (BLE_GAP_PHY_*). */
+    bool     bulk;          /**< A bulk stream is running on the connection. */
+    bool     degraded;      /**< The link quality is too low for 2M PHY. */
+} estc_phy_t;
+
+/**@brief Function for initializing a PHY policy instance.
+ */
+void estc_phy_init(estc_phy_t *phy);
+
+/**@brief Function for telling the policy that a bulk stream started or stopped.
+ *
+ * @param[in] phy     PHY policy instance.
+ * @param[in] active  True when bulk data is being transmitted.
+ */
+void estc_phy_bulk_set(estc_phy_t *phy, bool active);
+
+/**@brief Function for handling BLE events relevant to the PHY policy.
+ *
+ * @param[in] ble_evt  Bluetooth stack event.
+ * @param[in] ctx      PHY policy instance.
+ */
+void estc_phy_on_ble_event(const ble_evt_t *ble_evt, void *ctx);
+
+#endif /* ESTC_PHY_H__ */
@@ -0,0 +1,580 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#include "estc_sampler.h"
+
+#include <string.h>
+
+#include "app_error.h"
+#include "app_timer.h"
+#include "app_util.h"
+#include "nrf.h"
+#include "nrf_log.h"
+#include "sdk_macros.h"
+
+static bool estc_sampler_is_subscribed(estc_sampler_t const *sampler)
+{
+    return estc_ble_service_is_subscribed(sampler->service, sampler->service->characterstic3_handle.value_handle);
+}
+
+#if ESTC_DSP_ENABLED
+/**@brief Function for checking whether a central is subscribed to the features.
+ */
+static bool estc_sampler_features_are_subscribed(estc_sampler_t const *sampler)
+{
+    return estc_ble_service_is_subscribed(sampler->service, sampler->service->features_handle.value_handle);
+}
+#endif
+
+/**@brief Function for checking whether any central uses the samples.
+ */
+static bool estc_sampler_is_needed(estc_sampler_t const *sampler)
+{
+#if ESTC_DSP_ENABLED
+    if (estc_sampler_features_are_subscribed(sampler))
+    {
+        return true;
+    }
+#endif
+    return estc_sampler_is_subscribed(sampler);
+}
+
+/**@brief Function for taking a sample, runs in the app_timer interrupt.
+ */
+static void estc_sampler_timeout_handler(void *p_context)
+{
+    estc_sampler_t *sampler = (estc_sampler_t *)p_context;
+
+    if (!estc_sampler_is_needed(sampler))
+    {
+        return;
+    }
+
+#if ESTC_SAMPLER_PROFILE
+    uint32_t start = DWT->CYCCNT;
+#endif
+    estc_sample_t sample;
+    sample.ticks = app_timer_cnt_get();
+    sample.value = (uint16_t)MIN(sensorsim_measure(&sampler->sensor_state, &sampler->sensor_cfg), UINT16_MAX);
+
+    if (NRF_SUCCESS == nrf_atfifo_alloc_put(sampler->p_fifo, &sample, sizeof(sample), NULL))
+    {
+        sampler->samples_taken++;
+    }
+    else
+    {
+        // The main loop did not keep up, the newest sample is lost
+        sampler->samples_overrun++;
+    }
+#if ESTC_SAMPLER_PROFILE
+    sampler->cycles += DWT->CYCCNT - start;
+#endif
+}
+
+static void estc_sampler_packet_reset(estc_sampler_t *sampler)
+{
+    sampler->packet_len   = ESTC_SAMPLER_HEADER_LEN;
+    sampler->packet_count = 0;
+    memset(sampler->block_or, 0, sizeof(sampler->block_or));
+}
+
+static uint8_t estc_sampler_field_count(estc_sampler_t const *sampler)
+{
+    return (ESTC_SAMPLER_KIND_SUMMARY == sampler->kind) ? ESTC_SAMPLER_FIELDS_MAX : 1;
+}
+
+/**@brief Function for getting the coded numbers of a staged record: the ticks since the previous
+ *        record, then the zigzag coded difference of each value.
+ */
+static void estc_sampler_record_deltas(estc_sampler_t const *sampler, uint8_t index, uint32_t *deltas)
+{
+    estc_sampler_record_t const *record = &sampler->records[index];
+    estc_sampler_record_t const *prev   = (index > 0) ? &sampler->records[index - 1] : NULL;
+
+    deltas[0] = (NULL == prev) ? 0 : app_timer_cnt_diff_compute(record->ticks, prev->ticks);
+    for (uint8_t i = 0; i < estc_sampler_field_count(sampler); i++)
+    {
+        int32_t reference = (NULL == prev) ? 0 : prev->values[i];
+        deltas[1 + i] = estc_codec_zigzag_encode((int32_t)record->values[i] - reference);
+    }
+}
+
+/**@brief Function for adding a record to the next packet if it still fits.
+ *
+ * @return False if the packet is full or the record is too long for @p max_len.
+ */
+static bool estc_sampler_stage(estc_sampler_t *sampler, estc_sampler_record_t const *record, uint16_t max_len)
+{
+    uint8_t  fields = estc_sampler_field_count(sampler);
+    uint8_t  index  = sampler->packet_count;
+    uint32_t deltas[1 + ESTC_SAMPLER_FIELDS_MAX];
+    uint32_t block_or[1 + ESTC_SAMPLER_FIELDS_MAX];
+    uint16_t len;
+
+    if (ESTC_SAMPLER_RECORDS_MAX == index)
+    {
+        return false;
+    }
+    if (ESTC_SAMPLER_ENCODING_FIXED == sampler->encoding && index > 0 &&
+        app_timer_cnt_diff_compute(record->ticks, sampler->records[0].ticks) > UINT16_MAX)
+    {
+        // The time offset does not fit
+        return false;
+    }
+
+    sampler->records[index] = *record;
+    estc_sampler_record_deltas(sampler, index, deltas);
+
+    switch (sampler->encoding)
+    {
+        case ESTC_SAMPLER_ENCODING_DELTA:
+            len = sampler->packet_len;
+            for (uint8_t i = 0; i <= fields; i++)
+            {
+                len += estc_codec_varint_len(deltas[i]);
+            }
+            break;
+
+        case ESTC_SAMPLER_ENCODING_BLOCK:
+            // Each column gets as wide as its widest number
+            len = ESTC_SAMPLER_HEADER_LEN;
+            for (uint8_t i = 0; i <= fields; i++)
+            {
+                block_or[i] = sampler->block_or[i] | deltas[i];
+                len += estc_codec_block_len(estc_codec_bit_width(block_or[i]), index + 1);
+            }
+            break;
+
+        default:
+            len = sampler->packet_len + sizeof(uint16_t) * (1 + fields);
+            break;
+    }
+
+    if (len > max_len)
+    {
+        return false;
+    }
+
+    if (ESTC_SAMPLER_ENCODING_BLOCK == sampler->encoding)
+    {
+        memcpy(sampler->block_or, block_or, sizeof(uint32_t) * (1 + fields));
+    }
+    sampler->packet_len = len;
+    sampler->packet_count++;
+    return true;
+}
+
+/**@brief Function for encoding the staged records into the packet.
+ */
+static void estc_sampler_packet_encode(estc_sampler_t *sampler)
+{
+    uint8_t  fields = estc_sampler_field_count(sampler);
+    uint32_t deltas[1 + ESTC_SAMPLER_FIELDS_MAX];
+    uint16_t len = ESTC_SAMPLER_HEADER_LEN;
+
+    sampler->packet[0] = sampler->packet_seq;
+    sampler->packet[1] = ESTC_SAMPLER_FORMAT(sampler->kind, sampler->encoding);
+    sampler->packet[2] = sampler->packet_count;
+    (void)uint32_encode(sampler->records[0].ticks, &sampler->packet[3]);
+
+    switch (sampler->encoding)
+    {
+        case ESTC_SAMPLER_ENCODING_DELTA:
+            for (uint8_t i = 0; i < sampler->packet_count; i++)
+            {
+                estc_sampler_record_deltas(sampler, i, deltas);
+                for (uint8_t j = 0; j <= fields; j++)
+                {
+                    len += estc_codec_varint_encode(deltas[j], &sampler->packet[len]);
+                }
+            }
+            break;
+
+        case ESTC_SAMPLER_ENCODING_BLOCK:
+        {
+            // Main loop only, kept off the stack
+            static uint32_t column[ESTC_SAMPLER_RECORDS_MAX];
+            for (uint8_t j = 0; j <= fields; j++)
+            {
+                for (uint8_t i = 0; i < sampler->packet_count; i++)
+                {
+                    estc_sampler_record_deltas(sampler, i, deltas);
+                    column[i] = deltas[j];
+                }
+                len += estc_codec_block_encode(column,
+                                               sampler->packet_count,
+                                               estc_codec_bit_width(sampler->block_or[j]),
+                                               &sampler->packet[len]);
+            }
+        } break;
+
+        default:
+            for (uint8_t i = 0; i < sampler->packet_count; i++)
+            {
+                estc_sampler_record_t const *record = &sampler->records[i];
+                uint16_t offset = (uint16_t)app_timer_cnt_diff_compute(record->ticks, sampler->records[0].ticks);
+
+                len += uint16_encode(offset, &sampler->packet[len]);
+                for (uint8_t j = 0; j < fields; j++)
+                {
+                    len += uint16_encode(record->values[j], &sampler->packet[len]);
+                }
+            }
+            break;
+    }
+
+    ASSERT(len == sampler->packet_len)
+}
+
+static void estc_sampler_pack(estc_sampler_t *sampler, estc_sampler_record_t const *record);
+
+/**@brief Function for encoding the staged records and publishing them.
+ */
+static void estc_sampler_packet_publish(estc_sampler_t *sampler)
+{
+    estc_sampler_packet_encode(sampler);
+
+    ret_code_t error_code = estc_ble_service_sample_publish(sampler->service, sampler->packet, sampler->packet_len);
+    if (NRF_SUCCESS == error_code)
+    {
+        sampler->packets_sent++;
+        sampler->packet_seq++;
+    }
+    else
+    {
+        NRF_LOG_DEBUG("Sampler packet of %d bytes rejected: %d", sampler->packet_len, error_code);
+        sampler->packets_failed++;
+    }
+
+    estc_sampler_packet_reset(sampler);
+}
+
+/**@brief Function for sending the staged records, leaving the packet empty.
+ *
+ * @details A central with a smaller ATT MTU may have subscribed since the records were staged.
+ *          The records are then staged again against the new limit and sent in as many packets
+ *          as they need, so no subscriber misses a packet that is too long for it.
+ */
+static void estc_sampler_packet_send(estc_sampler_t *sampler)
+{
+    uint16_t max_len = estc_ble_service_sample_max_len(sampler->service);
+    if (sampler->packet_len <= max_len)
+    {
+        estc_sampler_packet_publish(sampler);
+        return;
+    }
+
+    // Staging record i writes at most at index i, so the records are staged again in place
+    uint8_t count = sampler->packet_count;
+    estc_sampler_packet_reset(sampler);
+    for (uint8_t i = 0; i < count; i++)
+    {
+        estc_sampler_record_t record = sampler->records[i];
+        estc_sampler_pack(sampler, &record);
+    }
+
+    if (sampler->packet_count > 0)
+    {
+        estc_sampler_packet_publish(sampler);
+    }
+}
+
+/**@brief Function for adding a record to the next packet, sending the packet first when it is full.
+ */
+static void estc_sampler_pack(estc_sampler_t *sampler, estc_sampler_record_t const *record)
+{
+    // Checked for every record, the packet is sent against the limit it was staged with
+    uint16_t max_len = estc_ble_service_sample_max_len(sampler->service);
+
+    if (estc_sampler_stage(sampler, record, max_len))
+    {
+        return;
+    }
+
+    if (sampler->packet_count > 0)
+    {
+        estc_sampler_packet_send(sampler);
+        if (estc_sampler_stage(sampler, record, max_len))
+        {
+            return;
+        }
+    }
+
+    // Only with small ATT MTUs, a record coded against 0 may not fit an empty packet
+    sampler->records_dropped++;
+}
+
+static uint16_t estc_sampler_value_encode(float value)
+{
+    return (uint16_t)MIN(value + 0.5f, (float)UINT16_MAX);
+}
+
+#if ESTC_DSP_ENABLED
+/**@brief Function for passing a sample to the feature extraction and publishing completed windows.
+ */
+static void estc_sampler_features_handle(estc_sampler_t *sampler, estc_sample_t const *sample)
+{
+    estc_dsp_features_t features;
+    uint8_t             packet[ESTC_DSP_FEATURES_LEN];
+
+    if (!estc_dsp_add(&sampler->dsp, (float32_t)sample->value, &features))
+    {
+        return;
+    }
+
+    uint16_t len = estc_dsp_features_encode(&features, sampler->features_seq, packet);
+    ret_code_t error_code = estc_ble_service_features_publish(sampler->service, packet, len);
+    if (NRF_SUCCESS == error_code)
+    {
+        sampler->features_sent++;
+        sampler->features_seq++;
+    }
+    else
+    {
+        NRF_LOG_DEBUG("Features packet rejected: %d", error_code);
+        sampler->features_failed++;
+    }
+}
+#endif
+
+/**@brief Function for passing a sample through the aggregation stage into the packet.
+ */
+static void estc_sampler_sample_handle(estc_sampler_t *sampler, estc_sample_t const *sample)
+{
+#if ESTC_DSP_ENABLED
+    // The FFT runs only for a features subscriber, not for every characteristic 3 sample
+    if (estc_sampler_features_are_subscribed(sampler))
+    {
+        estc_sampler_features_handle(sampler, sample);
+    }
+
+    if (!estc_sampler_is_subscribed(sampler))
+    {
+        // Sampled for the features only
+        return;
+    }
+#endif
+
+    // Count the packets the raw samples need, the reference for the reduction
+    uint16_t max_len = estc_ble_service_sample_max_len(sampler->service);
+    if (0 == sampler->raw_count)
+    {
+        sampler->raw_ticks = sample->ticks;
+    }
+    sampler->raw_count++;
+    if (ESTC_SAMPLER_HEADER_LEN + (sampler->raw_count + 1) * ESTC_SAMPLER_SAMPLE_LEN > max_len)
+    {
+        sampler->raw_packets++;
+        sampler->raw_count = 0;
+    }
+
+    estc_aggregate_result_t result;
+    if (!estc_aggregate_add(&sampler->aggregate, (float)sample->value, &result))
+    {
+        return;
+    }
+
+    estc_sampler_record_t record = {0};
+    record.ticks = sample->ticks;
+    if (ESTC_SAMPLER_KIND_RAW == sampler->kind)
+    {
+        record.values[0] = sample->value;
+    }
+    else
+    {
+        record.values[0] = estc_sampler_value_encode(result.min);
+        record.values[1] = estc_sampler_value_encode(result.max);
+        record.values[2] = estc_sampler_value_encode(result.mean);
+        record.values[3] = estc_sampler_value_encode(result.last);
+    }
+    estc_sampler_pack(sampler, &record);
+}
+
+ret_code_t estc_sampler_init(estc_sampler_t *sampler,
+                             ble_estc_service_t *service,
+                             nrf_atfifo_t *p_fifo,
+                             estc_sampler_init_t const *init)
+{
+    ASSERT(NULL != sampler)
+    ASSERT(NULL != service)
+    ASSERT(NULL != p_fifo)
+    ASSERT(NULL != init)
+    ASSERT(init->rate_hz > 0)
+
+    memset(sampler, 0, sizeof(*sampler));
+    sampler->service           = service;
+    sampler->p_fifo            = p_fifo;
+    sampler->sensor_cfg        = init->sensor_cfg;
+    // APP_TIMER_CLOCK_FREQ is the RTC input clock, the counter runs behind the prescaler
+    sampler->period_ticks      = MAX(ROUNDED_DIV(APP_TIMER_TICKS(1000), init->rate_hz), APP_TIMER_MIN_TIMEOUT_TICKS);
+    sampler->max_latency_ticks = APP_TIMER_TICKS(init->max_latency_ms);
+
+    sensorsim_init(&sampler->sensor_state, &sampler->sensor_cfg);
+
+    estc_aggregate_init(&sampler->aggregate, &init->aggregate);
+    sampler->kind = (sampler->aggregate.config.window > 1) ? ESTC_SAMPLER_KIND_SUMMARY : ESTC_SAMPLER_KIND_RAW;
+    sampler->encoding = init->encoding;
+    estc_sampler_packet_reset(sampler);
+
+#if ESTC_DSP_ENABLED
+    ret_code_t error_code = estc_dsp_init(&sampler->dsp, init->dsp_format);
+    if (NRF_SUCCESS != error_code)
+    {
+        return error_code;
+    }
+#endif
+
+#if ESTC_SAMPLER_PROFILE
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL        |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+
+    sampler->timer_id = &sampler->timer_data;
+    return app_timer_create(&sampler->timer_id, APP_TIMER_MODE_REPEATED, estc_sampler_timeout_handler);
+}
+
+/**@brief Function for running the sampling timer only while a central uses the samples.
+ */
+static ret_code_t estc_sampler_timer_update(estc_sampler_t *sampler)
+{
+    bool needed = sampler->started && estc_sampler_is_needed(sampler);
+    if (needed == sampler->timer_running)
+    {
+        return NRF_SUCCESS;
+    }
+
+    ret_code_t error_code = needed ? app_timer_start(sampler->timer_id, sampler->period_ticks, sampler)
+                                   : app_timer_stop(sampler->timer_id);
+    if (NRF_SUCCESS == error_code)
+    {
+        sampler->timer_running = needed;
+    }
+
+    return error_code;
+}
+
+ret_code_t estc_sampler_start(estc_sampler_t *sampler)
+{
+    ASSERT(NULL != sampler)
+
+    NRF_LOG_INFO("Sampler started, period %d ticks, packet format 0x%02x",
+                 sampler->period_ticks, ESTC_SAMPLER_FORMAT(sampler->kind, sampler->encoding));
+    sampler->started = true;
+
+#if ESTC_DSP_ENABLED && ESTC_DSP_BENCHMARK
+    estc_dsp_benchmark_t benchmark;
+    ret_code_t error_code = estc_dsp_benchmark(&sampler->dsp, &benchmark);
+    VERIFY_SUCCESS(error_code);
+    NRF_LOG_INFO("Features window of %d samples: %d cycles in f32, %d cycles in q15",
+                 ESTC_DSP_FFT_LEN, benchmark.f32_cycles, benchmark.q15_cycles);
+#endif
+
+    // A central may have subscribed before the start, otherwise processing starts the timer
+    return estc_sampler_timer_update(sampler);
+}
+
+void estc_sampler_process(estc_sampler_t *sampler)
+{
+    ASSERT(NULL != sampler)
+
+#if ESTC_SAMPLER_PROFILE
+    uint32_t start = DWT->CYCCNT;
+#endif
+    estc_sample_t sample;
+    while (NRF_SUCCESS == nrf_atfifo_get_free(sampler->p_fifo, &sample, sizeof(sample), NULL))
+    {
+        estc_sampler_sample_handle(sampler, &sample);
+    }
+
+    if (sampler->packet_count > 0 &&
+        app_timer_cnt_diff_compute(app_timer_cnt_get(), sampler->records[0].ticks) >= sampler->max_latency_ticks)
+    {
+        // Do not hold the samples back until the packet is full
+        estc_sampler_packet_send(sampler);
+    }
+
+    if (sampler->raw_count > 0 &&
+        app_timer_cnt_diff_compute(app_timer_cnt_get(), sampler->raw_ticks) >= sampler->max_latency_ticks)
+    {
+        // The raw stream would have flushed its packet here
+        sampler->raw_packets++;
+        sampler->raw_count = 0;
+    }
+
+    bool subscribed = estc_sampler_is_subscribed(sampler);
+    if (sampler->subscribed && !subscribed)
+    {
+        // A new subscriber gets the current value, not a deadband reference it never saw
+        estc_aggregate_reset(&sampler->aggregate);
+        estc_sampler_stats_log(sampler);
+    }
+    sampler->subscribed = subscribed;
+
+#if ESTC_DSP_ENABLED
+    bool features_subscribed = estc_sampler_features_are_subscribed(sampler);
+    if (sampler->features_subscribed && !features_subscribed)
+    {
+        // The next subscriber gets a window of its own samples, not one joined across the gap
+        estc_dsp_reset(&sampler->dsp);
+    }
+    sampler->features_subscribed = features_subscribed;
+#endif
+
+    ret_code_t error_code = estc_sampler_timer_update(sampler);
+    APP_ERROR_CHECK(error_code);
+#if ESTC_SAMPLER_PROFILE
+    sampler->cycles += DWT->CYCCNT - start;
+#endif
+}
+
+void estc_sampler_stats_log(estc_sampler_t const *sampler)
+{
+    ASSERT(NULL != sampler)
+
+    NRF_LOG_INFO("Sampler: %d samples, %d overruns, %d packets sent, %d failed, %d records dropped",
+                 sampler->samples_taken, sampler->samples_overrun, sampler->packets_sent, sampler->packets_failed,
+                 sampler->records_dropped);
+    NRF_LOG_INFO("Characteristic 3: %d packets instead of %d fixed raw, %d%% fewer, %d of %d windows in the deadband",
+                 sampler->packets_sent + sampler->packets_failed,
+                 sampler->raw_packets,
+                 (sampler->raw_packets > sampler->packets_sent + sampler->packets_failed)
+                     ? 100 - 100 * (sampler->packets_sent + sampler->packets_failed) / sampler->raw_packets
+                     : 0,
+                 sampler->aggregate.suppressed,
+                 sampler->aggregate.windows);
+#if ESTC_SAMPLER_PROFILE
+    NRF_LOG_INFO("Sampler: %d cycles per sample",
+                 (sampler->samples_taken > 0) ? (uint32_t)(sampler->cycles / sampler->samples_taken) : 0);
+#endif
+#if ESTC_DSP_ENABLED
+    NRF_LOG_INFO("Features: %d windows of %d samples, %d packets sent, %d failed",
+                 sampler->dsp.windows, ESTC_DSP_FFT_LEN, sampler->features_sent, sampler->features_failed);
+#endif
+}
@@ -0,0 +1,214 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#ifndef ESTC_SAMPLER_H__
+#define ESTC_SAMPLER_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "app_timer.h"
+#include "nrf_atfifo.h"
+#include "sdk_errors.h"
+#include "sensorsim.h"
+
+#include "estc_aggregate.h"
+#include "estc_codec.h"
+#include "estc_service.h"
+#if ESTC_DSP_ENABLED
+#include "estc_dsp.h"
+#endif
+#include "estc_fanout.h"
+
+// Count the DWT cycles the timer handler and estc_sampler_process take, reported per sample by
+// estc_sampler_stats_log
+#ifndef ESTC_SAMPLER_PROFILE
+#define ESTC_SAMPLER_PROFILE 0
+#endif
+
+// Packet header: sequence number (1 byte), format (1 byte), record count (1 byte),
+// RTC counter of the first record (4 bytes)
+#define ESTC_SAMPLER_HEADER_LEN     7
+
+// Fixed raw record: RTC ticks since the first record (2 bytes), value (2 bytes)
+#define ESTC_SAMPLER_SAMPLE_LEN     4
+
+// Fixed summary record: RTC ticks since the first record (2 bytes), min, max, mean, last (2 bytes each)
+#define ESTC_SAMPLER_SUMMARY_LEN    10
+
+// Most values in a record
+#define ESTC_SAMPLER_FIELDS_MAX     4
+
+// Most records in one packet, the count has to fit into its header byte
+#define ESTC_SAMPLER_RECORDS_MAX    UINT8_MAX
+
+// Format byte of the packet header
+#define ESTC_SAMPLER_FORMAT(kind, encoding)     ((uint8_t)((kind) | ((encoding) << 4)))
+
+/**@brief Kinds of records in a packet, low nibble of the format byte. */
+typedef enum
+{
+    ESTC_SAMPLER_KIND_RAW,      /**< Every sample, one value per record. */
+    ESTC_SAMPLER_KIND_SUMMARY,  /**< Window summaries, min, max, mean and last per record. */
+} estc_sampler_kind_t;
+
+/**@brief Encodings of the records, high nibble of the format byte.
+ *
+ * @details Apart from FIXED, a record carries the RTC ticks since the previous record and the
+ *          zigzag coded difference of each value to the same value of the previous record. The
+ *          first record of a packet is coded against 0, so every packet decodes on its own.
+ */
+typedef enum
+{
+    ESTC_SAMPLER_ENCODING_FIXED,    /**< 2 bytes of ticks since the first record, 2 bytes per value. */
+    ESTC_SAMPLER_ENCODING_DELTA,    /**< Record by record, each number a varint. */
+    ESTC_SAMPLER_ENCODING_BLOCK,    /**< Column by column, each a bit-packed block: ticks first, then each value. */
+} estc_sampler_encoding_t;
+
+/**@brief Record staged for the next packet. */
+typedef struct
+{
+    uint32_t ticks;                                 /**< RTC counter of the record. */
+    uint16_t values[ESTC_SAMPLER_FIELDS_MAX];       /**< Values, as many as the kind has. */
+} estc_sampler_record_t;
+
+/**@brief Sample passed from the timer to the packer through the FIFO. */
+typedef struct
+{
+    uint32_t ticks;     /**< RTC counter when the sample was taken. */
+    uint16_t value;     /**< Measured value. */
+} estc_sample_t;
+
+/**@brief Sensor sampler initialization parameters. */
+typedef struct
+{
+    uint32_t        rate_hz;            /**< Sampling rate, at most APP_TIMER_TICKS(1000) / APP_TIMER_MIN_TIMEOUT_TICKS. */
+    uint32_t        max_latency_ms;     /**< Longest time a sample waits for the packet to fill up. */
+    sensorsim_cfg_t sensor_cfg;         /**< Simulated sensor waveform. */
+    estc_aggregate_init_t aggregate;    /**< Window and deadband, a window of 0 or 1 without deadband sends raw samples. */
+    estc_sampler_encoding_t encoding;   /**< Encoding of the records. */
+#if ESTC_DSP_ENABLED
+    estc_dsp_format_t dsp_format;       /**< Arithmetic of the feature extraction. */
+#endif
+} estc_sampler_init_t;
+
+/**@brief Timer-driven sensor sampling pipeline.
+ *
+ * @details The timer handler only takes a sample and puts it into a lock-free FIFO, so it is short
+ *          and never waits for the main loop. The main loop drains the FIFO and packs as many
+ *          timestamped samples as the smallest subscribed ATT MTU allows into one characteristic 3
+ *          notification. A packet is sent when it is full or when its first sample is
+ *          max_latency_ms old. The timer only runs while a central is subscribed to the samples
+ *          or, with ESTC_DSP_ENABLED, to the features.
+ *
+ *          With aggregation configured, window summaries replace the raw samples and windows
+ *          within the deadband are not sent at all. The packets the raw samples would have
+ *          needed are still counted, to report the reduction.
+ *
+ *          With ESTC_DSP_ENABLED the raw samples also go to a CMSIS-DSP stage while a central is
+ *          subscribed to the features characteristic, which notifies the features of each window.
+ */
+typedef struct
+{
+    ble_estc_service_t *service;            /**< Service the packets are published on. */
+    nrf_atfifo_t       *p_fifo;             /**< Samples taken but not packed yet. */
+    sensorsim_cfg_t     sensor_cfg;         /**< Simulated sensor waveform. */
+    sensorsim_state_t   sensor_state;       /**< Simulated sensor state. */
+    estc_aggregate_t    aggregate;          /**< Aggregation stage between the sampler and the packer. */
+    estc_sampler_kind_t kind;               /**< Kind of records in the packets. */
+    estc_sampler_encoding_t encoding;       /**< Encoding of the records. */
+    uint32_t            period_ticks;       /**< Sampling period in RTC ticks. */
+    uint32_t            max_latency_ticks;  /**< Longest time a sample waits in a packet, in RTC ticks. */
+    estc_sampler_record_t records[ESTC_SAMPLER_RECORDS_MAX]; /**< Records of the next packet. */
+    uint32_t            block_or[1 + ESTC_SAMPLER_FIELDS_MAX]; /**< Coded numbers of each column OR-ed, for the block widths. */
+    uint8_t             packet[ESTC_FANOUT_SAMPLE_MAX_LEN]; /**< Encoded packet. */
+    uint16_t            packet_len;         /**< Encoded length of the records. */
+    uint8_t             packet_count;       /**< Records staged. */
+    uint8_t             packet_seq;         /**< Sequence number of the next packet. */
+    bool                subscribed;         /**< A central was subscribed at the last processing. */
+    bool                started;            /**< Sampling was started by the application. */
+    bool                timer_running;      /**< Sampling timer is running. */
+    uint32_t            samples_taken;      /**< Samples put into the FIFO. */
+    uint32_t            samples_overrun;    /**< Samples lost because the FIFO was full. */
+    uint32_t            packets_sent;       /**< Packets accepted by the service. */
+    uint32_t            packets_failed;     /**< Packets the service rejected. */
+    uint32_t            records_dropped;    /**< Records too long for an empty packet. */
+    uint32_t            raw_packets;        /**< Packets the raw samples would have needed. */
+    uint8_t             raw_count;          /**< Raw samples not counted in raw_packets yet. */
+    uint32_t            raw_ticks;          /**< RTC counter of the first raw sample not counted yet. */
+#if ESTC_SAMPLER_PROFILE
+    uint64_t            cycles;             /**< DWT cycles spent sampling and packing. */
+#endif
+#if ESTC_DSP_ENABLED
+    estc_dsp_t          dsp;                /**< Feature extraction of the raw samples. */
+    bool                features_subscribed; /**< A central was subscribed to the features at the last processing. */
+    uint8_t             features_seq;       /**< Sequence number of the next features packet. */
+    uint32_t            features_sent;      /**< Features packets accepted by the service. */
+    uint32_t            features_failed;    /**< Features packets the service rejected. */
+#endif
+    app_timer_t         timer_data;         /**< Sampling timer. */
+    app_timer_id_t      timer_id;           /**< Identifier of timer_data. */
+} estc_sampler_t;
+
+/**@brief Function for initializing the sensor sampler.
+ *
+ * @param[out] sampler  Sampler instance.
+ * @param[in]  service  ESTC service the packets are published on.
+ * @param[in]  p_fifo   FIFO defined with NRF_ATFIFO_DEF for estc_sample_t items.
+ * @param[in]  init     Initialization parameters.
+ */
+ret_code_t estc_sampler_init(estc_sampler_t *sampler,
+                             ble_estc_service_t *service,
+                             nrf_atfifo_t *p_fifo,
+                             estc_sampler_init_t const *init);
+
+/**@brief Function for starting the sampling.
+ *
+ * @details The timer runs from then on whenever a central subscribes, see estc_sampler_process.
+ *
+ * @param[in] sampler  Sampler instance.
+ */
+ret_code_t estc_sampler_start(estc_sampler_t *sampler);
+
+/**@brief Function for packing the sampled data and publishing full or expired packets.
+ *
+ * @details Call from the main loop.
+ *
+ * @param[in] sampler  Sampler instance.
+ */
+void estc_sampler_process(estc_sampler_t *sampler);
+
+/**@brief Function for logging the sampler counters and the packet reduction of the aggregation.
+ *
+ * @param[in] sampler  Sampler instance.
+ */
+void estc_sampler_stats_log(estc_sampler_t const *sampler);
+
+#endif /* ESTC_SAMPLER_H__ */
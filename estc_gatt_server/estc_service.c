@@ -30,25 +30,276 @@
 
 #include "estc_service.h"
 
+#include <stddef.h>
+#include <string.h>
+
 #include "app_error.h"
+#include "app_timer.h"
+#include "app_util.h"
+#include "app_util_platform.h"
 #include "nrf_log.h"
+#include "nrf_ringbuf.h"
+#include "sdk_macros.h"
 
 #include "ble.h"
+#include "ble_conn_state.h"
 #include "ble_gatts.h"
 #include "ble_srv_common.h"
 
-#define ESTC_CHAR_LEN   20                                       /**< Size of the characteristic value being notified (in bytes). */
-static uint8_t          m_char1_value[ESTC_CHAR_LEN] = { 0 };    /**< Value of the characteristic that will be sent as a notification to the central. */
-static uint8_t          m_char2_value[ESTC_CHAR_LEN] = { 0 };
-static uint8_t          m_char3_value[ESTC_CHAR_LEN] = { 0 };
+static uint8_t          m_char1_value[ESTC_CHAR1_MAX_LEN] = { 0 };    /**< Value of the characteristic that will be sent as a notification to the central. */
+static uint8_t          m_char2_value[ESTC_CHAR_MAX_LEN] = { 0 };
+static uint8_t          m_char3_value[ESTC_CHAR_MAX_LEN] = { 0 };
+static uint8_t          m_echo_value[ESTC_CHAR_MAX_LEN] = { 0 };
+static uint8_t          m_reliable_value[ESTC_CHAR_MAX_LEN] = { 0 };
+#if ESTC_BENCH_ENABLED
+static uint8_t          m_bench_data_value[ESTC_CHAR_MAX_LEN] = { 0 };
+static uint8_t          m_bench_report_value[ESTC_CHAR_MAX_LEN] = { 0 };
+#endif
+#if ESTC_DSP_ENABLED
+static uint8_t          m_features_value[ESTC_CHAR_MAX_LEN] = { 0 };
+#endif
+
+static uint8_t const            m_char_desc[] = "Mercedes GLK";
+
+#define ESTC_UPDATE_DEFAULT_PERIOD_MS   100                      /**< Coalescing period of characteristic 1 updates when the connection interval is unknown. */
+APP_TIMER_DEF(m_char1_update_timer);                             /**< Commits coalesced characteristic 1 updates. */
+
+#define ESTC_INGEST_BUFFER_SIZE 2048                             /**< Size of the characteristic 1 ingest buffer (in bytes, must be a power of 2). */
+NRF_RINGBUF_DEF(m_char1_ringbuf, ESTC_INGEST_BUFFER_SIZE);
+
+#if ESTC_SERVICE_VLOC_USER
+#define ESTC_CHAR_VLOC      BLE_GATTS_VLOC_USER                  /**< Values live in the application buffers. */
+#define ESTC_CHAR_RD_AUTH   1                                    /**< Reads of staged values are authorized, so they never see a value being written. */
+#else
+#define ESTC_CHAR_VLOC      BLE_GATTS_VLOC_STACK                 /**< The SoftDevice keeps its own copy of the values. */
+#define ESTC_CHAR_RD_AUTH   0
+#endif
+
+#define ESTC_VALUE_INDEX_NONE   0xFF                             /**< Attribute that is not a characteristic value. */
+
+#define ESTC_SEC_OPEN           { .sm = 1, .lv = 1 }             /**< Security mode 1 level 1, no protection. */
+#define ESTC_SEC_NO_ACCESS      { .sm = 0, .lv = 0 }             /**< No access rights. */
+
+/**@brief Handler for a write to one attribute of the service. */
+typedef void (*estc_attr_write_handler_t)(ble_estc_service_t *service, estc_link_t *link,
+                                          uint16_t offset, uint8_t const *data, uint16_t len);
+
+/**@brief Definition of one characteristic of the service. */
+typedef struct
+{
+    uint16_t                  uuid;             /**< 16-bit UUID, octets 12-13 of the service base UUID. */
+    ble_gatt_char_props_t     props;            /**< Characteristic properties. */
+    ble_gap_conn_sec_mode_t   read_perm;        /**< Read permissions of the value. */
+    ble_gap_conn_sec_mode_t   write_perm;       /**< Write permissions of the value. */
+    uint8_t                   wr_auth;          /**< Writes are authorized by the service. */
+    uint8_t                   staged;           /**< Written in two phases, by estc_ble_service_value_begin and _commit. */
+    uint16_t                  max_len;          /**< Maximum length of the value (in bytes). */
+    uint8_t                  *p_value;          /**< Application buffer of max_len bytes holding the value. */
+    uint8_t const            *p_init_value;     /**< Initial content of the value. */
+    uint16_t                  init_value_len;   /**< Length of p_init_value (in bytes). */
+    uint8_t const            *p_user_desc;      /**< User description descriptor, NULL for none. */
+    uint16_t                  user_desc_len;    /**< Length of p_user_desc (in bytes). */
+    size_t                    handles_offset;   /**< Offset of the characteristic handles in ble_estc_service_t. */
+    estc_attr_write_handler_t on_value_write;   /**< Handler for writes to the value, may be NULL. */
+    estc_attr_write_handler_t on_cccd_write;    /**< Handler for writes to the CCCD, may be NULL. */
+} estc_char_def_t;
+
+static void estc_on_char1_write(ble_estc_service_t *service, estc_link_t *link,
+                                uint16_t offset, uint8_t const *data, uint16_t len);
+static void estc_on_char2_cccd_write(ble_estc_service_t *service, estc_link_t *link,
+                                     uint16_t offset, uint8_t const *data, uint16_t len);
+static void estc_on_char3_cccd_write(ble_estc_service_t *service, estc_link_t *link,
+                                     uint16_t offset, uint8_t const *data, uint16_t len);
+static void estc_on_echo_write(ble_estc_service_t *service, estc_link_t *link,
+                               uint16_t offset, uint8_t const *data, uint16_t len);
+static void estc_on_reliable_write(ble_estc_service_t *service, estc_link_t *link,
+                                   uint16_t offset, uint8_t const *data, uint16_t len);
+#if ESTC_BENCH_ENABLED
+static void estc_on_bench_report_write(ble_estc_service_t *service, estc_link_t *link,
+                                       uint16_t offset, uint8_t const *data, uint16_t len);
+#endif
+#if ESTC_DSP_ENABLED
+static void estc_on_features_cccd_write(ble_estc_service_t *service, estc_link_t *link,
+                                        uint16_t offset, uint8_t const *data, uint16_t len);
+#endif
+
+/**@brief Characteristics of the service, registered in this order. */
+static const estc_char_def_t m_char_defs[] =
+{
+    {
+        .uuid           = ESTC_CHAR_1_UUID_16,
+        .props          = { .read = 1, .write = 1, .write_wo_resp = 1 },
+        .read_perm      = ESTC_SEC_OPEN,
+        .write_perm     = ESTC_SEC_OPEN,
+        .wr_auth        = 1,    // Lets the Queued Write module handle long writes
+        .staged         = 1,
+        .max_len        = ESTC_CHAR1_MAX_LEN,
+        .p_value        = m_char1_value,
+        .p_init_value   = (uint8_t const *)"Andrew",
+        .init_value_len = 6,
+        .p_user_desc    = m_char_desc,
+        .user_desc_len  = sizeof(m_char_desc),
+        .handles_offset = offsetof(ble_estc_service_t, characterstic1_handle),
+        .on_value_write = estc_on_char1_write,
+    },
+    {
+        .uuid           = ESTC_CHAR_2_UUID_16,
+        .props          = { .read = 1, .indicate = 1 },
+        .read_perm      = ESTC_SEC_OPEN,
+        .write_perm     = ESTC_SEC_NO_ACCESS,
+        .max_len        = ESTC_CHAR_MAX_LEN,
+        .p_value        = m_char2_value,
+        .p_init_value   = (uint8_t const *)"X",
+        .init_value_len = 1,
+        .handles_offset = offsetof(ble_estc_service_t, characterstic2_handle),
+        .on_cccd_write  = estc_on_char2_cccd_write,
+    },
+    {
+        .uuid           = ESTC_CHAR_3_UUID_16,
+        .props          = { .read = 1, .notify = 1 },
+        .read_perm      = ESTC_SEC_OPEN,
+        .write_perm     = ESTC_SEC_NO_ACCESS,
+        .max_len        = ESTC_CHAR_MAX_LEN,
+        .p_value        = m_char3_value,
+        .p_init_value   = (uint8_t const *)"Y",
+        .init_value_len = 1,
+        .handles_offset = offsetof(ble_estc_service_t, characterstic3_handle),
+        .on_cccd_write  = estc_on_char3_cccd_write,
+    },
+    {
+        .uuid           = ESTC_CHAR_ECHO_UUID_16,
+        .props          = { .write = 1, .write_wo_resp = 1, .notify = 1 },
+        .read_perm      = ESTC_SEC_NO_ACCESS,
+        .write_perm     = ESTC_SEC_OPEN,
+        .max_len        = ESTC_CHAR_MAX_LEN,
+        .p_value        = m_echo_value,
+        .p_init_value   = (uint8_t const *)"",
+        .init_value_len = 0,
+        .handles_offset = offsetof(ble_estc_service_t, echo_handle),
+        .on_value_write = estc_on_echo_write,
+    },
+    {
+        .uuid           = ESTC_CHAR_RELIABLE_UUID_16,
+        .props          = { .write = 1, .write_wo_resp = 1, .notify = 1 },
+        .read_perm      = ESTC_SEC_NO_ACCESS,
+        .write_perm     = ESTC_SEC_OPEN,
+        .max_len        = ESTC_CHAR_MAX_LEN,
+        .p_value        = m_reliable_value,
+        .p_init_value   = (uint8_t const *)"",
+        .init_value_len = 0,
+        .handles_offset = offsetof(ble_estc_service_t, reliable_handle),
+        .on_value_write = estc_on_reliable_write,
+    },
+#if ESTC_BENCH_ENABLED
+    {
+        .uuid           = ESTC_CHAR_BENCH_DATA_UUID_16,
+        .props          = { .notify = 1 },
+        .read_perm      = ESTC_SEC_NO_ACCESS,
+        .write_perm     = ESTC_SEC_NO_ACCESS,
+        .max_len        = ESTC_CHAR_MAX_LEN,
+        .p_value        = m_bench_data_value,
+        .p_init_value   = (uint8_t const *)"",
+        .init_value_len = 0,
+        .handles_offset = offsetof(ble_estc_service_t, bench_data_handle),
+    },
+    {
+        .uuid           = ESTC_CHAR_BENCH_REPORT_UUID_16,
+        .props          = { .read = 1, .write = 1, .notify = 1 },
+        .read_perm      = ESTC_SEC_OPEN,
+        .write_perm     = ESTC_SEC_OPEN,
+        .staged         = 1,
+        .max_len        = ESTC_CHAR_MAX_LEN,
+        .p_value        = m_bench_report_value,
+        .p_init_value   = (uint8_t const *)"",
+        .init_value_len = 0,
+        .handles_offset = offsetof(ble_estc_service_t, bench_report_handle),
+        .on_value_write = estc_on_bench_report_write,
+    },
+#endif
+#if ESTC_DSP_ENABLED
+    {
+        .uuid           = ESTC_CHAR_FEATURES_UUID_16,
+        .props          = { .notify = 1 },
+        .read_perm      = ESTC_SEC_NO_ACCESS,
+        .write_perm     = ESTC_SEC_NO_ACCESS,
+        .max_len        = ESTC_CHAR_MAX_LEN,
+        .p_value        = m_features_value,
+        .p_init_value   = (uint8_t const *)"",
+        .init_value_len = 0,
+        .handles_offset = offsetof(ble_estc_service_t, features_handle),
+        .on_cccd_write  = estc_on_features_cccd_write,
+    },
+#endif
+};
+
+#define ESTC_CHAR_COUNT ARRAY_SIZE(m_char_defs)                  /**< Number of characteristics of the service. */
+
+// Every characteristic has a bit in the subscription bitmaps
+STATIC_ASSERT(ESTC_CHAR_COUNT <= 8);
+
+/**@brief Ownership of one characteristic value buffer. */
+typedef struct
+{
+    bool      busy;                                 /**< The application is writing the buffer. */
+    uint16_t  deferred_read_conn[ESTC_LINK_COUNT];  /**< Connections whose reads wait for the write to finish, by link index. */
+} estc_value_t;
+
+static estc_value_t m_values[ESTC_CHAR_COUNT];                   /**< State of the value buffers, indexed like m_char_defs. */
+
+/**@brief Entry of the attribute dispatch table. */
+typedef struct
+{
+    estc_attr_write_handler_t on_write;     /**< Handler for writes, may be NULL. */
+    uint8_t                   value_index;  /**< Index in m_char_defs, ESTC_VALUE_INDEX_NONE for descriptors. */
+    uint8_t                   cccd_index;   /**< Index in m_char_defs of the CCCD owner, ESTC_VALUE_INDEX_NONE for other attributes. */
+} estc_attr_entry_t;
+
+// Handles of one characteristic at most: declaration, value, extended properties, user
+// description and CCCD, none of the characteristics broadcasts so there is no SCCD
+#define ESTC_CHAR_ATTR_MAX      5
+
+// Upper bound of the handles the service occupies: its own declaration and every row of m_char_defs
+#define ESTC_ATTR_TABLE_SIZE    (1 + ESTC_CHAR_ATTR_MAX * ESTC_CHAR_COUNT)
+
+// Grows with m_char_defs, but stays a small static array
+STATIC_ASSERT(ESTC_ATTR_TABLE_SIZE <= UINT8_MAX);
+
+#if !ESTC_SERVICE_VLOC_USER
+// The SoftDevice keeps every value at its max_len in its attribute table, next to some bytes of
+// bookkeeping per attribute, and fails sd_ble_gatts_characteristic_add with NRF_ERROR_NO_MEM
+// when the table is full
+STATIC_ASSERT(ESTC_CHAR1_MAX_LEN + (ESTC_CHAR_COUNT - 1) * ESTC_CHAR_MAX_LEN + 8 * ESTC_ATTR_TABLE_SIZE
+              <= NRF_SDH_BLE_GATTS_ATTR_TAB_SIZE);
+#endif
 
-static uint8_t                  m_char_desc[] = "Mercedes GLK";
+/**@brief Attribute entries indexed by attribute handle relative to the service handle.
+ *
+ * @details The SoftDevice allocates the handles of a service consecutively, so an event is
+ *          dispatched with one bounds check and one table lookup.
+ */
+static estc_attr_entry_t m_attr_table[ESTC_ATTR_TABLE_SIZE];
 
 static ret_code_t estc_ble_add_characteristics(ble_estc_service_t *service, const uint8_t uuid_type);
+static ret_code_t estc_ble_attr_table_init(ble_estc_service_t const *service);
+static void estc_char1_update_timeout_handler(void *ctx);
+static uint8_t estc_ble_char_bit(ble_estc_service_t const *service, uint16_t value_handle);
+static void estc_ble_on_tx_complete(void *ctx, uint16_t conn_handle, uint8_t completed);
+static void estc_ble_on_tx_load(void *ctx, uint16_t conn_handle, bool saturated);
+#if ESTC_BENCH_ENABLED
+static void estc_bench_done_handler(estc_bench_t *bench, bool completed);
+#endif
 
-ret_code_t estc_ble_service_init(ble_estc_service_t *service)
+/**@brief Function for getting the handles of a characteristic inside the service instance.
+ */
+static ble_gatts_char_handles_t * estc_char_handles(ble_estc_service_t const *service, estc_char_def_t const *def)
+{
+    return (ble_gatts_char_handles_t *)((uint8_t *)service + def->handles_offset);
+}
+
+ret_code_t estc_ble_service_init(ble_estc_service_t *service, estc_ble_service_init_t const *init)
 {
     ASSERT(NULL != service)
+    ASSERT(NULL != init)
     ret_code_t error_code = NRF_SUCCESS;
     ble_uuid128_t base_uuid = {ESTC_SERVICE_UUID_128};
     ble_uuid_t service_uuid;
@@ -67,118 +318,961 @@ ret_code_t estc_ble_service_init(ble_estc_service_t *service)
     // NRF_LOG_DEBUG("%s:%d | Service UUID type: 0x%02x", __FUNCTION__, __LINE__, service_uuid.type);
     // NRF_LOG_DEBUG("%s:%d | Service handle: 0x%04x", __FUNCTION__, __LINE__, service->service_handle);
 
-    return estc_ble_add_characteristics(service, service_uuid.type);
+    error_code = estc_ble_add_characteristics(service, service_uuid.type);
+    APP_ERROR_CHECK(error_code);
+
+    service->characteristic1_value                  = (int32_t)uint32_decode(m_char1_value);
+    service->characteristic1_pending                = service->characteristic1_value;
+    service->characteristic1_dirty                  = false;
+    service->characteristic1_updates                = 0;
+    service->characteristic1_updates_elided         = 0;
+    service->ingest_handler                         = init->ingest_handler;
+    service->activity_handler                       = init->activity_handler;
+    service->reliable_request_handler               = init->reliable_request_handler;
+    service->load_handler                           = init->load_handler;
+    service->ingest_bytes                           = 0;
+    service->ingest_overflow_bytes                  = 0;
+    service->echo_probes                            = 0;
+    service->echo_dropped                           = 0;
+    service->cccd_listeners                         = 0;
+    nrf_ringbuf_init(&m_char1_ringbuf);
+    error_code = estc_ble_attr_table_init(service);
+    APP_ERROR_CHECK(error_code);
+
+    uint8_t hvn_tx_queue_size = (0 != init->hvn_tx_queue_size) ? init->hvn_tx_queue_size
+                                                               : BLE_GATTS_HVN_TX_QUEUE_SIZE_DEFAULT;
+    error_code = estc_tx_init(&service->tx, hvn_tx_queue_size, estc_ble_on_tx_load, service);
+    APP_ERROR_CHECK(error_code);
+
+    error_code = estc_tx_client_register(&service->tx, estc_ble_on_tx_complete, service, &service->tx_client);
+    APP_ERROR_CHECK(error_code);
+
+    error_code = app_timer_create(&m_char1_update_timer, APP_TIMER_MODE_SINGLE_SHOT, estc_char1_update_timeout_handler);
+    APP_ERROR_CHECK(error_code);
+
+    error_code = estc_fanout_init(&service->characteristic3_fanout, &service->tx,
+                                  service->characterstic3_handle.value_handle);
+    APP_ERROR_CHECK(error_code);
+
+    error_code = estc_indicate_init(&service->characteristic2_indicate, service->characterstic2_handle.value_handle);
+    APP_ERROR_CHECK(error_code);
+
+    error_code = estc_arq_init(&service->reliable_arq,
+                               &service->tx,
+                               service->reliable_handle.value_handle,
+                               init->reliable_space_handler);
+    APP_ERROR_CHECK(error_code);
+
+#if ESTC_BENCH_ENABLED
+    error_code = estc_bench_init(&service->bench, &service->tx, service->bench_data_handle.value_handle,
+                                 estc_bench_done_handler);
+    APP_ERROR_CHECK(error_code);
+#endif
+
+#if ESTC_DSP_ENABLED
+    error_code = estc_fanout_init(&service->features_fanout, &service->tx, service->features_handle.value_handle);
+    APP_ERROR_CHECK(error_code);
+#endif
+
+    for (uint16_t i = 0; i < ESTC_LINK_COUNT; i++)
+    {
+        estc_link_t *link = &service->links[i];
+        memset(link, 0, sizeof(*link));
+        link->conn_handle = BLE_CONN_HANDLE_INVALID;
+        link->att_mtu     = BLE_GATT_ATT_MTU_DEFAULT;
+    }
+
+    return NRF_SUCCESS;
+}
+
+estc_link_t * estc_ble_service_link_get(ble_estc_service_t *service, uint16_t conn_handle)
+{
+    ASSERT(NULL != service)
+
+    uint16_t index = ble_conn_state_conn_idx(conn_handle);
+    if (index >= ESTC_LINK_COUNT)
+    {
+        return NULL;
+    }
+
+    return &service->links[index];
+}
+
+void estc_ble_service_att_mtu_set(ble_estc_service_t *service, uint16_t conn_handle, uint16_t att_mtu)
+{
+    ASSERT(NULL != service)
+
+    estc_link_t *link = estc_ble_service_link_get(service, conn_handle);
+    if (NULL == link)
+    {
+        return;
+    }
+
+    link->att_mtu = att_mtu;
+    estc_arq_att_mtu_set(&service->reliable_arq, conn_handle, att_mtu);
+    estc_fanout_att_mtu_set(&service->characteristic3_fanout, conn_handle, att_mtu);
+#if ESTC_DSP_ENABLED
+    estc_fanout_att_mtu_set(&service->features_fanout, conn_handle, att_mtu);
+#endif
+}
+
+ret_code_t estc_ble_service_sample_publish(ble_estc_service_t *service, uint8_t const *data, uint16_t len)
+{
+    ASSERT(NULL != service)
+
+    return estc_fanout_publish(&service->characteristic3_fanout, data, len);
+}
+
+uint32_t estc_ble_service_reliable_write(ble_estc_service_t *service, uint16_t conn_handle,
+                                         uint8_t const *data, uint32_t len)
+{
+    ASSERT(NULL != service)
+
+    return estc_arq_write(&service->reliable_arq, conn_handle, data, len);
+}
+
+uint16_t estc_ble_service_sample_max_len(ble_estc_service_t const *service)
+{
+    ASSERT(NULL != service)
+
+    return estc_fanout_max_len(&service->characteristic3_fanout);
+}
+
+ret_code_t estc_ble_service_sample_stats_get(ble_estc_service_t const *service, uint16_t conn_handle,
+                                             estc_fanout_stats_t *stats)
+{
+    ASSERT(NULL != service)
+
+    return estc_fanout_stats_get(&service->characteristic3_fanout, conn_handle, stats);
+}
+
+#if ESTC_DSP_ENABLED
+ret_code_t estc_ble_service_features_publish(ble_estc_service_t *service, uint8_t const *data, uint16_t len)
+{
+    ASSERT(NULL != service)
+
+    return estc_fanout_publish(&service->features_fanout, data, len);
+}
+#endif
+
+ret_code_t estc_ble_service_alarm_send(ble_estc_service_t *service, uint8_t const *data, uint16_t len, uint8_t key)
+{
+    ASSERT(NULL != service)
+
+    return estc_indicate_send(&service->characteristic2_indicate, data, len, key);
+}
+
+void estc_update_characteristic_1_value(ble_estc_service_t *service, int32_t *value)
+{
+    ASSERT(NULL != service)
+    ASSERT(NULL != value)
+    bool schedule = false;
+
+    CRITICAL_REGION_ENTER();
+    service->characteristic1_updates++;
+    if (service->characteristic1_dirty)
+    {
+        // The scheduled commit will write this value instead of the previous one
+        service->characteristic1_pending = *value;
+        service->characteristic1_updates_elided++;
+    }
+    else if (*value == service->characteristic1_value)
+    {
+        service->characteristic1_updates_elided++;
+    }
+    else
+    {
+        service->characteristic1_pending = *value;
+        service->characteristic1_dirty   = true;
+        schedule = true;
+    }
+    CRITICAL_REGION_EXIT();
+
+    if (!schedule)
+    {
+        return;
+    }
+
+    uint32_t period_ms = ESTC_UPDATE_DEFAULT_PERIOD_MS;
+    for (uint16_t i = 0; i < ESTC_LINK_COUNT; i++)
+    {
+        // Commit at the pace of the fastest connected central
+        uint16_t conn_interval = service->links[i].conn_interval;
+        if (BLE_CONN_HANDLE_INVALID != service->links[i].conn_handle && 0 != conn_interval)
+        {
+            period_ms = MIN(period_ms, (conn_interval * UNIT_1_25_MS) / 1000);
+        }
+    }
+    ret_code_t error_code = app_timer_start(m_char1_update_timer, APP_TIMER_TICKS(period_ms), service);
+    APP_ERROR_CHECK(error_code);
+}
+
+static void estc_char1_update_timeout_handler(void *ctx)
+{
+    ble_estc_service_t *service = (ble_estc_service_t *)ctx;
+
+    int32_t value;
+
+    CRITICAL_REGION_ENTER();
+    value = service->characteristic1_pending;
+    service->characteristic1_dirty = false;
+    CRITICAL_REGION_EXIT();
+
+    if (value == service->characteristic1_value)
+    {
+        // The burst ended where it started
+        return;
+    }
+
+    uint16_t value_handle = service->characterstic1_handle.value_handle;
+    uint8_t *buffer = estc_ble_service_value_begin(service, value_handle);
+    uint16_t len = uint32_encode((uint32_t)value, buffer);
+    ret_code_t error_code = estc_ble_service_value_commit(service, value_handle, len);
+    APP_ERROR_CHECK(error_code);
+    service->characteristic1_value = value;
+
+    NRF_LOG_DEBUG("Characteristic 1 committed, %d of %d updates elided",
+                  service->characteristic1_updates_elided, service->characteristic1_updates);
+}
+
+static void estc_on_char1_write(ble_estc_service_t *service, estc_link_t *link,
+                                uint16_t offset, uint8_t const *data, uint16_t len)
+{
+    size_t queued = len;
+    ret_code_t error_code = nrf_ringbuf_cpy_put(&m_char1_ringbuf, data, &queued);
+    if (NRF_SUCCESS != error_code)
+    {
+        queued = 0;
+    }
+    service->ingest_bytes          += queued;
+    service->ingest_overflow_bytes += len - queued;
+
+    if (0 == offset && sizeof(int32_t) == len)
+    {
+        // Keep change detection in line with what the peer wrote
+        service->characteristic1_value = (int32_t)uint32_decode(data);
+    }
+}
+
+void estc_ble_service_process(ble_estc_service_t *service)
+{
+    ASSERT(NULL != service)
+
+    for (;;)
+    {
+        uint8_t *data = NULL;
+        size_t length = ESTC_INGEST_BUFFER_SIZE;
+        ret_code_t error_code = nrf_ringbuf_get(&m_char1_ringbuf, &data, &length, true);
+        APP_ERROR_CHECK(error_code);
+
+        if (0 == length)
+        {
+            nrf_ringbuf_free(&m_char1_ringbuf, 0);
+            return;
+        }
+
+        if (NULL != service->ingest_handler)
+        {
+            service->ingest_handler(data, length);
+        }
+
+        error_code = nrf_ringbuf_free(&m_char1_ringbuf, length);
+        APP_ERROR_CHECK(error_code);
+    }
+}
+
+static void estc_on_char2_cccd_write(ble_estc_service_t *service, estc_link_t *link,
+                                     uint16_t offset, uint8_t const *data, uint16_t len)
+{
+    bool enabled = ble_srv_is_indication_enabled(data);
+    NRF_LOG_INFO("Characteristic 2 indications %s (conn_handle: %d)",
+                 enabled ? "enabled" : "disabled", link->conn_handle);
+
+    estc_indicate_subscribe_set(&service->characteristic2_indicate, link->conn_handle, enabled);
+}
+
+static void estc_on_char3_cccd_write(ble_estc_service_t *service, estc_link_t *link,
+                                     uint16_t offset, uint8_t const *data, uint16_t len)
+{
+    bool enabled = ble_srv_is_notification_enabled(data);
+    NRF_LOG_INFO("Characteristic 3 notifications %s (conn_handle: %d)",
+                 enabled ? "enabled" : "disabled", link->conn_handle);
+
+    estc_fanout_subscribe_set(&service->characteristic3_fanout, link->conn_handle, enabled);
+}
+
+/**@brief Function for notifying a latency probe back to the peer.
+ *
+ * @details The notification carries the RTC tick at which the write was handled and the tick at
+ *          which the notification was queued, followed by the written data, truncated to fit.
+ *          The peer measures the round trip; the two ticks split it into the inbound path and
+ *          the time the probe spent in the firmware.
+ */
+static void estc_on_echo_write(ble_estc_service_t *service, estc_link_t *link,
+                               uint16_t offset, uint8_t const *data, uint16_t len)
+{
+    uint32_t rx_ticks = app_timer_cnt_get();
+    uint8_t packet[ESTC_CHAR_MAX_LEN];
+
+    if (0 != offset)
+    {
+        return;
+    }
+    service->echo_probes++;
+
+    if (0 == (link->cccd_bitmap & estc_ble_char_bit(service, service->echo_handle.value_handle)))
+    {
+        service->echo_dropped++;
+        return;
+    }
+
+    uint16_t data_len = MIN(len, link->att_mtu - ESTC_TX_ATT_HEADER_LEN - ESTC_ECHO_HEADER_LEN);
+    memcpy(&packet[ESTC_ECHO_HEADER_LEN], data, data_len);
+    uint16_t packet_len = ESTC_ECHO_HEADER_LEN + data_len;
+
+    (void)uint32_encode(rx_ticks, &packet[0]);
+    (void)uint32_encode(app_timer_cnt_get(), &packet[sizeof(uint32_t)]);
+
+    ret_code_t error_code = estc_tx_notify(&service->tx, service->tx_client, link->conn_handle,
+                                           service->echo_handle.value_handle, packet, &packet_len);
+    if (NRF_SUCCESS != error_code)
+    {
+        // TX queue full or notifications disabled, the peer sees the probe as lost
+        service->echo_dropped++;
+    }
+}
+
+/**@brief Function for handling a write to the reliable characteristic.
+ *
+ * @details The central writes acknowledgements of the frames it received, and a byte count
+ *          (uint32, little-endian) to request a transfer of that many bytes.
+ */
+static void estc_on_reliable_write(ble_estc_service_t *service, estc_link_t *link,
+                                   uint16_t offset, uint8_t const *data, uint16_t len)
+{
+    if (0 != offset || estc_arq_on_ack(&service->reliable_arq, link->conn_handle, data, len))
+    {
+        return;
+    }
+
+    if (sizeof(uint32_t) == len && NULL != service->reliable_request_handler)
+    {
+        service->reliable_request_handler(link->conn_handle, uint32_decode(data));
+    }
+}
+
+/**@brief Function for handling transmitted notifications of the link.
+ *
+ * @details Echoes and reports are sent once, a probe that found no credit is already counted
+ *          as dropped, so there is nothing to send again. The handler still runs for the
+ *          notifications of every sender, which makes it the place to report transmit traffic.
+ */
+static void estc_ble_on_tx_complete(void *ctx, uint16_t conn_handle, uint8_t completed)
+{
+    ble_estc_service_t *service = (ble_estc_service_t *)ctx;
+
+    if (NULL != service->activity_handler)
+    {
+        service->activity_handler(conn_handle);
+    }
+}
+
+/**@brief Function for passing saturation changes of the notification queues to the application.
+ */
+static void estc_ble_on_tx_load(void *ctx, uint16_t conn_handle, bool saturated)
+{
+    ble_estc_service_t *service = (ble_estc_service_t *)ctx;
+
+    if (NULL != service->load_handler)
+    {
+        service->load_handler(conn_handle, saturated);
+    }
+}
+
+#if ESTC_DSP_ENABLED
+static void estc_on_features_cccd_write(ble_estc_service_t *service, estc_link_t *link,
+                                        uint16_t offset, uint8_t const *data, uint16_t len)
+{
+    bool enabled = ble_srv_is_notification_enabled(data);
+    NRF_LOG_INFO("Features notifications %s (conn_handle: %d)",
+                 enabled ? "enabled" : "disabled", link->conn_handle);
+
+    estc_fanout_subscribe_set(&service->features_fanout, link->conn_handle, enabled);
+}
+#endif
+
+#if ESTC_BENCH_ENABLED
+static void estc_on_bench_report_write(ble_estc_service_t *service, estc_link_t *link,
+                                       uint16_t offset, uint8_t const *data, uint16_t len)
+{
+    if (0 != offset || sizeof(uint32_t) != len)
+    {
+        return;
+    }
+
+    if (0 == (link->cccd_bitmap & estc_ble_char_bit(service, service->bench_data_handle.value_handle)))
+    {
+        NRF_LOG_WARNING("Benchmark not started, data notifications are disabled");
+        return;
+    }
+
+    if (!service->bench.running)
+    {
+        // Packets fill the notifications of the requesting link
+        estc_bench_att_mtu_set(&service->bench, link->att_mtu);
+    }
+
+    ret_code_t error_code = estc_bench_start(&service->bench, link->conn_handle, uint32_decode(data));
+    if (NRF_SUCCESS != error_code)
+    {
+        NRF_LOG_WARNING("Benchmark not started, error 0x%x", error_code);
+    }
+}
+
+/**@brief Function for publishing the report of a completed benchmark run.
+ */
+static void estc_bench_done_handler(estc_bench_t *bench, bool completed)
+{
+    ble_estc_service_t *service = (ble_estc_service_t *)((uint8_t *)bench - offsetof(ble_estc_service_t, bench));
+    uint16_t value_handle = service->bench_report_handle.value_handle;
+
+    if (!completed)
+    {
+        return;
+    }
+
+    uint8_t *buffer = estc_ble_service_value_begin(service, value_handle);
+    uint16_t len = estc_bench_report_encode(&bench->report, buffer);
+    ret_code_t error_code = estc_ble_service_value_commit(service, value_handle, len);
+    APP_ERROR_CHECK(error_code);
+
+    estc_link_t *link = estc_ble_service_link_get(service, bench->conn_handle);
+    if (NULL == link || !estc_ble_service_link_is_subscribed(service, bench->conn_handle, value_handle))
+    {
+        return;
+    }
+
+    // Notify the value committed above
+    error_code = estc_tx_notify(&service->tx, service->tx_client, bench->conn_handle, value_handle, NULL, &len);
+    if (NRF_SUCCESS != error_code)
+    {
+        // The peer can still read the report
+        NRF_LOG_WARNING("Benchmark report not notified, error 0x%x", error_code);
+    }
+}
+#endif
+
+/**@brief Function for setting the dispatch table entry of an attribute.
+ *
+ * @retval NRF_ERROR_NO_MEM  The handle is beyond ESTC_ATTR_TABLE_SIZE, a characteristic has more
+ *                           attributes than ESTC_CHAR_ATTR_MAX.
+ */
+static ret_code_t estc_ble_attr_entry_set(ble_estc_service_t const *service,
+                                          uint16_t handle,
+                                          estc_attr_write_handler_t on_write,
+                                          uint8_t value_index,
+                                          uint8_t cccd_index)
+{
+    if (BLE_GATT_HANDLE_INVALID == handle)
+    {
+        return NRF_SUCCESS;
+    }
+
+    uint16_t index = handle - service->service_handle;
+    if (index >= ESTC_ATTR_TABLE_SIZE)
+    {
+        return NRF_ERROR_NO_MEM;
+    }
+    m_attr_table[index].on_write    = on_write;
+    m_attr_table[index].value_index = value_index;
+    m_attr_table[index].cccd_index  = cccd_index;
+
+    return NRF_SUCCESS;
+}
+
+static ret_code_t estc_ble_attr_table_init(ble_estc_service_t const *service)
+{
+    ret_code_t error_code;
+
+    for (uint16_t i = 0; i < ESTC_ATTR_TABLE_SIZE; i++)
+    {
+        m_attr_table[i].on_write    = NULL;
+        m_attr_table[i].value_index = ESTC_VALUE_INDEX_NONE;
+        m_attr_table[i].cccd_index  = ESTC_VALUE_INDEX_NONE;
+    }
+
+    for (uint8_t i = 0; i < ESTC_CHAR_COUNT; i++)
+    {
+        estc_char_def_t const *def = &m_char_defs[i];
+        ble_gatts_char_handles_t const *handles = estc_char_handles(service, def);
+
+        error_code = estc_ble_attr_entry_set(service, handles->value_handle, def->on_value_write, i,
+                                             ESTC_VALUE_INDEX_NONE);
+        VERIFY_SUCCESS(error_code);
+        error_code = estc_ble_attr_entry_set(service, handles->cccd_handle, NULL, ESTC_VALUE_INDEX_NONE, i);
+        VERIFY_SUCCESS(error_code);
+
+        m_values[i].busy = false;
+        for (uint16_t j = 0; j < ESTC_LINK_COUNT; j++)
+        {
+            m_values[i].deferred_read_conn[j] = BLE_CONN_HANDLE_INVALID;
+        }
+    }
+
+    return NRF_SUCCESS;
+}
+
+/**@brief Function for looking up the dispatch table entry of an attribute.
+ *
+ * @return Entry of the attribute, NULL if the handle does not belong to the service.
+ */
+static estc_attr_entry_t const * estc_ble_attr_entry_get(ble_estc_service_t const *service, uint16_t handle)
+{
+    // Unsigned subtraction also maps handles below the service out of range
+    uint16_t index = handle - service->service_handle;
+    if (index >= ESTC_ATTR_TABLE_SIZE)
+    {
+        return NULL;
+    }
+
+    return &m_attr_table[index];
+}
+
+/**@brief Function for getting the subscription bit of a characteristic.
+ *
+ * @return Bit of the characteristic in the subscription bitmaps, 0 for an unknown handle.
+ */
+static uint8_t estc_ble_char_bit(ble_estc_service_t const *service, uint16_t value_handle)
+{
+    estc_attr_entry_t const *entry = estc_ble_attr_entry_get(service, value_handle);
+    if (NULL == entry || ESTC_VALUE_INDEX_NONE == entry->value_index)
+    {
+        return 0;
+    }
+
+    return (uint8_t)(1 << entry->value_index);
+}
+
+/**@brief Function for recomputing the subscriptions of all connected links.
+ */
+static void estc_ble_listeners_update(ble_estc_service_t *service)
+{
+    uint8_t listeners = 0;
+    for (uint16_t i = 0; i < ESTC_LINK_COUNT; i++)
+    {
+        if (BLE_CONN_HANDLE_INVALID != service->links[i].conn_handle)
+        {
+            listeners |= service->links[i].cccd_bitmap;
+        }
+    }
+    service->cccd_listeners = listeners;
+}
+
+/**@brief Function for applying a CCCD value of a link, written by the peer or restored.
+ */
+static void estc_ble_cccd_apply(ble_estc_service_t *service, estc_link_t *link, uint8_t char_index,
+                                uint8_t const *data, uint16_t len)
+{
+    if (BLE_CCCD_VALUE_LEN != len)
+    {
+        return;
+    }
+
+    uint8_t bit = (uint8_t)(1 << char_index);
+    if (0 != uint16_decode(data))
+    {
+        link->cccd_bitmap |= bit;
+    }
+    else
+    {
+        link->cccd_bitmap &= (uint8_t)~bit;
+    }
+    estc_ble_listeners_update(service);
+
+    if (NULL != m_char_defs[char_index].on_cccd_write)
+    {
+        m_char_defs[char_index].on_cccd_write(service, link, 0, data, len);
+    }
+}
+
+bool estc_ble_service_is_subscribed(ble_estc_service_t const *service, uint16_t value_handle)
+{
+    ASSERT(NULL != service)
+
+    return 0 != (service->cccd_listeners & estc_ble_char_bit(service, value_handle));
+}
+
+bool estc_ble_service_link_is_subscribed(ble_estc_service_t *service, uint16_t conn_handle, uint16_t value_handle)
+{
+    ASSERT(NULL != service)
+
+    estc_link_t *link = estc_ble_service_link_get(service, conn_handle);
+    if (NULL == link || BLE_CONN_HANDLE_INVALID == link->conn_handle)
+    {
+        return false;
+    }
+
+    return 0 != (link->cccd_bitmap & estc_ble_char_bit(service, value_handle));
+}
+
+void estc_ble_service_subscriptions_restore(ble_estc_service_t *service, uint16_t conn_handle)
+{
+    ASSERT(NULL != service)
+
+    estc_link_t *link = estc_ble_service_link_get(service, conn_handle);
+    if (NULL == link)
+    {
+        return;
+    }
+
+    for (uint8_t i = 0; i < ESTC_CHAR_COUNT; i++)
+    {
+        uint16_t cccd_handle = estc_char_handles(service, &m_char_defs[i])->cccd_handle;
+        if (BLE_GATT_HANDLE_INVALID == cccd_handle)
+        {
+            continue;
+        }
+
+        uint8_t cccd[BLE_CCCD_VALUE_LEN] = { 0 };
+        ble_gatts_value_t gatts_value = { 0 };
+        gatts_value.len     = sizeof(cccd);
+        gatts_value.p_value = cccd;
+
+        // Fails with BLE_ERROR_GATTS_SYS_ATTR_MISSING until system attributes are set
+        ret_code_t error_code = sd_ble_gatts_value_get(conn_handle, cccd_handle, &gatts_value);
+        if (NRF_SUCCESS != error_code)
+        {
+            continue;
+        }
+
+        uint8_t bit = (uint8_t)(1 << i);
+        if ((0 != uint16_decode(cccd)) != (0 != (link->cccd_bitmap & bit)))
+        {
+            estc_ble_cccd_apply(service, link, i, cccd, sizeof(cccd));
+        }
+    }
+}
+
+/**@brief Function for applying a write to an attribute of the service.
+ */
+static void estc_ble_attr_write(ble_estc_service_t *service, uint16_t conn_handle, estc_attr_entry_t const *entry,
+                                uint16_t offset, uint8_t const *data, uint16_t len)
+{
+    estc_link_t *link = estc_ble_service_link_get(service, conn_handle);
+    if (NULL == link)
+    {
+        return;
+    }
+
+    if (NULL != service->activity_handler)
+    {
+        service->activity_handler(conn_handle);
+    }
+
+    if (ESTC_VALUE_INDEX_NONE != entry->cccd_index)
+    {
+        estc_ble_cccd_apply(service, link, entry->cccd_index, data, len);
+    }
+    else if (NULL != entry->on_write)
+    {
+        entry->on_write(service, link, offset, data, len);
+    }
+}
+
+static void estc_ble_on_write(ble_estc_service_t *service, uint16_t conn_handle, ble_gatts_evt_write_t const *write)
+{
+    estc_attr_entry_t const *entry = estc_ble_attr_entry_get(service, write->handle);
+    if (NULL != entry)
+    {
+        estc_ble_attr_write(service, conn_handle, entry, write->offset, write->data, write->len);
+    }
+}
+
+void estc_ble_service_on_long_write(ble_estc_service_t *service, uint16_t conn_handle, uint16_t handle,
+                                    uint8_t const *data, uint16_t len)
+{
+    ASSERT(NULL != service)
+
+    estc_attr_entry_t const *entry = estc_ble_attr_entry_get(service, handle);
+    if (NULL != entry)
+    {
+        estc_ble_attr_write(service, conn_handle, entry, 0, data, len);
+    }
+}
+
+/**@brief Function for accepting a write to an attribute with write authorization.
+ *
+ * @details Characteristic 1 is authorized so the Queued Write module can take over long writes.
+ *          Prepare and execute requests are answered by that module, plain writes are applied here.
+ */
+static void estc_ble_on_write_authorize_request(ble_estc_service_t *service, uint16_t conn_handle,
+                                                ble_gatts_evt_write_t const *write)
+{
+    if (BLE_GATTS_OP_WRITE_REQ != write->op && BLE_GATTS_OP_WRITE_CMD != write->op)
+    {
+        return;
+    }
+
+    estc_attr_entry_t const *entry = estc_ble_attr_entry_get(service, write->handle);
+    if (NULL == entry)
+    {
+        return;
+    }
+
+    ble_gatts_rw_authorize_reply_params_t reply = { 0 };
+    reply.type                      = BLE_GATTS_AUTHORIZE_TYPE_WRITE;
+    reply.params.write.gatt_status  = BLE_GATT_STATUS_SUCCESS;
+    reply.params.write.update       = 1;
+    reply.params.write.offset       = write->offset;
+    reply.params.write.len          = write->len;
+    reply.params.write.p_data       = write->data;
+
+    ret_code_t error_code = sd_ble_gatts_rw_authorize_reply(conn_handle, &reply);
+    if (NRF_ERROR_INVALID_STATE == error_code || BLE_ERROR_INVALID_CONN_HANDLE == error_code)
+    {
+        return;
+    }
+    APP_ERROR_CHECK(error_code);
+
+    estc_ble_attr_write(service, conn_handle, entry, write->offset, write->data, write->len);
+}
+
+static void estc_ble_read_authorize(uint16_t conn_handle)
+{
+    ble_gatts_rw_authorize_reply_params_t reply = { 0 };
+    reply.type                     = BLE_GATTS_AUTHORIZE_TYPE_READ;
+    reply.params.read.gatt_status  = BLE_GATT_STATUS_SUCCESS;
+    reply.params.read.update       = 0;     // Serve the value straight from the application buffer
+
+    ret_code_t error_code = sd_ble_gatts_rw_authorize_reply(conn_handle, &reply);
+    if (NRF_ERROR_INVALID_STATE == error_code || BLE_ERROR_INVALID_CONN_HANDLE == error_code)
+    {
+        // The peer disconnected in the meantime
+        return;
+    }
+    APP_ERROR_CHECK(error_code);
+}
+
+/**@brief Function for dropping the deferred reads of a connection, its link may be reused before the next commit.
+ */
+static void estc_ble_deferred_reads_clear(uint16_t conn_handle)
+{
+    uint16_t index = ble_conn_state_conn_idx(conn_handle);
+    if (index >= ESTC_LINK_COUNT)
+    {
+        return;
+    }
+
+    CRITICAL_REGION_ENTER();
+    for (uint8_t i = 0; i < ESTC_CHAR_COUNT; i++)
+    {
+        m_values[i].deferred_read_conn[index] = BLE_CONN_HANDLE_INVALID;
+    }
+    CRITICAL_REGION_EXIT();
+}
+
+static void estc_ble_on_rw_authorize_request(ble_estc_service_t *service, uint16_t conn_handle,
+                                             ble_gatts_evt_rw_authorize_request_t const *request)
+{
+    if (BLE_GATTS_AUTHORIZE_TYPE_WRITE == request->type)
+    {
+        estc_ble_on_write_authorize_request(service, conn_handle, &request->request.write);
+        return;
+    }
+    if (BLE_GATTS_AUTHORIZE_TYPE_READ != request->type)
+    {
+        return;
+    }
+
+    estc_attr_entry_t const *entry = estc_ble_attr_entry_get(service, request->request.read.handle);
+    if (NULL == entry || ESTC_VALUE_INDEX_NONE == entry->value_index)
+    {
+        return;
+    }
+
+    estc_value_t *value = &m_values[entry->value_index];
+    uint16_t index = ble_conn_state_conn_idx(conn_handle);
+    bool defer = false;
+
+    CRITICAL_REGION_ENTER();
+    if (value->busy && index < ESTC_LINK_COUNT)
+    {
+        // The reply is sent when the writer commits the value, each link has at most one read pending
+        value->deferred_read_conn[index] = conn_handle;
+        defer = true;
+    }
+    CRITICAL_REGION_EXIT();
+
+    if (!defer)
+    {
+        estc_ble_read_authorize(conn_handle);
+    }
+}
+
+uint8_t * estc_ble_service_value_begin(ble_estc_service_t *service, uint16_t value_handle)
+{
+    ASSERT(NULL != service)
+
+    estc_attr_entry_t const *entry = estc_ble_attr_entry_get(service, value_handle);
+    if (NULL == entry || ESTC_VALUE_INDEX_NONE == entry->value_index || !m_char_defs[entry->value_index].staged)
+    {
+        return NULL;
+    }
+
+    estc_value_t *value = &m_values[entry->value_index];
+    CRITICAL_REGION_ENTER();
+    value->busy = true;
+    CRITICAL_REGION_EXIT();
+
+    return m_char_defs[entry->value_index].p_value;
+}
+
+ret_code_t estc_ble_service_value_commit(ble_estc_service_t *service, uint16_t value_handle, uint16_t len)
+{
+    ASSERT(NULL != service)
+    ASSERT(len <= ESTC_CHAR_MAX_LEN)
+
+    estc_attr_entry_t const *entry = estc_ble_attr_entry_get(service, value_handle);
+    if (NULL == entry || ESTC_VALUE_INDEX_NONE == entry->value_index || !m_char_defs[entry->value_index].staged)
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+
+    estc_value_t *value = &m_values[entry->value_index];
+    ble_gatts_value_t gatts_value = { 0 };
+    gatts_value.len    = len;
+    gatts_value.offset = 0;
+#if ESTC_SERVICE_VLOC_USER
+    // The buffer already is the attribute value, only its length is updated
+    gatts_value.p_value = NULL;
+#else
+    gatts_value.p_value = m_char_defs[entry->value_index].p_value;
+#endif
+    ret_code_t error_code = sd_ble_gatts_value_set(BLE_CONN_HANDLE_INVALID, value_handle, &gatts_value);
+
+    uint16_t deferred_read_conn[ESTC_LINK_COUNT];
+
+    CRITICAL_REGION_ENTER();
+    memcpy(deferred_read_conn, value->deferred_read_conn, sizeof(deferred_read_conn));
+    for (uint16_t i = 0; i < ESTC_LINK_COUNT; i++)
+    {
+        value->deferred_read_conn[i] = BLE_CONN_HANDLE_INVALID;
+    }
+    value->busy = false;
+    CRITICAL_REGION_EXIT();
+
+    for (uint16_t i = 0; i < ESTC_LINK_COUNT; i++)
+    {
+        if (BLE_CONN_HANDLE_INVALID != deferred_read_conn[i])
+        {
+            estc_ble_read_authorize(deferred_read_conn[i]);
+        }
+    }
+
+    return error_code;
+}
+
+void estc_ble_service_on_ble_event(const ble_evt_t *ble_evt, void *ctx)
+{
+    ble_estc_service_t *service = (ble_estc_service_t *)ctx;
+
+    // Credits first, so the senders see them returned or reset
+    estc_tx_on_ble_event(ble_evt, &service->tx);
+#if ESTC_BENCH_ENABLED
+    estc_bench_on_ble_event(ble_evt, &service->bench);
+#endif
+    estc_fanout_on_ble_event(ble_evt, &service->characteristic3_fanout);
+#if ESTC_DSP_ENABLED
+    estc_fanout_on_ble_event(ble_evt, &service->features_fanout);
+#endif
+    estc_indicate_on_ble_event(ble_evt, &service->characteristic2_indicate);
+    estc_arq_on_ble_event(ble_evt, &service->reliable_arq);
+
+    // Every BLE event starts with the handle of its connection
+    estc_link_t *link = estc_ble_service_link_get(service, ble_evt->evt.gap_evt.conn_handle);
+    if (NULL == link)
+    {
+        return;
+    }
+
+    switch (ble_evt->header.evt_id)
+    {
+        case BLE_GAP_EVT_CONNECTED:
+            link->conn_handle                            = ble_evt->evt.gap_evt.conn_handle;
+            link->conn_interval                          = ble_evt->evt.gap_evt.params.connected.conn_params.max_conn_interval;
+            link->att_mtu                                = BLE_GATT_ATT_MTU_DEFAULT;
+            link->cccd_bitmap                            = 0;
+            // System attributes of a bonded peer may already be applied
+            estc_ble_service_subscriptions_restore(service, link->conn_handle);
+            break;
+
+        case BLE_GAP_EVT_DISCONNECTED:
+            estc_ble_deferred_reads_clear(ble_evt->evt.gap_evt.conn_handle);
+            link->conn_handle   = BLE_CONN_HANDLE_INVALID;
+            link->conn_interval = 0;
+            link->cccd_bitmap   = 0;
+            estc_ble_listeners_update(service);
+            break;
+
+        case BLE_GAP_EVT_CONN_PARAM_UPDATE:
+            link->conn_interval = ble_evt->evt.gap_evt.params.conn_param_update.conn_params.max_conn_interval;
+            break;
+
+        case BLE_GATTS_EVT_WRITE:
+            estc_ble_on_write(service, ble_evt->evt.gatts_evt.conn_handle, &ble_evt->evt.gatts_evt.params.write);
+            break;
+
+        case BLE_GATTS_EVT_RW_AUTHORIZE_REQUEST:
+            estc_ble_on_rw_authorize_request(service,
+                                             ble_evt->evt.gatts_evt.conn_handle,
+                                             &ble_evt->evt.gatts_evt.params.authorize_request);
+            break;
+
+        default:
+            break;
+    }
 }
 
 static ret_code_t estc_ble_add_characteristics(ble_estc_service_t *service, const uint8_t uuid_type)
 {
     ASSERT(NULL != service)
     ret_code_t error_code = NRF_SUCCESS;
-    ble_uuid_t characteristic1_uuid;
-    ble_uuid_t characteristic2_uuid;
-    ble_uuid_t characteristic3_uuid;
-      
-    characteristic1_uuid.uuid = ESTC_CHAR_1_UUID_16; /**< 16-bit UUID value or octets 12-13 of 128-bit UUID. */
-    characteristic1_uuid.type = uuid_type;
-    characteristic2_uuid.uuid = ESTC_CHAR_2_UUID_16;
-    characteristic2_uuid.type = uuid_type;
-    characteristic3_uuid.uuid = ESTC_CHAR_3_UUID_16;
-    characteristic3_uuid.type = uuid_type;
-
-    // Configure Characteristic metadata (enable read and write)
-    ble_gatts_char_md_t char1_md = { 0 };
-    char1_md.char_props.read  = 1;
-    char1_md.char_props.write = 1;
-
-    ble_gatts_char_md_t char2_md = { 0 };
-    char2_md.char_props.read  = 1;
-    char2_md.char_props.indicate = 1;
-
-    ble_gatts_char_md_t char3_md = { 0 };    
-    char3_md.char_props.read  = 1;
-    char3_md.char_props.notify = 1;
-
-    // Additional descriptor
-    char1_md.p_char_user_desc = m_char_desc;
-    char1_md.char_user_desc_max_size = sizeof(m_char_desc);
-    char1_md.char_user_desc_size = sizeof(m_char_desc);
-
-    // Configures attribute metadata. For now we only specify that the attribute will be stored in the softdevice
-    ble_gatts_attr_md_t attr1_md = { 0 };
-    attr1_md.vloc = BLE_GATTS_VLOC_STACK;
-    
-    ble_gatts_attr_md_t attr2_md = { 0 };
-    attr2_md.vloc = BLE_GATTS_VLOC_STACK;
-
-    ble_gatts_attr_md_t attr3_md = { 0 };
-    attr3_md.vloc = BLE_GATTS_VLOC_STACK;
-
-    // Set read/write security levels to our attribute metadata
-    BLE_GAP_CONN_SEC_MODE_SET_OPEN(&attr1_md.read_perm);
-    BLE_GAP_CONN_SEC_MODE_SET_OPEN(&attr1_md.write_perm);
-
-    BLE_GAP_CONN_SEC_MODE_SET_OPEN(&attr2_md.read_perm);
-    BLE_GAP_CONN_SEC_MODE_SET_NO_ACCESS(&attr2_md.write_perm);
-
-    BLE_GAP_CONN_SEC_MODE_SET_OPEN(&attr3_md.read_perm);
-    BLE_GAP_CONN_SEC_MODE_SET_NO_ACCESS(&attr3_md.write_perm);
-
-    // Configure the characteristic value attribute
-    ble_gatts_attr_t attr_char1_value = { 0 };
-    attr_char1_value.p_uuid = &characteristic1_uuid;
-    attr_char1_value.p_attr_md = &attr1_md;
-
-    ble_gatts_attr_t attr_char2_value = { 0 };
-    attr_char2_value.p_uuid = &characteristic2_uuid;
-    attr_char2_value.p_attr_md = &attr2_md;
-
-    ble_gatts_attr_t attr_char3_value = { 0 };
-    attr_char3_value.p_uuid = &characteristic3_uuid;
-    attr_char3_value.p_attr_md = &attr3_md;
-
-    m_char1_value[0] = 'A';
-    m_char1_value[1] = 'n';
-    m_char1_value[2] = 'd';
-    m_char1_value[3] = 'r';
-    m_char1_value[4] = 'e';
-    m_char1_value[5] = 'w';
-
-    m_char2_value[0] = 'X';
-
-    m_char3_value[0] = 'Y';
-
-    // Set characteristic length in number of bytes in attr_char_value structure
-    attr_char1_value.init_len  = ESTC_CHAR_LEN;
-    attr_char1_value.init_offs = 0;
-    attr_char1_value.max_len   = ESTC_CHAR_LEN;
-    attr_char1_value.p_value   = m_char1_value;
-
-    attr_char2_value.init_len  = ESTC_CHAR_LEN;
-    attr_char2_value.init_offs = 0;
-    attr_char2_value.max_len   = ESTC_CHAR_LEN;
-    attr_char2_value.p_value   = m_char2_value;
-
-    attr_char3_value.init_len  = ESTC_CHAR_LEN;
-    attr_char3_value.init_offs = 0;
-    attr_char3_value.max_len   = ESTC_CHAR_LEN;
-    attr_char3_value.p_value   = m_char3_value;
-
-    // Add new characteristic to the service
-    error_code = sd_ble_gatts_characteristic_add(service->service_handle,
-                                               &char1_md,
-                                               &attr_char1_value,
-                                               &(service->characterstic1_handle));
-
-    error_code = sd_ble_gatts_characteristic_add(service->service_handle,
-                                               &char2_md,
-                                               &attr_char2_value,
-                                               &(service->characterstic2_handle));
-
-    error_code = sd_ble_gatts_characteristic_add(service->service_handle,
-                                               &char3_md,
-                                               &attr_char3_value,
-                                               &(service->characterstic3_handle));
 
-    APP_ERROR_CHECK(error_code);
+    for (uint8_t i = 0; i < ESTC_CHAR_COUNT; i++)
+    {
+        estc_char_def_t const *def = &m_char_defs[i];
+        ble_uuid_t char_uuid = { .uuid = def->uuid, .type = uuid_type };
+
+        ble_gatts_char_md_t char_md = { 0 };
+        char_md.char_props              = def->props;
+        char_md.p_char_user_desc        = def->p_user_desc;
+        char_md.char_user_desc_max_size = def->user_desc_len;
+        char_md.char_user_desc_size     = def->user_desc_len;
+
+        ble_gatts_attr_md_t attr_md = { 0 };
+        attr_md.read_perm  = def->read_perm;
+        attr_md.write_perm = def->write_perm;
+        attr_md.vloc       = ESTC_CHAR_VLOC;
+        attr_md.rd_auth    = ESTC_CHAR_RD_AUTH && def->staged;
+        attr_md.wr_auth    = def->wr_auth;
+        attr_md.vlen       = 1;
+
+        memcpy(def->p_value, def->p_init_value, def->init_value_len);
+
+        ble_gatts_attr_t attr_char_value = { 0 };
+        attr_char_value.p_uuid    = &char_uuid;
+        attr_char_value.p_attr_md = &attr_md;
+        attr_char_value.init_len  = def->init_value_len;
+        attr_char_value.init_offs = 0;
+        attr_char_value.max_len   = def->max_len;
+        attr_char_value.p_value   = def->p_value;
+
+        error_code = sd_ble_gatts_characteristic_add(service->service_handle,
+                                                     &char_md,
+                                                     &attr_char_value,
+                                                     estc_char_handles(service, def));
+        VERIFY_SUCCESS(error_code);
+    }
+
     return NRF_SUCCESS;
-}
\ No newline at end of file
+}
@@ -31,10 +31,19 @@
 #ifndef ESTC_SERVICE_H__
 #define ESTC_SERVICE_H__
 
+#include <stdbool.h>
 #include <stdint.h>
 
 #include "ble.h"
 #include "sdk_errors.h"
+#include "nrf_sdh_ble.h"
+#include "sdk_config.h"
+
+#include "estc_arq.h"
+#include "estc_bench.h"
+#include "estc_fanout.h"
+#include "estc_indicate.h"
+#include "estc_tx.h"
 
 // Service 128-bit UUID (Version 4 UUID)
 #define ESTC_SERVICE_UUID_128 { 0x91, 0x30, 0x4b, 0x4c, 0xf2, 0x2a, /* - */ 0x42, 0x43, /* - */ 0x95, 0xd8, /* - */ 0xf6, 0xc8, /* - */ 0x47, 0x1e, 0x92, 0xb3 }
@@ -46,20 +55,308 @@
 #define ESTC_CHAR_1_UUID_16 0x0001
 #define ESTC_CHAR_2_UUID_16 0x0002
 #define ESTC_CHAR_3_UUID_16 0x0003
+#define ESTC_CHAR_ECHO_UUID_16 0x0006
+#define ESTC_CHAR_RELIABLE_UUID_16 0x0008
+
+// Benchmark characteristic 16-bit UUIDs, see ESTC_BENCH_ENABLED
+#define ESTC_CHAR_BENCH_DATA_UUID_16    0x0004
+#define ESTC_CHAR_BENCH_REPORT_UUID_16  0x0005
+
+// Signal features characteristic 16-bit UUID, see ESTC_DSP_ENABLED
+#define ESTC_CHAR_FEATURES_UUID_16      0x0007
+
+// Largest characteristic value, fits into one packet with the maximum ATT MTU (in bytes)
+#define ESTC_CHAR_MAX_LEN (NRF_SDH_BLE_GATT_MAX_MTU_SIZE - ESTC_TX_ATT_HEADER_LEN)
+
+// Echo notification header: RTC tick of the write and RTC tick of the notification (uint32, little-endian)
+#define ESTC_ECHO_HEADER_LEN 8
+
+// Largest value of characteristic 1, which accepts long writes through the Queued Write module (in bytes)
+#define ESTC_CHAR1_MAX_LEN BLE_GATTS_VAR_ATTR_LEN_MAX
+
+// Store the characteristic values in application memory (BLE_GATTS_VLOC_USER) instead of the SoftDevice
+#ifndef ESTC_SERVICE_VLOC_USER
+#define ESTC_SERVICE_VLOC_USER 0
+#endif
+
+// Add the throughput benchmark: writing a byte count (uint32, little-endian) to the report
+// characteristic notifies that many sequence-numbered, CRC-protected bytes on the data
+// characteristic, and the result is published on the report characteristic
+#ifndef ESTC_BENCH_ENABLED
+#define ESTC_BENCH_ENABLED 0
+#endif
+
+// Add the signal features characteristic: RMS, peak and FFT band energies of the sampled signal,
+// computed with CMSIS-DSP (build with ESTC_DSP=1, which links the library)
+#ifndef ESTC_DSP_ENABLED
+#define ESTC_DSP_ENABLED 0
+#endif
+
+// Number of centrals the service serves at the same time, one context per connection index
+#define ESTC_LINK_COUNT NRF_SDH_BLE_TOTAL_LINK_COUNT
+
+// Priority of the ESTC service BLE observer, after the SDK modules and before the application
+#define ESTC_BLE_OBSERVER_PRIO 2
+
+/**@brief Macro for defining an ESTC service instance and registering its BLE observer.
+ *
+ * @param _name Name of the instance.
+ */
+#define BLE_ESTC_SERVICE_DEF(_name)                                                                 \
+static ble_estc_service_t _name;                                                                    \
+NRF_SDH_BLE_OBSERVER(_name ## _obs,                                                                 \
+                     ESTC_BLE_OBSERVER_PRIO,                                                        \
+                     estc_ble_service_on_ble_event, &_name)
+
+/**@brief Handler for data a central wrote to characteristic 1.
+ *
+ * @details Called from the main loop by estc_ble_service_process. The data is only valid during the call.
+ */
+typedef void (*estc_ingest_handler_t)(uint8_t const *data, uint32_t len);
+
+/**@brief Handler called from the BLE event handler whenever a central writes to the service on a connection
+ *        or notifications of the service were transmitted on it. */
+typedef void (*estc_activity_handler_t)(uint16_t conn_handle);
+
+/**@brief Handler called when the notification queue of a connection starts or stops running full, see estc_tx_load_handler_t. */
+typedef void (*estc_load_handler_t)(uint16_t conn_handle, bool saturated);
+
+/**@brief Handler called from the BLE event handler when a central requests a reliable transfer of @p len bytes. */
+typedef void (*estc_reliable_request_handler_t)(uint16_t conn_handle, uint32_t len);
+
+/**@brief ESTC service initialization parameters. */
+typedef struct
+{
+    estc_ingest_handler_t ingest_handler;           /**< Handler for data written to characteristic 1, may be NULL. */
+    estc_activity_handler_t activity_handler;       /**< Handler for traffic of the service, may be NULL. */
+    estc_load_handler_t load_handler;               /**< Handler for notification queues starting or stopping to run full, may be NULL. */
+    estc_arq_space_handler_t reliable_space_handler; /**< Handler for free space in a reliable delivery window, may be NULL. */
+    estc_reliable_request_handler_t reliable_request_handler; /**< Handler for reliable transfer requests, may be NULL. */
+    uint8_t hvn_tx_queue_size;                      /**< hvn_tx_queue_size of the connection configuration, 0 for the SoftDevice default. */
+} estc_ble_service_init_t;
+
+/**@brief State of the service on one connection.
+ *
+ * @details Indexed by ble_conn_state_conn_idx, so the context of an event is found without a search.
+ */
+typedef struct
+{
+    uint16_t conn_handle;                           /**< Connection of the context, BLE_CONN_HANDLE_INVALID when unused. */
+    uint16_t att_mtu;                               /**< Effective ATT MTU of the connection. */
+    uint16_t conn_interval;                         /**< Connection interval (in 1.25 ms units). */
+    uint8_t cccd_bitmap;                            /**< Bit n is set while the peer is subscribed to characteristic n of the service. */
+} estc_link_t;
 
 typedef struct
 {
     uint16_t service_handle;
-    uint16_t connection_handle;
     ble_gatts_char_handles_t characterstic1_handle;
+    ble_gatts_char_handles_t echo_handle;           /**< Latency probe, notifies every write back with timestamps. */
     ble_gatts_char_handles_t characterstic2_handle;
     ble_gatts_char_handles_t characterstic3_handle;
+    ble_gatts_char_handles_t reliable_handle;       /**< Reliable delivery, notifies data frames and takes acknowledgements and requests. */
+    estc_link_t links[ESTC_LINK_COUNT];             /**< Per-connection state. */
+    uint8_t cccd_listeners;                         /**< Union of the cccd_bitmap of all connected links. */
+    estc_tx_t tx;                                   /**< Notification credits shared by every sender of the service. */
+    uint8_t tx_client;                              /**< Client identifier of the echo and report notifications in tx. */
+    estc_fanout_t characteristic3_fanout;           /**< Shares characteristic 3 samples across the subscribed links. */
+    estc_indicate_t characteristic2_indicate;       /**< Confirmed delivery of characteristic 2 indications. */
+    estc_arq_t reliable_arq;                        /**< Reliable delivery over the reliable characteristic. */
+    estc_reliable_request_handler_t reliable_request_handler; /**< Producer of requested reliable transfers. */
+    int32_t characteristic1_value;                  /**< Last value written to the characteristic 1 attribute. */
+    int32_t characteristic1_pending;                /**< Value waiting for the next characteristic 1 commit. */
+    bool characteristic1_dirty;                     /**< A characteristic 1 commit is scheduled. */
+    uint32_t characteristic1_updates;               /**< Calls to estc_update_characteristic_1_value. */
+    uint32_t characteristic1_updates_elided;        /**< Updates that did not cause a SoftDevice call. */
+    estc_ingest_handler_t ingest_handler;           /**< Consumer of data written to characteristic 1. */
+    estc_activity_handler_t activity_handler;       /**< Observer of traffic of the service. */
+    estc_load_handler_t load_handler;               /**< Observer of saturated notification queues. */
+    uint32_t ingest_bytes;                          /**< Bytes written to characteristic 1 and queued for the main loop. */
+    uint32_t ingest_overflow_bytes;                 /**< Bytes dropped because the ingest buffer was full. */
+    uint32_t echo_probes;                           /**< Writes to the echo characteristic. */
+    uint32_t echo_dropped;                          /**< Probes that could not be notified back. */
+#if ESTC_BENCH_ENABLED
+    ble_gatts_char_handles_t bench_data_handle;     /**< Characteristic notifying benchmark packets. */
+    ble_gatts_char_handles_t bench_report_handle;   /**< Characteristic starting runs and publishing their results. */
+    estc_bench_t bench;                             /**< Throughput benchmark. */
+#endif
+#if ESTC_DSP_ENABLED
+    ble_gatts_char_handles_t features_handle;       /**< Characteristic notifying signal features. */
+    estc_fanout_t features_fanout;                  /**< Shares the features across the subscribed links. */
+#endif
 } ble_estc_service_t;
 
-ret_code_t estc_ble_service_init(ble_estc_service_t *service);
+ret_code_t estc_ble_service_init(ble_estc_service_t *service, estc_ble_service_init_t const *init);
+
+/**@brief Function for getting the context of a connection.
+ *
+ * @param[in] service      ESTC service instance.
+ * @param[in] conn_handle  Connection handle.
+ *
+ * @return Context of the connection, NULL if the handle is not a valid connection.
+ */
+estc_link_t * estc_ble_service_link_get(ble_estc_service_t *service, uint16_t conn_handle);
+
+/**@brief Function for checking whether any central is subscribed to a characteristic.
+ *
+ * @details Producers call this before sampling and encoding, so no work is done for a value
+ *          nobody receives.
+ *
+ * @param[in] service       ESTC service instance.
+ * @param[in] value_handle  Handle of the characteristic value.
+ *
+ * @return True if at least one connected peer enabled notifications or indications.
+ */
+bool estc_ble_service_is_subscribed(ble_estc_service_t const *service, uint16_t value_handle);
+
+/**@brief Function for checking whether the peer of a connection is subscribed to a characteristic.
+ *
+ * @param[in] service       ESTC service instance.
+ * @param[in] conn_handle   Connection handle.
+ * @param[in] value_handle  Handle of the characteristic value.
+ */
+bool estc_ble_service_link_is_subscribed(ble_estc_service_t *service, uint16_t conn_handle, uint16_t value_handle);
+
+/**@brief Function for reloading the subscriptions of a connection from its system attributes.
+ *
+ * @details Call after sd_ble_gatts_sys_attr_set, so the CCCDs stored for a bonded peer take
+ *          effect as if the peer had written them again. The service calls it itself on
+ *          BLE_GAP_EVT_CONNECTED, which covers system attributes applied by the Peer Manager.
+ *
+ * @param[in] service      ESTC service instance.
+ * @param[in] conn_handle  Connection handle.
+ */
+void estc_ble_service_subscriptions_restore(ble_estc_service_t *service, uint16_t conn_handle);
+
+/**@brief Function for handling a long write reassembled by the Queued Write module.
+ *
+ * @param[in] service      ESTC service instance.
+ * @param[in] conn_handle  Connection the write came from.
+ * @param[in] handle       Handle of the written attribute.
+ * @param[in] data         Complete value.
+ * @param[in] len          Length of the value.
+ */
+void estc_ble_service_on_long_write(ble_estc_service_t *service, uint16_t conn_handle, uint16_t handle,
+                                    uint8_t const *data, uint16_t len);
+
+/**@brief Function for handing data written to characteristic 1 to the ingest handler.
+ *
+ * @details Call from the main loop. Writes are queued by the BLE event handler in a lock-free
+ *          ring buffer, so a central can push data with Write Without Response at link speed.
+ */
+void estc_ble_service_process(ble_estc_service_t *service);
 
 void estc_ble_service_on_ble_event(const ble_evt_t *ble_evt, void *ctx);
 
+void estc_ble_service_att_mtu_set(ble_estc_service_t *service, uint16_t conn_handle, uint16_t att_mtu);
+
+/**@brief Function for notifying a sample on characteristic 3 to every subscribed central.
+ *
+ * @details Never blocks: a central that falls behind loses its oldest samples. See estc_fanout_t.
+ *
+ * @param[in] service  ESTC service instance.
+ * @param[in] data     Sample.
+ * @param[in] len      Length of the sample, at most ESTC_FANOUT_SAMPLE_MAX_LEN.
+ */
+ret_code_t estc_ble_service_sample_publish(ble_estc_service_t *service, uint8_t const *data, uint16_t len);
+
+/**@brief Function for getting the longest characteristic 3 sample every subscribed central receives.
+ *
+ * @details Depends on the ATT MTU negotiated with each central, so it may grow after connecting.
+ *
+ * @param[in] service  ESTC service instance.
+ */
+uint16_t estc_ble_service_sample_max_len(ble_estc_service_t const *service);
+
+/**@brief Function for getting the characteristic 3 samples delivered to and dropped for a central.
+ *
+ * @param[in]  service      ESTC service instance.
+ * @param[in]  conn_handle  Connection of the central.
+ * @param[out] stats        Counters of the connection.
+ *
+ * @retval NRF_SUCCESS          The counters were copied.
+ * @retval NRF_ERROR_NOT_FOUND  The connection is not a link of the service.
+ */
+ret_code_t estc_ble_service_sample_stats_get(ble_estc_service_t const *service, uint16_t conn_handle,
+                                             estc_fanout_stats_t *stats);
+
+#if ESTC_DSP_ENABLED
+/**@brief Function for notifying signal features to every subscribed central.
+ *
+ * @param[in] service  ESTC service instance.
+ * @param[in] data     Encoded features.
+ * @param[in] len      Length of the features, at most ESTC_FANOUT_SAMPLE_MAX_LEN.
+ */
+ret_code_t estc_ble_service_features_publish(ble_estc_service_t *service, uint8_t const *data, uint16_t len);
+#endif
+
+/**@brief Function for sending data reliably to one central.
+ *
+ * @details The data is notified on the reliable characteristic in sequence-numbered frames,
+ *          which the central acknowledges by writing the same characteristic. Call from the main
+ *          loop only. See estc_arq_t for the frame and acknowledgement formats.
+ *
+ * @param[in] service      ESTC service instance.
+ * @param[in] conn_handle  Connection of the central.
+ * @param[in] data         Data to send.
+ * @param[in] len          Length of the data.
+ *
+ * @return Number of bytes accepted, the rest can be written again after the
+ *         reliable_space_handler was called.
+ */
+uint32_t estc_ble_service_reliable_write(ble_estc_service_t *service, uint16_t conn_handle,
+                                         uint8_t const *data, uint32_t len);
+
+/**@brief Function for indicating an alarm on characteristic 2 to every subscribed central.
+ *
+ * @details Alarms are queued per link and sent one at a time, each after the confirmation of
+ *          the previous one. See estc_indicate_t.
+ *
+ * @param[in] service  ESTC service instance.
+ * @param[in] data     Alarm.
+ * @param[in] len      Length of the alarm, at most ESTC_INDICATE_MAX_LEN.
+ * @param[in] key      Alarm identifier, a queued alarm with the same one is replaced.
+ *                     ESTC_INDICATE_KEY_NONE to always queue.
+ */
+ret_code_t estc_ble_service_alarm_send(ble_estc_service_t *service, uint8_t const *data, uint16_t len, uint8_t key);
+
+/**@brief Function for taking ownership of a characteristic value buffer.
+ *
+ * @details Until estc_ble_service_value_commit is called, reads of the value by a central are
+ *          held back, so nobody sees a half-written value. With ESTC_SERVICE_VLOC_USER the buffer
+ *          is the attribute value itself and the commit does not copy it. Only characteristics
+ *          marked as staged in the service definition are written this way, the reads of the
+ *          others are not authorized.
+ *
+ * @param[in] service       ESTC service instance.
+ * @param[in] value_handle  Handle of the characteristic value.
+ *
+ * @return Buffer of ESTC_CHAR_MAX_LEN bytes to write the new value into, NULL for an unknown
+ *         handle or a characteristic that is not staged.
+ */
+uint8_t * estc_ble_service_value_begin(ble_estc_service_t *service, uint16_t value_handle);
+
+/**@brief Function for publishing a value written after estc_ble_service_value_begin.
+ *
+ * @param[in] service       ESTC service instance.
+ * @param[in] value_handle  Handle of the characteristic value.
+ * @param[in] len           New length of the value.
+ *
+ * @retval NRF_ERROR_INVALID_PARAM  Unknown handle or a characteristic that is not staged.
+ * @return Otherwise the result of sd_ble_gatts_value_set.
+ */
+ret_code_t estc_ble_service_value_commit(ble_estc_service_t *service, uint16_t value_handle, uint16_t len);
+
+/**@brief Function for updating the value of characteristic 1.
+ *
+ * @details An unchanged value is dropped without calling into the SoftDevice. Changed values are
+ *          coalesced and committed once per connection interval, so only the latest value of a
+ *          burst is written. Dropped and overwritten updates are counted in
+ *          characteristic1_updates_elided.
+ *
+ * @param[in] service  ESTC service instance.
+ * @param[in] value    New value.
+ */
 void estc_update_characteristic_1_value(ble_estc_service_t *service, int32_t *value);
 
 #endif /* ESTC_SERVICE_H__ */
\ No newline at end of file
@@ -0,0 +1,98 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#include "estc_throughput.h"
+
+#include "app_error.h"
+#include "ble_gap.h"
+
+#define ESTC_TP_T_IFS_US            150     /**< Inter frame space (in microseconds). */
+#define ESTC_TP_ACCESS_ADDR_LEN     4       /**< Access address (in bytes). */
+#define ESTC_TP_LL_HEADER_LEN       2       /**< LL data PDU header (in bytes). */
+#define ESTC_TP_CRC_LEN             3       /**< CRC (in bytes). */
+#define ESTC_TP_L2CAP_HEADER_LEN    4       /**< L2CAP basic header (in bytes). */
+#define ESTC_TP_ATT_HEADER_LEN      3       /**< ATT notification header (in bytes). */
+#define ESTC_TP_UNIT_1_25_MS_US     1250    /**< Connection interval unit (in microseconds). */
+
+/**@brief Function for computing the airtime of an LL packet.
+ *
+ * @param[in] phy          BLE_GAP_PHY_1MBPS or BLE_GAP_PHY_2MBPS.
+ * @param[in] payload_len  LL payload (in bytes).
+ *
+ * @return Airtime (in microseconds).
+ */
+static uint32_t estc_tp_packet_us(uint8_t phy, uint32_t payload_len)
+{
+    // 1M PHY sends 1 byte of preamble at 8 us per byte, 2M PHY 2 bytes at 4 us per byte
+    uint32_t preamble_len = (BLE_GAP_PHY_2MBPS == phy) ? 2 : 1;
+    uint32_t us_per_byte  = (BLE_GAP_PHY_2MBPS == phy) ? 4 : 8;
+    uint32_t packet_len   = preamble_len + ESTC_TP_ACCESS_ADDR_LEN + ESTC_TP_LL_HEADER_LEN + payload_len + ESTC_TP_CRC_LEN;
+
+    return packet_len * us_per_byte;
+}
+
+void estc_throughput_estimate(estc_throughput_params_t const *params, estc_throughput_estimate_t *estimate)
+{
+    ASSERT(NULL != params)
+    ASSERT(NULL != estimate)
+
+    estimate->ll_packets_per_event    = 0;
+    estimate->notifications_per_event = 0;
+    estimate->bytes_per_second        = 0;
+
+    if (0 == params->conn_interval || 0 == params->data_length || params->att_mtu <= ESTC_TP_ATT_HEADER_LEN)
+    {
+        return;
+    }
+
+    uint32_t interval_us = (uint32_t)params->conn_interval * ESTC_TP_UNIT_1_25_MS_US;
+    uint32_t event_us    = (uint32_t)params->event_length * ESTC_TP_UNIT_1_25_MS_US;
+
+    // With event extension the connection event may run until the next one starts
+    if (params->event_extension || event_us > interval_us)
+    {
+        event_us = interval_us;
+    }
+
+    uint32_t pair_us = estc_tp_packet_us(params->phy, params->data_length) + ESTC_TP_T_IFS_US
+                     + estc_tp_packet_us(params->phy, 0) + ESTC_TP_T_IFS_US;
+    uint32_t fragments = (params->att_mtu + ESTC_TP_L2CAP_HEADER_LEN + params->data_length - 1) / params->data_length;
+
+    uint32_t notifications = (event_us / pair_us) / fragments;
+    if (0 != params->tx_queue_size && notifications > params->tx_queue_size)
+    {
+        notifications = params->tx_queue_size;
+    }
+
+    estimate->ll_packets_per_event    = notifications * fragments;
+    estimate->notifications_per_event = notifications;
+    estimate->bytes_per_second        = (uint32_t)(((uint64_t)notifications * (params->att_mtu - ESTC_TP_ATT_HEADER_LEN)
+                                                    * 1000000) / interval_us);
+}
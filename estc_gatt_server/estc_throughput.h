@@ -0,0 +1,68 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#ifndef ESTC_THROUGHPUT_H__
+#define ESTC_THROUGHPUT_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**@brief Link settings the throughput model is evaluated for. */
+typedef struct
+{
+    uint16_t att_mtu;           /**< Effective ATT MTU (in bytes). */
+    uint16_t data_length;       /**< LL data PDU payload length (27-251 bytes). */
+    uint8_t  phy;               /**< TX PHY, BLE_GAP_PHY_1MBPS or BLE_GAP_PHY_2MBPS. */
+    uint16_t conn_interval;     /**< Connection interval (in 1.25 ms units). */
+    uint16_t event_length;      /**< Event length reserved for the connection (in 1.25 ms units). */
+    bool     event_extension;   /**< Connection event extension is enabled. */
+    uint8_t  tx_queue_size;     /**< Notifications the SoftDevice can queue, 0 for no limit. */
+} estc_throughput_params_t;
+
+/**@brief Predicted throughput of notifications for one connection. */
+typedef struct
+{
+    uint32_t ll_packets_per_event;      /**< LL data packets that fit into one connection event. */
+    uint32_t notifications_per_event;   /**< Complete notifications sent in one connection event. */
+    uint32_t bytes_per_second;          /**< Notification payload rate (in bytes per second). */
+} estc_throughput_estimate_t;
+
+/**@brief Function for predicting how many notifications fit into a connection interval.
+ *
+ * @details Every LL data packet is acknowledged by an empty packet from the central, and both are
+ *          separated by the 150 us inter frame space. A notification of ATT MTU bytes plus the
+ *          4-byte L2CAP header is fragmented into data_length sized LL packets.
+ *
+ * @param[in]  params    Link settings.
+ * @param[out] estimate  Predicted throughput.
+ */
+void estc_throughput_estimate(estc_throughput_params_t const *params, estc_throughput_estimate_t *estimate);
+
+#endif /* ESTC_THROUGHPUT_H__ */
@@ -0,0 +1,253 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#include "estc_tx.h"
+
+#include <string.h>
+
+#include "app_error.h"
+#include "app_util.h"
+#include "app_util_platform.h"
+
+#include "ble.h"
+#include "ble_conn_state.h"
+#include "ble_gatts.h"
+
+STATIC_ASSERT(IS_POWER_OF_TWO(ESTC_TX_QUEUE_LEN));
+
+#define ESTC_TX_QUEUE_MASK  (ESTC_TX_QUEUE_LEN - 1)
+
+/**@brief Function for reporting a saturation change of a link to the load handler.
+ */
+static void estc_tx_saturated_set(estc_tx_t *tx, estc_tx_link_t *link, bool saturated)
+{
+    if (link->saturated == saturated)
+    {
+        return;
+    }
+
+    link->saturated = saturated;
+    if (NULL != tx->load_handler)
+    {
+        tx->load_handler(tx->load_ctx, link->conn_handle, saturated);
+    }
+}
+
+static estc_tx_link_t * estc_tx_link_get(estc_tx_t const *tx, uint16_t conn_handle)
+{
+    uint16_t index = ble_conn_state_conn_idx(conn_handle);
+    if (index >= ESTC_TX_LINK_COUNT)
+    {
+        return NULL;
+    }
+
+    return (estc_tx_link_t *)&tx->links[index];
+}
+
+static void estc_tx_link_reset(estc_tx_link_t *link, uint16_t conn_handle)
+{
+    CRITICAL_REGION_ENTER();
+    link->conn_handle = conn_handle;
+    link->head        = 0;
+    link->in_flight   = 0;
+    link->saturated   = false;
+    CRITICAL_REGION_EXIT();
+}
+
+ret_code_t estc_tx_init(estc_tx_t *tx, uint8_t queue_size, estc_tx_load_handler_t load_handler, void *load_ctx)
+{
+    ASSERT(NULL != tx)
+
+    if (0 == queue_size || queue_size > ESTC_TX_QUEUE_LEN)
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+
+    memset(tx, 0, sizeof(*tx));
+    tx->queue_size   = queue_size;
+    tx->load_handler = load_handler;
+    tx->load_ctx     = load_ctx;
+
+    for (uint8_t i = 0; i < ESTC_TX_LINK_COUNT; i++)
+    {
+        estc_tx_link_reset(&tx->links[i], BLE_CONN_HANDLE_INVALID);
+    }
+
+    return NRF_SUCCESS;
+}
+
+ret_code_t estc_tx_client_register(estc_tx_t *tx, estc_tx_complete_handler_t handler, void *ctx, uint8_t *client_id)
+{
+    ASSERT(NULL != tx)
+    ASSERT(NULL != handler)
+    ASSERT(NULL != client_id)
+
+    if (ESTC_TX_CLIENT_MAX == tx->client_count)
+    {
+        return NRF_ERROR_NO_MEM;
+    }
+
+    tx->clients[tx->client_count].handler = handler;
+    tx->clients[tx->client_count].ctx     = ctx;
+    *client_id = tx->client_count++;
+
+    return NRF_SUCCESS;
+}
+
+uint8_t estc_tx_credits(estc_tx_t const *tx, uint16_t conn_handle)
+{
+    ASSERT(NULL != tx)
+
+    estc_tx_link_t const *link = estc_tx_link_get(tx, conn_handle);
+    if (NULL == link || conn_handle != link->conn_handle)
+    {
+        return 0;
+    }
+
+    return tx->queue_size - link->in_flight;
+}
+
+ret_code_t estc_tx_notify(estc_tx_t *tx, uint8_t client_id, uint16_t conn_handle,
+                          uint16_t value_handle, uint8_t const *data, uint16_t *len)
+{
+    ASSERT(NULL != tx)
+    ASSERT(client_id < tx->client_count)
+    ASSERT(NULL != len)
+    ret_code_t error_code;
+    bool full;
+
+    estc_tx_link_t *link = estc_tx_link_get(tx, conn_handle);
+    if (NULL == link || conn_handle != link->conn_handle)
+    {
+        return BLE_ERROR_INVALID_CONN_HANDLE;
+    }
+
+    ble_gatts_hvx_params_t hvx_params = { 0 };
+    hvx_params.handle = value_handle;
+    hvx_params.type   = BLE_GATT_HVX_NOTIFICATION;
+    hvx_params.offset = 0;
+    hvx_params.p_len  = len;
+    hvx_params.p_data = data;
+
+    // Senders run in the main loop and in the BLE event handler. Taking the credit, queueing the
+    // notification and recording its owner in one go keeps the owners in SoftDevice queue order.
+    CRITICAL_REGION_ENTER();
+    if (link->in_flight >= tx->queue_size)
+    {
+        error_code = NRF_ERROR_RESOURCES;
+    }
+    else
+    {
+        error_code = sd_ble_gatts_hvx(conn_handle, &hvx_params);
+        if (NRF_SUCCESS == error_code)
+        {
+            link->owners[(link->head + link->in_flight) & ESTC_TX_QUEUE_MASK] = client_id;
+            link->in_flight++;
+        }
+    }
+    full = (link->in_flight >= tx->queue_size);
+    CRITICAL_REGION_EXIT();
+
+    if (full)
+    {
+        estc_tx_saturated_set(tx, link, true);
+    }
+
+    return error_code;
+}
+
+/**@brief Function for returning the credits of transmitted notifications to their senders.
+ */
+static void estc_tx_on_complete(estc_tx_t *tx, estc_tx_link_t *link, uint8_t count)
+{
+    uint8_t completed[ESTC_TX_CLIENT_MAX] = { 0 };
+
+    CRITICAL_REGION_ENTER();
+    count = MIN(count, link->in_flight);
+    for (uint8_t i = 0; i < count; i++)
+    {
+        completed[link->owners[link->head]]++;
+        link->head = (link->head + 1) & ESTC_TX_QUEUE_MASK;
+    }
+    link->in_flight -= count;
+    CRITICAL_REGION_EXIT();
+
+    // Every client may have been waiting for a credit, the one called first rotates
+    uint8_t first = tx->cursor;
+    tx->cursor = (tx->client_count > 0) ? (first + 1) % tx->client_count : 0;
+
+    for (uint8_t i = 0; i < tx->client_count; i++)
+    {
+        uint8_t id = (first + i) % tx->client_count;
+        tx->clients[id].handler(tx->clients[id].ctx, link->conn_handle, completed[id]);
+    }
+
+    // Senders that keep up refill the queue from their handlers, so an empty one means they stopped
+    if (0 == link->in_flight)
+    {
+        estc_tx_saturated_set(tx, link, false);
+    }
+}
+
+void estc_tx_on_ble_event(const ble_evt_t *ble_evt, void *ctx)
+{
+    estc_tx_t *tx = (estc_tx_t *)ctx;
+
+    // Every BLE event starts with the handle of its connection
+    estc_tx_link_t *link = estc_tx_link_get(tx, ble_evt->evt.gap_evt.conn_handle);
+    if (NULL == link)
+    {
+        return;
+    }
+
+    switch (ble_evt->header.evt_id)
+    {
+        case BLE_GAP_EVT_CONNECTED:
+            estc_tx_link_reset(link, ble_evt->evt.gap_evt.conn_handle);
+            break;
+
+        case BLE_GAP_EVT_DISCONNECTED:
+            if (ble_evt->evt.gap_evt.conn_handle == link->conn_handle)
+            {
+                estc_tx_link_reset(link, BLE_CONN_HANDLE_INVALID);
+            }
+            break;
+
+        case BLE_GATTS_EVT_HVN_TX_COMPLETE:
+            if (ble_evt->evt.gatts_evt.conn_handle == link->conn_handle)
+            {
+                estc_tx_on_complete(tx, link, ble_evt->evt.gatts_evt.params.hvn_tx_complete.count);
+            }
+            break;
+
+        default:
+            break;
+    }
+}
@@ -0,0 +1,170 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#ifndef ESTC_TX_H__
+#define ESTC_TX_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ble.h"
+#include "sdk_errors.h"
+#include "nrf_sdh_ble.h"
+#include "sdk_config.h"
+
+// Size of the ATT header of a notification (opcode and attribute handle)
+#define ESTC_TX_ATT_HEADER_LEN      3
+
+// Payload of a notification with the default ATT MTU
+#define ESTC_TX_DEFAULT_PAYLOAD     (BLE_GATT_ATT_MTU_DEFAULT - ESTC_TX_ATT_HEADER_LEN)
+
+// Largest SoftDevice notification queue the credits can track per link (must be a power of 2)
+#define ESTC_TX_QUEUE_LEN           16
+
+// Senders sharing the notification queues
+#define ESTC_TX_CLIENT_MAX          8
+
+// Number of links with their own credits, one per connection index
+#define ESTC_TX_LINK_COUNT          NRF_SDH_BLE_TOTAL_LINK_COUNT
+
+/**@brief Handler called after notifications of a link were transmitted.
+ *
+ * @details Called for every client on every BLE_GATTS_EVT_HVN_TX_COMPLETE of the link, so a
+ *          sender that found no credit can send again.
+ *
+ * @param[in] ctx          Context the client was registered with.
+ * @param[in] conn_handle  Connection of the link.
+ * @param[in] completed    Notifications of this client that were transmitted, may be 0.
+ */
+typedef void (*estc_tx_complete_handler_t)(void *ctx, uint16_t conn_handle, uint8_t completed);
+
+/**@brief Handler called when the notification queue of a link starts or stops running full.
+ *
+ * @details A link is saturated once its senders fill every queue slot, so they produce faster
+ *          than the link carries, and stays saturated until the queue drains completely.
+ *
+ * @param[in] ctx          Context given to estc_tx_init.
+ * @param[in] conn_handle  Connection of the link.
+ * @param[in] saturated    True if the queue filled up, false if it drained.
+ */
+typedef void (*estc_tx_load_handler_t)(void *ctx, uint16_t conn_handle, bool saturated);
+
+/**@brief Sender sharing the notification queues. */
+typedef struct
+{
+    estc_tx_complete_handler_t handler;     /**< Handler for transmitted notifications. */
+    void                      *ctx;         /**< Parameter to the handler. */
+} estc_tx_client_t;
+
+/**@brief Notification credits of one link. */
+typedef struct
+{
+    uint16_t conn_handle;                   /**< Connection of the link, BLE_CONN_HANDLE_INVALID when unused. */
+    uint8_t  head;                          /**< Index of the oldest notification in flight. */
+    uint8_t  in_flight;                     /**< Notifications queued in the SoftDevice. */
+    bool     saturated;                     /**< The queue filled up and has not drained since. */
+    uint8_t  owners[ESTC_TX_QUEUE_LEN];     /**< Client of each notification in flight, oldest first. */
+} estc_tx_link_t;
+
+/**@brief Notification credits shared by every sender of a link.
+ *
+ * @details The SoftDevice queues hvn_tx_queue_size notifications per connection, across all
+ *          characteristics. Every sender notifies through this module, which hands out one
+ *          credit per queue slot and never calls into the SoftDevice without one. Notifications
+ *          are transmitted in the order they were queued, so the count of each
+ *          BLE_GATTS_EVT_HVN_TX_COMPLETE is split among the senders of the oldest ones, and
+ *          every sender learns both its own completions and that credits were returned.
+ */
+typedef struct
+{
+    uint8_t                queue_size;                  /**< Notifications the SoftDevice queues per link. */
+    uint8_t                client_count;                /**< Registered clients. */
+    uint8_t                cursor;                      /**< Client called first on the next completion. */
+    estc_tx_load_handler_t load_handler;                /**< Handler for saturation changes, may be NULL. */
+    void                  *load_ctx;                    /**< Parameter to load_handler. */
+    estc_tx_client_t       clients[ESTC_TX_CLIENT_MAX];
+    estc_tx_link_t         links[ESTC_TX_LINK_COUNT];
+} estc_tx_t;
+
+/**@brief Function for initializing the notification credits.
+ *
+ * @param[out] tx            Instance to initialize.
+ * @param[in]  queue_size    hvn_tx_queue_size the SoftDevice was configured with.
+ * @param[in]  load_handler  Handler for saturation changes of a link, may be NULL.
+ * @param[in]  load_ctx      Parameter to load_handler.
+ *
+ * @retval NRF_SUCCESS              The credits are initialized.
+ * @retval NRF_ERROR_INVALID_PARAM  The queue size is 0 or larger than ESTC_TX_QUEUE_LEN.
+ */
+ret_code_t estc_tx_init(estc_tx_t *tx, uint8_t queue_size, estc_tx_load_handler_t load_handler, void *load_ctx);
+
+/**@brief Function for registering a sender.
+ *
+ * @param[in]  tx         Instance.
+ * @param[in]  handler    Handler for transmitted notifications.
+ * @param[in]  ctx        Parameter to the handler.
+ * @param[out] client_id  Identifier to notify with.
+ *
+ * @retval NRF_SUCCESS          The sender is registered.
+ * @retval NRF_ERROR_NO_MEM     ESTC_TX_CLIENT_MAX senders are registered already.
+ */
+ret_code_t estc_tx_client_register(estc_tx_t *tx, estc_tx_complete_handler_t handler, void *ctx, uint8_t *client_id);
+
+/**@brief Function for getting the free notification credits of a link.
+ *
+ * @return Notifications the SoftDevice still accepts, 0 for an unknown connection.
+ */
+uint8_t estc_tx_credits(estc_tx_t const *tx, uint16_t conn_handle);
+
+/**@brief Function for queueing a notification if the link has a credit.
+ *
+ * @param[in]    tx            Instance.
+ * @param[in]    client_id     Sender of the notification.
+ * @param[in]    conn_handle   Connection to notify on.
+ * @param[in]    value_handle  Handle of the characteristic value.
+ * @param[in]    data          Value, NULL to notify the current attribute value.
+ * @param[inout] len           Length of the value in, length queued out.
+ *
+ * @retval NRF_SUCCESS          The notification was queued.
+ * @retval NRF_ERROR_RESOURCES  No credit, the completion handler of the client is called when
+ *                              notifications of the link were transmitted.
+ * @return Any other error of sd_ble_gatts_hvx.
+ */
+ret_code_t estc_tx_notify(estc_tx_t *tx, uint8_t client_id, uint16_t conn_handle,
+                          uint16_t value_handle, uint8_t const *data, uint16_t *len);
+
+/**@brief Function for handling BLE events relevant to the notification credits.
+ *
+ * @param[in] ble_evt  Bluetooth stack event.
+ * @param[in] ctx      Instance.
+ */
+void estc_tx_on_ble_event(const ble_evt_t *ble_evt, void *ctx);
+
+#endif /* ESTC_TX_H__ */
@@ -65,6 +65,7 @@
 #include "nrf_sdh_soc.h"
 #include "nrf_sdh_ble.h"
 #include "app_timer.h"
+#include "app_util_platform.h"
 #include "fds.h"
 #include "peer_manager.h"
 #include "peer_manager_handler.h"
@@ -81,6 +82,11 @@
 #include "nrf_log_backend_usb.h"
 
 #include "estc_service.h"
+#include "estc_conn_policy.h"
+#include "estc_l2cap.h"
+#include "estc_phy.h"
+#include "estc_sampler.h"
+#include "estc_throughput.h"
 
 #define DEVICE_NAME                     "ESTC-GATT"                             /**< Name of device. Will be included in the advertising data. */
 #define MANUFACTURER_NAME               "NordicSemiconductor"                   /**< Manufacturer. Will be passed to Device Information Service. */
@@ -89,23 +95,50 @@
 #define APP_ADV_DURATION                18000                                   /**< The advertising duration (180 seconds) in units of 10 milliseconds. */
 #define APP_BLE_OBSERVER_PRIO           3                                       /**< Application's BLE observer priority. You shouldn't need to modify this value. */
 #define APP_BLE_CONN_CFG_TAG            1                                       /**< A tag identifying the SoftDevice BLE configuration. */
+#define APP_HVN_TX_QUEUE_SIZE           8                                       /**< Number of notifications the SoftDevice can queue per connection. */
 
 #define MIN_CONN_INTERVAL               MSEC_TO_UNITS(100, UNIT_1_25_MS)        /**< Minimum acceptable connection interval (0.1 seconds). */
 #define MAX_CONN_INTERVAL               MSEC_TO_UNITS(200, UNIT_1_25_MS)        /**< Maximum acceptable connection interval (0.2 second). */
 #define SLAVE_LATENCY                   0                                       /**< Slave latency. */
 #define CONN_SUP_TIMEOUT                MSEC_TO_UNITS(4000, UNIT_10_MS)         /**< Connection supervisory timeout (4 seconds). */
 
+#define IDLE_MIN_CONN_INTERVAL          MIN_CONN_INTERVAL                       /**< Minimum connection interval while the link is quiet (0.1 seconds). */
+#define IDLE_MAX_CONN_INTERVAL          MAX_CONN_INTERVAL                       /**< Maximum connection interval while the link is quiet (0.2 seconds). */
+#define IDLE_SLAVE_LATENCY              4                                       /**< Connection events the peripheral may skip while the link is quiet. */
+#define BUSY_MIN_CONN_INTERVAL          MSEC_TO_UNITS(7.5, UNIT_1_25_MS)        /**< Minimum connection interval during traffic (7.5 milliseconds). */
+#define BUSY_MAX_CONN_INTERVAL          MSEC_TO_UNITS(15, UNIT_1_25_MS)         /**< Maximum connection interval during traffic (15 milliseconds). */
+#define BUSY_SLAVE_LATENCY              0                                       /**< Slave latency during traffic. */
+#define CONN_POLICY_IDLE_TIMEOUT_MS     2000                                    /**< Time without traffic before the quiet parameters are requested (2 seconds). */
+
 #define FIRST_CONN_PARAMS_UPDATE_DELAY  APP_TIMER_TICKS(5000)                   /**< Time from initiating event (connect or start of notification) to first time sd_ble_gap_conn_param_update is called (5 seconds). */
 #define NEXT_CONN_PARAMS_UPDATE_DELAY   APP_TIMER_TICKS(30000)                  /**< Time between each call to sd_ble_gap_conn_param_update after the first call (30 seconds). */
 #define MAX_CONN_PARAMS_UPDATE_COUNT    3                                       /**< Number of attempts before giving up the connection parameter negotiation. */
 
+#define SAMPLE_RATE_HZ                  100                                     /**< Sensor sampling rate (in Hz). */
+#define SAMPLE_MAX_LATENCY_MS           200                                     /**< Longest time a sample waits for its packet to fill up (0.2 seconds). */
+#define SAMPLE_FIFO_SIZE                32                                      /**< Samples the timer can take before the main loop packs them. */
+#define SAMPLE_SENSOR_MIN               0                                       /**< Lowest value of the simulated sensor. */
+#define SAMPLE_SENSOR_MAX               4095                                    /**< Highest value of the simulated sensor (12-bit ADC range). */
+#define SAMPLE_SENSOR_INCR              37                                      /**< Change of the simulated sensor per sample. */
+#define SAMPLE_AGGREGATE_WINDOW         10                                      /**< Samples summarized into one min/max/mean/last record, 1 sends raw samples. */
+#define SAMPLE_DEADBAND                 16.0f                                   /**< Change of the mean needed before another summary is sent, 0 sends every window. */
+#define SAMPLE_ENCODING                 ESTC_SAMPLER_ENCODING_DELTA             /**< Coding of the sample records: fixed width, varint deltas or bit-packed blocks. */
+#if ESTC_DSP_ENABLED
+#define SAMPLE_DSP_FORMAT               ESTC_DSP_FORMAT_F32                     /**< Arithmetic of the signal features, Q15 needs half the buffers (see ESTC_DSP_BENCHMARK for the cycles). */
+#endif
+
+#define QWR_MEM_BUFF_SIZE               1024                                    /**< Memory for queued Prepare Write requests (in bytes). */
+
 #define DEAD_BEEF                       0xDEADBEEF                              /**< Value used as error code on stack dump, can be used to identify stack location on stack unwind. */
 
 NRF_BLE_GATT_DEF(m_gatt);                                                       /**< GATT module instance. */
-NRF_BLE_QWR_DEF(m_qwr);                                                         /**< Context for the Queued Write module.*/
+NRF_BLE_QWRS_DEF(m_qwr, NRF_SDH_BLE_TOTAL_LINK_COUNT);                          /**< Context for the Queued Write module, one per link.*/
 BLE_ADVERTISING_DEF(m_advertising);                                             /**< Advertising module instance. */
 
-static uint16_t m_conn_handle = BLE_CONN_HANDLE_INVALID;                        /**< Handle of the current connection. */
+static bool m_advertising_active = false;                                       /**< Connectable advertising is running. */
+
+static uint8_t m_qwr_mem[NRF_SDH_BLE_TOTAL_LINK_COUNT][QWR_MEM_BUFF_SIZE];      /**< Queued Write module buffers for Prepare Write requests. */
+static uint8_t m_qwr_value[ESTC_CHAR1_MAX_LEN];                                 /**< Reassembled value of a long write. */
 
 static ble_uuid_t m_adv_uuids[] =                                               /**< Universally unique service identifiers. */
 {
@@ -113,11 +146,48 @@ static ble_uuid_t m_adv_uuids[] =
     {ESTC_SERVICE_UUID_16, BLE_UUID_TYPE_BLE},
 };
 
-ble_estc_service_t m_estc_service; /**< ESTC example BLE service */
+/**@brief Application state of one connection. */
+typedef struct
+{
+    uint16_t                 conn_handle;           /**< Connection of the state, BLE_CONN_HANDLE_INVALID when unused. */
+    estc_phy_t               phy;                   /**< PHY policy of the connection. */
+    estc_conn_policy_t       conn_policy;           /**< Connection parameter policy of the connection. */
+    estc_throughput_params_t params;                /**< Settings of the connection, used to predict its throughput. */
+    bool                     tx_saturated;          /**< The notification senders keep the queue of the connection full. */
+    uint32_t                 reliable_requested;    /**< Size of the current reliable transfer, 0 when idle. */
+    uint32_t                 reliable_remaining;    /**< Bytes of the current reliable transfer not handed to the service yet. */
+} app_link_t;
+
+BLE_ESTC_SERVICE_DEF(m_estc_service);                                           /**< ESTC example BLE service */
+static app_link_t m_links[NRF_SDH_BLE_TOTAL_LINK_COUNT];                        /**< Per-connection state, indexed by ble_conn_state_conn_idx. */
+static estc_l2cap_t m_l2cap;                                                    /**< L2CAP channel for bulk transfers. */
+static uint32_t m_l2cap_requested;                                              /**< Size of the current L2CAP transfer, 0 when idle. */
+static uint32_t m_l2cap_remaining;                                              /**< Bytes of the current L2CAP transfer not handed to the channel yet. */
+static estc_sampler_t m_sampler;                                                /**< Sensor sampling pipeline publishing on characteristic 3. */
+
+NRF_ATFIFO_DEF(m_sample_fifo, estc_sample_t, SAMPLE_FIFO_SIZE);                 /**< Samples passed from the sampling timer to the main loop. */
+
+NRF_SDH_BLE_OBSERVER(m_l2cap_observer, APP_BLE_OBSERVER_PRIO, estc_l2cap_on_ble_event, &m_l2cap);
 
 static void advertising_start(void);
 
 
+/**@brief Function for getting the application state of a connection.
+ *
+ * @return State of the connection, NULL if the handle is not a valid connection.
+ */
+static app_link_t * app_link_get(uint16_t conn_handle)
+{
+    uint16_t index = ble_conn_state_conn_idx(conn_handle);
+    if (index >= NRF_SDH_BLE_TOTAL_LINK_COUNT)
+    {
+        return NULL;
+    }
+
+    return &m_links[index];
+}
+
+
 /**@brief Callback function for asserts in the SoftDevice.
  *
  * @details This function will be called in case of an assert in the SoftDevice.
@@ -179,11 +249,70 @@ static void gap_params_init(void)
 }
 
 
+/**@brief Function for logging the predicted notification throughput of a connection.
+ */
+static void throughput_estimate_log(app_link_t const * p_link)
+{
+    estc_throughput_estimate_t estimate;
+    estc_throughput_estimate(&p_link->params, &estimate);
+
+    NRF_LOG_INFO("Predicted %d notifications (%d LL packets) per connection event, %d bytes/s",
+                 estimate.notifications_per_event, estimate.ll_packets_per_event, estimate.bytes_per_second);
+}
+
+
+/**@brief Function for handling events from the GATT module.
+ *
+ * @param[in] p_gatt  GATT module instance.
+ * @param[in] p_evt   Event received from the GATT module.
+ */
+static void gatt_evt_handler(nrf_ble_gatt_t * p_gatt, nrf_ble_gatt_evt_t const * p_evt)
+{
+    app_link_t * p_link = app_link_get(p_evt->conn_handle);
+    if (p_link == NULL)
+    {
+        return;
+    }
+
+    switch (p_evt->evt_id)
+    {
+        case NRF_BLE_GATT_EVT_ATT_MTU_UPDATED:
+            NRF_LOG_INFO("ATT MTU updated to %d bytes (conn_handle: %d)",
+                         p_evt->params.att_mtu_effective, p_evt->conn_handle);
+            estc_ble_service_att_mtu_set(&m_estc_service, p_evt->conn_handle, p_evt->params.att_mtu_effective);
+
+            p_link->params.att_mtu = p_evt->params.att_mtu_effective;
+            throughput_estimate_log(p_link);
+            break;
+
+        case NRF_BLE_GATT_EVT_DATA_LENGTH_UPDATED:
+            NRF_LOG_INFO("Data length updated to %d bytes (conn_handle: %d)",
+                         p_evt->params.data_length, p_evt->conn_handle);
+
+            p_link->params.data_length = p_evt->params.data_length;
+            throughput_estimate_log(p_link);
+            break;
+
+        default:
+            break;
+    }
+}
+
+
 /**@brief Function for initializing the GATT module.
+ *
+ * @details Large ATT MTU and data length are negotiated on every connection, so one
+ *          notification can carry up to NRF_SDH_BLE_GATT_MAX_MTU_SIZE - 3 bytes.
  */
 static void gatt_init(void)
 {
-    ret_code_t err_code = nrf_ble_gatt_init(&m_gatt, NULL);
+    ret_code_t err_code = nrf_ble_gatt_init(&m_gatt, gatt_evt_handler);
+    APP_ERROR_CHECK(err_code);
+
+    err_code = nrf_ble_gatt_att_max_mtu_set(&m_gatt, NRF_SDH_BLE_GATT_MAX_MTU_SIZE);
+    APP_ERROR_CHECK(err_code);
+
+    err_code = nrf_ble_gatt_data_length_set(&m_gatt, BLE_CONN_HANDLE_INVALID, NRF_SDH_BLE_GAP_DATA_LENGTH);
     APP_ERROR_CHECK(err_code);
 }
 
@@ -200,21 +329,278 @@ static void nrf_qwr_error_handler(uint32_t nrf_error)
     APP_ERROR_HANDLER(nrf_error);
 }
 
+/**@brief Function for handling Queued Write module events.
+ *
+ * @param[in] p_qwr  Queued Write module instance.
+ * @param[in] p_evt  Event received from the Queued Write module.
+ *
+ * @return GATT status to reply to the peer with.
+ */
+static uint16_t nrf_qwr_evt_handler(nrf_ble_qwr_t * p_qwr, nrf_ble_qwr_evt_t * p_evt)
+{
+    if (p_evt->evt_type == NRF_BLE_QWR_EVT_EXECUTE_WRITE)
+    {
+        uint16_t   len      = sizeof(m_qwr_value);
+        ret_code_t err_code = nrf_ble_qwr_value_get(p_qwr, p_evt->attr_handle, m_qwr_value, &len);
+        APP_ERROR_CHECK(err_code);
+
+        NRF_LOG_DEBUG("Long write of %d bytes completed (handle: 0x%04x)", len, p_evt->attr_handle);
+        estc_ble_service_on_long_write(&m_estc_service, p_qwr->conn_handle, p_evt->attr_handle, m_qwr_value, len);
+    }
+
+    return BLE_GATT_STATUS_SUCCESS;
+}
+
+/**@brief Function for handling data written to characteristic 1.
+ *
+ * @param[in] data  Received data.
+ * @param[in] len   Number of received bytes.
+ */
+static void estc_ingest_handler(uint8_t const *data, uint32_t len)
+{
+    NRF_LOG_DEBUG("Received %d bytes on characteristic 1 (%d queued in total, %d dropped)",
+                  len, m_estc_service.ingest_bytes, m_estc_service.ingest_overflow_bytes);
+}
+
+/**@brief Function for handling writes and transmitted notifications of the ESTC service.
+ *
+ * @param[in] conn_handle  Connection with the traffic.
+ */
+static void estc_activity_handler(uint16_t conn_handle)
+{
+    app_link_t * p_link = app_link_get(conn_handle);
+    if (p_link == NULL)
+    {
+        return;
+    }
+
+    // Commands are answered and data delivered faster on a short connection interval
+    estc_conn_policy_activity(&p_link->conn_policy);
+}
+
+/**@brief Function for telling the PHY and connection parameter policies whether a bulk transfer runs on a connection.
+ *
+ * @details Notifications that keep the queue full and a running L2CAP transfer both produce
+ *          faster than the link carries, so they benefit from 2M PHY and keep the busy profile
+ *          until they end.
+ *
+ * @param[in] conn_handle  Connection handle.
+ */
+static void app_link_bulk_update(uint16_t conn_handle)
+{
+    app_link_t * p_link = app_link_get(conn_handle);
+    if (p_link == NULL)
+    {
+        return;
+    }
+
+    bool l2cap_active = (m_l2cap.conn_handle == conn_handle) && (m_l2cap_requested > 0);
+    bool bulk         = p_link->tx_saturated || l2cap_active;
+    estc_phy_bulk_set(&p_link->phy, bulk);
+    estc_conn_policy_stream_set(&p_link->conn_policy, bulk);
+}
+
+/**@brief Function for handling notification queues of the ESTC service starting or stopping to run full.
+ *
+ * @param[in] conn_handle  Connection of the queue.
+ * @param[in] saturated    True if the senders filled the queue, false if it drained.
+ */
+static void estc_load_handler(uint16_t conn_handle, bool saturated)
+{
+    app_link_t * p_link = app_link_get(conn_handle);
+    if (p_link == NULL)
+    {
+        return;
+    }
+
+    p_link->tx_saturated = saturated;
+    app_link_bulk_update(conn_handle);
+}
+
+/**@brief Function for handing the next part of the requested transfer to the L2CAP channel.
+ *
+ * @param[in] p_l2cap  L2CAP endpoint.
+ */
+static void l2cap_tx_handler(estc_l2cap_t * p_l2cap)
+{
+    uint8_t chunk[ESTC_L2CAP_SDU_LEN];
+
+    while (m_l2cap_remaining > 0)
+    {
+        uint32_t offset = m_l2cap_requested - m_l2cap_remaining;
+        uint32_t len    = MIN(m_l2cap_remaining, sizeof(chunk));
+        for (uint32_t i = 0; i < len; i++)
+        {
+            chunk[i] = (uint8_t)(offset + i);
+        }
+
+        uint32_t accepted = estc_l2cap_send(p_l2cap, chunk, len);
+        m_l2cap_remaining -= accepted;
+        if (accepted < len)
+        {
+            // Continued when the SoftDevice returns an SDU buffer
+            return;
+        }
+    }
+
+    if (m_l2cap_requested > 0 && p_l2cap->bytes_sent >= m_l2cap_requested)
+    {
+        estc_l2cap_stats_log(p_l2cap);
+        m_l2cap_requested = 0;
+        app_link_bulk_update(p_l2cap->conn_handle);
+    }
+}
+
+
+/**@brief Function for handling SDUs received on the L2CAP channel.
+ *
+ * @details A byte count (uint32, little-endian) starts a transfer of that many bytes, the same
+ *          request the GATT benchmark takes, so both paths can be compared on the same link.
+ *
+ * @param[in] p_l2cap  L2CAP endpoint.
+ * @param[in] p_data   Received SDU.
+ * @param[in] len      Length of the SDU.
+ */
+static void l2cap_rx_handler(estc_l2cap_t * p_l2cap, uint8_t const * p_data, uint16_t len)
+{
+    if (len != sizeof(uint32_t))
+    {
+        return;
+    }
+
+    // A new request replaces the current one, also one cut off by a released channel
+
+    m_l2cap_requested   = uint32_decode(p_data);
+    m_l2cap_remaining   = m_l2cap_requested;
+    p_l2cap->bytes_sent = 0;
+    p_l2cap->sdus_sent  = 0;
+    NRF_LOG_INFO("L2CAP transfer of %d bytes requested", m_l2cap_requested);
+    app_link_bulk_update(p_l2cap->conn_handle);
+    l2cap_tx_handler(p_l2cap);
+}
+
+
+/**@brief Function for handling a request of a central for a reliable transfer.
+ *
+ * @details A new request replaces the current one. The data is handed to the service from the
+ *          main loop by reliable_process.
+ *
+ * @param[in] conn_handle  Connection of the central.
+ * @param[in] len          Number of bytes requested.
+ */
+static void estc_reliable_request_handler(uint16_t conn_handle, uint32_t len)
+{
+    app_link_t * p_link = app_link_get(conn_handle);
+    if (p_link == NULL)
+    {
+        return;
+    }
+
+    CRITICAL_REGION_ENTER();
+    p_link->reliable_requested = len;
+    p_link->reliable_remaining = len;
+    CRITICAL_REGION_EXIT();
+    NRF_LOG_INFO("Reliable transfer of %d bytes requested (conn_handle: %d)", len, conn_handle);
+}
+
+/**@brief Function for handing the requested reliable transfers to the service.
+ *
+ * @details Called from the main loop. The same pattern as the L2CAP transfer is sent, as much as
+ *          the window of each link takes. Acknowledgements wake the CPU, so the rest follows
+ *          when the window has space again.
+ */
+static void reliable_process(void)
+{
+    uint8_t chunk[ESTC_ARQ_SEGMENT_MAX_LEN];
+
+    for (uint32_t i = 0; i < NRF_SDH_BLE_TOTAL_LINK_COUNT; i++)
+    {
+        app_link_t * p_link = &m_links[i];
+
+        while (p_link->reliable_remaining > 0 && p_link->conn_handle != BLE_CONN_HANDLE_INVALID)
+        {
+            uint32_t offset = p_link->reliable_requested - p_link->reliable_remaining;
+            uint32_t len    = MIN(p_link->reliable_remaining, sizeof(chunk));
+            for (uint32_t j = 0; j < len; j++)
+            {
+                chunk[j] = (uint8_t)(offset + j);
+            }
+
+            uint32_t accepted = estc_ble_service_reliable_write(&m_estc_service, p_link->conn_handle, chunk, len);
+            CRITICAL_REGION_ENTER();
+            p_link->reliable_remaining -= MIN(accepted, p_link->reliable_remaining);
+            CRITICAL_REGION_EXIT();
+            if (accepted < len)
+            {
+                break;
+            }
+        }
+    }
+}
+
+
 /**@brief Function for initializing services that will be used by the application.
  */
 static void services_init(void)
 {
-    ret_code_t         err_code;
-    nrf_ble_qwr_init_t qwr_init = {0};
+    ret_code_t              err_code;
+    nrf_ble_qwr_init_t      qwr_init = {0};
+    estc_ble_service_init_t estc_init = {0};
+
+    // Initialize Queued Write Module instances.
+    qwr_init.error_handler     = nrf_qwr_error_handler;
+    qwr_init.callback          = nrf_qwr_evt_handler;
+
+    for (uint32_t i = 0; i < NRF_SDH_BLE_TOTAL_LINK_COUNT; i++)
+    {
+        qwr_init.mem_buffer.p_mem  = m_qwr_mem[i];
+        qwr_init.mem_buffer.len    = sizeof(m_qwr_mem[i]);
+
+        err_code = nrf_ble_qwr_init(&m_qwr[i], &qwr_init);
+        APP_ERROR_CHECK(err_code);
 
-    // Initialize Queued Write Module.
-    qwr_init.error_handler = nrf_qwr_error_handler;
+        m_links[i].conn_handle = BLE_CONN_HANDLE_INVALID;
+        estc_phy_init(&m_links[i].phy);
+    }
+
+    estc_init.ingest_handler           = estc_ingest_handler;
+    estc_init.activity_handler         = estc_activity_handler;
+    estc_init.load_handler             = estc_load_handler;
+    estc_init.reliable_request_handler = estc_reliable_request_handler;
+    estc_init.hvn_tx_queue_size        = APP_HVN_TX_QUEUE_SIZE;
+
+    err_code = estc_ble_service_init(&m_estc_service, &estc_init);
+    APP_ERROR_CHECK(err_code);
+
+    err_code = estc_l2cap_init(&m_l2cap, l2cap_rx_handler, l2cap_tx_handler);
+    APP_ERROR_CHECK(err_code);
 
-    err_code = nrf_ble_qwr_init(&m_qwr, &qwr_init);
+    err_code = NRF_ATFIFO_INIT(m_sample_fifo);
     APP_ERROR_CHECK(err_code);
 
-    err_code = estc_ble_service_init(&m_estc_service);
+    estc_sampler_init_t sampler_init = {0};
+    sampler_init.rate_hz                 = SAMPLE_RATE_HZ;
+    sampler_init.max_latency_ms          = SAMPLE_MAX_LATENCY_MS;
+    sampler_init.sensor_cfg.min          = SAMPLE_SENSOR_MIN;
+    sampler_init.sensor_cfg.max          = SAMPLE_SENSOR_MAX;
+    sampler_init.sensor_cfg.incr         = SAMPLE_SENSOR_INCR;
+    sampler_init.sensor_cfg.start_at_max = false;
+    sampler_init.aggregate.window        = SAMPLE_AGGREGATE_WINDOW;
+    sampler_init.aggregate.deadband      = SAMPLE_DEADBAND;
+    sampler_init.encoding                = SAMPLE_ENCODING;
+#if ESTC_DSP_ENABLED
+    sampler_init.dsp_format              = SAMPLE_DSP_FORMAT;
+#endif
+
+    err_code = estc_sampler_init(&m_sampler, &m_estc_service, m_sample_fifo, &sampler_init);
     APP_ERROR_CHECK(err_code);
+
+    // Long writes to characteristic 1 are reassembled by the Queued Write module.
+    for (uint32_t i = 0; i < NRF_SDH_BLE_TOTAL_LINK_COUNT; i++)
+    {
+        err_code = nrf_ble_qwr_attr_register(&m_qwr[i], m_estc_service.characterstic1_handle.value_handle);
+        APP_ERROR_CHECK(err_code);
+    }
 }
 
 
@@ -222,9 +608,9 @@ static void services_init(void)
  *
  * @details This function will be called for all events in the Connection Parameters Module which
  *          are passed to the application.
- *          @note All this function does is to disconnect. This could have been done by simply
- *                setting the disconnect_on_fail config parameter, but instead we use the event
- *                handler mechanism to demonstrate its use.
+ *          @note The link is only dropped when the initial negotiation fails. A profile the
+ *                connection policy requested is optional, so a central that does not grant it
+ *                keeps its own parameters instead.
  *
  * @param[in] p_evt  Event received from the Connection Parameters Module.
  */
@@ -234,7 +620,13 @@ static void on_conn_params_evt(ble_conn_params_evt_t * p_evt)
 
     if (p_evt->evt_type == BLE_CONN_PARAMS_EVT_FAILED)
     {
-        err_code = sd_ble_gap_disconnect(m_conn_handle, BLE_HCI_CONN_INTERVAL_UNACCEPTABLE);
+        app_link_t * p_link = app_link_get(p_evt->conn_handle);
+        if (p_link != NULL && estc_conn_policy_on_conn_params_failed(&p_link->conn_policy))
+        {
+            return;
+        }
+
+        err_code = sd_ble_gap_disconnect(p_evt->conn_handle, BLE_HCI_CONN_INTERVAL_UNACCEPTABLE);
         APP_ERROR_CHECK(err_code);
     }
 }
@@ -270,6 +662,25 @@ static void conn_params_init(void)
 
     err_code = ble_conn_params_init(&cp_init);
     APP_ERROR_CHECK(err_code);
+
+    estc_conn_policy_init_t policy_init;
+    memset(&policy_init, 0, sizeof(policy_init));
+
+    policy_init.idle_params.min_conn_interval = IDLE_MIN_CONN_INTERVAL;
+    policy_init.idle_params.max_conn_interval = IDLE_MAX_CONN_INTERVAL;
+    policy_init.idle_params.slave_latency     = IDLE_SLAVE_LATENCY;
+    policy_init.idle_params.conn_sup_timeout  = CONN_SUP_TIMEOUT;
+    policy_init.busy_params.min_conn_interval = BUSY_MIN_CONN_INTERVAL;
+    policy_init.busy_params.max_conn_interval = BUSY_MAX_CONN_INTERVAL;
+    policy_init.busy_params.slave_latency     = BUSY_SLAVE_LATENCY;
+    policy_init.busy_params.conn_sup_timeout  = CONN_SUP_TIMEOUT;
+    policy_init.idle_timeout_ms               = CONN_POLICY_IDLE_TIMEOUT_MS;
+
+    for (uint32_t i = 0; i < NRF_SDH_BLE_TOTAL_LINK_COUNT; i++)
+    {
+        err_code = estc_conn_policy_init(&m_links[i].conn_policy, &policy_init);
+        APP_ERROR_CHECK(err_code);
+    }
 }
 
 
@@ -277,6 +688,8 @@ static void conn_params_init(void)
  */
 static void application_timers_start(void)
 {
+    ret_code_t err_code = estc_sampler_start(&m_sampler);
+    APP_ERROR_CHECK(err_code);
 }
 
 
@@ -315,13 +728,18 @@ static void on_adv_evt(ble_adv_evt_t ble_adv_evt)
     {
         case BLE_ADV_EVT_FAST:
             NRF_LOG_INFO("ADV Event: Start fast advertising");
+            m_advertising_active = true;
             err_code = bsp_indication_set(BSP_INDICATE_ADVERTISING);
             APP_ERROR_CHECK(err_code);
             break;
 
         case BLE_ADV_EVT_IDLE:
             NRF_LOG_INFO("ADV Event: idle, no connectable advertising is ongoing");
-            sleep_mode_enter();
+            m_advertising_active = false;
+            if (ble_conn_state_peripheral_conn_count() == 0)
+            {
+                sleep_mode_enter();
+            }
             break;
 
         default:
@@ -330,6 +748,24 @@ static void on_adv_evt(ble_adv_evt_t ble_adv_evt)
 }
 
 
+/**@brief Function for passing BLE events to the policies of the link they belong to.
+ *
+ * @param[in]   p_ble_evt   Bluetooth stack event.
+ * @param[in]   p_context   Unused.
+ */
+static void link_evt_handler(ble_evt_t const * p_ble_evt, void * p_context)
+{
+    app_link_t * p_link = app_link_get(p_ble_evt->evt.gap_evt.conn_handle);
+    if (p_link == NULL)
+    {
+        return;
+    }
+
+    estc_phy_on_ble_event(p_ble_evt, &p_link->phy);
+    estc_conn_policy_on_ble_event(p_ble_evt, &p_link->conn_policy);
+}
+
+
 /**@brief Function for handling BLE events.
  *
  * @param[in]   p_ble_evt   Bluetooth stack event.
@@ -338,36 +774,71 @@ static void on_adv_evt(ble_adv_evt_t ble_adv_evt)
 static void ble_evt_handler(ble_evt_t const * p_ble_evt, void * p_context)
 {
     ret_code_t err_code = NRF_SUCCESS;
+    uint16_t conn_handle = p_ble_evt->evt.gap_evt.conn_handle;
+    app_link_t * p_link  = app_link_get(conn_handle);
 
     switch (p_ble_evt->header.evt_id)
     {
         case BLE_GAP_EVT_DISCONNECTED:
-            NRF_LOG_INFO("Disconnected (conn_handle: %d)", p_ble_evt->evt.gap_evt.conn_handle);
-            // LED indication will be changed when advertising starts.
+            NRF_LOG_INFO("Disconnected (conn_handle: %d)", conn_handle);
+            p_link->conn_handle        = BLE_CONN_HANDLE_INVALID;
+            p_link->reliable_remaining = 0;
+            // The advertising module does not restart on its own, another link may still be up.
+            if (!m_advertising_active)
+            {
+                advertising_start();
+            }
             break;
 
         case BLE_GAP_EVT_CONNECTED:
-            NRF_LOG_INFO("Connected (conn_handle: %d)", p_ble_evt->evt.gap_evt.conn_handle);
+            NRF_LOG_INFO("Connected (conn_handle: %d)", conn_handle);
+            // Connectable advertising stops when a central connects.
+            m_advertising_active = false;
 
             err_code = bsp_indication_set(BSP_INDICATE_CONNECTED);
             APP_ERROR_CHECK(err_code);
 
-            m_conn_handle = p_ble_evt->evt.gap_evt.conn_handle;
-            err_code = nrf_ble_qwr_conn_handle_assign(&m_qwr, m_conn_handle);
+            err_code = nrf_ble_qwr_conn_handle_assign(&m_qwr[ble_conn_state_conn_idx(conn_handle)], conn_handle);
             APP_ERROR_CHECK(err_code);
+
+            p_link->params.att_mtu         = BLE_GATT_ATT_MTU_DEFAULT;
+            p_link->params.data_length     = BLE_GAP_DATA_LENGTH_DEFAULT;
+            p_link->params.phy             = BLE_GAP_PHY_1MBPS;
+            p_link->params.conn_interval   = p_ble_evt->evt.gap_evt.params.connected.conn_params.max_conn_interval;
+            p_link->params.event_length    = NRF_SDH_BLE_GAP_EVENT_LENGTH;
+            p_link->params.event_extension = true;
+            p_link->params.tx_queue_size   = APP_HVN_TX_QUEUE_SIZE;
+            p_link->tx_saturated           = false;
+            p_link->conn_handle            = conn_handle;
+            p_link->reliable_requested     = 0;
+            p_link->reliable_remaining     = 0;
+
+            // Keep accepting centrals until every peripheral link is taken.
+            if (ble_conn_state_peripheral_conn_count() < NRF_SDH_BLE_PERIPHERAL_LINK_COUNT)
+            {
+                advertising_start();
+            }
             break;
 
-        case BLE_GAP_EVT_PHY_UPDATE_REQUEST:
-        {
-            NRF_LOG_DEBUG("PHY update request (conn_handle: %d)", p_ble_evt->evt.gap_evt.conn_handle);
-            ble_gap_phys_t const phys =
+        case BLE_GAP_EVT_CONN_PARAM_UPDATE:
+            p_link->params.conn_interval = p_ble_evt->evt.gap_evt.params.conn_param_update.conn_params.max_conn_interval;
+            throughput_estimate_log(p_link);
+            break;
+
+        case BLE_GAP_EVT_PHY_UPDATE:
+            if (BLE_HCI_STATUS_CODE_SUCCESS == p_ble_evt->evt.gap_evt.params.phy_update.status)
             {
-                .rx_phys = BLE_GAP_PHY_AUTO,
-                .tx_phys = BLE_GAP_PHY_AUTO,
-            };
-            err_code = sd_ble_gap_phy_update(p_ble_evt->evt.gap_evt.conn_handle, &phys);
+                p_link->params.phy = p_ble_evt->evt.gap_evt.params.phy_update.tx_phy;
+                throughput_estimate_log(p_link);
+            }
+            break;
+
+        case BLE_GATTS_EVT_SYS_ATTR_MISSING:
+            // No system attributes have been stored.
+            err_code = sd_ble_gatts_sys_attr_set(p_ble_evt->evt.gatts_evt.conn_handle, NULL, 0, 0);
             APP_ERROR_CHECK(err_code);
-        } break;
+            estc_ble_service_subscriptions_restore(&m_estc_service, p_ble_evt->evt.gatts_evt.conn_handle);
+            break;
 
         case BLE_GATTC_EVT_TIMEOUT:
             // Disconnect on GATT Client timeout event.
@@ -392,6 +863,10 @@ static void ble_evt_handler(ble_evt_t const * p_ble_evt, void * p_context)
 }
 
 
+// The event length nrf_sdh_ble_default_cfg_set reserves per link has to leave room for every
+// link in the shortest connection interval, event extension uses the radio time left over
+STATIC_ASSERT(NRF_SDH_BLE_GAP_EVENT_LENGTH * NRF_SDH_BLE_PERIPHERAL_LINK_COUNT <= (uint32_t)BUSY_MIN_CONN_INTERVAL);
+
 /**@brief Function for initializing the BLE stack.
  *
  * @details Initializes the SoftDevice and the BLE event interrupt.
@@ -409,11 +884,38 @@ static void ble_stack_init(void)
     err_code = nrf_sdh_ble_default_cfg_set(APP_BLE_CONN_CFG_TAG, &ram_start);
     APP_ERROR_CHECK(err_code);
 
+    // Let the SoftDevice queue several notifications, so the senders can fill a connection event.
+    ble_cfg_t ble_cfg;
+    memset(&ble_cfg, 0, sizeof(ble_cfg));
+    ble_cfg.conn_cfg.conn_cfg_tag                            = APP_BLE_CONN_CFG_TAG;
+    ble_cfg.conn_cfg.params.gatts_conn_cfg.hvn_tx_queue_size = APP_HVN_TX_QUEUE_SIZE;
+    err_code = sd_ble_cfg_set(BLE_CONN_CFG_GATTS, &ble_cfg, ram_start);
+    APP_ERROR_CHECK(err_code);
+
+    // Let a central open one LE credit-based L2CAP channel per connection for bulk transfers.
+    memset(&ble_cfg, 0, sizeof(ble_cfg));
+    ble_cfg.conn_cfg.conn_cfg_tag                        = APP_BLE_CONN_CFG_TAG;
+    ble_cfg.conn_cfg.params.l2cap_conn_cfg.rx_mps        = ESTC_L2CAP_MPS;
+    ble_cfg.conn_cfg.params.l2cap_conn_cfg.tx_mps        = ESTC_L2CAP_MPS;
+    ble_cfg.conn_cfg.params.l2cap_conn_cfg.rx_queue_size = ESTC_L2CAP_RX_QUEUE_SIZE;
+    ble_cfg.conn_cfg.params.l2cap_conn_cfg.tx_queue_size = ESTC_L2CAP_TX_QUEUE_SIZE;
+    ble_cfg.conn_cfg.params.l2cap_conn_cfg.ch_count      = 1;
+    err_code = sd_ble_cfg_set(BLE_CONN_CFG_L2CAP, &ble_cfg, ram_start);
+    APP_ERROR_CHECK(err_code);
+
     // Enable BLE stack.
     err_code = nrf_sdh_ble_enable(&ram_start);
     APP_ERROR_CHECK(err_code);
 
-    // Register a handler for BLE events.
+    // Let connection events run past the event length when the radio has nothing else to do.
+    ble_opt_t ble_opt;
+    memset(&ble_opt, 0, sizeof(ble_opt));
+    ble_opt.common_opt.conn_evt_ext.enable = 1;
+    err_code = sd_ble_opt_set(BLE_COMMON_OPT_CONN_EVT_EXT, &ble_opt);
+    APP_ERROR_CHECK(err_code);
+
+    // Register handlers for BLE events.
+    NRF_SDH_BLE_OBSERVER(m_link_observer, APP_BLE_OBSERVER_PRIO, link_evt_handler, NULL);
     NRF_SDH_BLE_OBSERVER(m_ble_observer, APP_BLE_OBSERVER_PRIO, ble_evt_handler, NULL);
 }
 
@@ -433,13 +935,18 @@ static void bsp_event_handler(bsp_event_t event)
             break; // BSP_EVENT_SLEEP
 
         case BSP_EVENT_DISCONNECT:
-            err_code = sd_ble_gap_disconnect(m_conn_handle,
-                                             BLE_HCI_REMOTE_USER_TERMINATED_CONNECTION);
-            if (err_code != NRF_ERROR_INVALID_STATE)
+        {
+            ble_conn_state_conn_handle_list_t conn_handles = ble_conn_state_periph_handles();
+            for (uint32_t i = 0; i < conn_handles.len; i++)
             {
-                APP_ERROR_CHECK(err_code);
+                err_code = sd_ble_gap_disconnect(conn_handles.conn_handles[i],
+                                                 BLE_HCI_REMOTE_USER_TERMINATED_CONNECTION);
+                if (err_code != NRF_ERROR_INVALID_STATE)
+                {
+                    APP_ERROR_CHECK(err_code);
+                }
             }
-            break; // BSP_EVENT_DISCONNECT
+        } break; // BSP_EVENT_DISCONNECT
         default:
             break;
     }
@@ -465,6 +972,8 @@ static void advertising_init(void)
     init.config.ble_adv_fast_enabled  = true;
     init.config.ble_adv_fast_interval = APP_ADV_INTERVAL;
     init.config.ble_adv_fast_timeout  = APP_ADV_DURATION;
+    // Restarted from ble_evt_handler, only while a peripheral link is free.
+    init.config.ble_adv_on_disconnect_disabled = true;
 
     init.evt_handler = on_adv_evt;
 
@@ -518,6 +1027,10 @@ static void power_management_init(void)
  */
 static void idle_state_handle(void)
 {
+    estc_ble_service_process(&m_estc_service);
+    estc_sampler_process(&m_sampler);
+    reliable_process();
+
     if (NRF_LOG_PROCESS() == false)
     {
         nrf_pwr_mgmt_run();
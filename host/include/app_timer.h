@@ -0,0 +1,92 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#ifndef APP_TIMER_H__
+#define APP_TIMER_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "app_util.h"
+#include "sdk_config.h"
+#include "sdk_errors.h"
+
+/* Host build: app_timer v2 API on a simulated RTC1, see sim.h for advancing it */
+
+#define APP_TIMER_CLOCK_FREQ            32768
+#define APP_TIMER_MIN_TIMEOUT_TICKS     5
+#define APP_TIMER_MAX_CNT_VAL           0xFFFFFF
+
+#define APP_TIMER_TICKS(MS)                                     \
+            ((uint32_t)ROUNDED_DIV(                             \
+            (MS) * (uint64_t)APP_TIMER_CLOCK_FREQ,              \
+            1000 * (APP_TIMER_CONFIG_RTC_FREQUENCY + 1)))
+
+/**@brief Application time-out handler type. */
+typedef void (*app_timer_timeout_handler_t)(void *p_context);
+
+/**@brief Timer modes. */
+typedef enum
+{
+    APP_TIMER_MODE_SINGLE_SHOT,
+    APP_TIMER_MODE_REPEATED
+} app_timer_mode_t;
+
+/**@brief Timer instance. */
+typedef struct app_timer_s
+{
+    struct app_timer_s         *p_next;         /**< Next timer in the list of running timers. */
+    uint64_t                    end_val;        /**< RTC ticks (64-bit) when the timer expires. */
+    uint32_t                    repeat_period;  /**< Period of a repeated timer, 0 while stopped for single shot. */
+    app_timer_timeout_handler_t handler;        /**< User handler. */
+    void                       *p_context;      /**< User context. */
+    bool                        repeated;       /**< Timer was created in APP_TIMER_MODE_REPEATED. */
+    bool                        active;         /**< Timer is running. */
+} app_timer_t;
+
+/**@brief Timer ID type. */
+typedef app_timer_t *app_timer_id_t;
+
+#define _APP_TIMER_DEF(timer_id)                                \
+    static app_timer_t CONCAT_2(timer_id, _data) = { .active = false }; \
+    static const app_timer_id_t timer_id = &CONCAT_2(timer_id, _data)
+
+#define APP_TIMER_DEF(timer_id) _APP_TIMER_DEF(timer_id)
+
+ret_code_t app_timer_init(void);
+ret_code_t app_timer_create(app_timer_id_t const *p_timer_id, app_timer_mode_t mode,
+                            app_timer_timeout_handler_t timeout_handler);
+ret_code_t app_timer_start(app_timer_id_t timer_id, uint32_t timeout_ticks, void *p_context);
+ret_code_t app_timer_stop(app_timer_id_t timer_id);
+ret_code_t app_timer_stop_all(void);
+uint32_t app_timer_cnt_get(void);
+uint32_t app_timer_cnt_diff_compute(uint32_t ticks_to, uint32_t ticks_from);
+
+#endif /* APP_TIMER_H__ */
@@ -0,0 +1,86 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#ifndef APP_UTIL_H__
+#define APP_UTIL_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "nordic_common.h"
+
+#define STATIC_ASSERT(EXPR, ...) _Static_assert((EXPR), "" __VA_ARGS__)
+
+enum
+{
+    UNIT_0_625_MS = 625,
+    UNIT_1_25_MS  = 1250,
+    UNIT_10_MS    = 10000
+};
+
+#define MSEC_TO_UNITS(TIME, RESOLUTION) (((TIME) * 1000) / (RESOLUTION))
+
+#define ROUNDED_DIV(A, B) (((A) + ((B) / 2)) / (B))
+#define CEIL_DIV(A, B)    (((A) + (B) - 1) / (B))
+#define ALIGN_NUM(alignment, number) (((number) - 1) + (alignment) - ((((number) - 1) + (alignment)) % (alignment)))
+#define IS_POWER_OF_TWO(A) (((A) != 0) && ((((A) - 1) & (A)) == 0))
+#define ARRAY_SIZE(arr) (sizeof(arr) / sizeof((arr)[0]))
+
+static inline uint8_t uint16_encode(uint16_t value, uint8_t *p_encoded_data)
+{
+    p_encoded_data[0] = (uint8_t)((value & 0x00FF) >> 0);
+    p_encoded_data[1] = (uint8_t)((value & 0xFF00) >> 8);
+    return sizeof(uint16_t);
+}
+
+static inline uint8_t uint32_encode(uint32_t value, uint8_t *p_encoded_data)
+{
+    p_encoded_data[0] = (uint8_t)((value & 0x000000FF) >> 0);
+    p_encoded_data[1] = (uint8_t)((value & 0x0000FF00) >> 8);
+    p_encoded_data[2] = (uint8_t)((value & 0x00FF0000) >> 16);
+    p_encoded_data[3] = (uint8_t)((value & 0xFF000000) >> 24);
+    return sizeof(uint32_t);
+}
+
+static inline uint16_t uint16_decode(const uint8_t *p_encoded_data)
+{
+    return (uint16_t)((((uint16_t)p_encoded_data[0])) | (((uint16_t)p_encoded_data[1]) << 8));
+}
+
+static inline uint32_t uint32_decode(const uint8_t *p_encoded_data)
+{
+    return ((((uint32_t)p_encoded_data[0]) << 0)  |
+            (((uint32_t)p_encoded_data[1]) << 8)  |
+            (((uint32_t)p_encoded_data[2]) << 16) |
+            (((uint32_t)p_encoded_data[3]) << 24));
+}
+
+#endif /* APP_UTIL_H__ */
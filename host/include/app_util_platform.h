@@ -0,0 +1,61 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#ifndef APP_UTIL_PLATFORM_H__
+#define APP_UTIL_PLATFORM_H__
+
+#include <stdint.h>
+
+#include "nrf.h"
+#include "app_error.h"
+#include "app_util.h"
+
+/* Host build: interrupts are simulated on one thread, so there is nothing to mask */
+
+#define APP_IRQ_PRIORITY_HIGHEST    2
+#define APP_IRQ_PRIORITY_HIGH       2
+#define APP_IRQ_PRIORITY_MID        4
+#define APP_IRQ_PRIORITY_LOW        6
+#define APP_IRQ_PRIORITY_LOWEST     7
+#define APP_IRQ_PRIORITY_THREAD     15
+
+void app_util_critical_region_enter(uint8_t *p_nested);
+void app_util_critical_region_exit(uint8_t nested);
+
+#define CRITICAL_REGION_ENTER()                                                         \
+    {                                                                                   \
+        uint8_t __CR_NESTED = 0;                                                        \
+        app_util_critical_region_enter(&__CR_NESTED);
+
+#define CRITICAL_REGION_EXIT()                                                          \
+        app_util_critical_region_exit(__CR_NESTED);                                     \
+    }
+
+#endif /* APP_UTIL_PLATFORM_H__ */
@@ -0,0 +1,102 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#ifndef ARM_MATH_H__
+#define ARM_MATH_H__
+
+#include <stdint.h>
+
+#include "nrf.h"
+
+/* Host build: the CMSIS-DSP kernels the ESTC applications use, computed in double precision with
+ * the output formats and scaling of the library, so the fixed point paths keep their rounding
+ * and saturation. Only the forward real FFT exists, an inverse one aborts. */
+
+typedef float   float32_t;
+typedef int16_t q15_t;
+typedef int32_t q31_t;
+typedef int64_t q63_t;
+
+typedef enum
+{
+    ARM_MATH_SUCCESS        =  0,
+    ARM_MATH_ARGUMENT_ERROR = -1,
+    ARM_MATH_LENGTH_ERROR   = -2,
+    ARM_MATH_SIZE_MISMATCH  = -3,
+    ARM_MATH_NANINF         = -4,
+    ARM_MATH_SINGULAR       = -5,
+    ARM_MATH_TEST_FAILURE   = -6,
+} arm_status;
+
+typedef struct
+{
+    uint16_t fftLenRFFT;
+} arm_rfft_fast_instance_f32;
+
+typedef struct
+{
+    uint32_t fftLenReal;
+    uint8_t  ifftFlagR;
+    uint8_t  bitReverseFlagR;
+} arm_rfft_instance_q15;
+
+void arm_rms_f32(float32_t const *pSrc, uint32_t blockSize, float32_t *pResult);
+void arm_max_f32(float32_t const *pSrc, uint32_t blockSize, float32_t *pResult, uint32_t *pIndex);
+void arm_min_f32(float32_t const *pSrc, uint32_t blockSize, float32_t *pResult, uint32_t *pIndex);
+void arm_mean_f32(float32_t const *pSrc, uint32_t blockSize, float32_t *pResult);
+void arm_offset_f32(float32_t const *pSrc, float32_t offset, float32_t *pDst, uint32_t blockSize);
+void arm_cmplx_mag_squared_f32(float32_t const *pSrc, float32_t *pDst, uint32_t numSamples);
+
+/**@brief Sizes 32 to 4096. */
+arm_status arm_rfft_fast_init_f32(arm_rfft_fast_instance_f32 *S, uint16_t fftLen);
+
+/**@brief Unscaled, pOut[0] and pOut[1] hold the real DC and Nyquist bins, then bins 1 to N/2 - 1. */
+void arm_rfft_fast_f32(arm_rfft_fast_instance_f32 *S, float32_t *p, float32_t *pOut, uint8_t ifftFlag);
+
+void arm_rms_q15(q15_t const *pSrc, uint32_t blockSize, q15_t *pResult);
+void arm_max_q15(q15_t const *pSrc, uint32_t blockSize, q15_t *pResult, uint32_t *pIndex);
+void arm_min_q15(q15_t const *pSrc, uint32_t blockSize, q15_t *pResult, uint32_t *pIndex);
+void arm_mean_q15(q15_t const *pSrc, uint32_t blockSize, q15_t *pResult);
+
+/**@brief Saturating. */
+void arm_offset_q15(q15_t const *pSrc, q15_t offset, q15_t *pDst, uint32_t blockSize);
+
+/**@brief 1.15 input, 3.13 output. */
+void arm_cmplx_mag_squared_q15(q15_t const *pSrc, q15_t *pDst, uint32_t numSamples);
+
+/**@brief Sizes 32 to 8192. */
+arm_status arm_rfft_init_q15(arm_rfft_instance_q15 *S, uint32_t fftLenReal, uint32_t ifftFlagR,
+                             uint32_t bitReverseFlag);
+
+/**@brief Scaled down by the length, all N complex bins in pDst, which holds 2 * N values. The
+ *        input is overwritten like in the library. */
+void arm_rfft_q15(arm_rfft_instance_q15 const *S, q15_t *pSrc, q15_t *pDst);
+
+#endif /* ARM_MATH_H__ */
@@ -0,0 +1,155 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#ifndef BLE_H__
+#define BLE_H__
+
+#include <stdint.h>
+
+#include "ble_err.h"
+#include "ble_types.h"
+#include "ble_gap.h"
+#include "ble_l2cap.h"
+#include "ble_gatt.h"
+#include "ble_gattc.h"
+#include "ble_gatts.h"
+
+enum BLE_COMMON_EVTS
+{
+    BLE_EVT_USER_MEM_REQUEST    = 0x01,
+    BLE_EVT_USER_MEM_RELEASE    = 0x02,
+};
+
+enum BLE_CONN_CFGS
+{
+    BLE_CONN_CFG_GAP            = 0x20,
+    BLE_CONN_CFG_GATTC          = 0x21,
+    BLE_CONN_CFG_GATTS          = 0x22,
+    BLE_CONN_CFG_GATT           = 0x23,
+    BLE_CONN_CFG_L2CAP          = 0x24,
+};
+
+enum BLE_COMMON_OPTS
+{
+    BLE_COMMON_OPT_PA_LNA       = 0x01,
+    BLE_COMMON_OPT_CONN_EVT_EXT = 0x02,
+};
+
+#define BLE_USER_MEM_TYPE_INVALID               0x00
+#define BLE_USER_MEM_TYPE_GATTS_QUEUED_WRITES   0x01
+
+/**@brief User Memory Block. */
+typedef struct
+{
+    uint8_t  *p_mem;
+    uint16_t len;
+} ble_user_mem_block_t;
+
+typedef struct
+{
+    uint8_t type;
+} ble_evt_user_mem_request_t;
+
+typedef struct
+{
+    uint8_t              type;
+    ble_user_mem_block_t mem_block;
+} ble_evt_user_mem_release_t;
+
+/**@brief Event structure for events not associated with a specific function module. */
+typedef struct
+{
+    uint16_t conn_handle;
+    union
+    {
+        ble_evt_user_mem_request_t user_mem_request;
+        ble_evt_user_mem_release_t user_mem_release;
+    } params;
+} ble_common_evt_t;
+
+/**@brief BLE Event header. */
+typedef struct
+{
+    uint16_t evt_id;
+    uint16_t evt_len;
+} ble_evt_hdr_t;
+
+/**@brief Common BLE Event type, wrapping the module specific event reports. */
+typedef struct
+{
+    ble_evt_hdr_t header;
+    union
+    {
+        ble_common_evt_t common_evt;
+        ble_gap_evt_t    gap_evt;
+        ble_gattc_evt_t  gattc_evt;
+        ble_gatts_evt_t  gatts_evt;
+        ble_l2cap_evt_t  l2cap_evt;
+    } evt;
+} ble_evt_t;
+
+/**@brief BLE connection configuration. */
+typedef struct
+{
+    uint8_t conn_cfg_tag;
+    union
+    {
+        ble_gap_conn_cfg_t   gap_conn_cfg;
+        ble_gatts_conn_cfg_t gatts_conn_cfg;
+        ble_gatt_conn_cfg_t  gatt_conn_cfg;
+        ble_l2cap_conn_cfg_t l2cap_conn_cfg;
+    } params;
+} ble_conn_cfg_t;
+
+/**@brief BLE configuration. */
+typedef union
+{
+    ble_conn_cfg_t  conn_cfg;
+    ble_gatts_cfg_t gatts_cfg;
+} ble_cfg_t;
+
+/**@brief Common BLE options. */
+typedef union
+{
+    ble_common_opt_conn_evt_ext_t conn_evt_ext;
+} ble_common_opt_t;
+
+/**@brief BLE options. */
+typedef union
+{
+    ble_common_opt_t common_opt;
+} ble_opt_t;
+
+uint32_t sd_ble_cfg_set(uint32_t cfg_id, ble_cfg_t const *p_cfg, uint32_t app_ram_base);
+uint32_t sd_ble_opt_set(uint32_t opt_id, ble_opt_t const *p_opt);
+uint32_t sd_ble_uuid_vs_add(ble_uuid128_t const *p_vs_uuid, uint8_t *p_uuid_type);
+uint32_t sd_ble_user_mem_reply(uint16_t conn_handle, ble_user_mem_block_t const *p_block);
+
+#endif /* BLE_H__ */
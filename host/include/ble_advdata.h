@@ -0,0 +1,93 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#ifndef BLE_ADVDATA_H__
+#define BLE_ADVDATA_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ble.h"
+#include "sdk_errors.h"
+
+#define AD_LENGTH_FIELD_SIZE    1UL
+#define AD_TYPE_FIELD_SIZE      1UL
+#define AD_DATA_OFFSET          (AD_LENGTH_FIELD_SIZE + AD_TYPE_FIELD_SIZE)
+
+/**@brief Names of the device in the advertising data. */
+typedef enum
+{
+    BLE_ADVDATA_NO_NAME,
+    BLE_ADVDATA_SHORT_NAME,
+    BLE_ADVDATA_FULL_NAME
+} ble_advdata_name_type_t;
+
+/**@brief Byte array. */
+typedef struct
+{
+    uint16_t size;
+    uint8_t *p_data;
+} uint8_array_t;
+
+/**@brief UUID list. */
+typedef struct
+{
+    uint16_t    uuid_cnt;
+    ble_uuid_t *p_uuids;
+} ble_advdata_uuid_list_t;
+
+/**@brief Manufacturer specific data. */
+typedef struct
+{
+    uint16_t      company_identifier;
+    uint8_array_t data;
+} ble_advdata_manuf_data_t;
+
+/**@brief Advertising data, the fields the ESTC applications use. */
+typedef struct
+{
+    ble_advdata_name_type_t   name_type;
+    uint8_t                   short_name_len;
+    bool                      include_appearance;
+    uint8_t                   flags;
+    ble_advdata_uuid_list_t   uuids_more_available;
+    ble_advdata_uuid_list_t   uuids_complete;
+    ble_advdata_manuf_data_t *p_manuf_specific_data;
+} ble_advdata_t;
+
+/**@brief Function for encoding advertising data into the over-the-air format.
+ *
+ * @param[in]    p_advdata    Data to encode.
+ * @param[out]   p_encoded    Encoded data.
+ * @param[inout] p_len        Size of the buffer in, length of the encoded data out.
+ */
+ret_code_t ble_advdata_encode(ble_advdata_t const *p_advdata, uint8_t *p_encoded, uint16_t *p_len);
+
+#endif /* BLE_ADVDATA_H__ */
@@ -0,0 +1,137 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#ifndef BLE_ADVERTISING_H__
+#define BLE_ADVERTISING_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ble.h"
+#include "ble_advdata.h"
+#include "nrf_sdh_ble.h"
+#include "sdk_config.h"
+#include "sdk_errors.h"
+
+#ifndef BLE_ADV_BLE_OBSERVER_PRIO
+#define BLE_ADV_BLE_OBSERVER_PRIO 1
+#endif
+
+/**@brief Advertising modes. */
+typedef enum
+{
+    BLE_ADV_MODE_IDLE,
+    BLE_ADV_MODE_DIRECTED_HIGH_DUTY,
+    BLE_ADV_MODE_DIRECTED,
+    BLE_ADV_MODE_FAST,
+    BLE_ADV_MODE_SLOW,
+} ble_adv_mode_t;
+
+/**@brief Advertising events. */
+typedef enum
+{
+    BLE_ADV_EVT_IDLE,
+    BLE_ADV_EVT_DIRECTED_HIGH_DUTY,
+    BLE_ADV_EVT_DIRECTED,
+    BLE_ADV_EVT_FAST,
+    BLE_ADV_EVT_SLOW,
+    BLE_ADV_EVT_FAST_WHITELIST,
+    BLE_ADV_EVT_SLOW_WHITELIST,
+    BLE_ADV_EVT_WHITELIST_REQUEST,
+    BLE_ADV_EVT_PEER_ADDR_REQUEST
+} ble_adv_evt_t;
+
+/**@brief Advertising modes configuration. */
+typedef struct
+{
+    bool     ble_adv_on_disconnect_disabled;
+    bool     ble_adv_whitelist_enabled;
+    bool     ble_adv_directed_high_duty_enabled;
+    bool     ble_adv_directed_enabled;
+    bool     ble_adv_fast_enabled;
+    bool     ble_adv_slow_enabled;
+    uint32_t ble_adv_directed_interval;
+    uint32_t ble_adv_directed_timeout;
+    uint32_t ble_adv_fast_interval;             /**< Advertising interval (in 0.625 ms units). */
+    uint32_t ble_adv_fast_timeout;              /**< Advertising duration (in 10 ms units). */
+    uint32_t ble_adv_slow_interval;
+    uint32_t ble_adv_slow_timeout;
+    bool     ble_adv_extended_enabled;
+    uint32_t ble_adv_secondary_phy;
+    uint32_t ble_adv_primary_phy;
+} ble_adv_modes_config_t;
+
+typedef void (*ble_adv_evt_handler_t)(ble_adv_evt_t const adv_evt);
+typedef void (*ble_adv_error_handler_t)(uint32_t nrf_error);
+
+/**@brief Advertising module instance. */
+typedef struct
+{
+    bool                    initialized;
+    bool                    advertising_start_pending;
+    ble_adv_mode_t          adv_mode_current;
+    ble_adv_modes_config_t  adv_modes_config;
+    uint8_t                 conn_cfg_tag;
+    ble_adv_evt_t           adv_evt;
+    ble_adv_evt_handler_t   evt_handler;
+    ble_adv_error_handler_t error_handler;
+    uint16_t                current_slave_link_conn_handle;
+    ble_advdata_t           advdata;
+    ble_advdata_t           srdata;
+    uint8_t                 adv_handle;
+    ble_gap_adv_params_t    adv_params;
+    uint8_t                 enc_advdata[BLE_GAP_ADV_SET_DATA_SIZE_MAX];
+    uint8_t                 enc_scan_rsp_data[BLE_GAP_ADV_SET_DATA_SIZE_MAX];
+    ble_gap_adv_data_t      adv_data;
+} ble_advertising_t;
+
+/**@brief Initialization parameters of the advertising module. */
+typedef struct
+{
+    ble_advdata_t           advdata;
+    ble_advdata_t           srdata;
+    ble_adv_modes_config_t  config;
+    ble_adv_evt_handler_t   evt_handler;
+    ble_adv_error_handler_t error_handler;
+} ble_advertising_init_t;
+
+/**@brief Macro for defining an advertising module instance. */
+#define BLE_ADVERTISING_DEF(_name)                                                                  \
+static ble_advertising_t _name;                                                                     \
+NRF_SDH_BLE_OBSERVER(_name ## _ble_obs,                                                             \
+                     BLE_ADV_BLE_OBSERVER_PRIO,                                                     \
+                     ble_advertising_on_ble_evt, &_name)
+
+void ble_advertising_on_ble_evt(ble_evt_t const *p_ble_evt, void *p_adv);
+uint32_t ble_advertising_init(ble_advertising_t *const p_advertising, ble_advertising_init_t const *const p_init);
+void ble_advertising_conn_cfg_tag_set(ble_advertising_t *const p_advertising, uint8_t ble_cfg_tag);
+uint32_t ble_advertising_start(ble_advertising_t *const p_advertising, ble_adv_mode_t advertising_mode);
+
+#endif /* BLE_ADVERTISING_H__ */
@@ -0,0 +1,75 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#ifndef BLE_CONN_PARAMS_H__
+#define BLE_CONN_PARAMS_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ble.h"
+#include "ble_srv_common.h"
+#include "sdk_config.h"
+#include "sdk_errors.h"
+
+/**@brief Connection Parameters Module event types. */
+typedef enum
+{
+    BLE_CONN_PARAMS_EVT_FAILED,
+    BLE_CONN_PARAMS_EVT_SUCCEEDED
+} ble_conn_params_evt_type_t;
+
+/**@brief Connection Parameters Module event. */
+typedef struct
+{
+    ble_conn_params_evt_type_t evt_type;
+    uint16_t                   conn_handle;
+} ble_conn_params_evt_t;
+
+typedef void (*ble_conn_params_evt_handler_t)(ble_conn_params_evt_t *p_evt);
+
+/**@brief Connection Parameters Module init structure. */
+typedef struct
+{
+    ble_gap_conn_params_t        *p_conn_params;
+    uint32_t                      first_conn_params_update_delay;
+    uint32_t                      next_conn_params_update_delay;
+    uint8_t                       max_conn_params_update_count;
+    uint16_t                      start_on_notify_cccd_handle;
+    bool                          disconnect_on_fail;
+    ble_conn_params_evt_handler_t evt_handler;
+    ble_srv_error_handler_t       error_handler;
+} ble_conn_params_init_t;
+
+uint32_t ble_conn_params_init(const ble_conn_params_init_t *p_init);
+uint32_t ble_conn_params_stop(void);
+uint32_t ble_conn_params_change_conn_params(uint16_t conn_handle, ble_gap_conn_params_t *p_new_params);
+
+#endif /* BLE_CONN_PARAMS_H__ */
@@ -0,0 +1,60 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#ifndef BLE_CONN_STATE_H__
+#define BLE_CONN_STATE_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ble.h"
+#include "sdk_config.h"
+
+#define BLE_CONN_STATE_MAX_CONNECTIONS  20
+
+/**@brief Connection handles. */
+typedef struct
+{
+    uint32_t len;
+    uint16_t conn_handles[BLE_CONN_STATE_MAX_CONNECTIONS];
+} ble_conn_state_conn_handle_list_t;
+
+void ble_conn_state_init(void);
+bool ble_conn_state_valid(uint16_t conn_handle);
+uint8_t ble_conn_state_role(uint16_t conn_handle);
+uint32_t ble_conn_state_conn_count(void);
+uint32_t ble_conn_state_peripheral_conn_count(void);
+ble_conn_state_conn_handle_list_t ble_conn_state_conn_handles(void);
+ble_conn_state_conn_handle_list_t ble_conn_state_periph_handles(void);
+
+/**@brief Function for getting the index of a connection, BLE_CONN_STATE_MAX_CONNECTIONS if invalid. */
+uint16_t ble_conn_state_conn_idx(uint16_t conn_handle);
+
+#endif /* BLE_CONN_STATE_H__ */
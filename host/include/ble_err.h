@@ -0,0 +1,48 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#ifndef BLE_ERR_H__
+#define BLE_ERR_H__
+
+#include "nrf_error.h"
+
+#define BLE_ERROR_NOT_ENABLED               (NRF_ERROR_STK_BASE_NUM + 0x001)
+#define BLE_ERROR_INVALID_CONN_HANDLE       (NRF_ERROR_STK_BASE_NUM + 0x002)
+#define BLE_ERROR_INVALID_ATTR_HANDLE       (NRF_ERROR_STK_BASE_NUM + 0x003)
+#define BLE_ERROR_INVALID_ADV_HANDLE        (NRF_ERROR_STK_BASE_NUM + 0x004)
+#define BLE_ERROR_INVALID_ROLE              (NRF_ERROR_STK_BASE_NUM + 0x005)
+#define BLE_ERROR_BLOCKED_BY_OTHER_LINKS    (NRF_ERROR_STK_BASE_NUM + 0x006)
+
+#define NRF_L2CAP_ERR_BASE                  (NRF_ERROR_STK_BASE_NUM + 0x100)
+#define NRF_GAP_ERR_BASE                    (NRF_ERROR_STK_BASE_NUM + 0x200)
+#define NRF_GATTC_ERR_BASE                  (NRF_ERROR_STK_BASE_NUM + 0x300)
+#define NRF_GATTS_ERR_BASE                  (NRF_ERROR_STK_BASE_NUM + 0x400)
+
+#endif /* BLE_ERR_H__ */
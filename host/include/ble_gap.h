@@ -0,0 +1,310 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#ifndef BLE_GAP_H__
+#define BLE_GAP_H__
+
+#include <stdint.h>
+
+#include "ble_types.h"
+#include "ble_err.h"
+#include "nrf_error.h"
+
+enum BLE_GAP_EVTS
+{
+    BLE_GAP_EVT_CONNECTED                   = 0x10,
+    BLE_GAP_EVT_DISCONNECTED                = 0x11,
+    BLE_GAP_EVT_CONN_PARAM_UPDATE           = 0x12,
+    BLE_GAP_EVT_SEC_PARAMS_REQUEST          = 0x13,
+    BLE_GAP_EVT_SEC_INFO_REQUEST            = 0x14,
+    BLE_GAP_EVT_PASSKEY_DISPLAY             = 0x15,
+    BLE_GAP_EVT_KEY_PRESSED                 = 0x16,
+    BLE_GAP_EVT_AUTH_KEY_REQUEST            = 0x17,
+    BLE_GAP_EVT_LESC_DHKEY_REQUEST          = 0x18,
+    BLE_GAP_EVT_AUTH_STATUS                 = 0x19,
+    BLE_GAP_EVT_CONN_SEC_UPDATE             = 0x1A,
+    BLE_GAP_EVT_TIMEOUT                     = 0x1B,
+    BLE_GAP_EVT_RSSI_CHANGED                = 0x1C,
+    BLE_GAP_EVT_ADV_REPORT                  = 0x1D,
+    BLE_GAP_EVT_SEC_REQUEST                 = 0x1E,
+    BLE_GAP_EVT_CONN_PARAM_UPDATE_REQUEST   = 0x1F,
+    BLE_GAP_EVT_SCAN_REQ_REPORT             = 0x20,
+    BLE_GAP_EVT_PHY_UPDATE_REQUEST          = 0x21,
+    BLE_GAP_EVT_PHY_UPDATE                  = 0x22,
+    BLE_GAP_EVT_DATA_LENGTH_UPDATE_REQUEST  = 0x23,
+    BLE_GAP_EVT_DATA_LENGTH_UPDATE          = 0x24,
+    BLE_GAP_EVT_QOS_CHANNEL_SURVEY_REPORT   = 0x25,
+    BLE_GAP_EVT_ADV_SET_TERMINATED          = 0x26,
+};
+
+#define BLE_GAP_ROLE_INVALID                0x0
+#define BLE_GAP_ROLE_PERIPH                 0x1
+#define BLE_GAP_ROLE_CENTRAL                0x2
+
+#define BLE_GAP_PHY_AUTO                    0x00
+#define BLE_GAP_PHY_1MBPS                   0x01
+#define BLE_GAP_PHY_2MBPS                   0x02
+#define BLE_GAP_PHY_CODED                   0x04
+#define BLE_GAP_PHY_NOT_SET                 0xFF
+
+#define BLE_GAP_DATA_LENGTH_AUTO            0
+#define BLE_GAP_DATA_LENGTH_DEFAULT         27
+#define BLE_GAP_DATA_LENGTH_MAX             251
+
+#define BLE_GAP_EVENT_LENGTH_MIN            2
+#define BLE_GAP_EVENT_LENGTH_DEFAULT        3
+
+#define BLE_GAP_CP_MIN_CONN_INTVL_MIN       0x0006
+#define BLE_GAP_CP_MAX_CONN_INTVL_MAX       0x0C80
+
+#define BLE_GAP_ADV_FLAG_LE_LIMITED_DISC_MODE   0x01
+#define BLE_GAP_ADV_FLAG_LE_GENERAL_DISC_MODE   0x02
+#define BLE_GAP_ADV_FLAG_BR_EDR_NOT_SUPPORTED   0x04
+#define BLE_GAP_ADV_FLAGS_LE_ONLY_LIMITED_DISC_MODE (BLE_GAP_ADV_FLAG_LE_LIMITED_DISC_MODE | BLE_GAP_ADV_FLAG_BR_EDR_NOT_SUPPORTED)
+#define BLE_GAP_ADV_FLAGS_LE_ONLY_GENERAL_DISC_MODE (BLE_GAP_ADV_FLAG_LE_GENERAL_DISC_MODE | BLE_GAP_ADV_FLAG_BR_EDR_NOT_SUPPORTED)
+
+#define BLE_GAP_AD_TYPE_FLAGS                               0x01
+#define BLE_GAP_AD_TYPE_16BIT_SERVICE_UUID_MORE_AVAILABLE   0x02
+#define BLE_GAP_AD_TYPE_16BIT_SERVICE_UUID_COMPLETE         0x03
+#define BLE_GAP_AD_TYPE_128BIT_SERVICE_UUID_COMPLETE        0x07
+#define BLE_GAP_AD_TYPE_SHORT_LOCAL_NAME                    0x08
+#define BLE_GAP_AD_TYPE_COMPLETE_LOCAL_NAME                 0x09
+#define BLE_GAP_AD_TYPE_APPEARANCE                          0x19
+#define BLE_GAP_AD_TYPE_MANUFACTURER_SPECIFIC_DATA          0xFF
+
+#define BLE_GAP_ADV_SET_DATA_SIZE_MAX       31
+#define BLE_GAP_ADV_SET_HANDLE_NOT_SET      0xFF
+#define BLE_GAP_ADV_SET_COUNT_DEFAULT       1
+#define BLE_GAP_ADV_TIMEOUT_GENERAL_UNLIMITED 0
+#define BLE_GAP_ADV_TYPE_CONNECTABLE_SCANNABLE_UNDIRECTED 0x01
+#define BLE_GAP_ADV_FP_ANY                  0x00
+
+#define BLE_GAP_EVT_ADV_SET_TERMINATED_REASON_TIMEOUT       0x01
+#define BLE_GAP_EVT_ADV_SET_TERMINATED_REASON_LIMIT_REACHED 0x02
+
+#define BLE_GAP_DEVNAME_DEFAULT             "nRF5x"
+#define BLE_GAP_DEVNAME_MAX_LEN             248
+#define BLE_GAP_ADDR_LEN                    6
+
+#define BLE_GAP_CONN_COUNT_DEFAULT          1
+
+/**@brief GAP connection security modes. */
+typedef struct
+{
+    uint8_t sm : 4;                 /**< Security Mode (1 or 2), 0 for no permissions at all. */
+    uint8_t lv : 4;                 /**< Level (1, 2, 3 or 4), 0 for no permissions at all. */
+} ble_gap_conn_sec_mode_t;
+
+#define BLE_GAP_CONN_SEC_MODE_SET_NO_ACCESS(ptr) do { (ptr)->sm = 0; (ptr)->lv = 0; } while (0)
+#define BLE_GAP_CONN_SEC_MODE_SET_OPEN(ptr)      do { (ptr)->sm = 1; (ptr)->lv = 1; } while (0)
+
+/**@brief Bluetooth Low Energy address. */
+typedef struct
+{
+    uint8_t addr_id_peer : 1;
+    uint8_t addr_type    : 7;
+    uint8_t addr[BLE_GAP_ADDR_LEN];
+} ble_gap_addr_t;
+
+/**@brief GAP connection parameters. */
+typedef struct
+{
+    uint16_t min_conn_interval;     /**< Minimum connection interval (in 1.25 ms units). */
+    uint16_t max_conn_interval;     /**< Maximum connection interval (in 1.25 ms units). */
+    uint16_t slave_latency;         /**< Slave latency (in connection events). */
+    uint16_t conn_sup_timeout;      /**< Connection supervision timeout (in 10 ms units). */
+} ble_gap_conn_params_t;
+
+/**@brief PHYs. */
+typedef struct
+{
+    uint8_t tx_phys;
+    uint8_t rx_phys;
+} ble_gap_phys_t;
+
+/**@brief Data length parameters. */
+typedef struct
+{
+    uint16_t max_tx_octets;
+    uint16_t max_rx_octets;
+    uint16_t max_tx_time_us;
+    uint16_t max_rx_time_us;
+} ble_gap_data_length_params_t;
+
+/**@brief Data length limitation. */
+typedef struct
+{
+    uint16_t tx_payload_limited_octets;
+    uint16_t rx_payload_limited_octets;
+    uint16_t tx_rx_time_limited_us;
+} ble_gap_data_length_limitation_t;
+
+/**@brief Advertising properties. */
+typedef struct
+{
+    uint8_t type;
+    uint8_t anonymous        : 1;
+    uint8_t include_tx_power : 1;
+} ble_gap_adv_properties_t;
+
+/**@brief Advertising parameters. */
+typedef struct
+{
+    ble_gap_adv_properties_t properties;
+    ble_gap_addr_t const    *p_peer_addr;
+    uint32_t                 interval;          /**< Advertising interval (in 0.625 ms units). */
+    uint16_t                 duration;          /**< Advertising duration (in 10 ms units), 0 for no timeout. */
+    uint8_t                  max_adv_evts;
+    uint8_t                  channel_mask[5];
+    uint8_t                  filter_policy;
+    uint8_t                  primary_phy;
+    uint8_t                  secondary_phy;
+    uint8_t                  set_id                : 4;
+    uint8_t                  scan_req_notification : 1;
+} ble_gap_adv_params_t;
+
+/**@brief Advertising and scan response data. */
+typedef struct
+{
+    ble_data_t adv_data;
+    ble_data_t scan_rsp_data;
+} ble_gap_adv_data_t;
+
+typedef struct
+{
+    ble_gap_addr_t        peer_addr;
+    uint8_t               role;
+    ble_gap_conn_params_t conn_params;
+    uint8_t               adv_handle;
+    ble_gap_adv_data_t    adv_data;
+} ble_gap_evt_connected_t;
+
+typedef struct
+{
+    uint8_t reason;
+} ble_gap_evt_disconnected_t;
+
+typedef struct
+{
+    ble_gap_conn_params_t conn_params;
+} ble_gap_evt_conn_param_update_t;
+
+typedef struct
+{
+    ble_gap_phys_t peer_preferred_phys;
+} ble_gap_evt_phy_update_request_t;
+
+typedef struct
+{
+    uint8_t status;
+    uint8_t tx_phy;
+    uint8_t rx_phy;
+} ble_gap_evt_phy_update_t;
+
+typedef struct
+{
+    ble_gap_data_length_params_t peer_params;
+} ble_gap_evt_data_length_update_request_t;
+
+typedef struct
+{
+    ble_gap_data_length_params_t effective_params;
+} ble_gap_evt_data_length_update_t;
+
+typedef struct
+{
+    int8_t  rssi;
+    uint8_t ch_index;
+} ble_gap_evt_rssi_changed_t;
+
+typedef struct
+{
+    uint8_t src;
+} ble_gap_evt_timeout_t;
+
+typedef struct
+{
+    uint8_t            reason;
+    uint8_t            adv_handle;
+    uint8_t            num_completed_adv_events;
+    ble_gap_adv_data_t adv_data;
+} ble_gap_evt_adv_set_terminated_t;
+
+/**@brief GAP event structure. */
+typedef struct
+{
+    uint16_t conn_handle;
+    union
+    {
+        ble_gap_evt_connected_t                  connected;
+        ble_gap_evt_disconnected_t               disconnected;
+        ble_gap_evt_conn_param_update_t          conn_param_update;
+        ble_gap_evt_timeout_t                    timeout;
+        ble_gap_evt_rssi_changed_t               rssi_changed;
+        ble_gap_evt_phy_update_request_t         phy_update_request;
+        ble_gap_evt_phy_update_t                 phy_update;
+        ble_gap_evt_data_length_update_request_t data_length_update_request;
+        ble_gap_evt_data_length_update_t         data_length_update;
+        ble_gap_evt_adv_set_terminated_t         adv_set_terminated;
+    } params;
+} ble_gap_evt_t;
+
+/**@brief GAP connection configuration. */
+typedef struct
+{
+    uint8_t  conn_count;
+    uint16_t event_length;          /**< Time reserved for a connection event (in 1.25 ms units). */
+} ble_gap_conn_cfg_t;
+
+/**@brief Connection event extension option. */
+typedef struct
+{
+    uint8_t enable : 1;
+} ble_common_opt_conn_evt_ext_t;
+
+uint32_t sd_ble_gap_adv_set_configure(uint8_t *p_adv_handle, ble_gap_adv_data_t const *p_adv_data,
+                                      ble_gap_adv_params_t const *p_adv_params);
+uint32_t sd_ble_gap_adv_start(uint8_t adv_handle, uint8_t conn_cfg_tag);
+uint32_t sd_ble_gap_adv_stop(uint8_t adv_handle);
+uint32_t sd_ble_gap_conn_param_update(uint16_t conn_handle, ble_gap_conn_params_t const *p_conn_params);
+uint32_t sd_ble_gap_disconnect(uint16_t conn_handle, uint8_t hci_status_code);
+uint32_t sd_ble_gap_device_name_set(ble_gap_conn_sec_mode_t const *p_write_perm, uint8_t const *p_dev_name, uint16_t len);
+uint32_t sd_ble_gap_device_name_get(uint8_t *p_dev_name, uint16_t *p_len);
+uint32_t sd_ble_gap_appearance_set(uint16_t appearance);
+uint32_t sd_ble_gap_appearance_get(uint16_t *p_appearance);
+uint32_t sd_ble_gap_ppcp_set(ble_gap_conn_params_t const *p_conn_params);
+uint32_t sd_ble_gap_ppcp_get(ble_gap_conn_params_t *p_conn_params);
+uint32_t sd_ble_gap_phy_update(uint16_t conn_handle, ble_gap_phys_t const *p_gap_phys);
+uint32_t sd_ble_gap_data_length_update(uint16_t conn_handle, ble_gap_data_length_params_t const *p_dl_params,
+                                       ble_gap_data_length_limitation_t *p_dl_limitation);
+uint32_t sd_ble_gap_rssi_start(uint16_t conn_handle, uint8_t threshold_dbm, uint8_t skip_count);
+uint32_t sd_ble_gap_rssi_stop(uint16_t conn_handle);
+
+#endif /* BLE_GAP_H__ */
@@ -0,0 +1,105 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#ifndef BLE_GATT_H__
+#define BLE_GATT_H__
+
+#include <stdint.h>
+
+#include "ble_types.h"
+#include "ble_err.h"
+
+#define BLE_GATT_ATT_MTU_DEFAULT            23
+#define BLE_GATT_HANDLE_INVALID             0x0000
+#define BLE_GATT_HANDLE_START               0x0001
+#define BLE_GATT_HANDLE_END                 0xFFFF
+
+#define BLE_GATT_TIMEOUT_SRC_PROTOCOL       0x00
+
+#define BLE_GATT_OP_INVALID                 0x00
+#define BLE_GATT_OP_WRITE_REQ               0x01
+#define BLE_GATT_OP_WRITE_CMD               0x02
+#define BLE_GATT_OP_SIGN_WRITE_CMD          0x03
+#define BLE_GATT_OP_PREP_WRITE_REQ          0x04
+#define BLE_GATT_OP_EXEC_WRITE_REQ          0x05
+
+#define BLE_GATT_HVX_INVALID                0x00
+#define BLE_GATT_HVX_NOTIFICATION           0x01
+#define BLE_GATT_HVX_INDICATION             0x02
+
+#define BLE_GATT_STATUS_SUCCESS                         0x0000
+#define BLE_GATT_STATUS_UNKNOWN                         0x0001
+#define BLE_GATT_STATUS_ATTERR_INVALID                  0x0100
+#define BLE_GATT_STATUS_ATTERR_INVALID_HANDLE           0x0101
+#define BLE_GATT_STATUS_ATTERR_READ_NOT_PERMITTED       0x0102
+#define BLE_GATT_STATUS_ATTERR_WRITE_NOT_PERMITTED      0x0103
+#define BLE_GATT_STATUS_ATTERR_INVALID_PDU              0x0104
+#define BLE_GATT_STATUS_ATTERR_INSUF_AUTHENTICATION     0x0105
+#define BLE_GATT_STATUS_ATTERR_REQUEST_NOT_SUPPORTED    0x0106
+#define BLE_GATT_STATUS_ATTERR_INVALID_OFFSET           0x0107
+#define BLE_GATT_STATUS_ATTERR_INSUF_AUTHORIZATION      0x0108
+#define BLE_GATT_STATUS_ATTERR_PREPARE_QUEUE_FULL       0x0109
+#define BLE_GATT_STATUS_ATTERR_ATTRIBUTE_NOT_FOUND      0x010A
+#define BLE_GATT_STATUS_ATTERR_ATTRIBUTE_NOT_LONG       0x010B
+#define BLE_GATT_STATUS_ATTERR_INSUF_ENC_KEY_SIZE       0x010C
+#define BLE_GATT_STATUS_ATTERR_INVALID_ATT_VAL_LENGTH   0x010D
+#define BLE_GATT_STATUS_ATTERR_UNLIKELY_ERROR           0x010E
+#define BLE_GATT_STATUS_ATTERR_INSUF_ENCRYPTION         0x010F
+#define BLE_GATT_STATUS_ATTERR_UNSUPPORTED_GROUP_TYPE   0x0110
+#define BLE_GATT_STATUS_ATTERR_INSUF_RESOURCES          0x0111
+#define BLE_GATT_STATUS_ATTERR_APP_BEGIN                0x0180
+#define BLE_GATT_STATUS_ATTERR_APP_END                  0x019F
+
+/**@brief GATT Characteristic Properties. */
+typedef struct
+{
+    uint8_t broadcast     : 1;
+    uint8_t read          : 1;
+    uint8_t write_wo_resp : 1;
+    uint8_t write         : 1;
+    uint8_t notify        : 1;
+    uint8_t indicate      : 1;
+    uint8_t auth_signed_wr : 1;
+} ble_gatt_char_props_t;
+
+/**@brief GATT Characteristic Extended Properties. */
+typedef struct
+{
+    uint8_t reliable_wr : 1;
+    uint8_t wr_aux      : 1;
+} ble_gatt_char_ext_props_t;
+
+/**@brief GATT connection configuration. */
+typedef struct
+{
+    uint16_t att_mtu;
+} ble_gatt_conn_cfg_t;
+
+#endif /* BLE_GATT_H__ */
@@ -0,0 +1,80 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#ifndef BLE_GATTC_H__
+#define BLE_GATTC_H__
+
+#include <stdint.h>
+
+#include "ble_gatt.h"
+
+enum BLE_GATTC_EVTS
+{
+    BLE_GATTC_EVT_PRIM_SRVC_DISC_RSP    = 0x30,
+    BLE_GATTC_EVT_REL_DISC_RSP          = 0x31,
+    BLE_GATTC_EVT_CHAR_DISC_RSP         = 0x32,
+    BLE_GATTC_EVT_DESC_DISC_RSP         = 0x33,
+    BLE_GATTC_EVT_ATTR_INFO_DISC_RSP    = 0x34,
+    BLE_GATTC_EVT_CHAR_VAL_BY_UUID_READ_RSP = 0x35,
+    BLE_GATTC_EVT_READ_RSP              = 0x36,
+    BLE_GATTC_EVT_CHAR_VALS_READ_RSP    = 0x37,
+    BLE_GATTC_EVT_WRITE_RSP             = 0x38,
+    BLE_GATTC_EVT_HVX                   = 0x39,
+    BLE_GATTC_EVT_EXCHANGE_MTU_RSP      = 0x3A,
+    BLE_GATTC_EVT_TIMEOUT               = 0x3B,
+    BLE_GATTC_EVT_WRITE_CMD_TX_COMPLETE = 0x3C,
+};
+
+typedef struct
+{
+    uint16_t server_rx_mtu;
+} ble_gattc_evt_exchange_mtu_rsp_t;
+
+typedef struct
+{
+    uint8_t src;
+} ble_gattc_evt_timeout_t;
+
+/**@brief GATTC event structure. */
+typedef struct
+{
+    uint16_t conn_handle;
+    uint16_t gatt_status;
+    uint16_t error_handle;
+    union
+    {
+        ble_gattc_evt_exchange_mtu_rsp_t exchange_mtu_rsp;
+        ble_gattc_evt_timeout_t          timeout;
+    } params;
+} ble_gattc_evt_t;
+
+uint32_t sd_ble_gattc_exchange_mtu_request(uint16_t conn_handle, uint16_t client_rx_mtu);
+
+#endif /* BLE_GATTC_H__ */
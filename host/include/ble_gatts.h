@@ -0,0 +1,289 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#ifndef BLE_GATTS_H__
+#define BLE_GATTS_H__
+
+#include <stdint.h>
+
+#include "ble_types.h"
+#include "ble_err.h"
+#include "ble_gatt.h"
+#include "ble_gap.h"
+
+#define BLE_ERROR_GATTS_INVALID_ATTR_TYPE   (NRF_GATTS_ERR_BASE + 0x000)
+#define BLE_ERROR_GATTS_SYS_ATTR_MISSING    (NRF_GATTS_ERR_BASE + 0x001)
+
+#define BLE_GATTS_FIX_ATTR_LEN_MAX          510
+#define BLE_GATTS_VAR_ATTR_LEN_MAX          512
+
+#define BLE_GATTS_SRVC_TYPE_INVALID         0x00
+#define BLE_GATTS_SRVC_TYPE_PRIMARY         0x01
+#define BLE_GATTS_SRVC_TYPE_SECONDARY       0x02
+
+#define BLE_GATTS_ATTR_TYPE_INVALID         0x00
+
+#define BLE_GATTS_OP_INVALID                0x00
+#define BLE_GATTS_OP_WRITE_REQ              0x01
+#define BLE_GATTS_OP_WRITE_CMD              0x02
+#define BLE_GATTS_OP_SIGN_WRITE_CMD         0x03
+#define BLE_GATTS_OP_PREP_WRITE_REQ         0x04
+#define BLE_GATTS_OP_EXEC_WRITE_REQ_CANCEL  0x05
+#define BLE_GATTS_OP_EXEC_WRITE_REQ_NOW     0x06
+
+#define BLE_GATTS_VLOC_INVALID              0x00
+#define BLE_GATTS_VLOC_STACK                0x01
+#define BLE_GATTS_VLOC_USER                 0x02
+
+#define BLE_GATTS_AUTHORIZE_TYPE_INVALID    0x00
+#define BLE_GATTS_AUTHORIZE_TYPE_READ       0x01
+#define BLE_GATTS_AUTHORIZE_TYPE_WRITE      0x02
+
+#define BLE_GATTS_SYS_ATTR_FLAG_SYS_SRVCS   (1 << 0)
+#define BLE_GATTS_SYS_ATTR_FLAG_USR_SRVCS   (1 << 1)
+
+#define BLE_GATTS_HVN_TX_QUEUE_SIZE_DEFAULT 1
+
+#define BLE_GATTS_ATTR_TAB_SIZE_MIN         248
+#define BLE_GATTS_ATTR_TAB_SIZE_DEFAULT     1408
+
+enum BLE_GATTS_CFGS
+{
+    BLE_GATTS_CFG_SERVICE_CHANGED       = 0xA0,
+    BLE_GATTS_CFG_ATTR_TAB_SIZE         = 0xA1,
+};
+
+enum BLE_GATTS_EVTS
+{
+    BLE_GATTS_EVT_WRITE                 = 0x50,
+    BLE_GATTS_EVT_RW_AUTHORIZE_REQUEST  = 0x51,
+    BLE_GATTS_EVT_SYS_ATTR_MISSING      = 0x52,
+    BLE_GATTS_EVT_HVC                   = 0x53,
+    BLE_GATTS_EVT_SC_CONFIRM            = 0x54,
+    BLE_GATTS_EVT_EXCHANGE_MTU_REQUEST  = 0x55,
+    BLE_GATTS_EVT_TIMEOUT               = 0x56,
+    BLE_GATTS_EVT_HVN_TX_COMPLETE       = 0x57,
+};
+
+/**@brief Attribute metadata. */
+typedef struct
+{
+    ble_gap_conn_sec_mode_t read_perm;
+    ble_gap_conn_sec_mode_t write_perm;
+    uint8_t                 vlen    : 1;    /**< Variable length attribute. */
+    uint8_t                 vloc    : 2;    /**< Value location, BLE_GATTS_VLOC_STACK or BLE_GATTS_VLOC_USER. */
+    uint8_t                 rd_auth : 1;    /**< Read authorization and value will be requested from the application. */
+    uint8_t                 wr_auth : 1;    /**< Write authorization will be requested from the application. */
+} ble_gatts_attr_md_t;
+
+/**@brief GATT Attribute. */
+typedef struct
+{
+    ble_uuid_t const          *p_uuid;
+    ble_gatts_attr_md_t const *p_attr_md;
+    uint16_t                   init_len;
+    uint16_t                   init_offs;
+    uint16_t                   max_len;
+    uint8_t                   *p_value;
+} ble_gatts_attr_t;
+
+/**@brief GATT Attribute Value. */
+typedef struct
+{
+    uint16_t len;
+    uint16_t offset;
+    uint8_t *p_value;
+} ble_gatts_value_t;
+
+/**@brief GATT Characteristic Presentation Format. */
+typedef struct
+{
+    uint8_t  format;
+    int8_t   exponent;
+    uint16_t unit;
+    uint8_t  name_space;
+    uint16_t desc;
+} ble_gatts_char_pf_t;
+
+/**@brief GATT Characteristic metadata. */
+typedef struct
+{
+    ble_gatt_char_props_t      char_props;
+    ble_gatt_char_ext_props_t  char_ext_props;
+    uint8_t const             *p_char_user_desc;
+    uint16_t                   char_user_desc_max_size;
+    uint16_t                   char_user_desc_size;
+    ble_gatts_char_pf_t const *p_char_pf;
+    ble_gatts_attr_md_t const *p_user_desc_md;
+    ble_gatts_attr_md_t const *p_cccd_md;
+    ble_gatts_attr_md_t const *p_sccd_md;
+} ble_gatts_char_md_t;
+
+/**@brief GATT Characteristic Definition Handles. */
+typedef struct
+{
+    uint16_t value_handle;
+    uint16_t user_desc_handle;
+    uint16_t cccd_handle;
+    uint16_t sccd_handle;
+} ble_gatts_char_handles_t;
+
+/**@brief GATT HVx parameters. */
+typedef struct
+{
+    uint16_t       handle;
+    uint8_t        type;
+    uint16_t       offset;
+    uint16_t      *p_len;
+    uint8_t const *p_data;              /**< NULL to send the current value of the attribute. */
+} ble_gatts_hvx_params_t;
+
+/**@brief GATT Authorization parameters. */
+typedef struct
+{
+    uint16_t       gatt_status;
+    uint8_t        update : 1;
+    uint16_t       offset;
+    uint16_t       len;
+    uint8_t const *p_data;
+} ble_gatts_authorize_params_t;
+
+/**@brief GATT Read or Write Authorize Reply parameters. */
+typedef struct
+{
+    uint8_t type;
+    union
+    {
+        ble_gatts_authorize_params_t read;
+        ble_gatts_authorize_params_t write;
+    } params;
+} ble_gatts_rw_authorize_reply_params_t;
+
+/**@brief Attribute table size configuration, a multiple of 4. */
+typedef struct
+{
+    uint32_t attr_tab_size;
+} ble_gatts_cfg_attr_tab_size_t;
+
+/**@brief GATTS configuration. */
+typedef union
+{
+    ble_gatts_cfg_attr_tab_size_t attr_tab_size;
+} ble_gatts_cfg_t;
+
+/**@brief GATTS connection configuration. */
+typedef struct
+{
+    uint8_t hvn_tx_queue_size;
+} ble_gatts_conn_cfg_t;
+
+/**@brief Event structure for BLE_GATTS_EVT_WRITE. */
+typedef struct
+{
+    uint16_t   handle;
+    ble_uuid_t uuid;
+    uint8_t    op;
+    uint8_t    auth_required;
+    uint16_t   offset;
+    uint16_t   len;
+    uint8_t    data[1];                 /**< Variable length, the event buffer holds the rest. */
+} ble_gatts_evt_write_t;
+
+/**@brief Event substructure for authorized read requests. */
+typedef struct
+{
+    uint16_t   handle;
+    ble_uuid_t uuid;
+    uint16_t   offset;
+} ble_gatts_evt_read_t;
+
+/**@brief Event structure for BLE_GATTS_EVT_RW_AUTHORIZE_REQUEST. */
+typedef struct
+{
+    uint8_t type;
+    union
+    {
+        ble_gatts_evt_read_t  read;
+        ble_gatts_evt_write_t write;
+    } request;
+} ble_gatts_evt_rw_authorize_request_t;
+
+typedef struct
+{
+    uint8_t hint;
+} ble_gatts_evt_sys_attr_missing_t;
+
+typedef struct
+{
+    uint16_t handle;
+} ble_gatts_evt_hvc_t;
+
+typedef struct
+{
+    uint16_t client_rx_mtu;
+} ble_gatts_evt_exchange_mtu_request_t;
+
+typedef struct
+{
+    uint8_t src;
+} ble_gatts_evt_timeout_t;
+
+typedef struct
+{
+    uint8_t count;
+} ble_gatts_evt_hvn_tx_complete_t;
+
+/**@brief GATTS event structure. */
+typedef struct
+{
+    uint16_t conn_handle;
+    union
+    {
+        ble_gatts_evt_write_t                write;
+        ble_gatts_evt_rw_authorize_request_t authorize_request;
+        ble_gatts_evt_sys_attr_missing_t     sys_attr_missing;
+        ble_gatts_evt_hvc_t                  hvc;
+        ble_gatts_evt_exchange_mtu_request_t exchange_mtu_request;
+        ble_gatts_evt_timeout_t              timeout;
+        ble_gatts_evt_hvn_tx_complete_t      hvn_tx_complete;
+    } params;
+} ble_gatts_evt_t;
+
+uint32_t sd_ble_gatts_service_add(uint8_t type, ble_uuid_t const *p_uuid, uint16_t *p_handle);
+uint32_t sd_ble_gatts_characteristic_add(uint16_t service_handle, ble_gatts_char_md_t const *p_char_md,
+                                         ble_gatts_attr_t const *p_attr_char_value, ble_gatts_char_handles_t *p_handles);
+uint32_t sd_ble_gatts_value_set(uint16_t conn_handle, uint16_t handle, ble_gatts_value_t *p_value);
+uint32_t sd_ble_gatts_value_get(uint16_t conn_handle, uint16_t handle, ble_gatts_value_t *p_value);
+uint32_t sd_ble_gatts_hvx(uint16_t conn_handle, ble_gatts_hvx_params_t const *p_hvx_params);
+uint32_t sd_ble_gatts_rw_authorize_reply(uint16_t conn_handle, ble_gatts_rw_authorize_reply_params_t const *p_rw_authorize_reply_params);
+uint32_t sd_ble_gatts_sys_attr_set(uint16_t conn_handle, uint8_t const *p_sys_attr_data, uint16_t len, uint32_t flags);
+uint32_t sd_ble_gatts_exchange_mtu_reply(uint16_t conn_handle, uint16_t server_rx_mtu);
+
+#endif /* BLE_GATTS_H__ */
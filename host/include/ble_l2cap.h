@@ -0,0 +1,167 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#ifndef BLE_L2CAP_H__
+#define BLE_L2CAP_H__
+
+#include <stdint.h>
+
+#include "ble_types.h"
+#include "ble_err.h"
+
+#define BLE_L2CAP_CH_COUNT_MAX              64
+#define BLE_L2CAP_MTU_MIN                   23
+#define BLE_L2CAP_MPS_MIN                   23
+#define BLE_L2CAP_CID_INVALID               0x0000
+#define BLE_L2CAP_CREDITS_DEFAULT           1
+
+#define BLE_L2CAP_CH_SETUP_REFUSED_SRC_LOCAL    0x01
+#define BLE_L2CAP_CH_SETUP_REFUSED_SRC_REMOTE   0x02
+
+#define BLE_L2CAP_CH_STATUS_CODE_SUCCESS                0x0000
+#define BLE_L2CAP_CH_STATUS_CODE_LE_PSM_NOT_SUPPORTED   0x0002
+#define BLE_L2CAP_CH_STATUS_CODE_NO_RESOURCES           0x0004
+#define BLE_L2CAP_CH_STATUS_CODE_INSUFF_AUTHENTICATION  0x0005
+#define BLE_L2CAP_CH_STATUS_CODE_INSUFF_AUTHORIZATION   0x0006
+#define BLE_L2CAP_CH_STATUS_CODE_INSUFF_ENC_KEY_SIZE    0x0007
+#define BLE_L2CAP_CH_STATUS_CODE_INSUFF_ENC             0x0008
+#define BLE_L2CAP_CH_STATUS_CODE_INVALID_SCID           0x0009
+#define BLE_L2CAP_CH_STATUS_CODE_SCID_ALLOCATED         0x000A
+#define BLE_L2CAP_CH_STATUS_CODE_UNACCEPTABLE_PARAMS    0x000B
+
+enum BLE_L2CAP_EVTS
+{
+    BLE_L2CAP_EVT_CH_SETUP_REQUEST      = 0x70,
+    BLE_L2CAP_EVT_CH_SETUP_REFUSED      = 0x71,
+    BLE_L2CAP_EVT_CH_SETUP              = 0x72,
+    BLE_L2CAP_EVT_CH_RELEASED           = 0x73,
+    BLE_L2CAP_EVT_CH_SDU_BUF_RELEASED   = 0x74,
+    BLE_L2CAP_EVT_CH_CREDIT             = 0x75,
+    BLE_L2CAP_EVT_CH_RX                 = 0x76,
+    BLE_L2CAP_EVT_CH_TX                 = 0x77,
+};
+
+/**@brief L2CAP connection configuration. */
+typedef struct
+{
+    uint16_t rx_mps;
+    uint16_t tx_mps;
+    uint8_t  rx_queue_size;
+    uint8_t  tx_queue_size;
+    uint8_t  ch_count;
+} ble_l2cap_conn_cfg_t;
+
+/**@brief L2CAP channel RX parameters. */
+typedef struct
+{
+    uint16_t   rx_mtu;
+    uint16_t   rx_mps;
+    ble_data_t sdu_buf;
+} ble_l2cap_ch_rx_params_t;
+
+/**@brief L2CAP channel setup parameters. */
+typedef struct
+{
+    ble_l2cap_ch_rx_params_t rx_params;
+    uint16_t                 le_psm;
+    uint16_t                 status;
+} ble_l2cap_ch_setup_params_t;
+
+/**@brief L2CAP channel TX parameters. */
+typedef struct
+{
+    uint16_t tx_mtu;
+    uint16_t peer_mps;
+    uint16_t tx_mps;
+    uint16_t credits;
+} ble_l2cap_ch_tx_params_t;
+
+typedef struct
+{
+    ble_l2cap_ch_tx_params_t tx_params;
+    uint16_t                 le_psm;
+} ble_l2cap_evt_ch_setup_request_t;
+
+typedef struct
+{
+    uint8_t  source;
+    uint16_t status;
+} ble_l2cap_evt_ch_setup_refused_t;
+
+typedef struct
+{
+    ble_l2cap_ch_tx_params_t tx_params;
+} ble_l2cap_evt_ch_setup_t;
+
+typedef struct
+{
+    ble_data_t sdu_buf;
+} ble_l2cap_evt_ch_sdu_buf_released_t;
+
+typedef struct
+{
+    uint16_t credits;
+} ble_l2cap_evt_ch_credit_t;
+
+typedef struct
+{
+    uint16_t   sdu_len;
+    ble_data_t sdu_buf;
+} ble_l2cap_evt_ch_rx_t;
+
+typedef struct
+{
+    ble_data_t sdu_buf;
+} ble_l2cap_evt_ch_tx_t;
+
+/**@brief L2CAP event structure. */
+typedef struct
+{
+    uint16_t conn_handle;
+    uint16_t local_cid;
+    union
+    {
+        ble_l2cap_evt_ch_setup_request_t    ch_setup_request;
+        ble_l2cap_evt_ch_setup_refused_t    ch_setup_refused;
+        ble_l2cap_evt_ch_setup_t            ch_setup;
+        ble_l2cap_evt_ch_sdu_buf_released_t ch_sdu_buf_released;
+        ble_l2cap_evt_ch_credit_t           credit;
+        ble_l2cap_evt_ch_rx_t               rx;
+        ble_l2cap_evt_ch_tx_t               tx;
+    } params;
+} ble_l2cap_evt_t;
+
+uint32_t sd_ble_l2cap_ch_setup(uint16_t conn_handle, uint16_t *p_local_cid, ble_l2cap_ch_setup_params_t const *p_params);
+uint32_t sd_ble_l2cap_ch_release(uint16_t conn_handle, uint16_t local_cid);
+uint32_t sd_ble_l2cap_ch_rx(uint16_t conn_handle, uint16_t local_cid, ble_data_t const *p_sdu_buf);
+uint32_t sd_ble_l2cap_ch_tx(uint16_t conn_handle, uint16_t local_cid, ble_data_t const *p_sdu_buf);
+uint32_t sd_ble_l2cap_ch_flow_control(uint16_t conn_handle, uint16_t local_cid, uint16_t credits, uint16_t *p_credits);
+
+#endif /* BLE_L2CAP_H__ */
@@ -0,0 +1,75 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#ifndef BLE_TYPES_H__
+#define BLE_TYPES_H__
+
+#include <stdint.h>
+
+#define BLE_CONN_HANDLE_INVALID             0xFFFF
+#define BLE_CONN_HANDLE_ALL                 0xFFFE
+
+#define BLE_UUID_UNKNOWN                    0x0000
+#define BLE_UUID_GATT                       0x1801
+#define BLE_UUID_GAP                        0x1800
+#define BLE_UUID_DEVICE_INFORMATION_SERVICE 0x180A
+
+#define BLE_UUID_SERVICE_PRIMARY            0x2800
+#define BLE_UUID_CHARACTERISTIC             0x2803
+#define BLE_UUID_DESCRIPTOR_CHAR_USER_DESC  0x2901
+#define BLE_UUID_DESCRIPTOR_CLIENT_CHAR_CONFIG 0x2902
+
+#define BLE_UUID_TYPE_UNKNOWN               0x00
+#define BLE_UUID_TYPE_BLE                   0x01
+#define BLE_UUID_TYPE_VENDOR_BEGIN          0x02
+
+#define BLE_APPEARANCE_UNKNOWN              0
+
+/**@brief 128-bit UUID value, little-endian. */
+typedef struct
+{
+    uint8_t uuid128[16];
+} ble_uuid128_t;
+
+/**@brief Bluetooth Low Energy UUID type, 16-bit UUID or an offset into a vendor specific base. */
+typedef struct
+{
+    uint16_t uuid;
+    uint8_t  type;
+} ble_uuid_t;
+
+/**@brief Data structure. */
+typedef struct
+{
+    uint8_t  *p_data;
+    uint16_t len;
+} ble_data_t;
+
+#endif /* BLE_TYPES_H__ */
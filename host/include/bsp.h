@@ -0,0 +1,101 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#ifndef BSP_H__
+#define BSP_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "sdk_errors.h"
+
+#define BSP_INIT_NONE       0
+#define BSP_INIT_LEDS       (1 << 0)
+#define BSP_INIT_BUTTONS    (1 << 1)
+
+/**@brief BSP indication states. */
+typedef enum
+{
+    BSP_INDICATE_FIRST = 0,
+    BSP_INDICATE_IDLE  = BSP_INDICATE_FIRST,
+    BSP_INDICATE_SCANNING,
+    BSP_INDICATE_ADVERTISING,
+    BSP_INDICATE_ADVERTISING_WHITELIST,
+    BSP_INDICATE_ADVERTISING_SLOW,
+    BSP_INDICATE_ADVERTISING_DIRECTED,
+    BSP_INDICATE_BONDING,
+    BSP_INDICATE_CONNECTED,
+    BSP_INDICATE_SENT_OK,
+    BSP_INDICATE_SEND_ERROR,
+    BSP_INDICATE_RCV_OK,
+    BSP_INDICATE_RCV_ERROR,
+    BSP_INDICATE_FATAL_ERROR,
+    BSP_INDICATE_ALERT_0,
+    BSP_INDICATE_ALERT_1,
+    BSP_INDICATE_ALERT_2,
+    BSP_INDICATE_ALERT_3,
+    BSP_INDICATE_ALERT_OFF,
+    BSP_INDICATE_USER_STATE_OFF,
+    BSP_INDICATE_USER_STATE_0,
+    BSP_INDICATE_USER_STATE_1,
+    BSP_INDICATE_USER_STATE_2,
+    BSP_INDICATE_USER_STATE_3,
+    BSP_INDICATE_USER_STATE_ON
+} bsp_indication_t;
+
+/**@brief BSP events. */
+typedef enum
+{
+    BSP_EVENT_NOTHING = 0,
+    BSP_EVENT_DEFAULT,
+    BSP_EVENT_CLEAR_BONDING_DATA,
+    BSP_EVENT_CLEAR_ALERT,
+    BSP_EVENT_DISCONNECT,
+    BSP_EVENT_ADVERTISING_START,
+    BSP_EVENT_ADVERTISING_STOP,
+    BSP_EVENT_WHITELIST_OFF,
+    BSP_EVENT_BOND,
+    BSP_EVENT_RESET,
+    BSP_EVENT_SLEEP,
+    BSP_EVENT_WAKEUP,
+    BSP_EVENT_SYSOFF,
+    BSP_EVENT_DFU,
+    BSP_EVENT_KEY_0,
+    BSP_EVENT_KEY_1,
+    BSP_EVENT_KEY_2,
+    BSP_EVENT_KEY_3,
+} bsp_event_t;
+
+typedef void (*bsp_event_callback_t)(bsp_event_t);
+
+uint32_t bsp_init(uint32_t type, bsp_event_callback_t callback);
+uint32_t bsp_indication_set(bsp_indication_t indicate);
+
+#endif /* BSP_H__ */
@@ -0,0 +1,58 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#ifndef NRF_ASSERT_H__
+#define NRF_ASSERT_H__
+
+#include <stdint.h>
+
+/* Host build: assertions are always checked */
+#define NRF_ASSERT_PRESENT 1
+
+/**@brief Function called when an assertion fails.
+ *
+ * @details Every application defines it, the host library has a weak default for tests that
+ *          link modules without an application.
+ */
+void assert_nrf_callback(uint16_t line_num, const uint8_t *file_name);
+
+#define ASSERT(expr)                                                                    \
+if (NRF_ASSERT_PRESENT)                                                                 \
+{                                                                                       \
+    if (expr)                                                                           \
+    {                                                                                   \
+    }                                                                                   \
+    else                                                                                \
+    {                                                                                   \
+        assert_nrf_callback((uint16_t)__LINE__, (uint8_t *)__FILE__);                   \
+    }                                                                                   \
+}
+
+#endif /* NRF_ASSERT_H__ */
@@ -0,0 +1,65 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#ifndef NRF_ATFIFO_H__
+#define NRF_ATFIFO_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "app_util.h"
+#include "sdk_errors.h"
+
+/**@brief Atomic FIFO instance. */
+typedef struct
+{
+    void    *p_buf;
+    uint16_t buf_size;
+    uint16_t item_size;
+    uint16_t head;                  /**< Index of the oldest item. */
+    uint16_t tail;                  /**< Index where the next item is put. */
+} nrf_atfifo_t;
+
+#define NRF_ATFIFO_DEF(fifo_id, storage_type, item_cnt)                                     \
+    static storage_type CONCAT_2(fifo_id, _data)[(item_cnt) + 1];                           \
+    static nrf_atfifo_t CONCAT_2(fifo_id, _inst);                                           \
+    static nrf_atfifo_t * const fifo_id = &CONCAT_2(fifo_id, _inst)
+
+#define NRF_ATFIFO_INIT(fifo_id)                                                            \
+    nrf_atfifo_init(fifo_id, CONCAT_2(fifo_id, _data), sizeof(CONCAT_2(fifo_id, _data)),    \
+                    sizeof(CONCAT_2(fifo_id, _data)[0]))
+
+ret_code_t nrf_atfifo_init(nrf_atfifo_t *const p_fifo, void *p_buf, uint16_t buf_size, uint16_t item_size);
+ret_code_t nrf_atfifo_clear(nrf_atfifo_t *const p_fifo);
+ret_code_t nrf_atfifo_alloc_put(nrf_atfifo_t *const p_fifo, void const *p_var, size_t size, bool *const p_visible);
+ret_code_t nrf_atfifo_get_free(nrf_atfifo_t *const p_fifo, void *const p_var, size_t size, bool *const p_released);
+
+#endif /* NRF_ATFIFO_H__ */
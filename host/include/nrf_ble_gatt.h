@@ -0,0 +1,104 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#ifndef NRF_BLE_GATT_H__
+#define NRF_BLE_GATT_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ble.h"
+#include "nrf_sdh_ble.h"
+#include "sdk_config.h"
+#include "sdk_errors.h"
+
+#ifndef NRF_BLE_GATT_BLE_OBSERVER_PRIO
+#define NRF_BLE_GATT_BLE_OBSERVER_PRIO 1
+#endif
+
+#define NRF_BLE_GATT_LINK_COUNT (NRF_SDH_BLE_PERIPHERAL_LINK_COUNT + NRF_SDH_BLE_CENTRAL_LINK_COUNT)
+
+#define NRF_BLE_GATT_DEF(_name)                                                                     \
+static nrf_ble_gatt_t _name;                                                                        \
+NRF_SDH_BLE_OBSERVER(_name ## _obs,                                                                 \
+                     NRF_BLE_GATT_BLE_OBSERVER_PRIO,                                                \
+                     nrf_ble_gatt_on_ble_evt, &_name)
+
+/**@brief GATT module event types. */
+typedef enum
+{
+    NRF_BLE_GATT_EVT_ATT_MTU_UPDATED     = 0xA77,
+    NRF_BLE_GATT_EVT_DATA_LENGTH_UPDATED = 0xDA7A,
+} nrf_ble_gatt_evt_id_t;
+
+/**@brief GATT module event. */
+typedef struct
+{
+    nrf_ble_gatt_evt_id_t evt_id;
+    uint16_t              conn_handle;
+    union
+    {
+        uint16_t att_mtu_effective;
+        uint8_t  data_length;
+    } params;
+} nrf_ble_gatt_evt_t;
+
+typedef struct nrf_ble_gatt_s nrf_ble_gatt_t;
+
+typedef void (*nrf_ble_gatt_evt_handler_t)(nrf_ble_gatt_t *p_gatt, nrf_ble_gatt_evt_t const *p_evt);
+
+/**@brief GATT state of one link. */
+typedef struct
+{
+    uint16_t att_mtu_desired;
+    uint16_t att_mtu_effective;
+    bool     att_mtu_exchange_pending;
+    bool     att_mtu_exchange_requested;
+    uint8_t  data_length_desired;
+    uint8_t  data_length_effective;
+} nrf_ble_gatt_link_t;
+
+/**@brief GATT module instance. */
+struct nrf_ble_gatt_s
+{
+    uint16_t                   att_mtu_desired_periph;
+    uint16_t                   att_mtu_desired_central;
+    uint8_t                    data_length;
+    nrf_ble_gatt_link_t        links[NRF_BLE_GATT_LINK_COUNT];
+    nrf_ble_gatt_evt_handler_t evt_handler;
+};
+
+ret_code_t nrf_ble_gatt_init(nrf_ble_gatt_t *p_gatt, nrf_ble_gatt_evt_handler_t evt_handler);
+ret_code_t nrf_ble_gatt_att_max_mtu_set(nrf_ble_gatt_t *p_gatt, uint16_t desired_mtu);
+ret_code_t nrf_ble_gatt_data_length_set(nrf_ble_gatt_t *p_gatt, uint16_t conn_handle, uint8_t data_length);
+uint16_t nrf_ble_gatt_eff_mtu_get(nrf_ble_gatt_t const *p_gatt, uint16_t conn_handle);
+void nrf_ble_gatt_on_ble_evt(ble_evt_t const *p_ble_evt, void *p_context);
+
+#endif /* NRF_BLE_GATT_H__ */
@@ -0,0 +1,118 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#ifndef NRF_BLE_QWR_H__
+#define NRF_BLE_QWR_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ble.h"
+#include "ble_srv_common.h"
+#include "nrf_sdh_ble.h"
+#include "sdk_config.h"
+#include "sdk_errors.h"
+
+#ifndef NRF_BLE_QWR_BLE_OBSERVER_PRIO
+#define NRF_BLE_QWR_BLE_OBSERVER_PRIO 2
+#endif
+
+#define NRF_BLE_QWR_REJ_REQUEST_ERR_CODE BLE_GATT_STATUS_ATTERR_APP_BEGIN + 0
+
+#define NRF_BLE_QWR_DEF(_name)                                                                      \
+static nrf_ble_qwr_t _name;                                                                         \
+NRF_SDH_BLE_OBSERVER(_name ## _obs,                                                                 \
+                     NRF_BLE_QWR_BLE_OBSERVER_PRIO,                                                 \
+                     nrf_ble_qwr_on_ble_evt,                                                        \
+                     &_name)
+
+#define NRF_BLE_QWRS_DEF(_name, _cnt)                                                               \
+static nrf_ble_qwr_t _name[_cnt];                                                                   \
+NRF_SDH_BLE_OBSERVERS(_name ## _obs,                                                                \
+                      NRF_BLE_QWR_BLE_OBSERVER_PRIO,                                                \
+                      nrf_ble_qwr_on_ble_evt,                                                       \
+                      &_name,                                                                       \
+                      _cnt)
+
+/**@brief Queued Writes module event types. */
+typedef enum
+{
+    NRF_BLE_QWR_EVT_EXECUTE_WRITE,
+    NRF_BLE_QWR_EVT_AUTH_REQUEST,
+} nrf_ble_qwr_evt_type_t;
+
+/**@brief Queued Writes module events. */
+typedef struct
+{
+    nrf_ble_qwr_evt_type_t evt_type;
+    uint16_t               attr_handle;
+} nrf_ble_qwr_evt_t;
+
+typedef struct nrf_ble_qwr_t nrf_ble_qwr_t;
+
+typedef uint16_t (*nrf_ble_qwr_evt_handler_t)(struct nrf_ble_qwr_t *p_qwr, nrf_ble_qwr_evt_t *p_evt);
+
+/**@brief Queued Writes structure. */
+struct nrf_ble_qwr_t
+{
+    uint8_t                   initialized;
+    uint16_t                  conn_handle;
+    ble_srv_error_handler_t   error_handler;
+#if (NRF_BLE_QWR_MAX_ATTR > 0)
+    uint16_t                  attr_handles[NRF_BLE_QWR_MAX_ATTR];
+    uint8_t                   nb_registered_attr;
+    uint16_t                  written_attr_handles[NRF_BLE_QWR_MAX_ATTR];
+    uint8_t                   nb_written_handles;
+    ble_user_mem_block_t      mem_buffer;
+    nrf_ble_qwr_evt_handler_t callback;
+    bool                      is_user_mem_reply_pending;
+#endif
+};
+
+/**@brief Queued Writes init structure. */
+typedef struct
+{
+    ble_srv_error_handler_t   error_handler;
+#if (NRF_BLE_QWR_MAX_ATTR > 0)
+    ble_user_mem_block_t      mem_buffer;
+    nrf_ble_qwr_evt_handler_t callback;
+#endif
+} nrf_ble_qwr_init_t;
+
+ret_code_t nrf_ble_qwr_init(nrf_ble_qwr_t *p_qwr, nrf_ble_qwr_init_t const *p_qwr_init);
+ret_code_t nrf_ble_qwr_conn_handle_assign(nrf_ble_qwr_t *p_qwr, uint16_t conn_handle);
+void nrf_ble_qwr_on_ble_evt(ble_evt_t const *p_ble_evt, void *p_context);
+
+#if (NRF_BLE_QWR_MAX_ATTR > 0)
+ret_code_t nrf_ble_qwr_attr_register(nrf_ble_qwr_t *p_qwr, uint16_t attr_handle);
+ret_code_t nrf_ble_qwr_value_get(nrf_ble_qwr_t *p_qwr, uint16_t attr_handle, uint8_t *p_mem, uint16_t *p_len);
+#endif
+
+#endif /* NRF_BLE_QWR_H__ */
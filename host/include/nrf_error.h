@@ -0,0 +1,62 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#ifndef NRF_ERROR_H__
+#define NRF_ERROR_H__
+
+/* Host build: error codes of the SoftDevice, same values as on target */
+
+#define NRF_ERROR_BASE_NUM          (0x0)
+#define NRF_ERROR_SDM_BASE_NUM      (0x1000)
+#define NRF_ERROR_SOC_BASE_NUM      (0x2000)
+#define NRF_ERROR_STK_BASE_NUM      (0x3000)
+
+#define NRF_SUCCESS                 (NRF_ERROR_BASE_NUM + 0)
+#define NRF_ERROR_SVC_HANDLER_MISSING (NRF_ERROR_BASE_NUM + 1)
+#define NRF_ERROR_SOFTDEVICE_NOT_ENABLED (NRF_ERROR_BASE_NUM + 2)
+#define NRF_ERROR_INTERNAL          (NRF_ERROR_BASE_NUM + 3)
+#define NRF_ERROR_NO_MEM            (NRF_ERROR_BASE_NUM + 4)
+#define NRF_ERROR_NOT_FOUND         (NRF_ERROR_BASE_NUM + 5)
+#define NRF_ERROR_NOT_SUPPORTED     (NRF_ERROR_BASE_NUM + 6)
+#define NRF_ERROR_INVALID_PARAM     (NRF_ERROR_BASE_NUM + 7)
+#define NRF_ERROR_INVALID_STATE     (NRF_ERROR_BASE_NUM + 8)
+#define NRF_ERROR_INVALID_LENGTH    (NRF_ERROR_BASE_NUM + 9)
+#define NRF_ERROR_INVALID_FLAGS     (NRF_ERROR_BASE_NUM + 10)
+#define NRF_ERROR_INVALID_DATA      (NRF_ERROR_BASE_NUM + 11)
+#define NRF_ERROR_DATA_SIZE         (NRF_ERROR_BASE_NUM + 12)
+#define NRF_ERROR_TIMEOUT           (NRF_ERROR_BASE_NUM + 13)
+#define NRF_ERROR_NULL              (NRF_ERROR_BASE_NUM + 14)
+#define NRF_ERROR_FORBIDDEN         (NRF_ERROR_BASE_NUM + 15)
+#define NRF_ERROR_INVALID_ADDR      (NRF_ERROR_BASE_NUM + 16)
+#define NRF_ERROR_BUSY              (NRF_ERROR_BASE_NUM + 17)
+#define NRF_ERROR_CONN_COUNT        (NRF_ERROR_BASE_NUM + 18)
+#define NRF_ERROR_RESOURCES         (NRF_ERROR_BASE_NUM + 19)
+
+#endif /* NRF_ERROR_H__ */
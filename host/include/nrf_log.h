@@ -0,0 +1,64 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#ifndef NRF_LOG_H__
+#define NRF_LOG_H__
+
+#include <stdint.h>
+
+#include "sdk_config.h"
+
+/* Host build: log lines go to stdout when the simulation is verbose, see sim_log_verbose_set */
+
+typedef enum
+{
+    NRF_LOG_SEVERITY_NONE,
+    NRF_LOG_SEVERITY_ERROR,
+    NRF_LOG_SEVERITY_WARNING,
+    NRF_LOG_SEVERITY_INFO,
+    NRF_LOG_SEVERITY_DEBUG,
+} nrf_log_severity_t;
+
+/**@brief Function for logging a line, the target takes printf formats with integer arguments too. */
+void nrf_log_frontend_std(nrf_log_severity_t severity, char const *p_str, ...);
+
+#define NRF_LOG_ERROR(...)      nrf_log_frontend_std(NRF_LOG_SEVERITY_ERROR, __VA_ARGS__)
+#define NRF_LOG_WARNING(...)    nrf_log_frontend_std(NRF_LOG_SEVERITY_WARNING, __VA_ARGS__)
+#define NRF_LOG_INFO(...)       nrf_log_frontend_std(NRF_LOG_SEVERITY_INFO, __VA_ARGS__)
+#define NRF_LOG_DEBUG(...)      nrf_log_frontend_std(NRF_LOG_SEVERITY_DEBUG, __VA_ARGS__)
+#define NRF_LOG_FLUSH()
+
+#define NRF_LOG_FLOAT_MARKER    "%s%d.%02d"
+#define NRF_LOG_FLOAT(val)      (((val) < 0 && (val) > -1.0) ? "-" : ""),   \
+                                (int)(val),                                 \
+                                (int)((((val) > 0) ? (val) - (int)(val)     \
+                                                   : (int)(val) - (val)) * 100)
+
+#endif /* NRF_LOG_H__ */
@@ -0,0 +1,78 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#ifndef NRF_RINGBUF_H__
+#define NRF_RINGBUF_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "app_util.h"
+#include "nrf_atomic.h"
+#include "sdk_errors.h"
+
+/**@brief Ring buffer control block. */
+typedef struct
+{
+    nrf_atomic_flag_t wr_flag;
+    nrf_atomic_flag_t rd_flag;
+    uint32_t          wr_idx;
+    uint32_t          tmp_wr_idx;
+    uint32_t          rd_idx;
+    uint32_t          tmp_rd_idx;
+} nrf_ringbuf_cb_t;
+
+/**@brief Ring buffer instance. */
+typedef struct
+{
+    uint8_t          *p_buffer;
+    size_t            bufsize_mask;
+    nrf_ringbuf_cb_t *p_cb;
+} nrf_ringbuf_t;
+
+#define NRF_RINGBUF_DEF(_name, _size)                                       \
+    STATIC_ASSERT(IS_POWER_OF_TWO(_size));                                  \
+    static uint8_t CONCAT_2(_name, _buf)[_size];                            \
+    static nrf_ringbuf_cb_t CONCAT_2(_name, _cb);                           \
+    static const nrf_ringbuf_t _name = {                                    \
+        .p_buffer     = CONCAT_2(_name, _buf),                              \
+        .bufsize_mask = _size - 1,                                          \
+        .p_cb         = &CONCAT_2(_name, _cb),                              \
+    }
+
+void nrf_ringbuf_init(nrf_ringbuf_t const *p_ringbuf);
+ret_code_t nrf_ringbuf_alloc(nrf_ringbuf_t const *p_ringbuf, uint8_t **pp_data, size_t *p_length, bool start);
+ret_code_t nrf_ringbuf_put(nrf_ringbuf_t const *p_ringbuf, size_t length);
+ret_code_t nrf_ringbuf_cpy_put(nrf_ringbuf_t const *p_ringbuf, uint8_t const *p_data, size_t *p_length);
+ret_code_t nrf_ringbuf_get(nrf_ringbuf_t const *p_ringbuf, uint8_t **pp_data, size_t *p_length, bool start);
+ret_code_t nrf_ringbuf_free(nrf_ringbuf_t const *p_ringbuf, size_t length);
+ret_code_t nrf_ringbuf_cpy_get(nrf_ringbuf_t const *p_ringbuf, uint8_t *p_data, size_t *p_length);
+
+#endif /* NRF_RINGBUF_H__ */
@@ -0,0 +1,96 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#ifndef NRF_SDH_BLE_H__
+#define NRF_SDH_BLE_H__
+
+#include <stdint.h>
+
+#include "app_util.h"
+#include "ble.h"
+#include "nrf_section.h"
+#include "sdk_config.h"
+#include "sdk_errors.h"
+
+/**@brief BLE stack event handler. */
+typedef void (*nrf_sdh_ble_evt_handler_t)(ble_evt_t const *p_ble_evt, void *p_context);
+
+/**@brief BLE event observer.
+ *
+ * @details On the host the priority is kept with the observer, the dispatcher sorts by it
+ *          instead of the linker.
+ */
+typedef struct
+{
+    nrf_sdh_ble_evt_handler_t handler;      /**< BLE event handler. */
+    void                     *p_context;    /**< A parameter to the event handler. */
+    uintptr_t                 prio;         /**< Observer priority, lower values are called first. */
+} const nrf_sdh_ble_evt_observer_t;
+
+/**@brief Macro for registering a BLE event observer.
+ *
+ * @param _name     Observer name.
+ * @param _prio     Priority of the observer event handler.
+ * @param _handler  BLE event handler.
+ * @param _context  Parameter to the event handler.
+ */
+#define NRF_SDH_BLE_OBSERVER(_name, _prio, _handler, _context)                                      \
+STATIC_ASSERT(NRF_SDH_BLE_ENABLED, "NRF_SDH_BLE_ENABLED not set!");                                \
+STATIC_ASSERT(_prio < NRF_SDH_BLE_OBSERVER_PRIO_LEVELS, "Priority level unavailable.");            \
+NRF_SECTION_SET_ITEM_REGISTER(sdh_ble_observers, _prio, static nrf_sdh_ble_evt_observer_t _name) = \
+{                                                                                                   \
+    .handler   = _handler,                                                                          \
+    .p_context = _context,                                                                          \
+    .prio      = _prio,                                                                             \
+}
+
+#define NRF_SDH_BLE_HANDLER_SET(_idx, _handler, _context, _prio)                                    \
+{                                                                                                   \
+    .handler   = _handler,                                                                          \
+    .p_context = _context[_idx],                                                                    \
+    .prio      = _prio,                                                                             \
+},
+
+/**@brief Macro for registering an array of BLE event observers, one per context. */
+#define NRF_SDH_BLE_OBSERVERS(_name, _prio, _handler, _context, _cnt)                               \
+STATIC_ASSERT(NRF_SDH_BLE_ENABLED, "NRF_SDH_BLE_ENABLED not set!");                                \
+STATIC_ASSERT(_prio < NRF_SDH_BLE_OBSERVER_PRIO_LEVELS, "Priority level unavailable.");            \
+NRF_SECTION_SET_ITEM_REGISTER(sdh_ble_observers, _prio, static nrf_sdh_ble_evt_observer_t _name[_cnt]) = \
+{                                                                                                   \
+    MACRO_REPEAT_FOR(_cnt, NRF_SDH_BLE_HANDLER_SET, _handler, _context, _prio)                      \
+}
+
+/**@brief Function for configuring the BLE stack with the settings of sdk_config.h. */
+ret_code_t nrf_sdh_ble_default_cfg_set(uint8_t conn_cfg_tag, uint32_t *p_ram_start);
+
+/**@brief Function for enabling the BLE stack. */
+ret_code_t nrf_sdh_ble_enable(uint32_t *p_app_ram_start);
+
+#endif /* NRF_SDH_BLE_H__ */
@@ -0,0 +1,60 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#ifndef NRF_SECTION_H__
+#define NRF_SECTION_H__
+
+/* Host build: section variables are collected by the ELF linker, which defines
+ * __start_<section> and __stop_<section> for sections named like C identifiers.
+ * The explicit alignment keeps the compiler from padding items apart. */
+
+#define NRF_SECTION_ITEM_REGISTER(section_name, section_var) \
+    section_var __attribute__((section(#section_name), used, aligned(8)))
+
+#define NRF_SECTION_SET_ITEM_REGISTER(_name, _priority, _var) \
+    NRF_SECTION_ITEM_REGISTER(_name, _var)
+
+#define NRF_SECTION_START_ADDR(section_name)    &__start_##section_name
+#define NRF_SECTION_END_ADDR(section_name)      &__stop_##section_name
+
+/* Repeats a macro for indices 0 .. count - 1, count being a literal or a macro expanding to one */
+#define MACRO_REPEAT_FOR(count, macro, ...)     MACRO_REPEAT_FOR_(count, macro, __VA_ARGS__)
+#define MACRO_REPEAT_FOR_(count, macro, ...)    MACRO_REPEAT_FOR_##count(macro, __VA_ARGS__)
+#define MACRO_REPEAT_FOR_0(macro, ...)
+#define MACRO_REPEAT_FOR_1(macro, ...)          MACRO_REPEAT_FOR_0(macro, __VA_ARGS__) macro(0, __VA_ARGS__)
+#define MACRO_REPEAT_FOR_2(macro, ...)          MACRO_REPEAT_FOR_1(macro, __VA_ARGS__) macro(1, __VA_ARGS__)
+#define MACRO_REPEAT_FOR_3(macro, ...)          MACRO_REPEAT_FOR_2(macro, __VA_ARGS__) macro(2, __VA_ARGS__)
+#define MACRO_REPEAT_FOR_4(macro, ...)          MACRO_REPEAT_FOR_3(macro, __VA_ARGS__) macro(3, __VA_ARGS__)
+#define MACRO_REPEAT_FOR_5(macro, ...)          MACRO_REPEAT_FOR_4(macro, __VA_ARGS__) macro(4, __VA_ARGS__)
+#define MACRO_REPEAT_FOR_6(macro, ...)          MACRO_REPEAT_FOR_5(macro, __VA_ARGS__) macro(5, __VA_ARGS__)
+#define MACRO_REPEAT_FOR_7(macro, ...)          MACRO_REPEAT_FOR_6(macro, __VA_ARGS__) macro(6, __VA_ARGS__)
+#define MACRO_REPEAT_FOR_8(macro, ...)          MACRO_REPEAT_FOR_7(macro, __VA_ARGS__) macro(7, __VA_ARGS__)
+
+#endif /* NRF_SECTION_H__ */
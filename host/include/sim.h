@@ -0,0 +1,326 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#ifndef SIM_H__
+#define SIM_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ble.h"
+#include "bsp.h"
+
+/**@file
+ *
+ * @brief Host simulation of the SoftDevice and the board for the ESTC applications.
+ *
+ * @details The application runs unmodified: its main() is a coroutine that hands control back
+ *          whenever it calls nrf_pwr_mgmt_run(), like the CPU stopping at WFE. Everything the
+ *          SoftDevice and the RTC would do in interrupts runs on the caller of the sim_*
+ *          functions instead, followed by one pass of the main loop, as after a real wakeup.
+ *
+ *          The sd_* stubs keep a model of the GAP, GATT server and L2CAP state, check their
+ *          arguments like the SoftDevice does and record every call. The test plays the
+ *          central: it connects, writes, subscribes and runs connection events, which deliver
+ *          queued notifications into the received log and complete them with
+ *          BLE_GATTS_EVT_HVN_TX_COMPLETE.
+ *
+ *          Time is virtual and only moves when the test moves it. On the way, sim_time_advance_ms()
+ *          and sim_run_until() fire app_timer timeouts and let the SoftDevice act on its own:
+ *          advertising times out after its duration, connection parameter updates take effect
+ *          SIM_LL_INSTANT_EVENTS connection intervals after the request, and every connection
+ *          with queued data runs its connection events on the interval grid. Idle time is
+ *          skipped, so hours of advertising and reconnecting take milliseconds. Durations are
+ *          reported in RTC ticks by sim_now_ticks(), the unit app_timer uses.
+ */
+
+#define SIM_LINK_COUNT          8       /**< Connections the model supports. */
+#define SIM_ATTR_COUNT          96      /**< Attributes in the GATT table. */
+#define SIM_RX_LOG_LEN          4096    /**< Notifications and indications kept in the received log. */
+#define SIM_HVX_MAX_LEN         (BLE_GATTS_VAR_ATTR_LEN_MAX)
+#define SIM_LL_INSTANT_EVENTS   6       /**< Connection events from an LL procedure request to its instant. */
+
+/**@brief Notification or indication received by a central. */
+typedef struct
+{
+    uint64_t time_ns;                   /**< Simulated time of reception. */
+    uint16_t conn_handle;               /**< Connection it was received on. */
+    uint16_t handle;                    /**< Attribute handle. */
+    uint8_t  type;                      /**< BLE_GATT_HVX_NOTIFICATION or BLE_GATT_HVX_INDICATION. */
+    uint16_t len;                       /**< Length of the value. */
+    uint8_t  data[SIM_HVX_MAX_LEN];     /**< Value. */
+} sim_rx_t;
+
+/**@brief Handler for a notification or indication received by a central. */
+typedef void (*sim_rx_handler_t)(sim_rx_t const *p_rx, void *p_context);
+
+/**@brief Behaviour of the simulated central of a connection. */
+typedef struct
+{
+    uint16_t         att_mtu;               /**< Largest ATT MTU the central accepts. */
+    uint8_t          data_length;           /**< Largest LL payload the central accepts (27-251 bytes). */
+    uint8_t          phys;                  /**< PHYs the central supports, BLE_GAP_PHY_* bits. */
+    bool             accept_conn_params;    /**< The central grants connection parameter updates. */
+    uint16_t         min_conn_interval;     /**< Shortest connection interval the central grants (in 1.25 ms units). */
+    uint16_t         max_conn_interval;     /**< Longest connection interval the central grants (in 1.25 ms units). */
+    ble_gap_conn_params_t conn_params;      /**< Parameters the connection starts with. */
+    sim_rx_handler_t rx_handler;            /**< Called for every notification and indication, may be NULL. */
+    void            *p_context;             /**< Parameter to the handler. */
+} sim_central_t;
+
+/**@brief Function for resetting the simulation, call before starting an application. */
+void sim_reset(void);
+
+/**@brief Function for running an application until its main loop sleeps for the first time.
+ *
+ * @param[in] app_main  main() of the application, renamed when it is compiled for the host.
+ */
+void sim_app_start(int (*app_main)(void));
+
+/**@brief Function for checking whether the application entered System OFF. */
+bool sim_system_off(void);
+
+/**@brief Function for delivering queued BLE events and letting the main loop run until quiet. */
+void sim_process(void);
+
+/**@brief Function for queueing a BLE event for the observers, delivered by sim_process().
+ *
+ * @param[in] p_evt  Event, evt_len in the header is ignored.
+ * @param[in] len    Size of the event, including variable length data at its end.
+ */
+void sim_evt_push(ble_evt_t const *p_evt, uint16_t len);
+
+/**@brief Function for getting the simulated time (in nanoseconds). */
+uint64_t sim_now_ns(void);
+
+/**@brief Function for getting the simulated RTC1 counter, the same value app_timer_cnt_get() returns. */
+uint64_t sim_now_ticks(void);
+
+/**@brief Function for getting the number of running app_timer timers, each of them wakes the CPU. */
+uint32_t sim_timers_running(void);
+
+/**@brief Function for moving the simulated time forward, firing app_timer timeouts on the way. */
+void sim_time_advance_ns(uint64_t delta_ns);
+void sim_time_advance_ms(uint32_t delta_ms);
+
+/**@brief Function for running the simulation until a condition holds.
+ *
+ * @details Checks the condition after every timer timeout and SoftDevice activity, so the
+ *          simulated time is left at the moment it started to hold.
+ *
+ * @param[in] p_done  Condition.
+ * @param[in] max_ns  Longest simulated time to run.
+ *
+ * @return True if the condition holds, false if max_ns passed first.
+ */
+bool sim_run_until(bool (*p_done)(void), uint64_t max_ns);
+
+/**@brief Function for getting a central with the defaults of a recent phone. */
+void sim_central_default(sim_central_t *p_central);
+
+/**@brief Function for connecting a central to the advertising peripheral.
+ *
+ * @param[in] p_central  Behaviour of the central, NULL for sim_central_default().
+ *
+ * @return Handle of the connection, BLE_CONN_HANDLE_INVALID if the peripheral is not connectable.
+ */
+uint16_t sim_connect(sim_central_t const *p_central);
+
+/**@brief Function for disconnecting a central. */
+void sim_disconnect(uint16_t conn_handle, uint8_t hci_status);
+
+/**@brief Function for checking whether a connection is up. */
+bool sim_connected(uint16_t conn_handle);
+
+/**@brief Function for running one connection event of a connection.
+ *
+ * @details Sends as many queued notifications as the event length allows, an indication if one
+ *          is queued and not waiting for its confirmation, and confirms the indication sent in
+ *          the previous event.
+ *
+ * @return Number of notifications sent.
+ */
+uint32_t sim_conn_event(uint16_t conn_handle);
+
+/**@brief Function for writing an attribute as the central.
+ *
+ * @param[in] conn_handle  Connection.
+ * @param[in] handle       Attribute handle.
+ * @param[in] op           BLE_GATTS_OP_WRITE_REQ or BLE_GATTS_OP_WRITE_CMD.
+ * @param[in] p_data       Value.
+ * @param[in] len          Length of the value.
+ *
+ * @return GATT status of the write, BLE_GATT_STATUS_SUCCESS when it was accepted.
+ */
+uint16_t sim_write(uint16_t conn_handle, uint16_t handle, uint8_t op, uint8_t const *p_data, uint16_t len);
+
+/**@brief Function for writing a value longer than the ATT MTU with Prepare and Execute Write requests. */
+uint16_t sim_long_write(uint16_t conn_handle, uint16_t handle, uint8_t const *p_data, uint16_t len);
+
+/**@brief Function for writing the CCCD of a characteristic.
+ *
+ * @param[in] conn_handle   Connection.
+ * @param[in] value_handle  Handle of the characteristic value, the CCCD follows it.
+ * @param[in] cccd          BLE_GATT_HVX_NOTIFICATION, BLE_GATT_HVX_INDICATION or 0.
+ */
+uint16_t sim_subscribe(uint16_t conn_handle, uint16_t value_handle, uint16_t cccd);
+
+/**@brief Function for reading an attribute as the central.
+ *
+ * @details Reads with authorization complete when the application replies, which may take
+ *          until a later sim_process().
+ *
+ * @param[out]   p_data  Value read.
+ * @param[inout] p_len   Size of the buffer in, length of the value out.
+ *
+ * @return True if the read completed.
+ */
+bool sim_read(uint16_t conn_handle, uint16_t handle, uint8_t *p_data, uint16_t *p_len);
+
+/**@brief Function for getting the result of a read that completed after sim_read() returned.
+ *
+ * @return True if the read completed, the result is returned once.
+ */
+bool sim_read_result(uint16_t conn_handle, uint8_t *p_data, uint16_t *p_len);
+
+/**@brief Function for starting an ATT MTU exchange from the central. */
+void sim_mtu_exchange(uint16_t conn_handle, uint16_t client_rx_mtu);
+
+/**@brief Function for opening an LE credit-based L2CAP channel from the central.
+ *
+ * @return True if the peripheral accepted the channel.
+ */
+bool sim_l2cap_connect(uint16_t conn_handle, uint16_t le_psm, uint16_t rx_mtu, uint16_t credits);
+
+/**@brief Function for sending an SDU on the L2CAP channel of a connection.
+ *
+ * @return True if the peripheral had a receive buffer for it.
+ */
+bool sim_l2cap_send(uint16_t conn_handle, uint8_t const *p_data, uint16_t len);
+
+/**@brief Function for getting the bytes the central received on the L2CAP channel of a connection. */
+uint32_t sim_l2cap_received(uint16_t conn_handle);
+
+/**@brief Function for reporting an RSSI change of a connection. */
+void sim_rssi(uint16_t conn_handle, int8_t rssi);
+
+/**@brief Function for getting the parameters of a connection. */
+ble_gap_conn_params_t sim_conn_params(uint16_t conn_handle);
+
+/**@brief Function for getting the effective ATT MTU, data length and TX PHY of a connection. */
+uint16_t sim_conn_att_mtu(uint16_t conn_handle);
+uint8_t sim_conn_data_length(uint16_t conn_handle);
+uint8_t sim_conn_phy(uint16_t conn_handle);
+
+/**@brief Function for getting the time of the next connection event at which the peripheral listens.
+ *
+ * @details A write of the central reaches the application at that event. Without queued data the
+ *          peripheral skips the events that slave latency allows.
+ */
+uint64_t sim_conn_listen_ns(uint16_t conn_handle);
+
+/**@brief Function for getting the notifications queued in the SoftDevice for a connection. */
+uint32_t sim_conn_hvn_queued(uint16_t conn_handle);
+
+/**@brief Function for checking whether advertising is running. */
+bool sim_advertising(void);
+
+/**@brief Function for getting the advertising or scan response data being sent. */
+ble_data_t sim_adv_data(void);
+ble_data_t sim_scan_rsp_data(void);
+
+/**@brief Function for finding a field in advertising data.
+ *
+ * @return Length of the field data (without the type), 0 if the type is not present.
+ */
+uint8_t sim_adv_field(ble_data_t const *p_adv, uint8_t ad_type, uint8_t const **pp_field);
+
+/**@brief Function for finding a characteristic in the GATT table.
+ *
+ * @param[in] uuid  16-bit UUID, or octets 12-13 of a vendor specific UUID.
+ *
+ * @return Handle of the characteristic value, BLE_GATT_HANDLE_INVALID if there is none.
+ */
+uint16_t sim_char_find(uint16_t uuid);
+
+/**@brief Function for finding a service in the GATT table, BLE_GATT_HANDLE_INVALID if there is none. */
+uint16_t sim_service_find(uint16_t uuid);
+
+/**@brief Function for getting the properties of a characteristic value. */
+ble_gatt_char_props_t sim_char_props(uint16_t value_handle);
+
+/**@brief Function for getting the value of an attribute as stored in the GATT table. */
+uint16_t sim_attr_value(uint16_t handle, uint8_t *p_data, uint16_t size);
+
+/**@brief Function for getting the attribute table bytes in use.
+ *
+ * @details The SoftDevice does not document its attribute table layout, so this is a model that
+ *          errs on the large side: 8 bytes per attribute plus its value rounded up to a word,
+ *          BLE_GATTS_VLOC_STACK values counting with their max_len. Adding attributes beyond
+ *          the size configured with BLE_GATTS_CFG_ATTR_TAB_SIZE fails with NRF_ERROR_NO_MEM.
+ */
+uint32_t sim_attr_tab_used(void);
+
+/**@brief Function for getting the attribute table size configured with BLE_GATTS_CFG_ATTR_TAB_SIZE. */
+uint32_t sim_attr_tab_size(void);
+
+/**@brief Function for getting the received log.
+ *
+ * @details Holds the last SIM_RX_LOG_LEN entries, index 0 is the oldest one kept.
+ */
+uint32_t sim_rx_count(void);
+sim_rx_t const * sim_rx_get(uint32_t index);
+void sim_rx_clear(void);
+
+/**@brief Function for getting the number of calls to a SoftDevice function.
+ *
+ * @param[in] p_name  Function name, e.g. "sd_ble_gatts_hvx".
+ */
+uint32_t sim_calls(char const *p_name);
+
+/**@brief Function for getting the number of calls to a SoftDevice function that did not return NRF_SUCCESS. */
+uint32_t sim_calls_failed(char const *p_name);
+
+/**@brief Function for getting the last error a SoftDevice function returned. */
+uint32_t sim_calls_last_error(char const *p_name);
+
+/**@brief Function for pressing a button, delivered as the BSP event it is assigned to. */
+void sim_bsp_event(bsp_event_t event);
+
+/**@brief Function for getting the state the LEDs indicate. */
+bsp_indication_t sim_bsp_indication(void);
+
+/**@brief Function for printing log lines of the application to stdout. */
+void sim_log_verbose_set(bool verbose);
+
+/**@brief Function for getting the number of log lines of a severity, see nrf_log_severity_t. */
+uint32_t sim_log_count(uint8_t severity);
+
+#endif /* SIM_H__ */
@@ -0,0 +1,189 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#include <stddef.h>
+
+#include "app_timer.h"
+#include "sim_internal.h"
+
+static app_timer_t *mp_running;     /**< Running timers, sorted by expiry. */
+
+void sim_timer_reset(void)
+{
+    mp_running = NULL;
+}
+
+static void list_remove(app_timer_t *p_timer)
+{
+    for (app_timer_t **pp = &mp_running; *pp != NULL; pp = &(*pp)->p_next)
+    {
+        if (*pp == p_timer)
+        {
+            *pp = p_timer->p_next;
+            break;
+        }
+    }
+    p_timer->p_next = NULL;
+}
+
+static void list_insert(app_timer_t *p_timer)
+{
+    app_timer_t **pp = &mp_running;
+
+    // Timers expiring at the same tick run in the order they were started
+    while (*pp != NULL && (*pp)->end_val <= p_timer->end_val)
+    {
+        pp = &(*pp)->p_next;
+    }
+    p_timer->p_next = *pp;
+    *pp = p_timer;
+}
+
+ret_code_t app_timer_init(void)
+{
+    SIM_RETURN(NRF_SUCCESS);
+}
+
+ret_code_t app_timer_create(app_timer_id_t const *p_timer_id, app_timer_mode_t mode,
+                            app_timer_timeout_handler_t timeout_handler)
+{
+    if (timeout_handler == NULL)
+    {
+        SIM_RETURN(NRF_ERROR_INVALID_PARAM);
+    }
+
+    app_timer_t *p_timer = *p_timer_id;
+    if (p_timer->active)
+    {
+        SIM_RETURN(NRF_ERROR_INVALID_STATE);
+    }
+
+    p_timer->handler  = timeout_handler;
+    p_timer->repeated = (mode == APP_TIMER_MODE_REPEATED);
+    p_timer->p_next   = NULL;
+    SIM_RETURN(NRF_SUCCESS);
+}
+
+ret_code_t app_timer_start(app_timer_id_t timer_id, uint32_t timeout_ticks, void *p_context)
+{
+    if (timeout_ticks < APP_TIMER_MIN_TIMEOUT_TICKS || timeout_ticks > APP_TIMER_MAX_CNT_VAL)
+    {
+        SIM_RETURN(NRF_ERROR_INVALID_PARAM);
+    }
+    if (timer_id->handler == NULL)
+    {
+        SIM_RETURN(NRF_ERROR_INVALID_STATE);
+    }
+    if (timer_id->active)
+    {
+        // Like app_timer v2, starting a running timer leaves it running as it was
+        SIM_RETURN(NRF_SUCCESS);
+    }
+
+    timer_id->p_context     = p_context;
+    timer_id->repeat_period = timer_id->repeated ? timeout_ticks : 0;
+    timer_id->end_val       = sim_now_ticks() + timeout_ticks;
+    timer_id->active        = true;
+    list_insert(timer_id);
+    SIM_RETURN(NRF_SUCCESS);
+}
+
+ret_code_t app_timer_stop(app_timer_id_t timer_id)
+{
+    if (timer_id->active)
+    {
+        list_remove(timer_id);
+        timer_id->active = false;
+    }
+    SIM_RETURN(NRF_SUCCESS);
+}
+
+ret_code_t app_timer_stop_all(void)
+{
+    while (mp_running != NULL)
+    {
+        app_timer_t *p_timer = mp_running;
+        mp_running      = p_timer->p_next;
+        p_timer->p_next = NULL;
+        p_timer->active = false;
+    }
+    SIM_RETURN(NRF_SUCCESS);
+}
+
+uint32_t app_timer_cnt_get(void)
+{
+    return (uint32_t)(sim_now_ticks() & APP_TIMER_MAX_CNT_VAL);
+}
+
+uint32_t app_timer_cnt_diff_compute(uint32_t ticks_to, uint32_t ticks_from)
+{
+    return (ticks_to - ticks_from) & APP_TIMER_MAX_CNT_VAL;
+}
+
+uint64_t sim_timer_next(void)
+{
+    return (mp_running != NULL) ? mp_running->end_val : UINT64_MAX;
+}
+
+uint32_t sim_timers_running(void)
+{
+    uint32_t count = 0;
+
+    for (app_timer_t const *p_timer = mp_running; p_timer != NULL; p_timer = p_timer->p_next)
+    {
+        count++;
+    }
+    return count;
+}
+
+void sim_timer_fire(void *p_context)
+{
+    uint64_t now = sim_now_ticks();
+
+    (void)p_context;
+    while (mp_running != NULL && mp_running->end_val <= now)
+    {
+        app_timer_t *p_timer = mp_running;
+        mp_running      = p_timer->p_next;
+        p_timer->p_next = NULL;
+
+        if (p_timer->repeat_period > 0)
+        {
+            p_timer->end_val += p_timer->repeat_period;
+            list_insert(p_timer);
+        }
+        else
+        {
+            // Cleared before the handler runs, so the handler can start the timer again
+            p_timer->active = false;
+        }
+        p_timer->handler(p_timer->p_context);
+    }
+}
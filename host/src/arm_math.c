@@ -0,0 +1,271 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "arm_math.h"
+
+#define ARM_MATH_FFT_LEN_MAX    8192
+
+static q15_t arm_math_q15_saturate(double value)
+{
+    return (q15_t)fmax(fmin(value, INT16_MAX), INT16_MIN);
+}
+
+static bool arm_math_is_power_of_two(uint32_t len, uint32_t min, uint32_t max)
+{
+    return len >= min && len <= max && 0 == (len & (len - 1));
+}
+
+/**@brief Bin k of the DFT of len real values. */
+static void arm_math_dft_bin(double const *input, uint32_t len, uint32_t k, double *re, double *im)
+{
+    *re = 0.0;
+    *im = 0.0;
+    for (uint32_t n = 0; n < len; n++)
+    {
+        // Reduced first, so the phase stays exact for long transforms
+        double phase = 2.0 * M_PI * (double)(((uint64_t)k * n) % len) / len;
+        *re += input[n] * cos(phase);
+        *im -= input[n] * sin(phase);
+    }
+}
+
+void arm_rms_f32(float32_t const *pSrc, uint32_t blockSize, float32_t *pResult)
+{
+    double sum = 0.0;
+    for (uint32_t i = 0; i < blockSize; i++)
+    {
+        sum += (double)pSrc[i] * pSrc[i];
+    }
+    *pResult = (float32_t)sqrt(sum / blockSize);
+}
+
+void arm_max_f32(float32_t const *pSrc, uint32_t blockSize, float32_t *pResult, uint32_t *pIndex)
+{
+    *pIndex = 0;
+    for (uint32_t i = 1; i < blockSize; i++)
+    {
+        if (pSrc[i] > pSrc[*pIndex])
+        {
+            *pIndex = i;
+        }
+    }
+    *pResult = pSrc[*pIndex];
+}
+
+void arm_min_f32(float32_t const *pSrc, uint32_t blockSize, float32_t *pResult, uint32_t *pIndex)
+{
+    *pIndex = 0;
+    for (uint32_t i = 1; i < blockSize; i++)
+    {
+        if (pSrc[i] < pSrc[*pIndex])
+        {
+            *pIndex = i;
+        }
+    }
+    *pResult = pSrc[*pIndex];
+}
+
+void arm_mean_f32(float32_t const *pSrc, uint32_t blockSize, float32_t *pResult)
+{
+    double sum = 0.0;
+    for (uint32_t i = 0; i < blockSize; i++)
+    {
+        sum += pSrc[i];
+    }
+    *pResult = (float32_t)(sum / blockSize);
+}
+
+void arm_offset_f32(float32_t const *pSrc, float32_t offset, float32_t *pDst, uint32_t blockSize)
+{
+    for (uint32_t i = 0; i < blockSize; i++)
+    {
+        pDst[i] = pSrc[i] + offset;
+    }
+}
+
+void arm_cmplx_mag_squared_f32(float32_t const *pSrc, float32_t *pDst, uint32_t numSamples)
+{
+    for (uint32_t i = 0; i < numSamples; i++)
+    {
+        pDst[i] = pSrc[2 * i] * pSrc[2 * i] + pSrc[2 * i + 1] * pSrc[2 * i + 1];
+    }
+}
+
+arm_status arm_rfft_fast_init_f32(arm_rfft_fast_instance_f32 *S, uint16_t fftLen)
+{
+    if (!arm_math_is_power_of_two(fftLen, 32, 4096))
+    {
+        return ARM_MATH_ARGUMENT_ERROR;
+    }
+    S->fftLenRFFT = fftLen;
+    return ARM_MATH_SUCCESS;
+}
+
+void arm_rfft_fast_f32(arm_rfft_fast_instance_f32 *S, float32_t *p, float32_t *pOut, uint8_t ifftFlag)
+{
+    static double input[ARM_MATH_FFT_LEN_MAX];
+    uint32_t len = S->fftLenRFFT;
+    double   re;
+    double   im;
+
+    if (ifftFlag)
+    {
+        fprintf(stderr, "arm_rfft_fast_f32: the host build has no inverse FFT\n");
+        abort();
+    }
+
+    for (uint32_t n = 0; n < len; n++)
+    {
+        input[n] = p[n];
+    }
+
+    arm_math_dft_bin(input, len, 0, &re, &im);
+    pOut[0] = (float32_t)re;
+    arm_math_dft_bin(input, len, len / 2, &re, &im);
+    pOut[1] = (float32_t)re;
+    for (uint32_t k = 1; k < len / 2; k++)
+    {
+        arm_math_dft_bin(input, len, k, &re, &im);
+        pOut[2 * k]     = (float32_t)re;
+        pOut[2 * k + 1] = (float32_t)im;
+    }
+}
+
+void arm_rms_q15(q15_t const *pSrc, uint32_t blockSize, q15_t *pResult)
+{
+    q63_t sum = 0;
+    for (uint32_t i = 0; i < blockSize; i++)
+    {
+        sum += (q31_t)pSrc[i] * pSrc[i];
+    }
+    *pResult = arm_math_q15_saturate(floor(sqrt((double)sum / blockSize)));
+}
+
+void arm_max_q15(q15_t const *pSrc, uint32_t blockSize, q15_t *pResult, uint32_t *pIndex)
+{
+    *pIndex = 0;
+    for (uint32_t i = 1; i < blockSize; i++)
+    {
+        if (pSrc[i] > pSrc[*pIndex])
+        {
+            *pIndex = i;
+        }
+    }
+    *pResult = pSrc[*pIndex];
+}
+
+void arm_min_q15(q15_t const *pSrc, uint32_t blockSize, q15_t *pResult, uint32_t *pIndex)
+{
+    *pIndex = 0;
+    for (uint32_t i = 1; i < blockSize; i++)
+    {
+        if (pSrc[i] < pSrc[*pIndex])
+        {
+            *pIndex = i;
+        }
+    }
+    *pResult = pSrc[*pIndex];
+}
+
+void arm_mean_q15(q15_t const *pSrc, uint32_t blockSize, q15_t *pResult)
+{
+    q31_t sum = 0;
+    for (uint32_t i = 0; i < blockSize; i++)
+    {
+        sum += pSrc[i];
+    }
+    *pResult = (q15_t)(sum / (q31_t)blockSize);
+}
+
+void arm_offset_q15(q15_t const *pSrc, q15_t offset, q15_t *pDst, uint32_t blockSize)
+{
+    for (uint32_t i = 0; i < blockSize; i++)
+    {
+        pDst[i] = arm_math_q15_saturate((double)pSrc[i] + offset);
+    }
+}
+
+void arm_cmplx_mag_squared_q15(q15_t const *pSrc, q15_t *pDst, uint32_t numSamples)
+{
+    for (uint32_t i = 0; i < numSamples; i++)
+    {
+        q31_t re = pSrc[2 * i];
+        q31_t im = pSrc[2 * i + 1];
+        pDst[i] = (q15_t)(((q63_t)re * re + (q63_t)im * im) >> 17);
+    }
+}
+
+arm_status arm_rfft_init_q15(arm_rfft_instance_q15 *S, uint32_t fftLenReal, uint32_t ifftFlagR,
+                             uint32_t bitReverseFlag)
+{
+    if (!arm_math_is_power_of_two(fftLenReal, 32, ARM_MATH_FFT_LEN_MAX))
+    {
+        return ARM_MATH_ARGUMENT_ERROR;
+    }
+    S->fftLenReal      = fftLenReal;
+    S->ifftFlagR       = (uint8_t)ifftFlagR;
+    S->bitReverseFlagR = (uint8_t)bitReverseFlag;
+    return ARM_MATH_SUCCESS;
+}
+
+void arm_rfft_q15(arm_rfft_instance_q15 const *S, q15_t *pSrc, q15_t *pDst)
+{
+    static double input[ARM_MATH_FFT_LEN_MAX];
+    uint32_t len = S->fftLenReal;
+    double   re;
+    double   im;
+
+    if (S->ifftFlagR)
+    {
+        fprintf(stderr, "arm_rfft_q15: the host build has no inverse FFT\n");
+        abort();
+    }
+
+    for (uint32_t n = 0; n < len; n++)
+    {
+        input[n] = pSrc[n];
+    }
+    for (uint32_t k = 0; k < len; k++)
+    {
+        arm_math_dft_bin(input, len, k, &re, &im);
+        pDst[2 * k]     = arm_math_q15_saturate(floor(re / len));
+        pDst[2 * k + 1] = arm_math_q15_saturate(floor(im / len));
+    }
+    for (uint32_t n = 0; n < len; n++)
+    {
+        // The library works in place on its input
+        pSrc[n] = 0;
+    }
+}
@@ -0,0 +1,187 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#include <string.h>
+
+#include "ble_advdata.h"
+#include "ble_gap.h"
+#include "app_util.h"
+
+static ret_code_t field_put(uint8_t type, uint8_t const *p_data, uint16_t len,
+                            uint8_t *p_encoded, uint16_t *p_offset, uint16_t max_size)
+{
+    if (*p_offset + AD_DATA_OFFSET + len > max_size)
+    {
+        return NRF_ERROR_DATA_SIZE;
+    }
+
+    p_encoded[(*p_offset)++] = (uint8_t)(AD_TYPE_FIELD_SIZE + len);
+    p_encoded[(*p_offset)++] = type;
+    memcpy(&p_encoded[*p_offset], p_data, len);
+    *p_offset += len;
+    return NRF_SUCCESS;
+}
+
+static ret_code_t uuids_encode(ble_advdata_uuid_list_t const *p_list, uint8_t type,
+                               uint8_t *p_encoded, uint16_t *p_offset, uint16_t max_size)
+{
+    uint8_t  data[BLE_GAP_ADV_SET_DATA_SIZE_MAX];
+    uint16_t len = 0;
+
+    if (p_list->uuid_cnt == 0)
+    {
+        return NRF_SUCCESS;
+    }
+
+    for (uint16_t i = 0; i < p_list->uuid_cnt; i++)
+    {
+        if (p_list->p_uuids[i].type != BLE_UUID_TYPE_BLE)
+        {
+            // Only 16-bit UUIDs are used by the applications
+            return NRF_ERROR_INVALID_PARAM;
+        }
+        if (len + 2 > sizeof(data))
+        {
+            return NRF_ERROR_DATA_SIZE;
+        }
+        len += uint16_encode(p_list->p_uuids[i].uuid, &data[len]);
+    }
+    return field_put(type, data, len, p_encoded, p_offset, max_size);
+}
+
+static ret_code_t name_encode(ble_advdata_t const *p_advdata, uint8_t *p_encoded,
+                              uint16_t *p_offset, uint16_t max_size)
+{
+    uint8_t  name[BLE_GAP_DEVNAME_MAX_LEN];
+    uint16_t len  = sizeof(name);
+    uint8_t  type = BLE_GAP_AD_TYPE_COMPLETE_LOCAL_NAME;
+
+    ret_code_t err_code = sd_ble_gap_device_name_get(name, &len);
+    if (err_code != NRF_SUCCESS)
+    {
+        return err_code;
+    }
+
+    if (p_advdata->name_type == BLE_ADVDATA_SHORT_NAME && p_advdata->short_name_len < len)
+    {
+        len  = p_advdata->short_name_len;
+        type = BLE_GAP_AD_TYPE_SHORT_LOCAL_NAME;
+    }
+
+    // A name that does not fit is shortened, which is why it goes last
+    if (*p_offset + AD_DATA_OFFSET > max_size)
+    {
+        return NRF_ERROR_DATA_SIZE;
+    }
+    if (*p_offset + AD_DATA_OFFSET + len > max_size)
+    {
+        len  = max_size - *p_offset - AD_DATA_OFFSET;
+        type = BLE_GAP_AD_TYPE_SHORT_LOCAL_NAME;
+    }
+    return field_put(type, name, len, p_encoded, p_offset, max_size);
+}
+
+ret_code_t ble_advdata_encode(ble_advdata_t const *p_advdata, uint8_t *p_encoded, uint16_t *p_len)
+{
+    ret_code_t err_code;
+    uint16_t   max_size = *p_len;
+    uint16_t   offset   = 0;
+
+    if (p_advdata->include_appearance)
+    {
+        uint16_t appearance;
+        uint8_t  data[2];
+
+        err_code = sd_ble_gap_appearance_get(&appearance);
+        if (err_code != NRF_SUCCESS)
+        {
+            return err_code;
+        }
+        uint16_encode(appearance, data);
+        err_code = field_put(BLE_GAP_AD_TYPE_APPEARANCE, data, sizeof(data), p_encoded, &offset, max_size);
+        if (err_code != NRF_SUCCESS)
+        {
+            return err_code;
+        }
+    }
+
+    if (p_advdata->flags != 0)
+    {
+        err_code = field_put(BLE_GAP_AD_TYPE_FLAGS, &p_advdata->flags, 1, p_encoded, &offset, max_size);
+        if (err_code != NRF_SUCCESS)
+        {
+            return err_code;
+        }
+    }
+
+    err_code = uuids_encode(&p_advdata->uuids_more_available, BLE_GAP_AD_TYPE_16BIT_SERVICE_UUID_MORE_AVAILABLE,
+                            p_encoded, &offset, max_size);
+    if (err_code != NRF_SUCCESS)
+    {
+        return err_code;
+    }
+    err_code = uuids_encode(&p_advdata->uuids_complete, BLE_GAP_AD_TYPE_16BIT_SERVICE_UUID_COMPLETE,
+                            p_encoded, &offset, max_size);
+    if (err_code != NRF_SUCCESS)
+    {
+        return err_code;
+    }
+
+    if (p_advdata->p_manuf_specific_data != NULL)
+    {
+        ble_advdata_manuf_data_t const *p_manuf = p_advdata->p_manuf_specific_data;
+        uint8_t data[BLE_GAP_ADV_SET_DATA_SIZE_MAX];
+
+        if (p_manuf->data.size + 2 > sizeof(data))
+        {
+            return NRF_ERROR_DATA_SIZE;
+        }
+        uint16_encode(p_manuf->company_identifier, data);
+        memcpy(&data[2], p_manuf->data.p_data, p_manuf->data.size);
+        err_code = field_put(BLE_GAP_AD_TYPE_MANUFACTURER_SPECIFIC_DATA, data, p_manuf->data.size + 2,
+                             p_encoded, &offset, max_size);
+        if (err_code != NRF_SUCCESS)
+        {
+            return err_code;
+        }
+    }
+
+    if (p_advdata->name_type != BLE_ADVDATA_NO_NAME)
+    {
+        err_code = name_encode(p_advdata, p_encoded, &offset, max_size);
+        if (err_code != NRF_SUCCESS)
+        {
+            return err_code;
+        }
+    }
+
+    *p_len = offset;
+    return NRF_SUCCESS;
+}
@@ -0,0 +1,201 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#include <string.h>
+
+#include "ble_advertising.h"
+#include "ble_gap.h"
+
+static ble_adv_mode_t adv_mode_next_get(ble_adv_mode_t adv_mode)
+{
+    return (ble_adv_mode_t)((adv_mode + 1) % (BLE_ADV_MODE_SLOW + 1));
+}
+
+/* Picks the first enabled mode from the requested one on, directed modes need a peer nobody provides */
+static void adv_mode_set(ble_advertising_t *const p_advertising, ble_adv_mode_t mode)
+{
+    ble_adv_modes_config_t const *p_config = &p_advertising->adv_modes_config;
+
+    for (;;)
+    {
+        if (mode == BLE_ADV_MODE_FAST && p_config->ble_adv_fast_enabled)
+        {
+            p_advertising->adv_params.interval = p_config->ble_adv_fast_interval;
+            p_advertising->adv_params.duration = p_config->ble_adv_fast_timeout;
+            p_advertising->adv_evt             = BLE_ADV_EVT_FAST;
+            break;
+        }
+        if (mode == BLE_ADV_MODE_SLOW && p_config->ble_adv_slow_enabled)
+        {
+            p_advertising->adv_params.interval = p_config->ble_adv_slow_interval;
+            p_advertising->adv_params.duration = p_config->ble_adv_slow_timeout;
+            p_advertising->adv_evt             = BLE_ADV_EVT_SLOW;
+            break;
+        }
+        if (mode == BLE_ADV_MODE_IDLE)
+        {
+            p_advertising->adv_evt = BLE_ADV_EVT_IDLE;
+            break;
+        }
+        mode = adv_mode_next_get(mode);
+    }
+    p_advertising->adv_mode_current = mode;
+}
+
+uint32_t ble_advertising_init(ble_advertising_t *const p_advertising, ble_advertising_init_t const *const p_init)
+{
+    uint32_t ret;
+
+    if (p_advertising == NULL || p_init == NULL)
+    {
+        return NRF_ERROR_NULL;
+    }
+
+    p_advertising->initialized                    = true;
+    p_advertising->adv_mode_current               = BLE_ADV_MODE_IDLE;
+    p_advertising->adv_modes_config               = p_init->config;
+    p_advertising->conn_cfg_tag                   = 0;
+    p_advertising->evt_handler                    = p_init->evt_handler;
+    p_advertising->error_handler                  = p_init->error_handler;
+    p_advertising->current_slave_link_conn_handle = BLE_CONN_HANDLE_INVALID;
+    p_advertising->advdata                        = p_init->advdata;
+    p_advertising->srdata                         = p_init->srdata;
+    p_advertising->adv_handle                     = BLE_GAP_ADV_SET_HANDLE_NOT_SET;
+
+    memset(&p_advertising->adv_data, 0, sizeof(p_advertising->adv_data));
+    p_advertising->adv_data.adv_data.p_data = p_advertising->enc_advdata;
+    p_advertising->adv_data.adv_data.len    = BLE_GAP_ADV_SET_DATA_SIZE_MAX;
+    ret = ble_advdata_encode(&p_init->advdata, p_advertising->enc_advdata, &p_advertising->adv_data.adv_data.len);
+    if (ret != NRF_SUCCESS)
+    {
+        return ret;
+    }
+
+    p_advertising->adv_data.scan_rsp_data.p_data = p_advertising->enc_scan_rsp_data;
+    p_advertising->adv_data.scan_rsp_data.len    = BLE_GAP_ADV_SET_DATA_SIZE_MAX;
+    ret = ble_advdata_encode(&p_init->srdata, p_advertising->enc_scan_rsp_data,
+                             &p_advertising->adv_data.scan_rsp_data.len);
+    if (ret != NRF_SUCCESS)
+    {
+        return ret;
+    }
+
+    memset(&p_advertising->adv_params, 0, sizeof(p_advertising->adv_params));
+    p_advertising->adv_params.properties.type = BLE_GAP_ADV_TYPE_CONNECTABLE_SCANNABLE_UNDIRECTED;
+    p_advertising->adv_params.interval        = p_init->config.ble_adv_fast_interval;
+    p_advertising->adv_params.duration        = p_init->config.ble_adv_fast_timeout;
+    p_advertising->adv_params.filter_policy   = BLE_GAP_ADV_FP_ANY;
+
+    return sd_ble_gap_adv_set_configure(&p_advertising->adv_handle, NULL, &p_advertising->adv_params);
+}
+
+void ble_advertising_conn_cfg_tag_set(ble_advertising_t *const p_advertising, uint8_t ble_cfg_tag)
+{
+    p_advertising->conn_cfg_tag = ble_cfg_tag;
+}
+
+uint32_t ble_advertising_start(ble_advertising_t *const p_advertising, ble_adv_mode_t advertising_mode)
+{
+    uint32_t ret;
+
+    if (!p_advertising->initialized)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+
+    memset(&p_advertising->adv_params, 0, sizeof(p_advertising->adv_params));
+    p_advertising->adv_params.properties.type = BLE_GAP_ADV_TYPE_CONNECTABLE_SCANNABLE_UNDIRECTED;
+    p_advertising->adv_params.filter_policy   = BLE_GAP_ADV_FP_ANY;
+    adv_mode_set(p_advertising, advertising_mode);
+
+    if (p_advertising->adv_mode_current != BLE_ADV_MODE_IDLE)
+    {
+        ret = sd_ble_gap_adv_set_configure(&p_advertising->adv_handle, &p_advertising->adv_data,
+                                           &p_advertising->adv_params);
+        if (ret != NRF_SUCCESS)
+        {
+            return ret;
+        }
+        ret = sd_ble_gap_adv_start(p_advertising->adv_handle, p_advertising->conn_cfg_tag);
+        if (ret != NRF_SUCCESS)
+        {
+            return ret;
+        }
+    }
+
+    if (p_advertising->evt_handler != NULL)
+    {
+        p_advertising->evt_handler(p_advertising->adv_evt);
+    }
+    return NRF_SUCCESS;
+}
+
+void ble_advertising_on_ble_evt(ble_evt_t const *p_ble_evt, void *p_context)
+{
+    ble_advertising_t *p_advertising = (ble_advertising_t *)p_context;
+    uint32_t           ret;
+
+    switch (p_ble_evt->header.evt_id)
+    {
+        case BLE_GAP_EVT_CONNECTED:
+            if (p_ble_evt->evt.gap_evt.params.connected.role == BLE_GAP_ROLE_PERIPH)
+            {
+                p_advertising->current_slave_link_conn_handle = p_ble_evt->evt.gap_evt.conn_handle;
+            }
+            break;
+
+        case BLE_GAP_EVT_DISCONNECTED:
+            if (p_ble_evt->evt.gap_evt.conn_handle == p_advertising->current_slave_link_conn_handle &&
+                !p_advertising->adv_modes_config.ble_adv_on_disconnect_disabled)
+            {
+                ret = ble_advertising_start(p_advertising, BLE_ADV_MODE_DIRECTED_HIGH_DUTY);
+                if (ret != NRF_SUCCESS && p_advertising->error_handler != NULL)
+                {
+                    p_advertising->error_handler(ret);
+                }
+            }
+            break;
+
+        case BLE_GAP_EVT_ADV_SET_TERMINATED:
+            if (p_ble_evt->evt.gap_evt.params.adv_set_terminated.reason == BLE_GAP_EVT_ADV_SET_TERMINATED_REASON_TIMEOUT ||
+                p_ble_evt->evt.gap_evt.params.adv_set_terminated.reason == BLE_GAP_EVT_ADV_SET_TERMINATED_REASON_LIMIT_REACHED)
+            {
+                ret = ble_advertising_start(p_advertising, adv_mode_next_get(p_advertising->adv_mode_current));
+                if (ret != NRF_SUCCESS && p_advertising->error_handler != NULL)
+                {
+                    p_advertising->error_handler(ret);
+                }
+            }
+            break;
+
+        default:
+            break;
+    }
+}
@@ -0,0 +1,348 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#include <string.h>
+
+#include "app_timer.h"
+#include "ble_conn_params.h"
+#include "ble_conn_state.h"
+#include "ble_hci.h"
+#include "nordic_common.h"
+#include "nrf_sdh_ble.h"
+
+#ifndef BLE_CONN_PARAMS_BLE_OBSERVER_PRIO
+#define BLE_CONN_PARAMS_BLE_OBSERVER_PRIO 1
+#endif
+
+#define CONN_PARAMS_INSTANCE_COUNT  (NRF_SDH_BLE_PERIPHERAL_LINK_COUNT + NRF_SDH_BLE_CENTRAL_LINK_COUNT)
+
+/**@brief Negotiation state of one connection. */
+typedef struct
+{
+    uint16_t              conn_handle;
+    uint8_t               update_count;
+    bool                  params_ok;
+    ble_gap_conn_params_t preferred_conn_params;
+    app_timer_t           timer_data;
+    app_timer_id_t        timer_id;
+} ble_conn_params_instance_t;
+
+static ble_conn_params_init_t     m_conn_params_config;
+static ble_gap_conn_params_t      m_preferred_conn_params;
+static ble_conn_params_instance_t m_conn_params_instances[CONN_PARAMS_INSTANCE_COUNT];
+
+static void ble_conn_params_on_ble_evt(ble_evt_t const *p_ble_evt, void *p_context);
+
+NRF_SDH_BLE_OBSERVER(m_ble_observer, BLE_CONN_PARAMS_BLE_OBSERVER_PRIO, ble_conn_params_on_ble_evt, NULL);
+
+static ble_conn_params_instance_t * instance_get(uint16_t conn_handle)
+{
+    for (uint32_t i = 0; i < CONN_PARAMS_INSTANCE_COUNT; i++)
+    {
+        if (m_conn_params_instances[i].conn_handle == conn_handle)
+        {
+            return &m_conn_params_instances[i];
+        }
+    }
+    return NULL;
+}
+
+static bool is_conn_params_ok(ble_gap_conn_params_t const *p_preferred, ble_gap_conn_params_t const *p_actual,
+                              uint16_t max_slave_latency_err, uint16_t max_sup_timeout_err)
+{
+    uint32_t max_allowed_sl = p_preferred->slave_latency + max_slave_latency_err;
+    uint32_t min_allowed_sl = p_preferred->slave_latency - MIN(max_slave_latency_err, p_preferred->slave_latency);
+    uint32_t max_allowed_to = p_preferred->conn_sup_timeout + max_sup_timeout_err;
+    uint32_t min_allowed_to = p_preferred->conn_sup_timeout - MIN(max_sup_timeout_err, p_preferred->conn_sup_timeout);
+
+    if (p_actual->max_conn_interval < p_preferred->min_conn_interval ||
+        p_actual->max_conn_interval > p_preferred->max_conn_interval)
+    {
+        return false;
+    }
+    if (p_actual->slave_latency < min_allowed_sl || p_actual->slave_latency > max_allowed_sl)
+    {
+        return false;
+    }
+    if (p_actual->conn_sup_timeout < min_allowed_to || p_actual->conn_sup_timeout > max_allowed_to)
+    {
+        return false;
+    }
+    return true;
+}
+
+static void update_timeout_handler(void *p_context)
+{
+    uint16_t                    conn_handle = (uint16_t)(uintptr_t)p_context;
+    ble_conn_params_instance_t *p_instance  = instance_get(conn_handle);
+
+    if (p_instance == NULL || !ble_conn_state_valid(conn_handle))
+    {
+        return;
+    }
+
+    if (p_instance->update_count < m_conn_params_config.max_conn_params_update_count)
+    {
+        ret_code_t err_code = sd_ble_gap_conn_param_update(conn_handle, &p_instance->preferred_conn_params);
+        if (err_code == NRF_SUCCESS)
+        {
+            p_instance->update_count++;
+        }
+    }
+    else
+    {
+        p_instance->update_count = 0;
+
+        if (m_conn_params_config.disconnect_on_fail)
+        {
+            ret_code_t err_code = sd_ble_gap_disconnect(conn_handle, BLE_HCI_CONN_INTERVAL_UNACCEPTABLE);
+            if (err_code != NRF_SUCCESS && m_conn_params_config.error_handler != NULL)
+            {
+                m_conn_params_config.error_handler(err_code);
+            }
+        }
+
+        if (m_conn_params_config.evt_handler != NULL)
+        {
+            ble_conn_params_evt_t evt;
+
+            evt.evt_type    = BLE_CONN_PARAMS_EVT_FAILED;
+            evt.conn_handle = conn_handle;
+            m_conn_params_config.evt_handler(&evt);
+        }
+    }
+}
+
+uint32_t ble_conn_params_init(const ble_conn_params_init_t *p_init)
+{
+    ret_code_t err_code;
+
+    if (p_init == NULL)
+    {
+        return NRF_ERROR_NULL;
+    }
+
+    m_conn_params_config = *p_init;
+    m_conn_params_config.p_conn_params = &m_preferred_conn_params;
+
+    if (p_init->p_conn_params != NULL)
+    {
+        m_preferred_conn_params = *p_init->p_conn_params;
+        err_code = sd_ble_gap_ppcp_set(&m_preferred_conn_params);
+    }
+    else
+    {
+        err_code = sd_ble_gap_ppcp_get(&m_preferred_conn_params);
+    }
+    if (err_code != NRF_SUCCESS)
+    {
+        return err_code;
+    }
+
+    for (uint32_t i = 0; i < CONN_PARAMS_INSTANCE_COUNT; i++)
+    {
+        ble_conn_params_instance_t *p_instance = &m_conn_params_instances[i];
+
+        memset(p_instance, 0, sizeof(*p_instance));
+        p_instance->conn_handle = BLE_CONN_HANDLE_INVALID;
+        p_instance->timer_id    = &p_instance->timer_data;
+        err_code = app_timer_create(&p_instance->timer_id, APP_TIMER_MODE_SINGLE_SHOT, update_timeout_handler);
+        if (err_code != NRF_SUCCESS)
+        {
+            return NRF_ERROR_INTERNAL;
+        }
+    }
+    return NRF_SUCCESS;
+}
+
+uint32_t ble_conn_params_stop(void)
+{
+    for (uint32_t i = 0; i < CONN_PARAMS_INSTANCE_COUNT; i++)
+    {
+        ret_code_t err_code = app_timer_stop(m_conn_params_instances[i].timer_id);
+        if (err_code != NRF_SUCCESS)
+        {
+            return err_code;
+        }
+    }
+    return NRF_SUCCESS;
+}
+
+static void conn_params_negotiation(uint16_t conn_handle, ble_conn_params_instance_t *p_instance)
+{
+    if (!p_instance->params_ok)
+    {
+        uint32_t timeout_ticks = (p_instance->update_count == 0)
+                                 ? m_conn_params_config.first_conn_params_update_delay
+                                 : m_conn_params_config.next_conn_params_update_delay;
+
+        ret_code_t err_code = app_timer_start(p_instance->timer_id, timeout_ticks, (void *)(uintptr_t)conn_handle);
+        if (err_code != NRF_SUCCESS && m_conn_params_config.error_handler != NULL)
+        {
+            m_conn_params_config.error_handler(err_code);
+        }
+    }
+    else
+    {
+        p_instance->update_count = 0;
+
+        if (m_conn_params_config.evt_handler != NULL)
+        {
+            ble_conn_params_evt_t evt;
+
+            evt.evt_type    = BLE_CONN_PARAMS_EVT_SUCCEEDED;
+            evt.conn_handle = conn_handle;
+            m_conn_params_config.evt_handler(&evt);
+        }
+    }
+}
+
+static void on_connect(ble_evt_t const *p_ble_evt)
+{
+    uint16_t                    conn_handle = p_ble_evt->evt.gap_evt.conn_handle;
+    ble_conn_params_instance_t *p_instance  = instance_get(BLE_CONN_HANDLE_INVALID);
+
+    if (p_ble_evt->evt.gap_evt.params.connected.role != BLE_GAP_ROLE_PERIPH || p_instance == NULL)
+    {
+        return;
+    }
+
+    p_instance->conn_handle           = conn_handle;
+    p_instance->update_count          = 0;
+    p_instance->preferred_conn_params = m_preferred_conn_params;
+    p_instance->params_ok = is_conn_params_ok(&p_instance->preferred_conn_params,
+                                              &p_ble_evt->evt.gap_evt.params.connected.conn_params,
+                                              NRF_BLE_CONN_PARAMS_MAX_SLAVE_LATENCY_DEVIATION,
+                                              NRF_BLE_CONN_PARAMS_MAX_SUPERVISION_TIMEOUT_DEVIATION);
+
+    if (m_conn_params_config.start_on_notify_cccd_handle == BLE_GATT_HANDLE_INVALID)
+    {
+        conn_params_negotiation(conn_handle, p_instance);
+    }
+}
+
+static void on_disconnect(ble_evt_t const *p_ble_evt)
+{
+    ble_conn_params_instance_t *p_instance = instance_get(p_ble_evt->evt.gap_evt.conn_handle);
+
+    if (p_instance != NULL)
+    {
+        (void)app_timer_stop(p_instance->timer_id);
+        p_instance->conn_handle = BLE_CONN_HANDLE_INVALID;
+    }
+}
+
+static void on_write(ble_evt_t const *p_ble_evt)
+{
+    ble_gatts_evt_write_t const *p_evt_write = &p_ble_evt->evt.gatts_evt.params.write;
+    ble_conn_params_instance_t  *p_instance  = instance_get(p_ble_evt->evt.gatts_evt.conn_handle);
+
+    if (p_instance == NULL || p_evt_write->handle != m_conn_params_config.start_on_notify_cccd_handle ||
+        p_evt_write->len != 2)
+    {
+        return;
+    }
+
+    if (ble_srv_is_notification_enabled(p_evt_write->data))
+    {
+        conn_params_negotiation(p_ble_evt->evt.gatts_evt.conn_handle, p_instance);
+    }
+    else
+    {
+        (void)app_timer_stop(p_instance->timer_id);
+    }
+}
+
+static void on_conn_params_update(ble_evt_t const *p_ble_evt)
+{
+    uint16_t                    conn_handle = p_ble_evt->evt.gap_evt.conn_handle;
+    ble_conn_params_instance_t *p_instance  = instance_get(conn_handle);
+
+    if (p_instance == NULL)
+    {
+        return;
+    }
+
+    p_instance->params_ok = is_conn_params_ok(&p_instance->preferred_conn_params,
+                                              &p_ble_evt->evt.gap_evt.params.conn_param_update.conn_params,
+                                              NRF_BLE_CONN_PARAMS_MAX_SLAVE_LATENCY_DEVIATION,
+                                              NRF_BLE_CONN_PARAMS_MAX_SUPERVISION_TIMEOUT_DEVIATION);
+    conn_params_negotiation(conn_handle, p_instance);
+}
+
+static void ble_conn_params_on_ble_evt(ble_evt_t const *p_ble_evt, void *p_context)
+{
+    (void)p_context;
+
+    switch (p_ble_evt->header.evt_id)
+    {
+        case BLE_GAP_EVT_CONNECTED:
+            on_connect(p_ble_evt);
+            break;
+
+        case BLE_GAP_EVT_DISCONNECTED:
+            on_disconnect(p_ble_evt);
+            break;
+
+        case BLE_GATTS_EVT_WRITE:
+            on_write(p_ble_evt);
+            break;
+
+        case BLE_GAP_EVT_CONN_PARAM_UPDATE:
+            on_conn_params_update(p_ble_evt);
+            break;
+
+        default:
+            break;
+    }
+}
+
+uint32_t ble_conn_params_change_conn_params(uint16_t conn_handle, ble_gap_conn_params_t *p_new_params)
+{
+    ble_conn_params_instance_t *p_instance = instance_get(conn_handle);
+
+    if (p_new_params == NULL)
+    {
+        p_new_params = m_conn_params_config.p_conn_params;
+    }
+    if (p_instance == NULL)
+    {
+        return NRF_ERROR_NO_MEM;
+    }
+
+    ret_code_t err_code = sd_ble_gap_conn_param_update(conn_handle, p_new_params);
+    if (err_code == NRF_SUCCESS)
+    {
+        p_instance->params_ok             = false;
+        p_instance->update_count          = 1;
+        p_instance->preferred_conn_params = *p_new_params;
+    }
+    return err_code;
+}
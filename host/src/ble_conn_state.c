@@ -0,0 +1,136 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#include <string.h>
+
+#include "ble_conn_state.h"
+#include "nrf_sdh_ble.h"
+
+#ifndef BLE_CONN_STATE_BLE_OBSERVER_PRIO
+#define BLE_CONN_STATE_BLE_OBSERVER_PRIO 0
+#endif
+
+static bool    m_valid[BLE_CONN_STATE_MAX_CONNECTIONS];
+static bool    m_connected[BLE_CONN_STATE_MAX_CONNECTIONS];
+static uint8_t m_role[BLE_CONN_STATE_MAX_CONNECTIONS];
+
+static void ble_conn_state_on_ble_evt(ble_evt_t const *p_ble_evt, void *p_context);
+
+NRF_SDH_BLE_OBSERVER(m_ble_evt_observer, BLE_CONN_STATE_BLE_OBSERVER_PRIO, ble_conn_state_on_ble_evt, NULL);
+
+void ble_conn_state_init(void)
+{
+    memset(m_valid, 0, sizeof(m_valid));
+    memset(m_connected, 0, sizeof(m_connected));
+    memset(m_role, 0, sizeof(m_role));
+}
+
+static void ble_conn_state_on_ble_evt(ble_evt_t const *p_ble_evt, void *p_context)
+{
+    uint16_t conn_handle = p_ble_evt->evt.gap_evt.conn_handle;
+
+    (void)p_context;
+
+    if (conn_handle >= BLE_CONN_STATE_MAX_CONNECTIONS)
+    {
+        return;
+    }
+
+    switch (p_ble_evt->header.evt_id)
+    {
+        case BLE_GAP_EVT_CONNECTED:
+            // Records of links that went down are purged when a new link comes up
+            for (uint32_t i = 0; i < BLE_CONN_STATE_MAX_CONNECTIONS; i++)
+            {
+                m_valid[i] = m_valid[i] && m_connected[i];
+            }
+            m_valid[conn_handle]     = true;
+            m_connected[conn_handle] = true;
+            m_role[conn_handle]      = p_ble_evt->evt.gap_evt.params.connected.role;
+            break;
+
+        case BLE_GAP_EVT_DISCONNECTED:
+            m_connected[conn_handle] = false;
+            break;
+
+        default:
+            break;
+    }
+}
+
+bool ble_conn_state_valid(uint16_t conn_handle)
+{
+    return (conn_handle < BLE_CONN_STATE_MAX_CONNECTIONS) && m_valid[conn_handle];
+}
+
+uint8_t ble_conn_state_role(uint16_t conn_handle)
+{
+    return ble_conn_state_valid(conn_handle) ? m_role[conn_handle] : BLE_GAP_ROLE_INVALID;
+}
+
+static ble_conn_state_conn_handle_list_t handles_get(uint8_t role)
+{
+    ble_conn_state_conn_handle_list_t list;
+
+    list.len = 0;
+    for (uint16_t i = 0; i < BLE_CONN_STATE_MAX_CONNECTIONS; i++)
+    {
+        if (m_connected[i] && (role == BLE_GAP_ROLE_INVALID || m_role[i] == role))
+        {
+            list.conn_handles[list.len++] = i;
+        }
+    }
+    return list;
+}
+
+uint32_t ble_conn_state_conn_count(void)
+{
+    return handles_get(BLE_GAP_ROLE_INVALID).len;
+}
+
+uint32_t ble_conn_state_peripheral_conn_count(void)
+{
+    return handles_get(BLE_GAP_ROLE_PERIPH).len;
+}
+
+ble_conn_state_conn_handle_list_t ble_conn_state_conn_handles(void)
+{
+    return handles_get(BLE_GAP_ROLE_INVALID);
+}
+
+ble_conn_state_conn_handle_list_t ble_conn_state_periph_handles(void)
+{
+    return handles_get(BLE_GAP_ROLE_PERIPH);
+}
+
+uint16_t ble_conn_state_conn_idx(uint16_t conn_handle)
+{
+    return (conn_handle < BLE_CONN_STATE_MAX_CONNECTIONS) ? conn_handle : BLE_CONN_STATE_MAX_CONNECTIONS;
+}
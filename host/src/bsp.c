@@ -0,0 +1,94 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#include <stddef.h>
+
+#include "app_timer.h"
+#include "bsp.h"
+#include "bsp_btn_ble.h"
+#include "nrf_error.h"
+#include "sim.h"
+#include "sim_internal.h"
+
+static bsp_event_callback_t m_callback;
+static bsp_indication_t     m_indication;
+
+void sim_bsp_reset(void)
+{
+    m_callback   = NULL;
+    m_indication = BSP_INDICATE_IDLE;
+}
+
+uint32_t bsp_init(uint32_t type, bsp_event_callback_t callback)
+{
+    (void)type;
+    m_callback = callback;
+    return NRF_SUCCESS;
+}
+
+uint32_t bsp_indication_set(bsp_indication_t indicate)
+{
+    m_indication = indicate;
+    return NRF_SUCCESS;
+}
+
+uint32_t bsp_btn_ble_init(bsp_btn_ble_error_handler_t error_handler, bsp_event_t *p_startup_bsp_evt)
+{
+    (void)error_handler;
+    if (p_startup_bsp_evt != NULL)
+    {
+        *p_startup_bsp_evt = BSP_EVENT_NOTHING;
+    }
+    return NRF_SUCCESS;
+}
+
+uint32_t bsp_btn_ble_sleep_mode_prepare(void)
+{
+    return NRF_SUCCESS;
+}
+
+static void button_isr(void *p_context)
+{
+    if (m_callback != NULL)
+    {
+        m_callback(*(bsp_event_t *)p_context);
+    }
+}
+
+void sim_bsp_event(bsp_event_t event)
+{
+    sim_isr(button_isr, &event);
+    sim_process();
+}
+
+bsp_indication_t sim_bsp_indication(void)
+{
+    return m_indication;
+}
@@ -0,0 +1,108 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#include <string.h>
+
+#include "nrf_atfifo.h"
+#include "nrf_error.h"
+
+/* Host build: a plain FIFO with one spare slot, the simulation never preempts a put or a get */
+
+ret_code_t nrf_atfifo_init(nrf_atfifo_t *const p_fifo, void *p_buf, uint16_t buf_size, uint16_t item_size)
+{
+    if (p_buf == NULL || item_size == 0 || buf_size < 2 * item_size || (buf_size % item_size) != 0)
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+
+    p_fifo->p_buf     = p_buf;
+    p_fifo->buf_size  = buf_size;
+    p_fifo->item_size = item_size;
+    p_fifo->head      = 0;
+    p_fifo->tail      = 0;
+    return NRF_SUCCESS;
+}
+
+ret_code_t nrf_atfifo_clear(nrf_atfifo_t *const p_fifo)
+{
+    bool released = p_fifo->head == p_fifo->tail;
+
+    p_fifo->head = 0;
+    p_fifo->tail = 0;
+    return released ? NRF_SUCCESS : NRF_ERROR_BUSY;
+}
+
+static uint16_t next_offset(nrf_atfifo_t const *p_fifo, uint16_t offset)
+{
+    offset += p_fifo->item_size;
+    return (offset >= p_fifo->buf_size) ? 0 : offset;
+}
+
+ret_code_t nrf_atfifo_alloc_put(nrf_atfifo_t *const p_fifo, void const *p_var, size_t size, bool *const p_visible)
+{
+    if (size > p_fifo->item_size)
+    {
+        return NRF_ERROR_INVALID_LENGTH;
+    }
+
+    uint16_t next = next_offset(p_fifo, p_fifo->tail);
+    if (next == p_fifo->head)
+    {
+        return NRF_ERROR_NO_MEM;
+    }
+
+    memcpy((uint8_t *)p_fifo->p_buf + p_fifo->tail, p_var, size);
+    p_fifo->tail = next;
+    if (p_visible != NULL)
+    {
+        *p_visible = true;
+    }
+    return NRF_SUCCESS;
+}
+
+ret_code_t nrf_atfifo_get_free(nrf_atfifo_t *const p_fifo, void *const p_var, size_t size, bool *const p_released)
+{
+    if (size > p_fifo->item_size)
+    {
+        return NRF_ERROR_INVALID_LENGTH;
+    }
+    if (p_fifo->head == p_fifo->tail)
+    {
+        return NRF_ERROR_NOT_FOUND;
+    }
+
+    memcpy(p_var, (uint8_t *)p_fifo->p_buf + p_fifo->head, size);
+    p_fifo->head = next_offset(p_fifo, p_fifo->head);
+    if (p_released != NULL)
+    {
+        *p_released = true;
+    }
+    return NRF_SUCCESS;
+}
@@ -0,0 +1,104 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#include "nrf_atomic.h"
+
+/* Host build: the simulation runs interrupts and the main loop on one thread */
+
+uint32_t nrf_atomic_u32_store(nrf_atomic_u32_t *p_data, uint32_t value)
+{
+    *p_data = value;
+    return value;
+}
+
+uint32_t nrf_atomic_u32_or(nrf_atomic_u32_t *p_data, uint32_t value)
+{
+    *p_data |= value;
+    return *p_data;
+}
+
+uint32_t nrf_atomic_u32_and(nrf_atomic_u32_t *p_data, uint32_t value)
+{
+    *p_data &= value;
+    return *p_data;
+}
+
+uint32_t nrf_atomic_u32_add(nrf_atomic_u32_t *p_data, uint32_t value)
+{
+    *p_data += value;
+    return *p_data;
+}
+
+uint32_t nrf_atomic_u32_sub(nrf_atomic_u32_t *p_data, uint32_t value)
+{
+    *p_data -= value;
+    return *p_data;
+}
+
+uint32_t nrf_atomic_u32_fetch_store(nrf_atomic_u32_t *p_data, uint32_t value)
+{
+    uint32_t old = *p_data;
+    *p_data      = value;
+    return old;
+}
+
+uint32_t nrf_atomic_u32_fetch_add(nrf_atomic_u32_t *p_data, uint32_t value)
+{
+    uint32_t old = *p_data;
+    *p_data     += value;
+    return old;
+}
+
+uint32_t nrf_atomic_u32_fetch_sub(nrf_atomic_u32_t *p_data, uint32_t value)
+{
+    uint32_t old = *p_data;
+    *p_data     -= value;
+    return old;
+}
+
+uint32_t nrf_atomic_flag_set(nrf_atomic_flag_t *p_data)
+{
+    return nrf_atomic_u32_or(p_data, 1);
+}
+
+uint32_t nrf_atomic_flag_set_fetch(nrf_atomic_flag_t *p_data)
+{
+    return nrf_atomic_u32_fetch_store(p_data, 1);
+}
+
+uint32_t nrf_atomic_flag_clear(nrf_atomic_flag_t *p_data)
+{
+    return nrf_atomic_u32_and(p_data, 0);
+}
+
+uint32_t nrf_atomic_flag_clear_fetch(nrf_atomic_flag_t *p_data)
+{
+    return nrf_atomic_u32_fetch_store(p_data, 0);
+}
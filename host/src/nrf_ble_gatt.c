@@ -0,0 +1,257 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#include <string.h>
+
+#include "nordic_common.h"
+#include "nrf_ble_gatt.h"
+
+static void link_init(nrf_ble_gatt_link_t *p_link)
+{
+    p_link->att_mtu_desired            = NRF_SDH_BLE_GATT_MAX_MTU_SIZE;
+    p_link->att_mtu_effective          = BLE_GATT_ATT_MTU_DEFAULT;
+    p_link->att_mtu_exchange_pending   = false;
+    p_link->att_mtu_exchange_requested = false;
+    p_link->data_length_desired        = NRF_SDH_BLE_GAP_DATA_LENGTH;
+    p_link->data_length_effective      = BLE_GAP_DATA_LENGTH_DEFAULT;
+}
+
+ret_code_t nrf_ble_gatt_init(nrf_ble_gatt_t *p_gatt, nrf_ble_gatt_evt_handler_t evt_handler)
+{
+    if (p_gatt == NULL)
+    {
+        return NRF_ERROR_NULL;
+    }
+
+    p_gatt->evt_handler             = evt_handler;
+    p_gatt->att_mtu_desired_periph  = NRF_SDH_BLE_GATT_MAX_MTU_SIZE;
+    p_gatt->att_mtu_desired_central = NRF_SDH_BLE_GATT_MAX_MTU_SIZE;
+    p_gatt->data_length             = NRF_SDH_BLE_GAP_DATA_LENGTH;
+
+    for (uint32_t i = 0; i < NRF_BLE_GATT_LINK_COUNT; i++)
+    {
+        link_init(&p_gatt->links[i]);
+    }
+    return NRF_SUCCESS;
+}
+
+ret_code_t nrf_ble_gatt_att_max_mtu_set(nrf_ble_gatt_t *p_gatt, uint16_t desired_mtu)
+{
+    if (p_gatt == NULL)
+    {
+        return NRF_ERROR_NULL;
+    }
+    if (desired_mtu < BLE_GATT_ATT_MTU_DEFAULT || desired_mtu > NRF_SDH_BLE_GATT_MAX_MTU_SIZE)
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+
+    p_gatt->att_mtu_desired_periph = desired_mtu;
+    return NRF_SUCCESS;
+}
+
+ret_code_t nrf_ble_gatt_data_length_set(nrf_ble_gatt_t *p_gatt, uint16_t conn_handle, uint8_t data_length)
+{
+    if (p_gatt == NULL)
+    {
+        return NRF_ERROR_NULL;
+    }
+
+    if (conn_handle == BLE_CONN_HANDLE_INVALID)
+    {
+        p_gatt->data_length = MIN(data_length, NRF_SDH_BLE_GAP_DATA_LENGTH);
+        return NRF_SUCCESS;
+    }
+    if (conn_handle >= NRF_BLE_GATT_LINK_COUNT)
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+
+    ble_gap_data_length_params_t dl_params;
+    memset(&dl_params, 0, sizeof(dl_params));
+    dl_params.max_tx_octets = data_length;
+    dl_params.max_rx_octets = data_length;
+
+    p_gatt->links[conn_handle].data_length_desired = data_length;
+    return sd_ble_gap_data_length_update(conn_handle, &dl_params, NULL);
+}
+
+uint16_t nrf_ble_gatt_eff_mtu_get(nrf_ble_gatt_t const *p_gatt, uint16_t conn_handle)
+{
+    if (p_gatt == NULL || conn_handle >= NRF_BLE_GATT_LINK_COUNT)
+    {
+        return 0;
+    }
+    return p_gatt->links[conn_handle].att_mtu_effective;
+}
+
+static void data_length_update(uint16_t conn_handle, uint8_t data_length)
+{
+    ble_gap_data_length_params_t dl_params;
+
+    memset(&dl_params, 0, sizeof(dl_params));
+    dl_params.max_tx_octets = data_length;
+    dl_params.max_rx_octets = data_length;
+    (void)sd_ble_gap_data_length_update(conn_handle, &dl_params, NULL);
+}
+
+static void on_connected_evt(nrf_ble_gatt_t *p_gatt, ble_evt_t const *p_ble_evt)
+{
+    uint16_t             conn_handle = p_ble_evt->evt.gap_evt.conn_handle;
+    nrf_ble_gatt_link_t *p_link      = &p_gatt->links[conn_handle];
+
+    link_init(p_link);
+    p_link->att_mtu_desired     = p_gatt->att_mtu_desired_periph;
+    p_link->data_length_desired = p_gatt->data_length;
+
+    if (p_link->att_mtu_desired > BLE_GATT_ATT_MTU_DEFAULT)
+    {
+        ret_code_t err_code = sd_ble_gattc_exchange_mtu_request(conn_handle, p_link->att_mtu_desired);
+        if (err_code == NRF_SUCCESS)
+        {
+            p_link->att_mtu_exchange_requested = true;
+        }
+        else if (err_code == NRF_ERROR_BUSY)
+        {
+            p_link->att_mtu_exchange_pending = true;
+        }
+    }
+
+    if (p_link->data_length_desired > BLE_GAP_DATA_LENGTH_DEFAULT)
+    {
+        data_length_update(conn_handle, p_link->data_length_desired);
+    }
+}
+
+static void evt_send(nrf_ble_gatt_t *p_gatt, nrf_ble_gatt_evt_t const *p_evt)
+{
+    if (p_gatt->evt_handler != NULL)
+    {
+        p_gatt->evt_handler(p_gatt, p_evt);
+    }
+}
+
+static void on_exchange_mtu_rsp_evt(nrf_ble_gatt_t *p_gatt, ble_evt_t const *p_ble_evt)
+{
+    uint16_t             conn_handle = p_ble_evt->evt.gattc_evt.conn_handle;
+    nrf_ble_gatt_link_t *p_link      = &p_gatt->links[conn_handle];
+    uint16_t             server_rx   = p_ble_evt->evt.gattc_evt.params.exchange_mtu_rsp.server_rx_mtu;
+
+    p_link->att_mtu_effective          = MAX(MIN(server_rx, p_link->att_mtu_desired), BLE_GATT_ATT_MTU_DEFAULT);
+    p_link->att_mtu_exchange_requested = false;
+
+    nrf_ble_gatt_evt_t evt;
+    evt.evt_id                   = NRF_BLE_GATT_EVT_ATT_MTU_UPDATED;
+    evt.conn_handle              = conn_handle;
+    evt.params.att_mtu_effective = p_link->att_mtu_effective;
+    evt_send(p_gatt, &evt);
+}
+
+static void on_exchange_mtu_request_evt(nrf_ble_gatt_t *p_gatt, ble_evt_t const *p_ble_evt)
+{
+    uint16_t             conn_handle = p_ble_evt->evt.gatts_evt.conn_handle;
+    nrf_ble_gatt_link_t *p_link      = &p_gatt->links[conn_handle];
+    uint16_t             client_rx   = p_ble_evt->evt.gatts_evt.params.exchange_mtu_request.client_rx_mtu;
+
+    p_link->att_mtu_effective = MAX(MIN(client_rx, p_link->att_mtu_desired), BLE_GATT_ATT_MTU_DEFAULT);
+    (void)sd_ble_gatts_exchange_mtu_reply(conn_handle, p_link->att_mtu_desired);
+    p_link->att_mtu_exchange_pending = false;
+
+    nrf_ble_gatt_evt_t evt;
+    evt.evt_id                   = NRF_BLE_GATT_EVT_ATT_MTU_UPDATED;
+    evt.conn_handle              = conn_handle;
+    evt.params.att_mtu_effective = p_link->att_mtu_effective;
+    evt_send(p_gatt, &evt);
+}
+
+static void on_data_length_update_evt(nrf_ble_gatt_t *p_gatt, ble_evt_t const *p_ble_evt)
+{
+    uint16_t conn_handle = p_ble_evt->evt.gap_evt.conn_handle;
+
+    p_gatt->links[conn_handle].data_length_effective =
+        (uint8_t)p_ble_evt->evt.gap_evt.params.data_length_update.effective_params.max_tx_octets;
+
+    nrf_ble_gatt_evt_t evt;
+    evt.evt_id             = NRF_BLE_GATT_EVT_DATA_LENGTH_UPDATED;
+    evt.conn_handle        = conn_handle;
+    evt.params.data_length = p_gatt->links[conn_handle].data_length_effective;
+    evt_send(p_gatt, &evt);
+}
+
+void nrf_ble_gatt_on_ble_evt(ble_evt_t const *p_ble_evt, void *p_context)
+{
+    nrf_ble_gatt_t *p_gatt      = (nrf_ble_gatt_t *)p_context;
+    uint16_t        conn_handle = p_ble_evt->evt.common_evt.conn_handle;
+
+    if (conn_handle >= NRF_BLE_GATT_LINK_COUNT)
+    {
+        return;
+    }
+
+    switch (p_ble_evt->header.evt_id)
+    {
+        case BLE_GAP_EVT_CONNECTED:
+            on_connected_evt(p_gatt, p_ble_evt);
+            break;
+
+        case BLE_GAP_EVT_DISCONNECTED:
+            link_init(&p_gatt->links[conn_handle]);
+            break;
+
+        case BLE_GATTC_EVT_EXCHANGE_MTU_RSP:
+            on_exchange_mtu_rsp_evt(p_gatt, p_ble_evt);
+            break;
+
+        case BLE_GATTS_EVT_EXCHANGE_MTU_REQUEST:
+            on_exchange_mtu_request_evt(p_gatt, p_ble_evt);
+            break;
+
+        case BLE_GAP_EVT_DATA_LENGTH_UPDATE:
+            on_data_length_update_evt(p_gatt, p_ble_evt);
+            break;
+
+        case BLE_GAP_EVT_DATA_LENGTH_UPDATE_REQUEST:
+            data_length_update(conn_handle, p_gatt->links[conn_handle].data_length_desired);
+            break;
+
+        default:
+            break;
+    }
+
+    if (p_gatt->links[conn_handle].att_mtu_exchange_pending)
+    {
+        ret_code_t err_code = sd_ble_gattc_exchange_mtu_request(conn_handle, p_gatt->links[conn_handle].att_mtu_desired);
+        if (err_code == NRF_SUCCESS)
+        {
+            p_gatt->links[conn_handle].att_mtu_exchange_pending   = false;
+            p_gatt->links[conn_handle].att_mtu_exchange_requested = true;
+        }
+    }
+}
@@ -0,0 +1,307 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#include <string.h>
+
+#include "nrf_ble_qwr.h"
+
+ret_code_t nrf_ble_qwr_init(nrf_ble_qwr_t *p_qwr, nrf_ble_qwr_init_t const *p_qwr_init)
+{
+    if (p_qwr == NULL || p_qwr_init == NULL)
+    {
+        return NRF_ERROR_NULL;
+    }
+    if (p_qwr->initialized)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+
+    p_qwr->error_handler = p_qwr_init->error_handler;
+    p_qwr->initialized   = 1;
+    p_qwr->conn_handle   = BLE_CONN_HANDLE_INVALID;
+#if (NRF_BLE_QWR_MAX_ATTR > 0)
+    memset(p_qwr->attr_handles, 0, sizeof(p_qwr->attr_handles));
+    p_qwr->nb_registered_attr        = 0;
+    p_qwr->nb_written_handles        = 0;
+    p_qwr->is_user_mem_reply_pending = false;
+    p_qwr->mem_buffer                = p_qwr_init->mem_buffer;
+    p_qwr->callback                  = p_qwr_init->callback;
+#endif
+    return NRF_SUCCESS;
+}
+
+ret_code_t nrf_ble_qwr_conn_handle_assign(nrf_ble_qwr_t *p_qwr, uint16_t conn_handle)
+{
+    if (p_qwr == NULL)
+    {
+        return NRF_ERROR_NULL;
+    }
+    if (!p_qwr->initialized)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+
+    p_qwr->conn_handle = conn_handle;
+    return NRF_SUCCESS;
+}
+
+#if (NRF_BLE_QWR_MAX_ATTR > 0)
+
+ret_code_t nrf_ble_qwr_attr_register(nrf_ble_qwr_t *p_qwr, uint16_t attr_handle)
+{
+    if (p_qwr == NULL)
+    {
+        return NRF_ERROR_NULL;
+    }
+    if (!p_qwr->initialized)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+    if (p_qwr->nb_registered_attr == NRF_BLE_QWR_MAX_ATTR || p_qwr->mem_buffer.p_mem == NULL ||
+        p_qwr->mem_buffer.len == 0)
+    {
+        return NRF_ERROR_NO_MEM;
+    }
+    if (attr_handle == BLE_GATT_HANDLE_INVALID)
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+
+    p_qwr->attr_handles[p_qwr->nb_registered_attr++] = attr_handle;
+    return NRF_SUCCESS;
+}
+
+ret_code_t nrf_ble_qwr_value_get(nrf_ble_qwr_t *p_qwr, uint16_t attr_handle, uint8_t *p_mem, uint16_t *p_len)
+{
+    if (p_qwr == NULL || p_mem == NULL || p_len == NULL)
+    {
+        return NRF_ERROR_NULL;
+    }
+    if (!p_qwr->initialized)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+
+    uint16_t i       = 0;
+    uint16_t cur_len = 0;
+
+    do
+    {
+        uint16_t handle = uint16_decode(&p_qwr->mem_buffer.p_mem[i]);
+        if (handle == BLE_GATT_HANDLE_INVALID)
+        {
+            break;
+        }
+        i += sizeof(uint16_t);
+        uint16_t val_offset = uint16_decode(&p_qwr->mem_buffer.p_mem[i]);
+        i += sizeof(uint16_t);
+        uint16_t val_len = uint16_decode(&p_qwr->mem_buffer.p_mem[i]);
+        i += sizeof(uint16_t);
+
+        if (handle == attr_handle)
+        {
+            cur_len = val_offset + val_len;
+            if (cur_len > *p_len)
+            {
+                return NRF_ERROR_NO_MEM;
+            }
+            memcpy(p_mem + val_offset, &p_qwr->mem_buffer.p_mem[i], val_len);
+        }
+        i += val_len;
+    }
+    while (i < p_qwr->mem_buffer.len);
+
+    *p_len = cur_len;
+    return NRF_SUCCESS;
+}
+
+static void user_mem_reserve(nrf_ble_qwr_t *p_qwr)
+{
+    ret_code_t err_code = sd_ble_user_mem_reply(p_qwr->conn_handle, &p_qwr->mem_buffer);
+
+    if (err_code == NRF_SUCCESS)
+    {
+        p_qwr->is_user_mem_reply_pending = false;
+    }
+    else if (err_code == NRF_ERROR_BUSY)
+    {
+        p_qwr->is_user_mem_reply_pending = true;
+    }
+    else if (p_qwr->error_handler != NULL)
+    {
+        p_qwr->error_handler(err_code);
+    }
+}
+
+static void auth_reply(nrf_ble_qwr_t *p_qwr, ble_gatts_rw_authorize_reply_params_t const *p_reply)
+{
+    ret_code_t err_code = sd_ble_gatts_rw_authorize_reply(p_qwr->conn_handle, p_reply);
+
+    if (err_code != NRF_SUCCESS && p_qwr->error_handler != NULL)
+    {
+        p_qwr->error_handler(err_code);
+    }
+}
+
+static void on_rw_authorize_request(nrf_ble_qwr_t *p_qwr, ble_evt_t const *p_ble_evt)
+{
+    ble_gatts_evt_rw_authorize_request_t const *p_auth_req = &p_ble_evt->evt.gatts_evt.params.authorize_request;
+    ble_gatts_rw_authorize_reply_params_t       reply;
+
+    if (p_auth_req->type != BLE_GATTS_AUTHORIZE_TYPE_WRITE)
+    {
+        return;
+    }
+
+    memset(&reply, 0, sizeof(reply));
+    reply.type                     = BLE_GATTS_AUTHORIZE_TYPE_WRITE;
+    reply.params.write.gatt_status = BLE_GATT_STATUS_SUCCESS;
+
+    switch (p_auth_req->request.write.op)
+    {
+        case BLE_GATTS_OP_PREP_WRITE_REQ:
+        {
+            uint16_t handle = p_auth_req->request.write.handle;
+            bool     known  = false;
+
+            for (uint8_t i = 0; i < p_qwr->nb_registered_attr; i++)
+            {
+                known = known || (p_qwr->attr_handles[i] == handle);
+            }
+            if (!known)
+            {
+                reply.params.write.gatt_status = NRF_BLE_QWR_REJ_REQUEST_ERR_CODE;
+                auth_reply(p_qwr, &reply);
+                return;
+            }
+
+            bool written = false;
+            for (uint8_t i = 0; i < p_qwr->nb_written_handles; i++)
+            {
+                written = written || (p_qwr->written_attr_handles[i] == handle);
+            }
+            if (!written)
+            {
+                p_qwr->written_attr_handles[p_qwr->nb_written_handles++] = handle;
+            }
+            auth_reply(p_qwr, &reply);
+            break;
+        }
+
+        case BLE_GATTS_OP_EXEC_WRITE_REQ_NOW:
+        {
+            nrf_ble_qwr_evt_t evt;
+
+            for (uint8_t i = 0; i < p_qwr->nb_written_handles && p_qwr->callback != NULL; i++)
+            {
+                evt.evt_type    = NRF_BLE_QWR_EVT_AUTH_REQUEST;
+                evt.attr_handle = p_qwr->written_attr_handles[i];
+                uint16_t status = p_qwr->callback(p_qwr, &evt);
+                if (status != BLE_GATT_STATUS_SUCCESS)
+                {
+                    reply.params.write.gatt_status = status;
+                }
+            }
+
+            auth_reply(p_qwr, &reply);
+
+            if (reply.params.write.gatt_status == BLE_GATT_STATUS_SUCCESS)
+            {
+                for (uint8_t i = 0; i < p_qwr->nb_written_handles && p_qwr->callback != NULL; i++)
+                {
+                    evt.evt_type    = NRF_BLE_QWR_EVT_EXECUTE_WRITE;
+                    evt.attr_handle = p_qwr->written_attr_handles[i];
+                    (void)p_qwr->callback(p_qwr, &evt);
+                }
+            }
+            p_qwr->nb_written_handles = 0;
+            break;
+        }
+
+        case BLE_GATTS_OP_EXEC_WRITE_REQ_CANCEL:
+            p_qwr->nb_written_handles = 0;
+            auth_reply(p_qwr, &reply);
+            break;
+
+        default:
+            break;
+    }
+}
+
+#endif // NRF_BLE_QWR_MAX_ATTR > 0
+
+void nrf_ble_qwr_on_ble_evt(ble_evt_t const *p_ble_evt, void *p_context)
+{
+    nrf_ble_qwr_t *p_qwr = (nrf_ble_qwr_t *)p_context;
+
+    if (p_qwr == NULL || !p_qwr->initialized || p_ble_evt->evt.gatts_evt.conn_handle != p_qwr->conn_handle)
+    {
+        return;
+    }
+
+    switch (p_ble_evt->header.evt_id)
+    {
+        case BLE_EVT_USER_MEM_REQUEST:
+#if (NRF_BLE_QWR_MAX_ATTR > 0)
+            if (p_ble_evt->evt.common_evt.params.user_mem_request.type == BLE_USER_MEM_TYPE_GATTS_QUEUED_WRITES)
+            {
+                user_mem_reserve(p_qwr);
+            }
+#else
+            {
+                ret_code_t err_code = sd_ble_user_mem_reply(p_qwr->conn_handle, NULL);
+                if (err_code != NRF_SUCCESS && p_qwr->error_handler != NULL)
+                {
+                    p_qwr->error_handler(err_code);
+                }
+            }
+#endif
+            break;
+
+        case BLE_GATTS_EVT_RW_AUTHORIZE_REQUEST:
+#if (NRF_BLE_QWR_MAX_ATTR > 0)
+            on_rw_authorize_request(p_qwr, p_ble_evt);
+#endif
+            break;
+
+        case BLE_GAP_EVT_DISCONNECTED:
+            p_qwr->conn_handle = BLE_CONN_HANDLE_INVALID;
+            break;
+
+        default:
+#if (NRF_BLE_QWR_MAX_ATTR > 0)
+            if (p_qwr->is_user_mem_reply_pending)
+            {
+                user_mem_reserve(p_qwr);
+            }
+#endif
+            break;
+    }
+}
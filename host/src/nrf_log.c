@@ -0,0 +1,79 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#include <stdarg.h>
+#include <stdio.h>
+
+#include "nrf_log.h"
+#include "sim.h"
+#include "sim_internal.h"
+
+static bool     m_verbose;
+static uint32_t m_counts[NRF_LOG_SEVERITY_DEBUG + 1];
+
+void sim_log_reset(void)
+{
+    for (uint32_t i = 0; i < NRF_LOG_SEVERITY_DEBUG + 1; i++)
+    {
+        m_counts[i] = 0;
+    }
+}
+
+void sim_log_verbose_set(bool verbose)
+{
+    m_verbose = verbose;
+}
+
+uint32_t sim_log_count(uint8_t severity)
+{
+    return (severity <= NRF_LOG_SEVERITY_DEBUG) ? m_counts[severity] : 0;
+}
+
+void nrf_log_frontend_std(nrf_log_severity_t severity, char const *p_str, ...)
+{
+    static char const * const prefixes[] = {"", "<error> ", "<warning> ", "<info> ", "<debug> "};
+
+    if (severity > NRF_LOG_SEVERITY_DEBUG)
+    {
+        return;
+    }
+    m_counts[severity]++;
+
+    if (m_verbose)
+    {
+        va_list args;
+
+        va_start(args, p_str);
+        printf("[%10llu] %s", (unsigned long long)sim_now_ticks(), prefixes[severity]);
+        vprintf(p_str, args);
+        printf("\n");
+        va_end(args);
+    }
+}
@@ -0,0 +1,214 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#include <string.h>
+
+#include "nordic_common.h"
+#include "nrf_error.h"
+#include "nrf_ringbuf.h"
+
+#define WR_OFFSET 0
+#define RD_OFFSET 1
+
+void nrf_ringbuf_init(nrf_ringbuf_t const *p_ringbuf)
+{
+    p_ringbuf->p_cb->wr_idx     = 0;
+    p_ringbuf->p_cb->rd_idx     = 0;
+    p_ringbuf->p_cb->tmp_rd_idx = 0;
+    p_ringbuf->p_cb->tmp_wr_idx = 0;
+    p_ringbuf->p_cb->rd_flag    = 0;
+    p_ringbuf->p_cb->wr_flag    = 0;
+}
+
+ret_code_t nrf_ringbuf_alloc(nrf_ringbuf_t const *p_ringbuf, uint8_t **pp_data, size_t *p_length, bool start)
+{
+    if (start)
+    {
+        if (nrf_atomic_flag_set_fetch(&p_ringbuf->p_cb->wr_flag))
+        {
+            return NRF_ERROR_BUSY;
+        }
+    }
+
+    if (p_ringbuf->p_cb->tmp_wr_idx - p_ringbuf->p_cb->rd_idx == p_ringbuf->bufsize_mask + 1)
+    {
+        *p_length = 0;
+        if (start)
+        {
+            (void)nrf_atomic_flag_clear(&p_ringbuf->p_cb->wr_flag);
+        }
+        return NRF_SUCCESS;
+    }
+
+    uint32_t wr_idx   = p_ringbuf->p_cb->tmp_wr_idx & p_ringbuf->bufsize_mask;
+    uint32_t rd_idx   = p_ringbuf->p_cb->rd_idx & p_ringbuf->bufsize_mask;
+    uint32_t available = (wr_idx >= rd_idx) ? p_ringbuf->bufsize_mask + 1 - wr_idx
+                                            : p_ringbuf->p_cb->rd_idx -
+                                                  (p_ringbuf->p_cb->tmp_wr_idx - (p_ringbuf->bufsize_mask + 1));
+
+    *p_length = MIN(*p_length, available);
+    *pp_data  = &p_ringbuf->p_buffer[wr_idx];
+    p_ringbuf->p_cb->tmp_wr_idx += *p_length;
+
+    return NRF_SUCCESS;
+}
+
+ret_code_t nrf_ringbuf_put(nrf_ringbuf_t const *p_ringbuf, size_t length)
+{
+    uint32_t available = p_ringbuf->bufsize_mask + 1 - (p_ringbuf->p_cb->wr_idx - p_ringbuf->p_cb->rd_idx);
+
+    if (length > available)
+    {
+        return NRF_ERROR_NO_MEM;
+    }
+
+    p_ringbuf->p_cb->wr_idx    += length;
+    p_ringbuf->p_cb->tmp_wr_idx = p_ringbuf->p_cb->wr_idx;
+    if (nrf_atomic_flag_clear_fetch(&p_ringbuf->p_cb->wr_flag) == 0)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+    return NRF_SUCCESS;
+}
+
+ret_code_t nrf_ringbuf_cpy_put(nrf_ringbuf_t const *p_ringbuf, uint8_t const *p_data, size_t *p_length)
+{
+    if (nrf_atomic_flag_set_fetch(&p_ringbuf->p_cb->wr_flag))
+    {
+        return NRF_ERROR_BUSY;
+    }
+
+    uint32_t available = p_ringbuf->bufsize_mask + 1 - (p_ringbuf->p_cb->wr_idx - p_ringbuf->p_cb->rd_idx);
+    *p_length          = available > *p_length ? *p_length : available;
+    size_t   length    = *p_length;
+    uint32_t masked_wr = p_ringbuf->p_cb->wr_idx & p_ringbuf->bufsize_mask;
+    uint32_t trail     = p_ringbuf->bufsize_mask + 1 - masked_wr;
+
+    if (length > trail)
+    {
+        memcpy(&p_ringbuf->p_buffer[masked_wr], p_data, trail);
+        memcpy(p_ringbuf->p_buffer, &p_data[trail], length - trail);
+    }
+    else
+    {
+        memcpy(&p_ringbuf->p_buffer[masked_wr], p_data, length);
+    }
+    p_ringbuf->p_cb->wr_idx    += length;
+    p_ringbuf->p_cb->tmp_wr_idx = p_ringbuf->p_cb->wr_idx;
+
+    (void)nrf_atomic_flag_clear(&p_ringbuf->p_cb->wr_flag);
+    return NRF_SUCCESS;
+}
+
+ret_code_t nrf_ringbuf_get(nrf_ringbuf_t const *p_ringbuf, uint8_t **pp_data, size_t *p_length, bool start)
+{
+    if (start)
+    {
+        if (nrf_atomic_flag_set_fetch(&p_ringbuf->p_cb->rd_flag))
+        {
+            *p_length = 0;
+            return NRF_ERROR_BUSY;
+        }
+    }
+
+    uint32_t available = p_ringbuf->p_cb->wr_idx - p_ringbuf->p_cb->tmp_rd_idx;
+    if (available == 0)
+    {
+        *p_length = 0;
+        if (start)
+        {
+            (void)nrf_atomic_flag_clear(&p_ringbuf->p_cb->rd_flag);
+        }
+        return NRF_SUCCESS;
+    }
+
+    uint32_t masked_rd = p_ringbuf->p_cb->tmp_rd_idx & p_ringbuf->bufsize_mask;
+    uint32_t masked_wr = p_ringbuf->p_cb->wr_idx & p_ringbuf->bufsize_mask;
+
+    if (masked_wr > masked_rd && available < p_ringbuf->bufsize_mask + 1)
+    {
+        available = masked_wr - masked_rd;
+    }
+    else
+    {
+        available = MIN(available, p_ringbuf->bufsize_mask + 1 - masked_rd);
+    }
+
+    *p_length = MIN(*p_length, available);
+    p_ringbuf->p_cb->tmp_rd_idx += *p_length;
+    *pp_data = &p_ringbuf->p_buffer[masked_rd];
+
+    return NRF_SUCCESS;
+}
+
+ret_code_t nrf_ringbuf_free(nrf_ringbuf_t const *p_ringbuf, size_t length)
+{
+    uint32_t available = p_ringbuf->p_cb->wr_idx - p_ringbuf->p_cb->rd_idx;
+
+    if (length > available)
+    {
+        return NRF_ERROR_NO_MEM;
+    }
+
+    p_ringbuf->p_cb->rd_idx    += length;
+    p_ringbuf->p_cb->tmp_rd_idx = p_ringbuf->p_cb->rd_idx;
+    (void)nrf_atomic_flag_clear(&p_ringbuf->p_cb->rd_flag);
+
+    return NRF_SUCCESS;
+}
+
+ret_code_t nrf_ringbuf_cpy_get(nrf_ringbuf_t const *p_ringbuf, uint8_t *p_data, size_t *p_length)
+{
+    if (nrf_atomic_flag_set_fetch(&p_ringbuf->p_cb->rd_flag))
+    {
+        return NRF_ERROR_BUSY;
+    }
+
+    uint32_t available = p_ringbuf->p_cb->wr_idx - p_ringbuf->p_cb->rd_idx;
+    *p_length          = available > *p_length ? *p_length : available;
+    size_t   length    = *p_length;
+    uint32_t masked_rd = p_ringbuf->p_cb->rd_idx & p_ringbuf->bufsize_mask;
+    uint32_t trail     = p_ringbuf->bufsize_mask + 1 - masked_rd;
+
+    if (length > trail)
+    {
+        memcpy(p_data, &p_ringbuf->p_buffer[masked_rd], trail);
+        memcpy(&p_data[trail], p_ringbuf->p_buffer, length - trail);
+    }
+    else
+    {
+        memcpy(p_data, &p_ringbuf->p_buffer[masked_rd], length);
+    }
+    p_ringbuf->p_cb->rd_idx    += length;
+    p_ringbuf->p_cb->tmp_rd_idx = p_ringbuf->p_cb->rd_idx;
+
+    (void)nrf_atomic_flag_clear(&p_ringbuf->p_cb->rd_flag);
+    return NRF_SUCCESS;
+}
@@ -0,0 +1,156 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "nrf_sdh.h"
+#include "nrf_sdh_ble.h"
+#include "nrf_sdh_soc.h"
+#include "sim_internal.h"
+
+#define SDH_OBSERVER_MAX    64
+
+/* Defined by the linker when at least one observer is registered */
+extern nrf_sdh_ble_evt_observer_t __start_sdh_ble_observers[] __attribute__((weak));
+extern nrf_sdh_ble_evt_observer_t __stop_sdh_ble_observers[] __attribute__((weak));
+
+static bool m_sdh_enabled;
+static nrf_sdh_ble_evt_observer_t *m_observers[SDH_OBSERVER_MAX];
+static uint32_t m_observer_count;
+
+void sim_sdh_reset(void)
+{
+    m_sdh_enabled    = false;
+    m_observer_count = 0;
+}
+
+/* The linker keeps observers in link order, the SDK sorts them by priority into subsections */
+static void observers_collect(void)
+{
+    nrf_sdh_ble_evt_observer_t *p_obs;
+
+    m_observer_count = 0;
+    for (uint32_t prio = 0; prio < NRF_SDH_BLE_OBSERVER_PRIO_LEVELS; prio++)
+    {
+        for (p_obs = __start_sdh_ble_observers; p_obs < __stop_sdh_ble_observers; p_obs++)
+        {
+            if (p_obs->prio == prio && m_observer_count < SDH_OBSERVER_MAX)
+            {
+                m_observers[m_observer_count++] = p_obs;
+            }
+        }
+    }
+}
+
+ret_code_t nrf_sdh_enable_request(void)
+{
+    if (m_sdh_enabled)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+
+    m_sdh_enabled = true;
+    observers_collect();
+    return NRF_SUCCESS;
+}
+
+ret_code_t nrf_sdh_disable_request(void)
+{
+    m_sdh_enabled = false;
+    return NRF_SUCCESS;
+}
+
+bool nrf_sdh_is_enabled(void)
+{
+    return m_sdh_enabled;
+}
+
+ret_code_t nrf_sdh_ble_default_cfg_set(uint8_t conn_cfg_tag, uint32_t *p_ram_start)
+{
+    ret_code_t err_code;
+    ble_cfg_t  ble_cfg;
+
+    if (p_ram_start == NULL)
+    {
+        return NRF_ERROR_NULL;
+    }
+    *p_ram_start = 0x20000000;
+
+    memset(&ble_cfg, 0, sizeof(ble_cfg));
+    ble_cfg.conn_cfg.conn_cfg_tag                     = conn_cfg_tag;
+    ble_cfg.conn_cfg.params.gap_conn_cfg.conn_count   = NRF_SDH_BLE_TOTAL_LINK_COUNT;
+    ble_cfg.conn_cfg.params.gap_conn_cfg.event_length = NRF_SDH_BLE_GAP_EVENT_LENGTH;
+    err_code = sd_ble_cfg_set(BLE_CONN_CFG_GAP, &ble_cfg, *p_ram_start);
+    if (err_code != NRF_SUCCESS)
+    {
+        return err_code;
+    }
+
+    memset(&ble_cfg, 0, sizeof(ble_cfg));
+    ble_cfg.conn_cfg.conn_cfg_tag                 = conn_cfg_tag;
+    ble_cfg.conn_cfg.params.gatt_conn_cfg.att_mtu = NRF_SDH_BLE_GATT_MAX_MTU_SIZE;
+    err_code = sd_ble_cfg_set(BLE_CONN_CFG_GATT, &ble_cfg, *p_ram_start);
+    if (err_code != NRF_SUCCESS)
+    {
+        return err_code;
+    }
+
+    memset(&ble_cfg, 0, sizeof(ble_cfg));
+    ble_cfg.gatts_cfg.attr_tab_size.attr_tab_size = NRF_SDH_BLE_GATTS_ATTR_TAB_SIZE;
+    return sd_ble_cfg_set(BLE_GATTS_CFG_ATTR_TAB_SIZE, &ble_cfg, *p_ram_start);
+}
+
+ret_code_t nrf_sdh_ble_enable(uint32_t *p_app_ram_start)
+{
+    (void)p_app_ram_start;
+
+    if (!m_sdh_enabled)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+    return sim_sd_ble_enable();
+}
+
+void nrf_sdh_ble_evt_dispatch(ble_evt_t const *p_ble_evt)
+{
+    if (!m_sdh_enabled)
+    {
+        return;
+    }
+
+    for (uint32_t i = 0; i < m_observer_count; i++)
+    {
+        if (m_observers[i]->handler != NULL)
+        {
+            m_observers[i]->handler(p_ble_evt, m_observers[i]->p_context);
+        }
+    }
+}
@@ -0,0 +1,2285 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "app_timer.h"
+#include "app_util.h"
+#include "ble.h"
+#include "ble_hci.h"
+#include "ble_srv_common.h"
+#include "nordic_common.h"
+#include "nrf_soc.h"
+#include "sdk_config.h"
+#include "sim.h"
+#include "sim_internal.h"
+
+#define SIM_VS_UUID_COUNT       10      /**< Vendor specific UUID bases the model accepts. */
+#define SIM_HVN_QUEUE_MAX       32      /**< Largest hvn_tx_queue_size the model supports. */
+#define SIM_L2CAP_TX_QUEUE_MAX  8       /**< SDUs the model queues per channel. */
+#define SIM_LL_IFS_US           150     /**< Inter frame space. */
+#define SIM_L2CAP_HEADER_LEN    4       /**< L2CAP header of an ATT PDU. */
+#define SIM_ATT_HVX_HEADER_LEN  3       /**< Opcode and handle of a notification or indication. */
+#define SIM_L2CAP_CID           0x40    /**< CID of the first dynamic L2CAP channel. */
+#define SIM_NS_PER_1_25_MS      1250000ULL
+#define SIM_ATTR_TAB_HEADER_LEN 8       /**< Attribute table bytes of an attribute besides its value. */
+#define SIM_GAP_DEVNAME_LEN     31      /**< Device name bytes the SoftDevice reserves by default. */
+
+#define SIM_EVT_LEN(_member)    ((uint16_t)(offsetof(ble_evt_t, evt) + sizeof(((ble_evt_t *)0)->evt._member)))
+
+/**@brief Kinds of attributes in the table. */
+typedef enum
+{
+    SIM_ATTR_SERVICE,
+    SIM_ATTR_CHAR_DECL,
+    SIM_ATTR_VALUE,
+    SIM_ATTR_USER_DESC,
+    SIM_ATTR_CCCD,
+} sim_attr_kind_t;
+
+/**@brief Attribute, the handle is its index plus one. */
+typedef struct
+{
+    sim_attr_kind_t       kind;
+    ble_uuid_t            uuid;
+    ble_gatt_char_props_t props;        /**< Properties of the characteristic, for the value and the CCCD. */
+    bool                  readable;
+    bool                  writable;
+    bool                  vlen;
+    bool                  rd_auth;
+    bool                  wr_auth;
+    uint16_t              max_len;
+    uint16_t              len;
+    uint8_t              *p_value;      /**< Value in user memory, or value below. */
+    uint8_t               value[BLE_GATTS_VAR_ATTR_LEN_MAX];
+} sim_attr_t;
+
+/**@brief Queued notification or indication. */
+typedef struct
+{
+    uint16_t handle;
+    uint8_t  type;
+    uint16_t len;
+    uint8_t  data[SIM_HVX_MAX_LEN];
+} sim_hvx_t;
+
+/**@brief LE credit-based L2CAP channel of a connection. */
+typedef struct
+{
+    bool       requested;               /**< The central asked for the channel. */
+    bool       open;
+    uint16_t   peer_mtu;                /**< SDU size the central receives. */
+    uint16_t   peer_credits;
+    ble_data_t rx_buf[SIM_L2CAP_TX_QUEUE_MAX];
+    uint8_t    rx_count;
+    ble_data_t tx_queue[SIM_L2CAP_TX_QUEUE_MAX];
+    uint8_t    tx_count;
+    uint32_t   received;                /**< Bytes the central received. */
+} sim_l2cap_t;
+
+/**@brief Connection. */
+typedef struct
+{
+    bool                  in_use;       /**< Handle allocated, until BLE_GAP_EVT_DISCONNECTED is dispatched. */
+    bool                  connected;    /**< Link up, false once a disconnection is queued. */
+    sim_central_t         central;
+    ble_gap_conn_params_t params;
+    uint16_t              att_mtu;
+    bool                  mtu_exchanged;
+    bool                  mtu_request_pending;  /**< The central waits for sd_ble_gatts_exchange_mtu_reply(). */
+    uint8_t               data_length;
+    uint8_t               phy;
+    bool                  sys_attr_set;
+    uint64_t              anchor_ns;    /**< Time of a connection event, the others follow every interval. */
+    uint64_t              last_event_ns; /**< Time of the last connection event that ran, UINT64_MAX if none. */
+
+    bool                  cp_pending;   /**< Connection parameter update waits for its instant. */
+    bool                  cp_accepted;  /**< The central granted it. */
+    uint64_t              cp_instant_ns;
+    ble_gap_conn_params_t cp_params;
+    uint16_t              cccd[SIM_ATTR_COUNT + 1];
+
+    sim_hvx_t             hvn[SIM_HVN_QUEUE_MAX];
+    uint8_t               hvn_head;
+    uint8_t               hvn_count;
+    sim_hvx_t             ind;
+    bool                  ind_queued;   /**< Indication waits for a connection event. */
+    bool                  ind_sent;     /**< Indication sent, confirmed in the next connection event. */
+
+    uint8_t               auth_type;    /**< Authorization request waiting for a reply. */
+    uint8_t               auth_op;
+    uint16_t              auth_handle;
+    uint16_t              auth_offset;
+    uint16_t              auth_status;
+    bool                  auth_replied;
+    uint8_t               read_data[BLE_GATTS_VAR_ATTR_LEN_MAX];
+    uint16_t              read_len;
+    bool                  read_done;
+
+    ble_user_mem_block_t  user_mem;
+    bool                  user_mem_set;
+
+    sim_l2cap_t           l2cap;
+} sim_conn_t;
+
+static bool                 m_enabled;
+static uint8_t              m_conn_count;
+static uint16_t             m_event_length;
+static uint8_t              m_hvn_queue_size;
+static uint16_t             m_att_mtu_max;
+static ble_l2cap_conn_cfg_t m_l2cap_cfg;
+static bool                 m_conn_evt_ext;
+
+static ble_uuid128_t        m_vs_uuids[SIM_VS_UUID_COUNT];
+static uint8_t              m_vs_uuid_count;
+
+static uint8_t              m_device_name[BLE_GAP_DEVNAME_MAX_LEN];
+static uint16_t             m_device_name_len;
+static uint16_t             m_appearance;
+static ble_gap_conn_params_t m_ppcp;
+
+static bool                 m_adv_configured;
+static bool                 m_advertising;
+static ble_gap_adv_params_t m_adv_params;
+static ble_gap_adv_data_t   m_adv_data;
+static uint64_t             m_adv_end_ns;   /**< Time advertising times out, UINT64_MAX without a duration. */
+
+static sim_attr_t           m_attrs[SIM_ATTR_COUNT];
+static uint16_t             m_attr_count;
+static uint32_t             m_attr_tab_size;
+static uint32_t             m_attr_tab_used;
+
+static sim_conn_t           m_conns[SIM_LINK_COUNT];
+
+void sim_sd_reset(void)
+{
+    m_enabled        = false;
+    m_conn_count     = BLE_GAP_CONN_COUNT_DEFAULT;
+    m_event_length   = BLE_GAP_EVENT_LENGTH_DEFAULT;
+    m_hvn_queue_size = BLE_GATTS_HVN_TX_QUEUE_SIZE_DEFAULT;
+    m_att_mtu_max    = BLE_GATT_ATT_MTU_DEFAULT;
+    m_conn_evt_ext   = false;
+    m_vs_uuid_count  = 0;
+    m_appearance     = BLE_APPEARANCE_UNKNOWN;
+    m_adv_configured = false;
+    m_advertising    = false;
+    m_attr_count     = 0;
+    m_attr_tab_size  = BLE_GATTS_ATTR_TAB_SIZE_DEFAULT;
+    m_attr_tab_used  = 0;
+
+    memset(&m_l2cap_cfg, 0, sizeof(m_l2cap_cfg));
+    memset(&m_ppcp, 0, sizeof(m_ppcp));
+    memset(&m_adv_params, 0, sizeof(m_adv_params));
+    memset(&m_adv_data, 0, sizeof(m_adv_data));
+    memset(m_conns, 0, sizeof(m_conns));
+
+    m_device_name_len = strlen(BLE_GAP_DEVNAME_DEFAULT);
+    memcpy(m_device_name, BLE_GAP_DEVNAME_DEFAULT, m_device_name_len);
+}
+
+static sim_conn_t * conn_get(uint16_t conn_handle)
+{
+    if (conn_handle >= SIM_LINK_COUNT || !m_conns[conn_handle].connected)
+    {
+        return NULL;
+    }
+    return &m_conns[conn_handle];
+}
+
+static sim_attr_t * attr_get(uint16_t handle)
+{
+    if (handle == BLE_GATT_HANDLE_INVALID || handle > m_attr_count)
+    {
+        return NULL;
+    }
+    return &m_attrs[handle - 1];
+}
+
+static uint32_t conn_link_count(void)
+{
+    uint32_t count = 0;
+
+    for (uint32_t i = 0; i < SIM_LINK_COUNT; i++)
+    {
+        count += m_conns[i].in_use ? 1 : 0;
+    }
+    return count;
+}
+
+static bool uuid_valid(ble_uuid_t const *p_uuid)
+{
+    return (p_uuid->type == BLE_UUID_TYPE_BLE) ||
+           ((p_uuid->type >= BLE_UUID_TYPE_VENDOR_BEGIN) &&
+            (p_uuid->type < BLE_UUID_TYPE_VENDOR_BEGIN + m_vs_uuid_count));
+}
+
+static sim_attr_t * attr_add(sim_attr_kind_t kind, uint16_t uuid, uint8_t uuid_type)
+{
+    if (m_attr_count == SIM_ATTR_COUNT)
+    {
+        return NULL;
+    }
+
+    sim_attr_t *p_attr = &m_attrs[m_attr_count++];
+    memset(p_attr, 0, sizeof(*p_attr));
+    p_attr->kind      = kind;
+    p_attr->uuid.uuid = uuid;
+    p_attr->uuid.type = uuid_type;
+    p_attr->readable  = true;
+    p_attr->p_value   = p_attr->value;
+    return p_attr;
+}
+
+static void attr_perms_set(sim_attr_t *p_attr, ble_gatts_attr_md_t const *p_md)
+{
+    p_attr->readable = (p_md->read_perm.sm != 0);
+    p_attr->writable = (p_md->write_perm.sm != 0);
+    p_attr->vlen     = p_md->vlen;
+    p_attr->rd_auth  = p_md->rd_auth;
+    p_attr->wr_auth  = p_md->wr_auth;
+}
+
+/* Attribute table bytes of an attribute holding value_len bytes in the table. The layout is not
+ * documented, so this model errs on the large side: a header per attribute and every value
+ * rounded up to a word. BLE_GATTS_VLOC_STACK values take max_len, user memory values nothing. */
+static uint32_t attr_tab_len(uint16_t value_len)
+{
+    return SIM_ATTR_TAB_HEADER_LEN + ALIGN_NUM(4, value_len);
+}
+
+/* Bytes of a 16-bit or vendor specific UUID in a declaration */
+static uint16_t attr_uuid_len(uint8_t uuid_type)
+{
+    return (uuid_type == BLE_UUID_TYPE_BLE) ? 2 : 16;
+}
+
+/* Default GAP and GATT services the SoftDevice puts in front of the application's */
+static void attr_table_init(void)
+{
+    static const uint16_t gap_chars[]     = { 0x2A00, 0x2A01, 0x2A04, 0x2AA6 };
+    static const uint16_t gap_value_len[] = { SIM_GAP_DEVNAME_LEN, 2, 8, 1 };
+
+    // Both service declarations, the GAP characteristics and Service Changed with its CCCD
+    m_attr_tab_used = 2 * attr_tab_len(2) + attr_tab_len(5) + attr_tab_len(4) + attr_tab_len(BLE_CCCD_VALUE_LEN);
+    for (uint32_t i = 0; i < ARRAY_SIZE(gap_chars); i++)
+    {
+        m_attr_tab_used += attr_tab_len(5) + attr_tab_len(gap_value_len[i]);
+    }
+
+    attr_add(SIM_ATTR_SERVICE, BLE_UUID_GAP, BLE_UUID_TYPE_BLE);
+    for (uint32_t i = 0; i < ARRAY_SIZE(gap_chars); i++)
+    {
+        attr_add(SIM_ATTR_CHAR_DECL, BLE_UUID_CHARACTERISTIC, BLE_UUID_TYPE_BLE);
+        sim_attr_t *p_value = attr_add(SIM_ATTR_VALUE, gap_chars[i], BLE_UUID_TYPE_BLE);
+        p_value->props.read = 1;
+    }
+    attr_add(SIM_ATTR_SERVICE, BLE_UUID_GATT, BLE_UUID_TYPE_BLE);
+}
+
+uint32_t sim_sd_ble_enable(void)
+{
+    if (m_enabled)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+
+    m_enabled = true;
+    attr_table_init();
+    return NRF_SUCCESS;
+}
+
+/* Air time of one LL data PDU with the empty PDU the central answers it with */
+static uint32_t ll_pdu_pair_us(uint8_t phy, uint32_t payload)
+{
+    switch (phy)
+    {
+        case BLE_GAP_PHY_2MBPS:
+            return (2 + 4 + 2 + payload + 3) * 4 + SIM_LL_IFS_US + (2 + 4 + 2 + 3) * 4 + SIM_LL_IFS_US;
+
+        case BLE_GAP_PHY_CODED:
+            return 376 + (2 + payload + 3) * 64 + SIM_LL_IFS_US + 376 + (2 + 3) * 64 + SIM_LL_IFS_US;
+
+        default:
+            return (1 + 4 + 2 + payload + 3) * 8 + SIM_LL_IFS_US + (1 + 4 + 2 + 3) * 8 + SIM_LL_IFS_US;
+    }
+}
+
+/* Air time of an L2CAP SDU of sdu_len bytes, fragmented into LL PDUs */
+static uint32_t sdu_air_us(sim_conn_t const *p_conn, uint32_t sdu_len)
+{
+    uint32_t total = sdu_len + SIM_L2CAP_HEADER_LEN;
+    uint32_t time  = 0;
+
+    while (total > 0)
+    {
+        uint32_t payload = MIN(total, (uint32_t)p_conn->data_length);
+        time  += ll_pdu_pair_us(p_conn->phy, payload);
+        total -= payload;
+    }
+    return time;
+}
+
+static uint64_t conn_interval_ns(sim_conn_t const *p_conn)
+{
+    return (uint64_t)p_conn->params.max_conn_interval * SIM_NS_PER_1_25_MS;
+}
+
+/* Radio time a connection event of the link gets, shared with the other links */
+static uint32_t conn_event_budget_us(sim_conn_t const *p_conn)
+{
+    uint32_t interval_us = (uint32_t)p_conn->params.max_conn_interval * 1250;
+    uint32_t share_us    = interval_us / MAX(conn_link_count(), 1);
+
+    if (m_conn_evt_ext)
+    {
+        return share_us;
+    }
+    return MIN((uint32_t)m_event_length * 1250, share_us);
+}
+
+static void rx_deliver(sim_conn_t *p_conn, uint16_t conn_handle, sim_hvx_t const *p_hvx)
+{
+    static sim_rx_t rx;
+
+    rx.time_ns     = sim_now_ns();
+    rx.conn_handle = conn_handle;
+    rx.handle      = p_hvx->handle;
+    rx.type        = p_hvx->type;
+    rx.len         = p_hvx->len;
+    memcpy(rx.data, p_hvx->data, p_hvx->len);
+
+    sim_rx_log(&rx);
+    if (p_conn->central.rx_handler != NULL)
+    {
+        p_conn->central.rx_handler(&rx, p_conn->central.p_context);
+    }
+}
+
+uint32_t sim_conn_event(uint16_t conn_handle)
+{
+    sim_conn_t *p_conn = conn_get(conn_handle);
+    ble_evt_t   evt;
+    uint32_t    sent = 0;
+
+    if (p_conn == NULL)
+    {
+        return 0;
+    }
+
+    uint32_t budget_us = conn_event_budget_us(p_conn);
+    uint32_t used_us   = 0;
+
+    p_conn->last_event_ns = sim_now_ns();
+
+    if (p_conn->ind_sent)
+    {
+        p_conn->ind_sent = false;
+
+        memset(&evt, 0, sizeof(evt));
+        evt.header.evt_id                     = BLE_GATTS_EVT_HVC;
+        evt.evt.gatts_evt.conn_handle         = conn_handle;
+        evt.evt.gatts_evt.params.hvc.handle   = p_conn->ind.handle;
+        sim_evt_push(&evt, SIM_EVT_LEN(gatts_evt));
+        used_us += ll_pdu_pair_us(p_conn->phy, SIM_L2CAP_HEADER_LEN + 1);
+    }
+
+    if (p_conn->ind_queued)
+    {
+        p_conn->ind_queued = false;
+        p_conn->ind_sent   = true;
+        used_us += sdu_air_us(p_conn, p_conn->ind.len + SIM_ATT_HVX_HEADER_LEN);
+        rx_deliver(p_conn, conn_handle, &p_conn->ind);
+    }
+
+    while (p_conn->hvn_count > 0)
+    {
+        sim_hvx_t const *p_hvx = &p_conn->hvn[p_conn->hvn_head];
+        uint32_t         air   = sdu_air_us(p_conn, p_hvx->len + SIM_ATT_HVX_HEADER_LEN);
+
+        // The first PDU of an event is always sent, the rest only if they fit
+        if (used_us > 0 && used_us + air > budget_us)
+        {
+            break;
+        }
+
+        used_us += air;
+        rx_deliver(p_conn, conn_handle, p_hvx);
+        p_conn->hvn_head = (p_conn->hvn_head + 1) % SIM_HVN_QUEUE_MAX;
+        p_conn->hvn_count--;
+        sent++;
+    }
+
+    if (sent > 0)
+    {
+        memset(&evt, 0, sizeof(evt));
+        evt.header.evt_id                               = BLE_GATTS_EVT_HVN_TX_COMPLETE;
+        evt.evt.gatts_evt.conn_handle                   = conn_handle;
+        evt.evt.gatts_evt.params.hvn_tx_complete.count  = (uint8_t)sent;
+        sim_evt_push(&evt, SIM_EVT_LEN(gatts_evt));
+    }
+
+    sim_l2cap_t *p_l2cap = &p_conn->l2cap;
+    while (p_l2cap->tx_count > 0 && p_l2cap->peer_credits > 0)
+    {
+        uint32_t air = sdu_air_us(p_conn, p_l2cap->tx_queue[0].len + 2);
+        if (used_us > 0 && used_us + air > budget_us)
+        {
+            break;
+        }
+
+        used_us += air;
+        p_l2cap->received += p_l2cap->tx_queue[0].len;
+        p_l2cap->peer_credits--;
+
+        memset(&evt, 0, sizeof(evt));
+        evt.header.evt_id                         = BLE_L2CAP_EVT_CH_TX;
+        evt.evt.l2cap_evt.conn_handle             = conn_handle;
+        evt.evt.l2cap_evt.local_cid               = SIM_L2CAP_CID;
+        evt.evt.l2cap_evt.params.tx.sdu_buf       = p_l2cap->tx_queue[0];
+        sim_evt_push(&evt, SIM_EVT_LEN(l2cap_evt));
+
+        memmove(&p_l2cap->tx_queue[0], &p_l2cap->tx_queue[1], (p_l2cap->tx_count - 1) * sizeof(ble_data_t));
+        p_l2cap->tx_count--;
+
+        if (p_l2cap->peer_credits == 0)
+        {
+            // The central hands credits back once it has consumed the SDUs
+            p_l2cap->peer_credits = 1;
+
+            memset(&evt, 0, sizeof(evt));
+            evt.header.evt_id                       = BLE_L2CAP_EVT_CH_CREDIT;
+            evt.evt.l2cap_evt.conn_handle           = conn_handle;
+            evt.evt.l2cap_evt.local_cid             = SIM_L2CAP_CID;
+            evt.evt.l2cap_evt.params.credit.credits = 1;
+            sim_evt_push(&evt, SIM_EVT_LEN(l2cap_evt));
+        }
+    }
+
+    sim_process();
+    return sent;
+}
+
+/* Connection has data to send in its next connection event */
+static bool conn_tx_pending(sim_conn_t const *p_conn)
+{
+    return (p_conn->hvn_count > 0) || p_conn->ind_queued || p_conn->ind_sent ||
+           (p_conn->l2cap.tx_count > 0 && p_conn->l2cap.peer_credits > 0);
+}
+
+/* Time of the first connection event at or after now that has not run yet */
+static uint64_t conn_next_event_ns(sim_conn_t const *p_conn)
+{
+    uint64_t now_ns      = sim_now_ns();
+    uint64_t interval_ns = conn_interval_ns(p_conn);
+    uint64_t event_ns    = p_conn->anchor_ns;
+
+    if (now_ns > event_ns)
+    {
+        event_ns += (now_ns - event_ns + interval_ns - 1) / interval_ns * interval_ns;
+    }
+    if (p_conn->last_event_ns != UINT64_MAX && event_ns <= p_conn->last_event_ns)
+    {
+        event_ns += interval_ns;
+    }
+    return event_ns;
+}
+
+/* Connection parameter update reaching its instant */
+static void conn_param_update_apply(uint16_t conn_handle, sim_conn_t *p_conn)
+{
+    ble_evt_t evt;
+
+    p_conn->cp_pending = false;
+    if (p_conn->cp_accepted)
+    {
+        p_conn->params    = p_conn->cp_params;
+        p_conn->anchor_ns = p_conn->cp_instant_ns;
+    }
+
+    memset(&evt, 0, sizeof(evt));
+    evt.header.evt_id                                       = BLE_GAP_EVT_CONN_PARAM_UPDATE;
+    evt.evt.gap_evt.conn_handle                             = conn_handle;
+    evt.evt.gap_evt.params.conn_param_update.conn_params    = p_conn->params;
+    sim_evt_push(&evt, SIM_EVT_LEN(gap_evt));
+}
+
+uint64_t sim_sd_next_ns(void)
+{
+    uint64_t next_ns = m_advertising ? m_adv_end_ns : UINT64_MAX;
+
+    for (uint16_t conn_handle = 0; conn_handle < SIM_LINK_COUNT; conn_handle++)
+    {
+        sim_conn_t const *p_conn = conn_get(conn_handle);
+        if (p_conn == NULL)
+        {
+            continue;
+        }
+        if (p_conn->cp_pending)
+        {
+            next_ns = MIN(next_ns, p_conn->cp_instant_ns);
+        }
+        if (conn_tx_pending(p_conn))
+        {
+            next_ns = MIN(next_ns, conn_next_event_ns(p_conn));
+        }
+    }
+    return next_ns;
+}
+
+void sim_sd_run(void)
+{
+    uint64_t  now_ns = sim_now_ns();
+    ble_evt_t evt;
+
+    if (m_advertising && m_adv_end_ns <= now_ns)
+    {
+        m_advertising = false;
+
+        memset(&evt, 0, sizeof(evt));
+        evt.header.evt_id                                   = BLE_GAP_EVT_ADV_SET_TERMINATED;
+        evt.evt.gap_evt.conn_handle                         = BLE_CONN_HANDLE_INVALID;
+        evt.evt.gap_evt.params.adv_set_terminated.reason    = BLE_GAP_EVT_ADV_SET_TERMINATED_REASON_TIMEOUT;
+        evt.evt.gap_evt.params.adv_set_terminated.adv_handle = 0;
+        evt.evt.gap_evt.params.adv_set_terminated.adv_data  = m_adv_data;
+        sim_evt_push(&evt, SIM_EVT_LEN(gap_evt));
+        sim_process();
+    }
+
+    for (uint16_t conn_handle = 0; conn_handle < SIM_LINK_COUNT && !sim_system_off(); conn_handle++)
+    {
+        sim_conn_t *p_conn = conn_get(conn_handle);
+        if (p_conn == NULL)
+        {
+            continue;
+        }
+        if (p_conn->cp_pending && p_conn->cp_instant_ns <= now_ns)
+        {
+            conn_param_update_apply(conn_handle, p_conn);
+            sim_process();
+        }
+        if (conn_get(conn_handle) != NULL && conn_tx_pending(p_conn) && conn_next_event_ns(p_conn) <= now_ns)
+        {
+            (void)sim_conn_event(conn_handle);
+        }
+    }
+}
+
+void sim_sd_evt_dispatching(ble_evt_t const *p_ble_evt)
+{
+    uint16_t conn_handle = p_ble_evt->evt.gap_evt.conn_handle;
+
+    if (p_ble_evt->header.evt_id == BLE_GAP_EVT_DISCONNECTED && conn_handle < SIM_LINK_COUNT)
+    {
+        // The handle can be reused once the application has been told
+        m_conns[conn_handle].in_use = false;
+    }
+}
+
+/* --- Central side ------------------------------------------------------------------------- */
+
+void sim_central_default(sim_central_t *p_central)
+{
+    memset(p_central, 0, sizeof(*p_central));
+    p_central->att_mtu            = 247;
+    p_central->data_length        = BLE_GAP_DATA_LENGTH_MAX;
+    p_central->phys               = BLE_GAP_PHY_1MBPS | BLE_GAP_PHY_2MBPS;
+    p_central->accept_conn_params = true;
+    p_central->min_conn_interval  = BLE_GAP_CP_MIN_CONN_INTVL_MIN;
+    p_central->max_conn_interval  = BLE_GAP_CP_MAX_CONN_INTVL_MAX;
+
+    p_central->conn_params.min_conn_interval = MSEC_TO_UNITS(30, UNIT_1_25_MS);
+    p_central->conn_params.max_conn_interval = MSEC_TO_UNITS(30, UNIT_1_25_MS);
+    p_central->conn_params.slave_latency     = 0;
+    p_central->conn_params.conn_sup_timeout  = MSEC_TO_UNITS(4000, UNIT_10_MS);
+}
+
+uint16_t sim_connect(sim_central_t const *p_central)
+{
+    sim_central_t central;
+    uint16_t      conn_handle;
+    ble_evt_t     evt;
+
+    if (p_central == NULL)
+    {
+        sim_central_default(&central);
+        p_central = &central;
+    }
+    if (!m_advertising)
+    {
+        return BLE_CONN_HANDLE_INVALID;
+    }
+
+    for (conn_handle = 0; conn_handle < SIM_LINK_COUNT; conn_handle++)
+    {
+        if (!m_conns[conn_handle].in_use)
+        {
+            break;
+        }
+    }
+    if (conn_handle == SIM_LINK_COUNT)
+    {
+        return BLE_CONN_HANDLE_INVALID;
+    }
+
+    sim_conn_t *p_conn = &m_conns[conn_handle];
+    memset(p_conn, 0, sizeof(*p_conn));
+    p_conn->in_use      = true;
+    p_conn->connected   = true;
+    p_conn->central     = *p_central;
+    p_conn->params      = p_central->conn_params;
+    p_conn->att_mtu     = BLE_GATT_ATT_MTU_DEFAULT;
+    p_conn->data_length = BLE_GAP_DATA_LENGTH_DEFAULT;
+    p_conn->phy         = BLE_GAP_PHY_1MBPS;
+    p_conn->params.min_conn_interval = p_conn->params.max_conn_interval;
+    p_conn->anchor_ns     = sim_now_ns();
+    p_conn->last_event_ns = UINT64_MAX;
+
+    m_advertising = false;
+
+    memset(&evt, 0, sizeof(evt));
+    evt.header.evt_id                             = BLE_GAP_EVT_CONNECTED;
+    evt.evt.gap_evt.conn_handle                   = conn_handle;
+    evt.evt.gap_evt.params.connected.role         = BLE_GAP_ROLE_PERIPH;
+    evt.evt.gap_evt.params.connected.conn_params  = p_conn->params;
+    evt.evt.gap_evt.params.connected.adv_handle   = 0;
+    evt.evt.gap_evt.params.connected.adv_data     = m_adv_data;
+    sim_evt_push(&evt, SIM_EVT_LEN(gap_evt));
+
+    sim_process();
+    return conn_handle;
+}
+
+static void disconnected_push(uint16_t conn_handle, uint8_t reason)
+{
+    ble_evt_t evt;
+
+    m_conns[conn_handle].connected = false;
+
+    memset(&evt, 0, sizeof(evt));
+    evt.header.evt_id                           = BLE_GAP_EVT_DISCONNECTED;
+    evt.evt.gap_evt.conn_handle                 = conn_handle;
+    evt.evt.gap_evt.params.disconnected.reason  = reason;
+    sim_evt_push(&evt, SIM_EVT_LEN(gap_evt));
+}
+
+void sim_disconnect(uint16_t conn_handle, uint8_t hci_status)
+{
+    if (conn_get(conn_handle) == NULL)
+    {
+        return;
+    }
+
+    disconnected_push(conn_handle, hci_status);
+    sim_process();
+}
+
+bool sim_connected(uint16_t conn_handle)
+{
+    return conn_get(conn_handle) != NULL;
+}
+
+static void attr_write(sim_attr_t *p_attr, uint16_t offset, uint8_t const *p_data, uint16_t len)
+{
+    memcpy(&p_attr->p_value[offset], p_data, len);
+    if (p_attr->vlen || offset + len > p_attr->len)
+    {
+        p_attr->len = offset + len;
+    }
+}
+
+static void write_evt_push(uint16_t conn_handle, uint16_t handle, sim_attr_t const *p_attr,
+                           uint8_t op, uint16_t offset, uint8_t const *p_data, uint16_t len)
+{
+    static struct
+    {
+        ble_evt_t evt;
+        uint8_t   extra[BLE_GATTS_VAR_ATTR_LEN_MAX];
+    } buf;
+
+    memset(&buf, 0, sizeof(buf));
+    buf.evt.header.evt_id                      = BLE_GATTS_EVT_WRITE;
+    buf.evt.evt.gatts_evt.conn_handle          = conn_handle;
+    buf.evt.evt.gatts_evt.params.write.handle  = handle;
+    buf.evt.evt.gatts_evt.params.write.uuid    = p_attr->uuid;
+    buf.evt.evt.gatts_evt.params.write.op      = op;
+    buf.evt.evt.gatts_evt.params.write.offset  = offset;
+    buf.evt.evt.gatts_evt.params.write.len     = len;
+    memcpy((uint8_t *)&buf + offsetof(ble_evt_t, evt.gatts_evt.params.write.data), p_data, len);
+
+    sim_evt_push(&buf.evt, (uint16_t)(offsetof(ble_evt_t, evt.gatts_evt.params.write.data) + len));
+}
+
+static void auth_evt_push(uint16_t conn_handle, uint8_t type, uint8_t op, uint16_t handle,
+                          uint16_t offset, uint8_t const *p_data, uint16_t len)
+{
+    static struct
+    {
+        ble_evt_t evt;
+        uint8_t   extra[BLE_GATTS_VAR_ATTR_LEN_MAX];
+    } buf;
+
+    sim_conn_t *p_conn = &m_conns[conn_handle];
+    sim_attr_t *p_attr = attr_get(handle);
+
+    p_conn->auth_type    = type;
+    p_conn->auth_op      = op;
+    p_conn->auth_handle  = handle;
+    p_conn->auth_offset  = offset;
+    p_conn->auth_status  = BLE_GATT_STATUS_UNKNOWN;
+    p_conn->auth_replied = false;
+
+    memset(&buf, 0, sizeof(buf));
+    buf.evt.header.evt_id                                   = BLE_GATTS_EVT_RW_AUTHORIZE_REQUEST;
+    buf.evt.evt.gatts_evt.conn_handle                       = conn_handle;
+    buf.evt.evt.gatts_evt.params.authorize_request.type     = type;
+
+    if (type == BLE_GATTS_AUTHORIZE_TYPE_READ)
+    {
+        buf.evt.evt.gatts_evt.params.authorize_request.request.read.handle = handle;
+        buf.evt.evt.gatts_evt.params.authorize_request.request.read.uuid   = p_attr->uuid;
+        buf.evt.evt.gatts_evt.params.authorize_request.request.read.offset = offset;
+        sim_evt_push(&buf.evt, SIM_EVT_LEN(gatts_evt));
+        return;
+    }
+
+    ble_gatts_evt_write_t *p_write = &buf.evt.evt.gatts_evt.params.authorize_request.request.write;
+    p_write->handle = handle;
+    p_write->uuid   = (p_attr != NULL) ? p_attr->uuid : (ble_uuid_t){ 0 };
+    p_write->op     = op;
+    p_write->offset = offset;
+    p_write->len    = len;
+    if (len > 0)
+    {
+        memcpy((uint8_t *)&buf + offsetof(ble_evt_t, evt.gatts_evt.params.authorize_request.request.write.data),
+               p_data, len);
+    }
+    sim_evt_push(&buf.evt,
+                 (uint16_t)(offsetof(ble_evt_t, evt.gatts_evt.params.authorize_request.request.write.data) + len));
+}
+
+static void sys_attr_check(uint16_t conn_handle)
+{
+    sim_conn_t *p_conn = &m_conns[conn_handle];
+    ble_evt_t   evt;
+
+    if (p_conn->sys_attr_set)
+    {
+        return;
+    }
+
+    memset(&evt, 0, sizeof(evt));
+    evt.header.evt_id                                = BLE_GATTS_EVT_SYS_ATTR_MISSING;
+    evt.evt.gatts_evt.conn_handle                    = conn_handle;
+    evt.evt.gatts_evt.params.sys_attr_missing.hint   = 0;
+    sim_evt_push(&evt, SIM_EVT_LEN(gatts_evt));
+    sim_process();
+}
+
+static uint16_t cccd_write(uint16_t conn_handle, uint16_t handle, sim_attr_t *p_attr, uint8_t const *p_data, uint16_t len)
+{
+    sim_conn_t *p_conn = &m_conns[conn_handle];
+
+    if (len != BLE_CCCD_VALUE_LEN)
+    {
+        return BLE_GATT_STATUS_ATTERR_INVALID_ATT_VAL_LENGTH;
+    }
+
+    uint16_t cccd = uint16_decode(p_data);
+    if (((cccd & BLE_GATT_HVX_NOTIFICATION) && !p_attr->props.notify) ||
+        ((cccd & BLE_GATT_HVX_INDICATION) && !p_attr->props.indicate))
+    {
+        return 0x00FD;  // Client Characteristic Configuration Descriptor Improperly Configured
+    }
+
+    sys_attr_check(conn_handle);
+    if (!sim_connected(conn_handle))
+    {
+        return BLE_GATT_STATUS_UNKNOWN;
+    }
+
+    p_conn->cccd[handle] = cccd;
+    write_evt_push(conn_handle, handle, p_attr, BLE_GATTS_OP_WRITE_REQ, 0, p_data, len);
+    sim_process();
+    return BLE_GATT_STATUS_SUCCESS;
+}
+
+uint16_t sim_write(uint16_t conn_handle, uint16_t handle, uint8_t op, uint8_t const *p_data, uint16_t len)
+{
+    sim_conn_t *p_conn = conn_get(conn_handle);
+    sim_attr_t *p_attr = attr_get(handle);
+
+    if (p_conn == NULL)
+    {
+        return BLE_GATT_STATUS_UNKNOWN;
+    }
+    if (p_attr == NULL)
+    {
+        return BLE_GATT_STATUS_ATTERR_INVALID_HANDLE;
+    }
+    if (len > p_conn->att_mtu - 3)
+    {
+        return BLE_GATT_STATUS_ATTERR_INVALID_PDU;
+    }
+    if (p_attr->kind == SIM_ATTR_CCCD)
+    {
+        return cccd_write(conn_handle, handle, p_attr, p_data, len);
+    }
+
+    bool allowed = p_attr->writable && (p_attr->kind == SIM_ATTR_VALUE || p_attr->kind == SIM_ATTR_USER_DESC);
+    if (p_attr->kind == SIM_ATTR_VALUE)
+    {
+        allowed = allowed && ((op == BLE_GATTS_OP_WRITE_REQ) ? p_attr->props.write : p_attr->props.write_wo_resp);
+    }
+    if (!allowed)
+    {
+        return BLE_GATT_STATUS_ATTERR_WRITE_NOT_PERMITTED;
+    }
+    if (len > p_attr->max_len)
+    {
+        return BLE_GATT_STATUS_ATTERR_INVALID_ATT_VAL_LENGTH;
+    }
+
+    if (p_attr->wr_auth)
+    {
+        // No write event follows an authorized write, the reply decides about the value
+        auth_evt_push(conn_handle, BLE_GATTS_AUTHORIZE_TYPE_WRITE, op, handle, 0, p_data, len);
+        sim_process();
+        return p_conn->auth_replied ? p_conn->auth_status : BLE_GATT_STATUS_UNKNOWN;
+    }
+
+    attr_write(p_attr, 0, p_data, len);
+    write_evt_push(conn_handle, handle, p_attr, op, 0, p_data, len);
+    sim_process();
+    return BLE_GATT_STATUS_SUCCESS;
+}
+
+static void user_mem_release(uint16_t conn_handle)
+{
+    sim_conn_t *p_conn = &m_conns[conn_handle];
+    ble_evt_t   evt;
+
+    memset(&evt, 0, sizeof(evt));
+    evt.header.evt_id                                         = BLE_EVT_USER_MEM_RELEASE;
+    evt.evt.common_evt.conn_handle                            = conn_handle;
+    evt.evt.common_evt.params.user_mem_release.type           = BLE_USER_MEM_TYPE_GATTS_QUEUED_WRITES;
+    evt.evt.common_evt.params.user_mem_release.mem_block      = p_conn->user_mem;
+    sim_evt_push(&evt, SIM_EVT_LEN(common_evt));
+
+    p_conn->user_mem_set = false;
+}
+
+uint16_t sim_long_write(uint16_t conn_handle, uint16_t handle, uint8_t const *p_data, uint16_t len)
+{
+    sim_conn_t *p_conn = conn_get(conn_handle);
+    sim_attr_t *p_attr = attr_get(handle);
+    ble_evt_t   evt;
+
+    if (p_conn == NULL)
+    {
+        return BLE_GATT_STATUS_UNKNOWN;
+    }
+    if (p_attr == NULL || p_attr->kind != SIM_ATTR_VALUE)
+    {
+        return BLE_GATT_STATUS_ATTERR_INVALID_HANDLE;
+    }
+    if (!p_attr->writable || !p_attr->props.write)
+    {
+        return BLE_GATT_STATUS_ATTERR_WRITE_NOT_PERMITTED;
+    }
+
+    if (!p_conn->user_mem_set)
+    {
+        memset(&evt, 0, sizeof(evt));
+        evt.header.evt_id                                   = BLE_EVT_USER_MEM_REQUEST;
+        evt.evt.common_evt.conn_handle                      = conn_handle;
+        evt.evt.common_evt.params.user_mem_request.type     = BLE_USER_MEM_TYPE_GATTS_QUEUED_WRITES;
+        sim_evt_push(&evt, SIM_EVT_LEN(common_evt));
+        sim_process();
+    }
+    if (!p_conn->user_mem_set || p_conn->user_mem.p_mem == NULL)
+    {
+        // The SoftDevice answers Prepare Write Requests itself when no memory was provided
+        return BLE_GATT_STATUS_ATTERR_PREPARE_QUEUE_FULL;
+    }
+
+    uint8_t *p_mem   = p_conn->user_mem.p_mem;
+    uint16_t mem_len = p_conn->user_mem.len;
+    uint16_t used    = 0;
+    uint16_t chunk   = p_conn->att_mtu - 5;
+
+    for (uint16_t offset = 0; offset < len; offset += chunk)
+    {
+        uint16_t part = MIN(chunk, len - offset);
+
+        if (used + 6 + part + 2 > mem_len)
+        {
+            user_mem_release(conn_handle);
+            sim_process();
+            return BLE_GATT_STATUS_ATTERR_PREPARE_QUEUE_FULL;
+        }
+
+        if (p_attr->wr_auth)
+        {
+            auth_evt_push(conn_handle, BLE_GATTS_AUTHORIZE_TYPE_WRITE, BLE_GATTS_OP_PREP_WRITE_REQ,
+                          handle, offset, &p_data[offset], part);
+            sim_process();
+            if (!p_conn->auth_replied || p_conn->auth_status != BLE_GATT_STATUS_SUCCESS)
+            {
+                user_mem_release(conn_handle);
+                sim_process();
+                return p_conn->auth_replied ? p_conn->auth_status : BLE_GATT_STATUS_UNKNOWN;
+            }
+        }
+
+        used += uint16_encode(handle, &p_mem[used]);
+        used += uint16_encode(offset, &p_mem[used]);
+        used += uint16_encode(part, &p_mem[used]);
+        memcpy(&p_mem[used], &p_data[offset], part);
+        used += part;
+    }
+    uint16_encode(BLE_GATT_HANDLE_INVALID, &p_mem[used]);
+
+    uint16_t status = BLE_GATT_STATUS_SUCCESS;
+    if (p_attr->wr_auth)
+    {
+        auth_evt_push(conn_handle, BLE_GATTS_AUTHORIZE_TYPE_WRITE, BLE_GATTS_OP_EXEC_WRITE_REQ_NOW,
+                      BLE_GATT_HANDLE_INVALID, 0, NULL, 0);
+        sim_process();
+        status = p_conn->auth_replied ? p_conn->auth_status : BLE_GATT_STATUS_UNKNOWN;
+    }
+    if (status == BLE_GATT_STATUS_SUCCESS && len <= p_attr->max_len)
+    {
+        attr_write(p_attr, 0, p_data, len);
+        if (!p_attr->wr_auth)
+        {
+            write_evt_push(conn_handle, handle, p_attr, BLE_GATTS_OP_EXEC_WRITE_REQ_NOW, 0, NULL, 0);
+        }
+    }
+
+    user_mem_release(conn_handle);
+    sim_process();
+    return status;
+}
+
+uint16_t sim_subscribe(uint16_t conn_handle, uint16_t value_handle, uint16_t cccd)
+{
+    sim_attr_t *p_cccd = attr_get(value_handle + 1);
+    uint8_t     data[BLE_CCCD_VALUE_LEN];
+
+    if (p_cccd == NULL || p_cccd->kind != SIM_ATTR_CCCD)
+    {
+        return BLE_GATT_STATUS_ATTERR_INVALID_HANDLE;
+    }
+
+    uint16_encode(cccd, data);
+    return sim_write(conn_handle, value_handle + 1, BLE_GATTS_OP_WRITE_REQ, data, sizeof(data));
+}
+
+bool sim_read(uint16_t conn_handle, uint16_t handle, uint8_t *p_data, uint16_t *p_len)
+{
+    sim_conn_t *p_conn = conn_get(conn_handle);
+    sim_attr_t *p_attr = attr_get(handle);
+
+    if (p_conn == NULL || p_attr == NULL || !p_attr->readable)
+    {
+        *p_len = 0;
+        return false;
+    }
+
+    if (p_attr->kind == SIM_ATTR_CCCD)
+    {
+        *p_len = (uint16_t)uint16_encode(p_conn->cccd[handle], p_data);
+        return true;
+    }
+
+    p_conn->read_done = false;
+    if (p_attr->rd_auth)
+    {
+        auth_evt_push(conn_handle, BLE_GATTS_AUTHORIZE_TYPE_READ, 0, handle, 0, NULL, 0);
+        sim_process();
+    }
+    else
+    {
+        p_conn->read_len  = p_attr->len;
+        p_conn->read_done = true;
+        memcpy(p_conn->read_data, p_attr->p_value, p_attr->len);
+    }
+
+    return sim_read_result(conn_handle, p_data, p_len);
+}
+
+bool sim_read_result(uint16_t conn_handle, uint8_t *p_data, uint16_t *p_len)
+{
+    sim_conn_t *p_conn = conn_get(conn_handle);
+
+    if (p_conn == NULL || !p_conn->read_done)
+    {
+        return false;
+    }
+
+    // A read response carries at most ATT MTU - 1 bytes
+    uint16_t len = MIN(p_conn->read_len, (uint16_t)(p_conn->att_mtu - 1));
+    *p_len = MIN(len, *p_len);
+    memcpy(p_data, p_conn->read_data, *p_len);
+    p_conn->read_done = false;
+    return true;
+}
+
+void sim_mtu_exchange(uint16_t conn_handle, uint16_t client_rx_mtu)
+{
+    sim_conn_t *p_conn = conn_get(conn_handle);
+    ble_evt_t   evt;
+
+    if (p_conn == NULL || p_conn->mtu_exchanged)
+    {
+        return;
+    }
+
+    p_conn->mtu_request_pending       = true;
+    p_conn->central.att_mtu           = client_rx_mtu;
+
+    memset(&evt, 0, sizeof(evt));
+    evt.header.evt_id                                        = BLE_GATTS_EVT_EXCHANGE_MTU_REQUEST;
+    evt.evt.gatts_evt.conn_handle                            = conn_handle;
+    evt.evt.gatts_evt.params.exchange_mtu_request.client_rx_mtu = client_rx_mtu;
+    sim_evt_push(&evt, SIM_EVT_LEN(gatts_evt));
+    sim_process();
+}
+
+void sim_rssi(uint16_t conn_handle, int8_t rssi)
+{
+    ble_evt_t evt;
+
+    if (conn_get(conn_handle) == NULL)
+    {
+        return;
+    }
+
+    memset(&evt, 0, sizeof(evt));
+    evt.header.evt_id                          = BLE_GAP_EVT_RSSI_CHANGED;
+    evt.evt.gap_evt.conn_handle                = conn_handle;
+    evt.evt.gap_evt.params.rssi_changed.rssi   = rssi;
+    sim_evt_push(&evt, SIM_EVT_LEN(gap_evt));
+    sim_process();
+}
+
+bool sim_l2cap_connect(uint16_t conn_handle, uint16_t le_psm, uint16_t rx_mtu, uint16_t credits)
+{
+    sim_conn_t *p_conn = conn_get(conn_handle);
+    ble_evt_t   evt;
+
+    if (p_conn == NULL || m_l2cap_cfg.ch_count == 0 || p_conn->l2cap.requested)
+    {
+        return false;
+    }
+
+    p_conn->l2cap.requested    = true;
+    p_conn->l2cap.peer_mtu     = rx_mtu;
+    p_conn->l2cap.peer_credits = credits;
+
+    memset(&evt, 0, sizeof(evt));
+    evt.header.evt_id                                               = BLE_L2CAP_EVT_CH_SETUP_REQUEST;
+    evt.evt.l2cap_evt.conn_handle                                   = conn_handle;
+    evt.evt.l2cap_evt.local_cid                                     = SIM_L2CAP_CID;
+    evt.evt.l2cap_evt.params.ch_setup_request.le_psm                = le_psm;
+    evt.evt.l2cap_evt.params.ch_setup_request.tx_params.tx_mtu      = rx_mtu;
+    evt.evt.l2cap_evt.params.ch_setup_request.tx_params.peer_mps    = MIN(rx_mtu, m_l2cap_cfg.tx_mps);
+    evt.evt.l2cap_evt.params.ch_setup_request.tx_params.tx_mps      = m_l2cap_cfg.tx_mps;
+    evt.evt.l2cap_evt.params.ch_setup_request.tx_params.credits     = credits;
+    sim_evt_push(&evt, SIM_EVT_LEN(l2cap_evt));
+    sim_process();
+
+    return p_conn->l2cap.open;
+}
+
+bool sim_l2cap_send(uint16_t conn_handle, uint8_t const *p_data, uint16_t len)
+{
+    sim_conn_t *p_conn = conn_get(conn_handle);
+    ble_evt_t   evt;
+
+    if (p_conn == NULL || !p_conn->l2cap.open || p_conn->l2cap.rx_count == 0)
+    {
+        return false;
+    }
+
+    sim_l2cap_t *p_l2cap = &p_conn->l2cap;
+    ble_data_t   buf     = p_l2cap->rx_buf[0];
+    if (len > buf.len)
+    {
+        return false;
+    }
+
+    memmove(&p_l2cap->rx_buf[0], &p_l2cap->rx_buf[1], (p_l2cap->rx_count - 1) * sizeof(ble_data_t));
+    p_l2cap->rx_count--;
+    memcpy(buf.p_data, p_data, len);
+
+    memset(&evt, 0, sizeof(evt));
+    evt.header.evt_id                       = BLE_L2CAP_EVT_CH_RX;
+    evt.evt.l2cap_evt.conn_handle           = conn_handle;
+    evt.evt.l2cap_evt.local_cid             = SIM_L2CAP_CID;
+    evt.evt.l2cap_evt.params.rx.sdu_len     = len;
+    evt.evt.l2cap_evt.params.rx.sdu_buf     = buf;
+    sim_evt_push(&evt, SIM_EVT_LEN(l2cap_evt));
+    sim_process();
+    return true;
+}
+
+uint32_t sim_l2cap_received(uint16_t conn_handle)
+{
+    return (conn_handle < SIM_LINK_COUNT) ? m_conns[conn_handle].l2cap.received : 0;
+}
+
+ble_gap_conn_params_t sim_conn_params(uint16_t conn_handle)
+{
+    sim_conn_t const *p_conn = conn_get(conn_handle);
+    return (p_conn != NULL) ? p_conn->params : (ble_gap_conn_params_t){ 0 };
+}
+
+uint16_t sim_conn_att_mtu(uint16_t conn_handle)
+{
+    sim_conn_t const *p_conn = conn_get(conn_handle);
+    return (p_conn != NULL) ? p_conn->att_mtu : 0;
+}
+
+uint8_t sim_conn_data_length(uint16_t conn_handle)
+{
+    sim_conn_t const *p_conn = conn_get(conn_handle);
+    return (p_conn != NULL) ? p_conn->data_length : 0;
+}
+
+uint8_t sim_conn_phy(uint16_t conn_handle)
+{
+    sim_conn_t const *p_conn = conn_get(conn_handle);
+    return (p_conn != NULL) ? p_conn->phy : 0;
+}
+
+uint64_t sim_conn_listen_ns(uint16_t conn_handle)
+{
+    sim_conn_t const *p_conn = conn_get(conn_handle);
+    if (p_conn == NULL)
+    {
+        return UINT64_MAX;
+    }
+    if (conn_tx_pending(p_conn))
+    {
+        return conn_next_event_ns(p_conn);
+    }
+
+    // Without data to send the peripheral skips slave_latency events after every one it listens to
+    uint64_t now_ns    = sim_now_ns();
+    uint64_t period_ns = conn_interval_ns(p_conn) * (p_conn->params.slave_latency + 1);
+    uint64_t event_ns  = p_conn->anchor_ns;
+    if (now_ns > event_ns)
+    {
+        event_ns += (now_ns - event_ns + period_ns - 1) / period_ns * period_ns;
+    }
+    return event_ns;
+}
+
+uint32_t sim_conn_hvn_queued(uint16_t conn_handle)
+{
+    sim_conn_t const *p_conn = conn_get(conn_handle);
+    return (p_conn != NULL) ? p_conn->hvn_count : 0;
+}
+
+bool sim_advertising(void)
+{
+    return m_advertising;
+}
+
+ble_data_t sim_adv_data(void)
+{
+    return m_adv_data.adv_data;
+}
+
+ble_data_t sim_scan_rsp_data(void)
+{
+    return m_adv_data.scan_rsp_data;
+}
+
+uint8_t sim_adv_field(ble_data_t const *p_adv, uint8_t ad_type, uint8_t const **pp_field)
+{
+    uint16_t offset = 0;
+
+    while (offset + 1 < p_adv->len)
+    {
+        uint8_t field_len = p_adv->p_data[offset];
+        if (field_len == 0)
+        {
+            break;
+        }
+        if (p_adv->p_data[offset + 1] == ad_type)
+        {
+            *pp_field = &p_adv->p_data[offset + 2];
+            return field_len - 1;
+        }
+        offset += field_len + 1;
+    }
+    return 0;
+}
+
+static uint16_t attr_find(sim_attr_kind_t kind, uint16_t uuid)
+{
+    for (uint16_t i = 0; i < m_attr_count; i++)
+    {
+        if (m_attrs[i].kind == kind && m_attrs[i].uuid.uuid == uuid)
+        {
+            return i + 1;
+        }
+    }
+    return BLE_GATT_HANDLE_INVALID;
+}
+
+uint16_t sim_char_find(uint16_t uuid)
+{
+    return attr_find(SIM_ATTR_VALUE, uuid);
+}
+
+uint16_t sim_service_find(uint16_t uuid)
+{
+    return attr_find(SIM_ATTR_SERVICE, uuid);
+}
+
+ble_gatt_char_props_t sim_char_props(uint16_t value_handle)
+{
+    sim_attr_t const *p_attr = attr_get(value_handle);
+    return (p_attr != NULL) ? p_attr->props : (ble_gatt_char_props_t){ 0 };
+}
+
+uint32_t sim_attr_tab_used(void)
+{
+    return m_attr_tab_used;
+}
+
+uint32_t sim_attr_tab_size(void)
+{
+    return m_attr_tab_size;
+}
+
+uint16_t sim_attr_value(uint16_t handle, uint8_t *p_data, uint16_t size)
+{
+    sim_attr_t const *p_attr = attr_get(handle);
+
+    if (p_attr == NULL)
+    {
+        return 0;
+    }
+
+    uint16_t len = MIN(size, p_attr->len);
+    memcpy(p_data, p_attr->p_value, len);
+    return len;
+}
+
+/* --- SoftDevice API ----------------------------------------------------------------------- */
+
+uint32_t sd_ble_cfg_set(uint32_t cfg_id, ble_cfg_t const *p_cfg, uint32_t app_ram_base)
+{
+    (void)app_ram_base;
+
+    if (m_enabled)
+    {
+        SIM_RETURN(NRF_ERROR_INVALID_STATE);
+    }
+    if (p_cfg == NULL)
+    {
+        SIM_RETURN(NRF_ERROR_INVALID_ADDR);
+    }
+
+    switch (cfg_id)
+    {
+        case BLE_CONN_CFG_GAP:
+            if (p_cfg->conn_cfg.params.gap_conn_cfg.event_length < BLE_GAP_EVENT_LENGTH_MIN ||
+                p_cfg->conn_cfg.params.gap_conn_cfg.conn_count > SIM_LINK_COUNT)
+            {
+                SIM_RETURN(NRF_ERROR_INVALID_PARAM);
+            }
+            m_conn_count   = p_cfg->conn_cfg.params.gap_conn_cfg.conn_count;
+            m_event_length = p_cfg->conn_cfg.params.gap_conn_cfg.event_length;
+            break;
+
+        case BLE_CONN_CFG_GATTS:
+            if (p_cfg->conn_cfg.params.gatts_conn_cfg.hvn_tx_queue_size > SIM_HVN_QUEUE_MAX)
+            {
+                SIM_RETURN(NRF_ERROR_INVALID_PARAM);
+            }
+            m_hvn_queue_size = MAX(p_cfg->conn_cfg.params.gatts_conn_cfg.hvn_tx_queue_size, 1);
+            break;
+
+        case BLE_CONN_CFG_GATT:
+            if (p_cfg->conn_cfg.params.gatt_conn_cfg.att_mtu < BLE_GATT_ATT_MTU_DEFAULT ||
+                p_cfg->conn_cfg.params.gatt_conn_cfg.att_mtu > SIM_HVX_MAX_LEN)
+            {
+                SIM_RETURN(NRF_ERROR_INVALID_PARAM);
+            }
+            m_att_mtu_max = p_cfg->conn_cfg.params.gatt_conn_cfg.att_mtu;
+            break;
+
+        case BLE_GATTS_CFG_ATTR_TAB_SIZE:
+            if (p_cfg->gatts_cfg.attr_tab_size.attr_tab_size < BLE_GATTS_ATTR_TAB_SIZE_MIN ||
+                p_cfg->gatts_cfg.attr_tab_size.attr_tab_size % 4 != 0)
+            {
+                SIM_RETURN(NRF_ERROR_INVALID_PARAM);
+            }
+            m_attr_tab_size = p_cfg->gatts_cfg.attr_tab_size.attr_tab_size;
+            break;
+
+        case BLE_CONN_CFG_L2CAP:
+            if (p_cfg->conn_cfg.params.l2cap_conn_cfg.tx_queue_size > SIM_L2CAP_TX_QUEUE_MAX ||
+                p_cfg->conn_cfg.params.l2cap_conn_cfg.rx_queue_size > SIM_L2CAP_TX_QUEUE_MAX)
+            {
+                SIM_RETURN(NRF_ERROR_INVALID_PARAM);
+            }
+            m_l2cap_cfg = p_cfg->conn_cfg.params.l2cap_conn_cfg;
+            break;
+
+        default:
+            SIM_RETURN(NRF_ERROR_NOT_SUPPORTED);
+    }
+    SIM_RETURN(NRF_SUCCESS);
+}
+
+uint32_t sd_ble_opt_set(uint32_t opt_id, ble_opt_t const *p_opt)
+{
+    if (opt_id != BLE_COMMON_OPT_CONN_EVT_EXT)
+    {
+        SIM_RETURN(NRF_ERROR_NOT_SUPPORTED);
+    }
+
+    m_conn_evt_ext = p_opt->common_opt.conn_evt_ext.enable;
+    SIM_RETURN(NRF_SUCCESS);
+}
+
+uint32_t sd_ble_uuid_vs_add(ble_uuid128_t const *p_vs_uuid, uint8_t *p_uuid_type)
+{
+    for (uint8_t i = 0; i < m_vs_uuid_count; i++)
+    {
+        if (memcmp(&m_vs_uuids[i], p_vs_uuid, sizeof(ble_uuid128_t)) == 0)
+        {
+            *p_uuid_type = BLE_UUID_TYPE_VENDOR_BEGIN + i;
+            SIM_RETURN(NRF_SUCCESS);
+        }
+    }
+    if (m_vs_uuid_count == SIM_VS_UUID_COUNT)
+    {
+        SIM_RETURN(NRF_ERROR_NO_MEM);
+    }
+
+    m_vs_uuids[m_vs_uuid_count] = *p_vs_uuid;
+    *p_uuid_type = BLE_UUID_TYPE_VENDOR_BEGIN + m_vs_uuid_count++;
+    SIM_RETURN(NRF_SUCCESS);
+}
+
+uint32_t sd_ble_user_mem_reply(uint16_t conn_handle, ble_user_mem_block_t const *p_block)
+{
+    sim_conn_t *p_conn = conn_get(conn_handle);
+
+    if (p_conn == NULL)
+    {
+        SIM_RETURN(BLE_ERROR_INVALID_CONN_HANDLE);
+    }
+    if (p_conn->user_mem_set)
+    {
+        SIM_RETURN(NRF_ERROR_INVALID_STATE);
+    }
+
+    p_conn->user_mem_set = true;
+    if (p_block != NULL)
+    {
+        p_conn->user_mem = *p_block;
+    }
+    else
+    {
+        memset(&p_conn->user_mem, 0, sizeof(p_conn->user_mem));
+    }
+    SIM_RETURN(NRF_SUCCESS);
+}
+
+uint32_t sd_ble_gap_adv_set_configure(uint8_t *p_adv_handle, ble_gap_adv_data_t const *p_adv_data,
+                                      ble_gap_adv_params_t const *p_adv_params)
+{
+    if (p_adv_handle == NULL)
+    {
+        SIM_RETURN(NRF_ERROR_INVALID_ADDR);
+    }
+    if (*p_adv_handle != BLE_GAP_ADV_SET_HANDLE_NOT_SET && *p_adv_handle != 0)
+    {
+        SIM_RETURN(BLE_ERROR_INVALID_ADV_HANDLE);
+    }
+    if (*p_adv_handle == BLE_GAP_ADV_SET_HANDLE_NOT_SET && m_adv_configured)
+    {
+        SIM_RETURN(NRF_ERROR_NO_MEM);
+    }
+    if (m_advertising && p_adv_params != NULL)
+    {
+        SIM_RETURN(NRF_ERROR_INVALID_STATE);
+    }
+    if (p_adv_data != NULL &&
+        (p_adv_data->adv_data.len > BLE_GAP_ADV_SET_DATA_SIZE_MAX ||
+         p_adv_data->scan_rsp_data.len > BLE_GAP_ADV_SET_DATA_SIZE_MAX))
+    {
+        SIM_RETURN(NRF_ERROR_INVALID_LENGTH);
+    }
+
+    *p_adv_handle    = 0;
+    m_adv_configured = true;
+    if (p_adv_params != NULL)
+    {
+        m_adv_params = *p_adv_params;
+    }
+    if (p_adv_data != NULL)
+    {
+        m_adv_data = *p_adv_data;
+    }
+    SIM_RETURN(NRF_SUCCESS);
+}
+
+uint32_t sd_ble_gap_adv_start(uint8_t adv_handle, uint8_t conn_cfg_tag)
+{
+    (void)conn_cfg_tag;
+
+    if (!m_adv_configured || adv_handle != 0)
+    {
+        SIM_RETURN(BLE_ERROR_INVALID_ADV_HANDLE);
+    }
+    if (m_advertising)
+    {
+        SIM_RETURN(NRF_ERROR_INVALID_STATE);
+    }
+    if (conn_link_count() >= m_conn_count)
+    {
+        SIM_RETURN(NRF_ERROR_CONN_COUNT);
+    }
+
+    m_advertising  = true;
+    m_adv_end_ns   = (m_adv_params.duration == BLE_GAP_ADV_TIMEOUT_GENERAL_UNLIMITED)
+                     ? UINT64_MAX
+                     : sim_now_ns() + (uint64_t)m_adv_params.duration * 10000000ULL;
+    SIM_RETURN(NRF_SUCCESS);
+}
+
+uint32_t sd_ble_gap_adv_stop(uint8_t adv_handle)
+{
+    if (adv_handle != 0)
+    {
+        SIM_RETURN(BLE_ERROR_INVALID_ADV_HANDLE);
+    }
+    if (!m_advertising)
+    {
+        SIM_RETURN(NRF_ERROR_INVALID_STATE);
+    }
+
+    m_advertising = false;
+    SIM_RETURN(NRF_SUCCESS);
+}
+
+static bool conn_params_valid(ble_gap_conn_params_t const *p_params)
+{
+    return (p_params->min_conn_interval >= BLE_GAP_CP_MIN_CONN_INTVL_MIN) &&
+           (p_params->max_conn_interval <= BLE_GAP_CP_MAX_CONN_INTVL_MAX) &&
+           (p_params->min_conn_interval <= p_params->max_conn_interval);
+}
+
+uint32_t sd_ble_gap_conn_param_update(uint16_t conn_handle, ble_gap_conn_params_t const *p_conn_params)
+{
+    sim_conn_t *p_conn = conn_get(conn_handle);
+
+    if (p_conn == NULL)
+    {
+        SIM_RETURN(BLE_ERROR_INVALID_CONN_HANDLE);
+    }
+    if (p_conn_params == NULL)
+    {
+        p_conn_params = &m_ppcp;
+    }
+    if (!conn_params_valid(p_conn_params))
+    {
+        SIM_RETURN(NRF_ERROR_INVALID_PARAM);
+    }
+    if (p_conn->cp_pending)
+    {
+        SIM_RETURN(NRF_ERROR_BUSY);
+    }
+
+    // A central that does not grant the request leaves the parameters as they are
+    uint16_t lowest  = MAX(p_conn_params->min_conn_interval, p_conn->central.min_conn_interval);
+    uint16_t highest = MIN(p_conn_params->max_conn_interval, p_conn->central.max_conn_interval);
+
+    p_conn->cp_pending    = true;
+    p_conn->cp_accepted   = p_conn->central.accept_conn_params && lowest <= highest;
+    p_conn->cp_instant_ns = sim_now_ns() + SIM_LL_INSTANT_EVENTS * conn_interval_ns(p_conn);
+    p_conn->cp_params     = *p_conn_params;
+    p_conn->cp_params.min_conn_interval = lowest;
+    p_conn->cp_params.max_conn_interval = lowest;
+    SIM_RETURN(NRF_SUCCESS);
+}
+
+uint32_t sd_ble_gap_disconnect(uint16_t conn_handle, uint8_t hci_status_code)
+{
+    if (conn_handle < SIM_LINK_COUNT && m_conns[conn_handle].in_use && !m_conns[conn_handle].connected)
+    {
+        SIM_RETURN(NRF_ERROR_INVALID_STATE);
+    }
+    if (conn_get(conn_handle) == NULL)
+    {
+        SIM_RETURN(BLE_ERROR_INVALID_CONN_HANDLE);
+    }
+    if (hci_status_code != BLE_HCI_REMOTE_USER_TERMINATED_CONNECTION &&
+        hci_status_code != BLE_HCI_CONN_INTERVAL_UNACCEPTABLE)
+    {
+        SIM_RETURN(NRF_ERROR_INVALID_PARAM);
+    }
+
+    disconnected_push(conn_handle, BLE_HCI_LOCAL_HOST_TERMINATED_CONNECTION);
+    SIM_RETURN(NRF_SUCCESS);
+}
+
+uint32_t sd_ble_gap_device_name_set(ble_gap_conn_sec_mode_t const *p_write_perm, uint8_t const *p_dev_name, uint16_t len)
+{
+    (void)p_write_perm;
+
+    if (len > BLE_GAP_DEVNAME_MAX_LEN)
+    {
+        SIM_RETURN(NRF_ERROR_DATA_SIZE);
+    }
+
+    memcpy(m_device_name, p_dev_name, len);
+    m_device_name_len = len;
+    SIM_RETURN(NRF_SUCCESS);
+}
+
+uint32_t sd_ble_gap_device_name_get(uint8_t *p_dev_name, uint16_t *p_len)
+{
+    if (p_dev_name == NULL)
+    {
+        *p_len = m_device_name_len;
+        SIM_RETURN(NRF_SUCCESS);
+    }
+    if (*p_len < m_device_name_len)
+    {
+        SIM_RETURN(NRF_ERROR_DATA_SIZE);
+    }
+
+    memcpy(p_dev_name, m_device_name, m_device_name_len);
+    *p_len = m_device_name_len;
+    SIM_RETURN(NRF_SUCCESS);
+}
+
+uint32_t sd_ble_gap_appearance_set(uint16_t appearance)
+{
+    m_appearance = appearance;
+    SIM_RETURN(NRF_SUCCESS);
+}
+
+uint32_t sd_ble_gap_appearance_get(uint16_t *p_appearance)
+{
+    *p_appearance = m_appearance;
+    SIM_RETURN(NRF_SUCCESS);
+}
+
+uint32_t sd_ble_gap_ppcp_set(ble_gap_conn_params_t const *p_conn_params)
+{
+    if (!conn_params_valid(p_conn_params))
+    {
+        SIM_RETURN(NRF_ERROR_INVALID_PARAM);
+    }
+
+    m_ppcp = *p_conn_params;
+    SIM_RETURN(NRF_SUCCESS);
+}
+
+uint32_t sd_ble_gap_ppcp_get(ble_gap_conn_params_t *p_conn_params)
+{
+    *p_conn_params = m_ppcp;
+    SIM_RETURN(NRF_SUCCESS);
+}
+
+uint32_t sd_ble_gap_phy_update(uint16_t conn_handle, ble_gap_phys_t const *p_gap_phys)
+{
+    sim_conn_t *p_conn = conn_get(conn_handle);
+    ble_evt_t   evt;
+    uint8_t     all = BLE_GAP_PHY_1MBPS | BLE_GAP_PHY_2MBPS | BLE_GAP_PHY_CODED;
+
+    if (p_conn == NULL)
+    {
+        SIM_RETURN(BLE_ERROR_INVALID_CONN_HANDLE);
+    }
+    if ((p_gap_phys->tx_phys & ~all) || (p_gap_phys->rx_phys & ~all))
+    {
+        SIM_RETURN(NRF_ERROR_INVALID_PARAM);
+    }
+
+    uint8_t wanted = (p_gap_phys->tx_phys == BLE_GAP_PHY_AUTO) ? all : p_gap_phys->tx_phys;
+    uint8_t common = wanted & p_conn->central.phys;
+    uint8_t phy    = BLE_GAP_PHY_1MBPS;
+
+    if (common & BLE_GAP_PHY_2MBPS)
+    {
+        phy = BLE_GAP_PHY_2MBPS;
+    }
+    else if ((common & BLE_GAP_PHY_CODED) && !(common & BLE_GAP_PHY_1MBPS))
+    {
+        phy = BLE_GAP_PHY_CODED;
+    }
+    p_conn->phy = phy;
+
+    memset(&evt, 0, sizeof(evt));
+    evt.header.evt_id                           = BLE_GAP_EVT_PHY_UPDATE;
+    evt.evt.gap_evt.conn_handle                 = conn_handle;
+    evt.evt.gap_evt.params.phy_update.status    = BLE_HCI_STATUS_CODE_SUCCESS;
+    evt.evt.gap_evt.params.phy_update.tx_phy    = phy;
+    evt.evt.gap_evt.params.phy_update.rx_phy    = phy;
+    sim_evt_push(&evt, SIM_EVT_LEN(gap_evt));
+    SIM_RETURN(NRF_SUCCESS);
+}
+
+uint32_t sd_ble_gap_data_length_update(uint16_t conn_handle, ble_gap_data_length_params_t const *p_dl_params,
+                                       ble_gap_data_length_limitation_t *p_dl_limitation)
+{
+    sim_conn_t *p_conn = conn_get(conn_handle);
+    ble_evt_t   evt;
+
+    (void)p_dl_limitation;
+
+    if (p_conn == NULL)
+    {
+        SIM_RETURN(BLE_ERROR_INVALID_CONN_HANDLE);
+    }
+
+    uint16_t wanted = BLE_GAP_DATA_LENGTH_MAX;
+    if (p_dl_params != NULL && p_dl_params->max_tx_octets != BLE_GAP_DATA_LENGTH_AUTO)
+    {
+        wanted = p_dl_params->max_tx_octets;
+    }
+    if (wanted < BLE_GAP_DATA_LENGTH_DEFAULT || wanted > BLE_GAP_DATA_LENGTH_MAX)
+    {
+        SIM_RETURN(NRF_ERROR_INVALID_PARAM);
+    }
+
+    p_conn->data_length = (uint8_t)MIN(wanted, p_conn->central.data_length);
+
+    memset(&evt, 0, sizeof(evt));
+    evt.header.evt_id                                                   = BLE_GAP_EVT_DATA_LENGTH_UPDATE;
+    evt.evt.gap_evt.conn_handle                                         = conn_handle;
+    evt.evt.gap_evt.params.data_length_update.effective_params.max_tx_octets = p_conn->data_length;
+    evt.evt.gap_evt.params.data_length_update.effective_params.max_rx_octets = p_conn->data_length;
+    evt.evt.gap_evt.params.data_length_update.effective_params.max_tx_time_us = (p_conn->data_length + 14) * 8;
+    evt.evt.gap_evt.params.data_length_update.effective_params.max_rx_time_us = (p_conn->data_length + 14) * 8;
+    sim_evt_push(&evt, SIM_EVT_LEN(gap_evt));
+    SIM_RETURN(NRF_SUCCESS);
+}
+
+uint32_t sd_ble_gap_rssi_start(uint16_t conn_handle, uint8_t threshold_dbm, uint8_t skip_count)
+{
+    (void)threshold_dbm;
+    (void)skip_count;
+
+    if (conn_get(conn_handle) == NULL)
+    {
+        SIM_RETURN(BLE_ERROR_INVALID_CONN_HANDLE);
+    }
+    SIM_RETURN(NRF_SUCCESS);
+}
+
+uint32_t sd_ble_gap_rssi_stop(uint16_t conn_handle)
+{
+    if (conn_get(conn_handle) == NULL)
+    {
+        SIM_RETURN(BLE_ERROR_INVALID_CONN_HANDLE);
+    }
+    SIM_RETURN(NRF_SUCCESS);
+}
+
+uint32_t sd_ble_gatts_service_add(uint8_t type, ble_uuid_t const *p_uuid, uint16_t *p_handle)
+{
+    if (!m_enabled)
+    {
+        SIM_RETURN(NRF_ERROR_INVALID_STATE);
+    }
+    if (type != BLE_GATTS_SRVC_TYPE_PRIMARY && type != BLE_GATTS_SRVC_TYPE_SECONDARY)
+    {
+        SIM_RETURN(NRF_ERROR_INVALID_PARAM);
+    }
+    if (!uuid_valid(p_uuid))
+    {
+        SIM_RETURN(NRF_ERROR_INVALID_PARAM);
+    }
+
+    uint32_t tab_len = attr_tab_len(attr_uuid_len(p_uuid->type));
+    if (m_attr_tab_used + tab_len > m_attr_tab_size)
+    {
+        SIM_RETURN(NRF_ERROR_NO_MEM);
+    }
+
+    sim_attr_t *p_attr = attr_add(SIM_ATTR_SERVICE, p_uuid->uuid, p_uuid->type);
+    if (p_attr == NULL)
+    {
+        SIM_RETURN(NRF_ERROR_NO_MEM);
+    }
+    m_attr_tab_used += tab_len;
+
+    *p_handle = m_attr_count;
+    SIM_RETURN(NRF_SUCCESS);
+}
+
+uint32_t sd_ble_gatts_characteristic_add(uint16_t service_handle, ble_gatts_char_md_t const *p_char_md,
+                                         ble_gatts_attr_t const *p_attr_char_value, ble_gatts_char_handles_t *p_handles)
+{
+    sim_attr_t const *p_service = attr_get(service_handle);
+
+    if (p_service == NULL || p_service->kind != SIM_ATTR_SERVICE)
+    {
+        SIM_RETURN(NRF_ERROR_INVALID_PARAM);
+    }
+    if (p_attr_char_value->p_uuid == NULL || !uuid_valid(p_attr_char_value->p_uuid) ||
+        p_attr_char_value->p_attr_md == NULL)
+    {
+        SIM_RETURN(NRF_ERROR_INVALID_PARAM);
+    }
+
+    ble_gatts_attr_md_t const *p_md = p_attr_char_value->p_attr_md;
+    if (p_attr_char_value->max_len > BLE_GATTS_VAR_ATTR_LEN_MAX ||
+        p_attr_char_value->init_offs + p_attr_char_value->init_len > p_attr_char_value->max_len ||
+        (p_md->vloc == BLE_GATTS_VLOC_USER && p_attr_char_value->p_value == NULL) ||
+        (p_md->vloc != BLE_GATTS_VLOC_USER && p_md->vloc != BLE_GATTS_VLOC_STACK))
+    {
+        SIM_RETURN(NRF_ERROR_INVALID_PARAM);
+    }
+
+    bool has_cccd  = p_char_md->char_props.notify || p_char_md->char_props.indicate;
+    bool has_desc  = p_char_md->p_char_user_desc != NULL;
+    uint32_t count = 2 + (has_desc ? 1 : 0) + (has_cccd ? 1 : 0);
+    if (m_attr_count + count > SIM_ATTR_COUNT)
+    {
+        SIM_RETURN(NRF_ERROR_NO_MEM);
+    }
+
+    // Declaration with properties, value handle and UUID, then the value and the descriptors
+    uint32_t tab_len = attr_tab_len(3 + attr_uuid_len(p_attr_char_value->p_uuid->type));
+    tab_len += attr_tab_len((p_md->vloc == BLE_GATTS_VLOC_STACK) ? p_attr_char_value->max_len : 0);
+    tab_len += has_cccd ? attr_tab_len(BLE_CCCD_VALUE_LEN) : 0;
+    tab_len += has_desc ? attr_tab_len(MAX(p_char_md->char_user_desc_max_size, p_char_md->char_user_desc_size)) : 0;
+    if (m_attr_tab_used + tab_len > m_attr_tab_size)
+    {
+        SIM_RETURN(NRF_ERROR_NO_MEM);
+    }
+    m_attr_tab_used += tab_len;
+
+    sim_attr_t *p_decl = attr_add(SIM_ATTR_CHAR_DECL, BLE_UUID_CHARACTERISTIC, BLE_UUID_TYPE_BLE);
+    p_decl->props = p_char_md->char_props;
+
+    sim_attr_t *p_value = attr_add(SIM_ATTR_VALUE, p_attr_char_value->p_uuid->uuid, p_attr_char_value->p_uuid->type);
+    attr_perms_set(p_value, p_md);
+    p_value->props   = p_char_md->char_props;
+    p_value->max_len = p_attr_char_value->max_len;
+    p_value->len     = p_attr_char_value->init_offs + p_attr_char_value->init_len;
+    if (p_md->vloc == BLE_GATTS_VLOC_USER)
+    {
+        p_value->p_value = p_attr_char_value->p_value;
+    }
+    else if (p_attr_char_value->p_value != NULL)
+    {
+        memcpy(&p_value->value[p_attr_char_value->init_offs], p_attr_char_value->p_value, p_attr_char_value->init_len);
+    }
+    p_handles->value_handle     = m_attr_count;
+    p_handles->user_desc_handle = BLE_GATT_HANDLE_INVALID;
+    p_handles->cccd_handle      = BLE_GATT_HANDLE_INVALID;
+    p_handles->sccd_handle      = BLE_GATT_HANDLE_INVALID;
+
+    if (has_cccd)
+    {
+        sim_attr_t *p_cccd = attr_add(SIM_ATTR_CCCD, BLE_UUID_DESCRIPTOR_CLIENT_CHAR_CONFIG, BLE_UUID_TYPE_BLE);
+        p_cccd->props    = p_char_md->char_props;
+        p_cccd->writable = true;
+        p_cccd->max_len  = BLE_CCCD_VALUE_LEN;
+        p_cccd->len      = BLE_CCCD_VALUE_LEN;
+        if (p_char_md->p_cccd_md != NULL)
+        {
+            p_cccd->readable = (p_char_md->p_cccd_md->read_perm.sm != 0);
+            p_cccd->writable = (p_char_md->p_cccd_md->write_perm.sm != 0);
+        }
+        p_handles->cccd_handle = m_attr_count;
+    }
+
+    if (has_desc)
+    {
+        sim_attr_t *p_desc = attr_add(SIM_ATTR_USER_DESC, BLE_UUID_DESCRIPTOR_CHAR_USER_DESC, BLE_UUID_TYPE_BLE);
+        if (p_char_md->p_user_desc_md != NULL)
+        {
+            attr_perms_set(p_desc, p_char_md->p_user_desc_md);
+        }
+        p_desc->max_len = MAX(p_char_md->char_user_desc_max_size, p_char_md->char_user_desc_size);
+        p_desc->len     = p_char_md->char_user_desc_size;
+        memcpy(p_desc->value, p_char_md->p_char_user_desc, p_desc->len);
+        p_handles->user_desc_handle = m_attr_count;
+    }
+
+    SIM_RETURN(NRF_SUCCESS);
+}
+
+uint32_t sd_ble_gatts_value_set(uint16_t conn_handle, uint16_t handle, ble_gatts_value_t *p_value)
+{
+    sim_attr_t *p_attr = attr_get(handle);
+
+    if (p_attr == NULL)
+    {
+        SIM_RETURN(BLE_ERROR_INVALID_ATTR_HANDLE);
+    }
+    if (p_attr->kind == SIM_ATTR_CCCD)
+    {
+        sim_conn_t *p_conn = conn_get(conn_handle);
+        if (p_conn == NULL)
+        {
+            SIM_RETURN(BLE_ERROR_INVALID_CONN_HANDLE);
+        }
+        if (p_value->offset != 0 || p_value->len != BLE_CCCD_VALUE_LEN)
+        {
+            SIM_RETURN(NRF_ERROR_INVALID_PARAM);
+        }
+        p_conn->cccd[handle] = uint16_decode(p_value->p_value);
+        SIM_RETURN(NRF_SUCCESS);
+    }
+    if (p_attr->kind != SIM_ATTR_VALUE && p_attr->kind != SIM_ATTR_USER_DESC)
+    {
+        SIM_RETURN(NRF_ERROR_FORBIDDEN);
+    }
+    if (p_value->offset > p_attr->len)
+    {
+        SIM_RETURN(NRF_ERROR_INVALID_PARAM);
+    }
+    if (p_value->offset + p_value->len > p_attr->max_len)
+    {
+        SIM_RETURN(NRF_ERROR_DATA_SIZE);
+    }
+
+    if (p_value->p_value == NULL)
+    {
+        // A value in user memory is already in place, only its length changes
+        if (p_attr->p_value == p_attr->value)
+        {
+            SIM_RETURN(NRF_ERROR_INVALID_ADDR);
+        }
+        p_attr->len = p_value->offset + p_value->len;
+        SIM_RETURN(NRF_SUCCESS);
+    }
+
+    attr_write(p_attr, p_value->offset, p_value->p_value, p_value->len);
+    SIM_RETURN(NRF_SUCCESS);
+}
+
+uint32_t sd_ble_gatts_value_get(uint16_t conn_handle, uint16_t handle, ble_gatts_value_t *p_value)
+{
+    sim_attr_t const *p_attr = attr_get(handle);
+
+    if (p_attr == NULL)
+    {
+        SIM_RETURN(BLE_ERROR_INVALID_ATTR_HANDLE);
+    }
+    if (p_attr->kind == SIM_ATTR_CCCD)
+    {
+        sim_conn_t const *p_conn = conn_get(conn_handle);
+        if (p_conn == NULL)
+        {
+            SIM_RETURN(BLE_ERROR_INVALID_CONN_HANDLE);
+        }
+        if (p_value->p_value != NULL && p_value->len >= BLE_CCCD_VALUE_LEN)
+        {
+            uint16_encode(p_conn->cccd[handle], p_value->p_value);
+        }
+        p_value->len = BLE_CCCD_VALUE_LEN;
+        SIM_RETURN(NRF_SUCCESS);
+    }
+    if (p_value->offset > p_attr->len)
+    {
+        SIM_RETURN(NRF_ERROR_INVALID_PARAM);
+    }
+
+    uint16_t remaining = p_attr->len - p_value->offset;
+    if (p_value->p_value != NULL)
+    {
+        remaining = MIN(remaining, p_value->len);
+        memcpy(p_value->p_value, &p_attr->p_value[p_value->offset], remaining);
+    }
+    p_value->len = remaining;
+    SIM_RETURN(NRF_SUCCESS);
+}
+
+uint32_t sd_ble_gatts_hvx(uint16_t conn_handle, ble_gatts_hvx_params_t const *p_hvx_params)
+{
+    sim_conn_t *p_conn = conn_get(conn_handle);
+    sim_attr_t *p_attr = attr_get(p_hvx_params->handle);
+
+    if (p_conn == NULL)
+    {
+        SIM_RETURN(BLE_ERROR_INVALID_CONN_HANDLE);
+    }
+    if (p_attr == NULL)
+    {
+        SIM_RETURN(BLE_ERROR_INVALID_ATTR_HANDLE);
+    }
+    if (p_attr->kind != SIM_ATTR_VALUE)
+    {
+        SIM_RETURN(BLE_ERROR_GATTS_INVALID_ATTR_TYPE);
+    }
+
+    uint8_t type = p_hvx_params->type;
+    if ((type == BLE_GATT_HVX_NOTIFICATION && !p_attr->props.notify) ||
+        (type == BLE_GATT_HVX_INDICATION && !p_attr->props.indicate) ||
+        (type != BLE_GATT_HVX_NOTIFICATION && type != BLE_GATT_HVX_INDICATION))
+    {
+        SIM_RETURN(NRF_ERROR_INVALID_PARAM);
+    }
+    if (!p_conn->sys_attr_set)
+    {
+        SIM_RETURN(BLE_ERROR_GATTS_SYS_ATTR_MISSING);
+    }
+    if ((p_conn->cccd[p_hvx_params->handle + 1] & type) == 0)
+    {
+        SIM_RETURN(NRF_ERROR_INVALID_STATE);
+    }
+    if (type == BLE_GATT_HVX_INDICATION && (p_conn->ind_queued || p_conn->ind_sent))
+    {
+        SIM_RETURN(NRF_ERROR_BUSY);
+    }
+    if (type == BLE_GATT_HVX_NOTIFICATION && p_conn->hvn_count >= m_hvn_queue_size)
+    {
+        SIM_RETURN(NRF_ERROR_RESOURCES);
+    }
+
+    uint16_t offset = p_hvx_params->offset;
+    if (p_hvx_params->p_data != NULL)
+    {
+        // The value is updated, truncated to the attribute and to what fits the ATT MTU
+        uint16_t len = (p_hvx_params->p_len != NULL) ? *p_hvx_params->p_len : 0;
+        if (offset > p_attr->max_len)
+        {
+            SIM_RETURN(NRF_ERROR_INVALID_PARAM);
+        }
+        len = MIN(len, (uint16_t)(p_attr->max_len - offset));
+        len = MIN(len, (uint16_t)(p_conn->att_mtu - SIM_ATT_HVX_HEADER_LEN));
+        attr_write(p_attr, offset, p_hvx_params->p_data, len);
+        if (p_hvx_params->p_len != NULL)
+        {
+            *p_hvx_params->p_len = len;
+        }
+    }
+    else if (offset > p_attr->len)
+    {
+        SIM_RETURN(NRF_ERROR_INVALID_PARAM);
+    }
+
+    sim_hvx_t *p_hvx = (type == BLE_GATT_HVX_INDICATION)
+                       ? &p_conn->ind
+                       : &p_conn->hvn[(p_conn->hvn_head + p_conn->hvn_count) % SIM_HVN_QUEUE_MAX];
+    uint16_t   len   = MIN((uint16_t)(p_attr->len - offset), (uint16_t)(p_conn->att_mtu - SIM_ATT_HVX_HEADER_LEN));
+
+    p_hvx->handle = p_hvx_params->handle;
+    p_hvx->type   = type;
+    p_hvx->len    = len;
+    memcpy(p_hvx->data, &p_attr->p_value[offset], len);
+
+    if (type == BLE_GATT_HVX_INDICATION)
+    {
+        p_conn->ind_queued = true;
+    }
+    else
+    {
+        p_conn->hvn_count++;
+    }
+    if (p_hvx_params->p_data == NULL && p_hvx_params->p_len != NULL)
+    {
+        *p_hvx_params->p_len = len;
+    }
+    SIM_RETURN(NRF_SUCCESS);
+}
+
+uint32_t sd_ble_gatts_rw_authorize_reply(uint16_t conn_handle, ble_gatts_rw_authorize_reply_params_t const *p_reply)
+{
+    sim_conn_t *p_conn = conn_get(conn_handle);
+
+    if (p_conn == NULL)
+    {
+        SIM_RETURN(BLE_ERROR_INVALID_CONN_HANDLE);
+    }
+    if (p_conn->auth_type == BLE_GATTS_AUTHORIZE_TYPE_INVALID || p_conn->auth_type != p_reply->type)
+    {
+        SIM_RETURN(NRF_ERROR_INVALID_STATE);
+    }
+
+    ble_gatts_authorize_params_t const *p_params = (p_reply->type == BLE_GATTS_AUTHORIZE_TYPE_READ)
+                                                   ? &p_reply->params.read
+                                                   : &p_reply->params.write;
+    sim_attr_t *p_attr = attr_get(p_conn->auth_handle);
+
+    if (p_params->gatt_status == BLE_GATT_STATUS_SUCCESS && p_params->update && p_attr != NULL)
+    {
+        if (p_params->offset + p_params->len > p_attr->max_len)
+        {
+            SIM_RETURN(NRF_ERROR_INVALID_PARAM);
+        }
+        if (p_reply->type == BLE_GATTS_AUTHORIZE_TYPE_READ || p_conn->auth_op == BLE_GATTS_OP_WRITE_REQ ||
+            p_conn->auth_op == BLE_GATTS_OP_WRITE_CMD)
+        {
+            attr_write(p_attr, p_params->offset, p_params->p_data, p_params->len);
+        }
+    }
+
+    if (p_reply->type == BLE_GATTS_AUTHORIZE_TYPE_READ && p_params->gatt_status == BLE_GATT_STATUS_SUCCESS &&
+        p_attr != NULL)
+    {
+        p_conn->read_len  = p_attr->len - MIN(p_attr->len, p_conn->auth_offset);
+        p_conn->read_done = true;
+        memcpy(p_conn->read_data, &p_attr->p_value[p_conn->auth_offset], p_conn->read_len);
+    }
+
+    p_conn->auth_type    = BLE_GATTS_AUTHORIZE_TYPE_INVALID;
+    p_conn->auth_status  = p_params->gatt_status;
+    p_conn->auth_replied = true;
+    SIM_RETURN(NRF_SUCCESS);
+}
+
+uint32_t sd_ble_gatts_sys_attr_set(uint16_t conn_handle, uint8_t const *p_sys_attr_data, uint16_t len, uint32_t flags)
+{
+    sim_conn_t *p_conn = conn_get(conn_handle);
+
+    (void)flags;
+
+    if (p_conn == NULL)
+    {
+        SIM_RETURN(BLE_ERROR_INVALID_CONN_HANDLE);
+    }
+    if (p_sys_attr_data != NULL || len != 0)
+    {
+        // Only the "no bonding data" form is modelled
+        SIM_RETURN(NRF_ERROR_NOT_SUPPORTED);
+    }
+
+    memset(p_conn->cccd, 0, sizeof(p_conn->cccd));
+    p_conn->sys_attr_set = true;
+    SIM_RETURN(NRF_SUCCESS);
+}
+
+uint32_t sd_ble_gatts_exchange_mtu_reply(uint16_t conn_handle, uint16_t server_rx_mtu)
+{
+    sim_conn_t *p_conn = conn_get(conn_handle);
+
+    if (p_conn == NULL)
+    {
+        SIM_RETURN(BLE_ERROR_INVALID_CONN_HANDLE);
+    }
+    if (!p_conn->mtu_request_pending)
+    {
+        SIM_RETURN(NRF_ERROR_INVALID_STATE);
+    }
+    if (server_rx_mtu < BLE_GATT_ATT_MTU_DEFAULT || server_rx_mtu > m_att_mtu_max)
+    {
+        SIM_RETURN(NRF_ERROR_INVALID_PARAM);
+    }
+
+    p_conn->mtu_request_pending = false;
+    p_conn->mtu_exchanged       = true;
+    p_conn->att_mtu             = MAX(MIN(server_rx_mtu, p_conn->central.att_mtu), BLE_GATT_ATT_MTU_DEFAULT);
+    SIM_RETURN(NRF_SUCCESS);
+}
+
+uint32_t sd_ble_gattc_exchange_mtu_request(uint16_t conn_handle, uint16_t client_rx_mtu)
+{
+    sim_conn_t *p_conn = conn_get(conn_handle);
+    ble_evt_t   evt;
+
+    if (p_conn == NULL)
+    {
+        SIM_RETURN(BLE_ERROR_INVALID_CONN_HANDLE);
+    }
+    if (p_conn->mtu_exchanged || p_conn->mtu_request_pending)
+    {
+        SIM_RETURN(NRF_ERROR_INVALID_STATE);
+    }
+    if (client_rx_mtu < BLE_GATT_ATT_MTU_DEFAULT || client_rx_mtu > m_att_mtu_max)
+    {
+        SIM_RETURN(NRF_ERROR_INVALID_PARAM);
+    }
+
+    p_conn->mtu_exchanged = true;
+    p_conn->att_mtu       = MAX(MIN(client_rx_mtu, p_conn->central.att_mtu), BLE_GATT_ATT_MTU_DEFAULT);
+
+    memset(&evt, 0, sizeof(evt));
+    evt.header.evt_id                                          = BLE_GATTC_EVT_EXCHANGE_MTU_RSP;
+    evt.evt.gattc_evt.conn_handle                              = conn_handle;
+    evt.evt.gattc_evt.gatt_status                              = BLE_GATT_STATUS_SUCCESS;
+    evt.evt.gattc_evt.params.exchange_mtu_rsp.server_rx_mtu    = p_conn->central.att_mtu;
+    sim_evt_push(&evt, SIM_EVT_LEN(gattc_evt));
+    SIM_RETURN(NRF_SUCCESS);
+}
+
+uint32_t sd_ble_l2cap_ch_setup(uint16_t conn_handle, uint16_t *p_local_cid, ble_l2cap_ch_setup_params_t const *p_params)
+{
+    sim_conn_t *p_conn = conn_get(conn_handle);
+    ble_evt_t   evt;
+
+    if (p_conn == NULL)
+    {
+        SIM_RETURN(BLE_ERROR_INVALID_CONN_HANDLE);
+    }
+    if (!p_conn->l2cap.requested || p_conn->l2cap.open || *p_local_cid != SIM_L2CAP_CID)
+    {
+        SIM_RETURN(NRF_ERROR_INVALID_STATE);
+    }
+
+    memset(&evt, 0, sizeof(evt));
+    evt.evt.l2cap_evt.conn_handle = conn_handle;
+    evt.evt.l2cap_evt.local_cid   = SIM_L2CAP_CID;
+
+    if (p_params->status != BLE_L2CAP_CH_STATUS_CODE_SUCCESS)
+    {
+        p_conn->l2cap.requested = false;
+        evt.header.evt_id                                  = BLE_L2CAP_EVT_CH_SETUP_REFUSED;
+        evt.evt.l2cap_evt.params.ch_setup_refused.source   = BLE_L2CAP_CH_SETUP_REFUSED_SRC_LOCAL;
+        evt.evt.l2cap_evt.params.ch_setup_refused.status   = p_params->status;
+        sim_evt_push(&evt, SIM_EVT_LEN(l2cap_evt));
+        SIM_RETURN(NRF_SUCCESS);
+    }
+    if (p_params->rx_params.sdu_buf.p_data == NULL || p_params->rx_params.rx_mps > m_l2cap_cfg.rx_mps)
+    {
+        SIM_RETURN(NRF_ERROR_INVALID_PARAM);
+    }
+
+    p_conn->l2cap.open        = true;
+    p_conn->l2cap.rx_buf[0]   = p_params->rx_params.sdu_buf;
+    p_conn->l2cap.rx_count    = 1;
+
+    evt.header.evt_id                                   = BLE_L2CAP_EVT_CH_SETUP;
+    evt.evt.l2cap_evt.params.ch_setup.tx_params.tx_mtu  = p_conn->l2cap.peer_mtu;
+    evt.evt.l2cap_evt.params.ch_setup.tx_params.peer_mps = MIN(p_conn->l2cap.peer_mtu, m_l2cap_cfg.tx_mps);
+    evt.evt.l2cap_evt.params.ch_setup.tx_params.tx_mps  = m_l2cap_cfg.tx_mps;
+    evt.evt.l2cap_evt.params.ch_setup.tx_params.credits = p_conn->l2cap.peer_credits;
+    sim_evt_push(&evt, SIM_EVT_LEN(l2cap_evt));
+    SIM_RETURN(NRF_SUCCESS);
+}
+
+uint32_t sd_ble_l2cap_ch_release(uint16_t conn_handle, uint16_t local_cid)
+{
+    sim_conn_t *p_conn = conn_get(conn_handle);
+    ble_evt_t   evt;
+
+    if (p_conn == NULL)
+    {
+        SIM_RETURN(BLE_ERROR_INVALID_CONN_HANDLE);
+    }
+    if (!p_conn->l2cap.open || local_cid != SIM_L2CAP_CID)
+    {
+        SIM_RETURN(NRF_ERROR_NOT_FOUND);
+    }
+
+    memset(&p_conn->l2cap, 0, sizeof(p_conn->l2cap));
+
+    memset(&evt, 0, sizeof(evt));
+    evt.header.evt_id             = BLE_L2CAP_EVT_CH_RELEASED;
+    evt.evt.l2cap_evt.conn_handle = conn_handle;
+    evt.evt.l2cap_evt.local_cid   = SIM_L2CAP_CID;
+    sim_evt_push(&evt, SIM_EVT_LEN(l2cap_evt));
+    SIM_RETURN(NRF_SUCCESS);
+}
+
+uint32_t sd_ble_l2cap_ch_rx(uint16_t conn_handle, uint16_t local_cid, ble_data_t const *p_sdu_buf)
+{
+    sim_conn_t *p_conn = conn_get(conn_handle);
+
+    if (p_conn == NULL)
+    {
+        SIM_RETURN(BLE_ERROR_INVALID_CONN_HANDLE);
+    }
+    if (!p_conn->l2cap.open || local_cid != SIM_L2CAP_CID)
+    {
+        SIM_RETURN(NRF_ERROR_NOT_FOUND);
+    }
+    if (p_conn->l2cap.rx_count >= MAX(m_l2cap_cfg.rx_queue_size, 1))
+    {
+        SIM_RETURN(NRF_ERROR_RESOURCES);
+    }
+
+    p_conn->l2cap.rx_buf[p_conn->l2cap.rx_count++] = *p_sdu_buf;
+    SIM_RETURN(NRF_SUCCESS);
+}
+
+uint32_t sd_ble_l2cap_ch_tx(uint16_t conn_handle, uint16_t local_cid, ble_data_t const *p_sdu_buf)
+{
+    sim_conn_t *p_conn = conn_get(conn_handle);
+
+    if (p_conn == NULL)
+    {
+        SIM_RETURN(BLE_ERROR_INVALID_CONN_HANDLE);
+    }
+    if (!p_conn->l2cap.open || local_cid != SIM_L2CAP_CID)
+    {
+        SIM_RETURN(NRF_ERROR_NOT_FOUND);
+    }
+    if (p_sdu_buf->len > p_conn->l2cap.peer_mtu)
+    {
+        SIM_RETURN(NRF_ERROR_INVALID_PARAM);
+    }
+    if (p_conn->l2cap.tx_count >= MAX(m_l2cap_cfg.tx_queue_size, 1))
+    {
+        SIM_RETURN(NRF_ERROR_RESOURCES);
+    }
+
+    p_conn->l2cap.tx_queue[p_conn->l2cap.tx_count++] = *p_sdu_buf;
+    SIM_RETURN(NRF_SUCCESS);
+}
+
+uint32_t sd_ble_l2cap_ch_flow_control(uint16_t conn_handle, uint16_t local_cid, uint16_t credits, uint16_t *p_credits)
+{
+    sim_conn_t *p_conn = conn_get(conn_handle);
+
+    (void)credits;
+
+    if (p_conn == NULL)
+    {
+        SIM_RETURN(BLE_ERROR_INVALID_CONN_HANDLE);
+    }
+    if (!p_conn->l2cap.open || local_cid != SIM_L2CAP_CID)
+    {
+        SIM_RETURN(NRF_ERROR_NOT_FOUND);
+    }
+    if (p_credits != NULL)
+    {
+        *p_credits = 0;
+    }
+    SIM_RETURN(NRF_SUCCESS);
+}
+
+uint32_t sd_power_system_off(void)
+{
+    sim_call_record(__func__, NRF_SUCCESS);
+    sim_app_system_off();
+    return NRF_SUCCESS;
+}
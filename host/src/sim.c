@@ -0,0 +1,421 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ucontext.h>
+
+#include "app_timer.h"
+#include "nordic_common.h"
+#include "nrf_log.h"
+#include "sim.h"
+#include "sim_internal.h"
+
+#define SIM_APP_STACK_SIZE      (1024 * 1024)
+#define SIM_EVT_QUEUE_LEN       64
+#define SIM_PROCESS_MAX_ROUNDS  10000
+#define SIM_CALL_NAMES          64
+
+/**@brief Queued BLE event with room for a write of the longest attribute value. */
+typedef struct
+{
+    ble_evt_t evt;
+    uint8_t   extra[BLE_GATTS_VAR_ATTR_LEN_MAX];
+} sim_evt_buf_t;
+
+/**@brief Calls of one SoftDevice function. */
+typedef struct
+{
+    char const *p_name;
+    uint32_t    count;
+    uint32_t    failed;
+    uint32_t    last_error;
+} sim_call_t;
+
+static ucontext_t m_sim_ctx;
+static ucontext_t m_app_ctx;
+static uint8_t   *m_app_stack;
+static int      (*m_app_main)(void);
+static bool       m_app_started;
+static bool       m_in_app;
+static bool       m_in_isr;
+static bool       m_system_off;
+static jmp_buf    m_isr_jmp;
+
+static sim_evt_buf_t m_evt_queue[SIM_EVT_QUEUE_LEN];
+static uint32_t      m_evt_head;
+static uint32_t      m_evt_count;
+
+static uint64_t   m_now_ns;
+
+static sim_call_t m_calls[SIM_CALL_NAMES];
+static uint32_t   m_call_names;
+
+static sim_rx_t   m_rx_log[SIM_RX_LOG_LEN];
+static uint32_t   m_rx_total;
+static uint32_t   m_rx_first;
+
+void sim_reset(void)
+{
+    m_app_main    = NULL;
+    m_app_started = false;
+    m_in_app      = false;
+    m_in_isr      = false;
+    m_system_off  = false;
+    m_evt_head    = 0;
+    m_evt_count   = 0;
+    m_now_ns      = 0;
+    m_call_names  = 0;
+    m_rx_total    = 0;
+    m_rx_first    = 0;
+    memset(m_calls, 0, sizeof(m_calls));
+
+    sim_sd_reset();
+    sim_timer_reset();
+    sim_bsp_reset();
+    sim_log_reset();
+    sim_sdh_reset();
+}
+
+static void app_entry(void)
+{
+    m_app_main();
+
+    /* main() of the applications never returns */
+    fprintf(stderr, "sim: main() returned\n");
+    abort();
+}
+
+static void app_resume(void)
+{
+    if (!m_app_started || m_system_off || m_in_app)
+    {
+        return;
+    }
+
+    m_in_app = true;
+    swapcontext(&m_sim_ctx, &m_app_ctx);
+    m_in_app = false;
+}
+
+void sim_app_start(int (*app_main)(void))
+{
+    if (m_app_stack == NULL)
+    {
+        m_app_stack = malloc(SIM_APP_STACK_SIZE);
+    }
+
+    m_app_main = app_main;
+    getcontext(&m_app_ctx);
+    m_app_ctx.uc_stack.ss_sp   = m_app_stack;
+    m_app_ctx.uc_stack.ss_size = SIM_APP_STACK_SIZE;
+    m_app_ctx.uc_link          = NULL;
+    makecontext(&m_app_ctx, app_entry, 0);
+    m_app_started = true;
+
+    app_resume();
+    sim_process();
+}
+
+void sim_app_sleep(void)
+{
+    if (!m_in_app)
+    {
+        return;
+    }
+
+    swapcontext(&m_app_ctx, &m_sim_ctx);
+}
+
+void sim_app_system_off(void)
+{
+    m_system_off = true;
+
+    if (m_in_isr)
+    {
+        longjmp(m_isr_jmp, 1);
+    }
+    if (m_in_app)
+    {
+        /* Never resumed */
+        swapcontext(&m_app_ctx, &m_sim_ctx);
+    }
+}
+
+bool sim_system_off(void)
+{
+    return m_system_off;
+}
+
+void sim_isr(void (*isr)(void *p_context), void *p_context)
+{
+    if (m_system_off)
+    {
+        return;
+    }
+    if (m_in_isr)
+    {
+        /* Interrupts of the same priority do not nest */
+        isr(p_context);
+        return;
+    }
+
+    m_in_isr = true;
+    if (setjmp(m_isr_jmp) == 0)
+    {
+        isr(p_context);
+    }
+    m_in_isr = false;
+}
+
+void sim_evt_push(ble_evt_t const *p_evt, uint16_t len)
+{
+    if (m_evt_count == SIM_EVT_QUEUE_LEN)
+    {
+        fprintf(stderr, "sim: event queue overflow, event 0x%x dropped\n", p_evt->header.evt_id);
+        abort();
+    }
+
+    sim_evt_buf_t *p_buf = &m_evt_queue[(m_evt_head + m_evt_count) % SIM_EVT_QUEUE_LEN];
+    len = (len > sizeof(sim_evt_buf_t)) ? sizeof(sim_evt_buf_t) : len;
+    memset(p_buf, 0, sizeof(*p_buf));
+    memcpy(p_buf, p_evt, len);
+    p_buf->evt.header.evt_len = len;
+    m_evt_count++;
+}
+
+bool sim_evt_pending(void)
+{
+    return m_evt_count > 0;
+}
+
+static void evt_dispatch(void *p_context)
+{
+    static sim_evt_buf_t evt;
+
+    (void)p_context;
+    while (m_evt_count > 0)
+    {
+        evt = m_evt_queue[m_evt_head];
+        m_evt_head = (m_evt_head + 1) % SIM_EVT_QUEUE_LEN;
+        m_evt_count--;
+
+        sim_sd_evt_dispatching(&evt.evt);
+        nrf_sdh_ble_evt_dispatch(&evt.evt);
+    }
+}
+
+void sim_process(void)
+{
+    for (uint32_t round = 0; round < SIM_PROCESS_MAX_ROUNDS && !m_system_off; round++)
+    {
+        sim_isr(evt_dispatch, NULL);
+        app_resume();
+        if (!sim_evt_pending())
+        {
+            return;
+        }
+    }
+}
+
+uint64_t sim_ticks_to_ns(uint64_t ticks)
+{
+    return (ticks * 1000000000ULL + SIM_RTC_HZ - 1) / SIM_RTC_HZ;
+}
+
+uint64_t sim_ns_to_ticks(uint64_t ns)
+{
+    return ns * SIM_RTC_HZ / 1000000000ULL;
+}
+
+uint64_t sim_now_ns(void)
+{
+    return m_now_ns;
+}
+
+uint64_t sim_now_ticks(void)
+{
+    return sim_ns_to_ticks(m_now_ns);
+}
+
+void sim_time_set_ns(uint64_t now_ns)
+{
+    if (now_ns > m_now_ns)
+    {
+        m_now_ns = now_ns;
+    }
+}
+
+/* Runs the next thing due at or before end_ns, returns false if there is none */
+static bool time_step(uint64_t end_ns)
+{
+    uint64_t timer_ticks = sim_timer_next();
+    uint64_t timer_ns    = (timer_ticks == UINT64_MAX) ? UINT64_MAX : sim_ticks_to_ns(timer_ticks);
+    uint64_t sd_ns       = sim_sd_next_ns();
+
+    if (m_system_off || MIN(timer_ns, sd_ns) > end_ns)
+    {
+        return false;
+    }
+
+    // The radio has a higher priority than RTC1
+    if (sd_ns <= timer_ns)
+    {
+        sim_time_set_ns(sd_ns);
+        sim_sd_run();
+    }
+    else
+    {
+        sim_time_set_ns(timer_ns);
+        sim_isr(sim_timer_fire, NULL);
+        sim_process();
+    }
+    return true;
+}
+
+void sim_time_advance_ns(uint64_t delta_ns)
+{
+    uint64_t end_ns = m_now_ns + delta_ns;
+
+    while (time_step(end_ns))
+    {
+    }
+
+    // Time stops with the CPU, so a test can read when it happened
+    if (!m_system_off)
+    {
+        sim_time_set_ns(end_ns);
+    }
+}
+
+void sim_time_advance_ms(uint32_t delta_ms)
+{
+    sim_time_advance_ns((uint64_t)delta_ms * 1000000ULL);
+}
+
+bool sim_run_until(bool (*p_done)(void), uint64_t max_ns)
+{
+    uint64_t end_ns = m_now_ns + max_ns;
+
+    while (!p_done())
+    {
+        if (!time_step(end_ns))
+        {
+            if (!m_system_off)
+            {
+                sim_time_set_ns(end_ns);
+            }
+            return p_done();
+        }
+    }
+    return true;
+}
+
+static sim_call_t * call_find(char const *p_name, bool add)
+{
+    for (uint32_t i = 0; i < m_call_names; i++)
+    {
+        if (strcmp(m_calls[i].p_name, p_name) == 0)
+        {
+            return &m_calls[i];
+        }
+    }
+    if (!add || m_call_names == SIM_CALL_NAMES)
+    {
+        return NULL;
+    }
+
+    m_calls[m_call_names].p_name = p_name;
+    return &m_calls[m_call_names++];
+}
+
+uint32_t sim_call_record(char const *p_name, uint32_t err_code)
+{
+    sim_call_t *p_call = call_find(p_name, true);
+
+    if (p_call != NULL)
+    {
+        p_call->count++;
+        if (err_code != NRF_SUCCESS)
+        {
+            p_call->failed++;
+            p_call->last_error = err_code;
+        }
+    }
+    return err_code;
+}
+
+uint32_t sim_calls(char const *p_name)
+{
+    sim_call_t const *p_call = call_find(p_name, false);
+    return (p_call != NULL) ? p_call->count : 0;
+}
+
+uint32_t sim_calls_failed(char const *p_name)
+{
+    sim_call_t const *p_call = call_find(p_name, false);
+    return (p_call != NULL) ? p_call->failed : 0;
+}
+
+uint32_t sim_calls_last_error(char const *p_name)
+{
+    sim_call_t const *p_call = call_find(p_name, false);
+    return (p_call != NULL) ? p_call->last_error : NRF_SUCCESS;
+}
+
+void sim_rx_log(sim_rx_t const *p_rx)
+{
+    m_rx_log[m_rx_total % SIM_RX_LOG_LEN] = *p_rx;
+    m_rx_total++;
+}
+
+uint32_t sim_rx_count(void)
+{
+    uint32_t count = m_rx_total - m_rx_first;
+    return (count > SIM_RX_LOG_LEN) ? SIM_RX_LOG_LEN : count;
+}
+
+sim_rx_t const * sim_rx_get(uint32_t index)
+{
+    uint32_t count = sim_rx_count();
+
+    if (index >= count)
+    {
+        return NULL;
+    }
+    return &m_rx_log[(m_rx_total - count + index) % SIM_RX_LOG_LEN];
+}
+
+void sim_rx_clear(void)
+{
+    m_rx_first = m_rx_total;
+}
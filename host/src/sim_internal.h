@@ -0,0 +1,103 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#ifndef SIM_INTERNAL_H__
+#define SIM_INTERNAL_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ble.h"
+#include "sim.h"
+
+/**@brief Simulated RTC1 frequency, the rate app_timer counts at. */
+#define SIM_RTC_HZ      (APP_TIMER_CLOCK_FREQ / (APP_TIMER_CONFIG_RTC_FREQUENCY + 1))
+
+/**@brief Macro for recording a SoftDevice call and returning its result. */
+#define SIM_RETURN(_ret)    return sim_call_record(__func__, (_ret))
+
+/**@brief Function for recording a SoftDevice call, returns err_code. */
+uint32_t sim_call_record(char const *p_name, uint32_t err_code);
+
+/**@brief Function for converting simulated time between nanoseconds and RTC ticks. */
+uint64_t sim_ticks_to_ns(uint64_t ticks);
+uint64_t sim_ns_to_ticks(uint64_t ns);
+
+/**@brief Function for moving the simulated time forward to now_ns, never backwards. */
+void sim_time_set_ns(uint64_t now_ns);
+
+/**@brief Function for enabling the SoftDevice model with the configuration set so far. */
+uint32_t sim_sd_ble_enable(void);
+
+/**@brief Function for running code in interrupt context, returns early if it enters System OFF. */
+void sim_isr(void (*isr)(void *p_context), void *p_context);
+
+/**@brief Function for checking whether events are waiting for the observers. */
+bool sim_evt_pending(void);
+
+/**@brief Function for giving control back to the simulation from nrf_pwr_mgmt_run(). */
+void sim_app_sleep(void);
+
+/**@brief Function for entering System OFF from sd_power_system_off(). */
+void sim_app_system_off(void);
+
+/**@brief Function for delivering a BLE event to the observers, see nrf_sdh.c. */
+void nrf_sdh_ble_evt_dispatch(ble_evt_t const *p_ble_evt);
+
+/**@brief Function for getting the time of the next thing the SoftDevice does on its own.
+ *
+ * @details Advertising timing out, a connection parameter update reaching its instant or a
+ *          connection event with data to send. UINT64_MAX if there is none.
+ */
+uint64_t sim_sd_next_ns(void);
+
+/**@brief Function for running what the SoftDevice does at the current time. */
+void sim_sd_run(void);
+
+/**@brief Function for letting the SoftDevice model see an event just before the observers do. */
+void sim_sd_evt_dispatching(ble_evt_t const *p_ble_evt);
+
+/**@brief Function for adding a received notification or indication to the log. */
+void sim_rx_log(sim_rx_t const *p_rx);
+
+/**@brief Hooks of the library stand-ins, called by sim_reset(). */
+void sim_sd_reset(void);
+void sim_timer_reset(void);
+void sim_bsp_reset(void);
+void sim_log_reset(void);
+void sim_sdh_reset(void);
+
+/**@brief Function for getting the RTC tick of the next app_timer timeout, UINT64_MAX if none is running. */
+uint64_t sim_timer_next(void);
+
+/**@brief Function for running the handlers of the timers that are due (in interrupt context). */
+void sim_timer_fire(void *p_context);
+
+#endif /* SIM_INTERNAL_H__ */
@@ -0,0 +1,166 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#ifndef SAMPLE_DECODE_H__
+#define SAMPLE_DECODE_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "app_util.h"
+#include "estc_codec.h"
+#include "estc_sampler.h"
+
+/**@file
+ *
+ * @brief Decoder of the characteristic 3 sample packets, as a central runs it.
+ *
+ * @details Reverses the packet encoding of estc_sampler.c with the codec the firmware uses. The
+ *          tests decode what the central received, so the packets are checked from the outside.
+ */
+
+/**@brief Decoded sample packet. */
+typedef struct
+{
+    uint8_t  seq;                                               /**< Sequence number of the packet. */
+    uint8_t  kind;                                              /**< estc_sampler_kind_t of the records. */
+    uint8_t  encoding;                                          /**< estc_sampler_encoding_t of the records. */
+    uint8_t  count;                                             /**< Number of records. */
+    estc_sampler_record_t records[ESTC_SAMPLER_RECORDS_MAX];    /**< Records, ticks as RTC counter values. */
+} sample_packet_t;
+
+/**@brief Function for decoding a sample packet.
+ *
+ * @param[in]  data    Notification value.
+ * @param[in]  len     Length of the value.
+ * @param[out] packet  Decoded packet.
+ *
+ * @return True if the packet decoded and used every byte of the value.
+ */
+static inline bool sample_packet_decode(uint8_t const *data, uint16_t len, sample_packet_t *packet)
+{
+    static uint32_t column[ESTC_SAMPLER_RECORDS_MAX];
+
+    if (len < ESTC_SAMPLER_HEADER_LEN || 0 == data[2])
+    {
+        return false;
+    }
+
+    memset(packet, 0, sizeof(*packet));
+    packet->seq      = data[0];
+    packet->kind     = data[1] & 0x0F;
+    packet->encoding = data[1] >> 4;
+    packet->count    = data[2];
+
+    uint8_t  fields = (ESTC_SAMPLER_KIND_SUMMARY == packet->kind) ? ESTC_SAMPLER_FIELDS_MAX : 1;
+    uint32_t first  = uint32_decode(&data[3]);
+    uint16_t pos    = ESTC_SAMPLER_HEADER_LEN;
+
+    switch (packet->encoding)
+    {
+        case ESTC_SAMPLER_ENCODING_FIXED:
+            for (uint8_t i = 0; i < packet->count; i++)
+            {
+                if (pos + sizeof(uint16_t) * (1 + fields) > len)
+                {
+                    return false;
+                }
+                packet->records[i].ticks = first + uint16_decode(&data[pos]);
+                pos += sizeof(uint16_t);
+                for (uint8_t j = 0; j < fields; j++)
+                {
+                    packet->records[i].values[j] = uint16_decode(&data[pos]);
+                    pos += sizeof(uint16_t);
+                }
+            }
+            break;
+
+        case ESTC_SAMPLER_ENCODING_DELTA:
+            for (uint8_t i = 0; i < packet->count; i++)
+            {
+                estc_sampler_record_t const *prev = (i > 0) ? &packet->records[i - 1] : NULL;
+                for (uint8_t j = 0; j <= fields; j++)
+                {
+                    uint32_t value;
+                    uint8_t  used = estc_codec_varint_decode(&data[pos], len - pos, &value);
+                    if (0 == used)
+                    {
+                        return false;
+                    }
+                    pos += used;
+
+                    if (0 == j)
+                    {
+                        packet->records[i].ticks = ((NULL == prev) ? first : prev->ticks) + value;
+                    }
+                    else
+                    {
+                        int32_t reference = (NULL == prev) ? 0 : prev->values[j - 1];
+                        packet->records[i].values[j - 1] = (uint16_t)(reference + estc_codec_zigzag_decode(value));
+                    }
+                }
+            }
+            break;
+
+        case ESTC_SAMPLER_ENCODING_BLOCK:
+            for (uint8_t j = 0; j <= fields; j++)
+            {
+                uint16_t used = estc_codec_block_decode(&data[pos], len - pos, column, packet->count);
+                if (0 == used)
+                {
+                    return false;
+                }
+                pos += used;
+
+                for (uint8_t i = 0; i < packet->count; i++)
+                {
+                    estc_sampler_record_t const *prev = (i > 0) ? &packet->records[i - 1] : NULL;
+                    if (0 == j)
+                    {
+                        packet->records[i].ticks = ((NULL == prev) ? first : prev->ticks) + column[i];
+                    }
+                    else
+                    {
+                        int32_t reference = (NULL == prev) ? 0 : prev->values[j - 1];
+                        packet->records[i].values[j - 1] = (uint16_t)(reference + estc_codec_zigzag_decode(column[i]));
+                    }
+                }
+            }
+            break;
+
+        default:
+            return false;
+    }
+
+    return pos == len;
+}
+
+#endif /* SAMPLE_DECODE_H__ */
@@ -0,0 +1,107 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#ifndef TEST_H__
+#define TEST_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "sim.h"
+
+/**@file
+ *
+ * @brief Minimal test runner for the host build.
+ *
+ * @details Every test runs in a child process, the applications keep their state in statics
+ *          and a failed APP_ERROR_CHECK aborts, so a test can neither leak state into the next
+ *          one nor take the whole suite down. Set SIM_VERBOSE in the environment to see the
+ *          log lines of the application.
+ */
+
+/**@brief Macro for failing the running test when a condition does not hold. */
+#define CHECK(expr)                                                                     \
+    do                                                                                  \
+    {                                                                                   \
+        if (!(expr))                                                                    \
+        {                                                                               \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #expr);    \
+            exit(1);                                                                    \
+        }                                                                               \
+    } while (0)
+
+/**@brief Macro for failing the running test when two integers differ. */
+#define CHECK_EQ(actual, expected)                                                      \
+    do                                                                                  \
+    {                                                                                   \
+        long long const _a = (long long)(actual);                                       \
+        long long const _e = (long long)(expected);                                     \
+        if (_a != _e)                                                                   \
+        {                                                                               \
+            fprintf(stderr, "%s:%d: %s is %lld, expected %lld\n",                       \
+                    __FILE__, __LINE__, #actual, _a, _e);                               \
+            exit(1);                                                                    \
+        }                                                                               \
+    } while (0)
+
+/**@brief Macro for running a test function, counts failures in the caller's test_failures. */
+#define RUN_TEST(fn)    test_failures += test_run(#fn, fn)
+
+/**@brief Function for running one test in a fresh process with a reset simulation.
+ *
+ * @return 1 if the test failed, 0 otherwise.
+ */
+static inline int test_run(char const *p_name, void (*test)(void))
+{
+    fflush(stdout);
+    pid_t pid = fork();
+
+    if (pid == 0)
+    {
+        sim_reset();
+        sim_log_verbose_set(getenv("SIM_VERBOSE") != NULL);
+        test();
+        fflush(stdout);
+        _exit(0);
+    }
+
+    int status = 0;
+    (void)waitpid(pid, &status, 0);
+
+    bool passed = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    printf("%-6s %s\n", passed ? "PASS" : "FAIL", p_name);
+    return passed ? 0 : 1;
+}
+
+#endif /* TEST_H__ */
@@ -0,0 +1,95 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#include <string.h>
+
+#include "ble_gap.h"
+#include "ble_hci.h"
+#include "test.h"
+
+int app_main(void);
+
+static void test_boot_advertises(void)
+{
+    sim_app_start(app_main);
+
+    CHECK(sim_advertising());
+    CHECK_EQ(sim_calls_failed("sd_ble_gap_adv_start"), 0);
+    CHECK_EQ(sim_bsp_indication(), BSP_INDICATE_ADVERTISING);
+}
+
+static void test_adv_data_has_name_and_flags(void)
+{
+    sim_app_start(app_main);
+
+    ble_data_t     adv = sim_adv_data();
+    ble_data_t     all = adv;
+    uint8_t const *p_field;
+
+    CHECK(adv.len > 0);
+    CHECK_EQ(sim_adv_field(&adv, BLE_GAP_AD_TYPE_FLAGS, &p_field), 1);
+
+    ble_data_t rsp = sim_scan_rsp_data();
+    uint8_t    len = sim_adv_field(&all, BLE_GAP_AD_TYPE_COMPLETE_LOCAL_NAME, &p_field);
+    if (len == 0)
+    {
+        len = sim_adv_field(&rsp, BLE_GAP_AD_TYPE_COMPLETE_LOCAL_NAME, &p_field);
+    }
+    if (len == 0)
+    {
+        len = sim_adv_field(&all, BLE_GAP_AD_TYPE_SHORT_LOCAL_NAME, &p_field);
+    }
+    CHECK(len > 0);
+}
+
+static void test_connect_stops_advertising(void)
+{
+    sim_app_start(app_main);
+
+    uint16_t conn_handle = sim_connect(NULL);
+
+    CHECK(conn_handle != BLE_CONN_HANDLE_INVALID);
+    CHECK(!sim_advertising());
+    CHECK_EQ(sim_bsp_indication(), BSP_INDICATE_CONNECTED);
+
+    sim_disconnect(conn_handle, BLE_HCI_REMOTE_USER_TERMINATED_CONNECTION);
+    CHECK(sim_advertising());
+}
+
+int main(void)
+{
+    int test_failures = 0;
+
+    RUN_TEST(test_boot_advertises);
+    RUN_TEST(test_adv_data_has_name_and_flags);
+    RUN_TEST(test_connect_stops_advertising);
+
+    return test_failures ? 1 : 0;
+}
@@ -0,0 +1,222 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#include <string.h>
+
+#include "app_util.h"
+#include "estc_service.h"
+#include "test.h"
+
+int app_main(void);
+
+#define TEST_ARQ_BYTES      20000   /**< Size of the requested transfer. */
+#define TEST_ARQ_LOSS_EVERY 5       /**< The first transmission of every fifth frame is lost. */
+#define TEST_ARQ_MAX_FRAMES 256     /**< Frames the central keeps track of. */
+
+/**@brief Central stand-in receiving reliable frames over a lossy link. */
+typedef struct
+{
+    uint16_t handle;                            /**< Handle of the reliable characteristic. */
+    uint16_t max_segment;                       /**< Segment length of all frames but the last one. */
+    uint8_t  copies[TEST_ARQ_MAX_FRAMES];       /**< Transmissions of each frame that reached the central. */
+    uint8_t  dropped[TEST_ARQ_MAX_FRAMES];      /**< Transmissions of each frame that were lost. */
+    uint16_t segment_len[TEST_ARQ_MAX_FRAMES];  /**< Length of the segment of each received frame. */
+    uint8_t  data[TEST_ARQ_BYTES + NRF_SDH_BLE_GATT_MAX_MTU_SIZE];
+    uint16_t frames;                            /**< Frames seen, one past the highest sequence number. */
+    uint16_t expected;                          /**< Lowest sequence number not received. */
+    uint32_t duplicates;                        /**< Frames received more than once. */
+} arq_central_t;
+
+static arq_central_t m_central;
+
+static void arq_rx_handler(sim_rx_t const *p_rx, void *p_context)
+{
+    arq_central_t *p_central = (arq_central_t *)p_context;
+
+    if (p_rx->handle != p_central->handle || p_rx->len < ESTC_ARQ_SEQ_LEN)
+    {
+        return;
+    }
+
+    uint16_t seq = uint16_decode(p_rx->data);
+    if (seq >= TEST_ARQ_MAX_FRAMES)
+    {
+        return;
+    }
+    if (0 == (seq % TEST_ARQ_LOSS_EVERY) && 0 == p_central->dropped[seq])
+    {
+        p_central->dropped[seq]++;
+        return;
+    }
+
+    if (p_central->copies[seq]++ > 0)
+    {
+        p_central->duplicates++;
+        return;
+    }
+
+    // Segments are cut in order and all but the last one are full
+    uint16_t segment_len = p_rx->len - ESTC_ARQ_SEQ_LEN;
+    memcpy(&p_central->data[(uint32_t)seq * p_central->max_segment], &p_rx->data[ESTC_ARQ_SEQ_LEN], segment_len);
+    p_central->segment_len[seq] = segment_len;
+    p_central->frames = MAX(p_central->frames, seq + 1);
+}
+
+/**@brief Function for writing an acknowledgement of everything the central received so far. */
+static void arq_ack_write(uint16_t conn_handle, arq_central_t *p_central)
+{
+    while (p_central->expected < TEST_ARQ_MAX_FRAMES && p_central->copies[p_central->expected] > 0)
+    {
+        p_central->expected++;
+    }
+
+    uint16_t selective = 0;
+    for (uint16_t bit = 0; bit < 16; bit++)
+    {
+        uint32_t seq = p_central->expected + 1 + bit;
+        if (seq < TEST_ARQ_MAX_FRAMES && p_central->copies[seq] > 0)
+        {
+            selective |= (uint16_t)(1u << bit);
+        }
+    }
+
+    uint8_t ack[ESTC_ARQ_ACK_LEN];
+    ack[0] = ESTC_ARQ_ACK_OPCODE;
+    (void)uint16_encode(p_central->expected, &ack[1]);
+    (void)uint16_encode(selective, &ack[3]);
+    CHECK_EQ(sim_write(conn_handle, p_central->handle, BLE_GATTS_OP_WRITE_CMD, ack, sizeof(ack)),
+             BLE_GATT_STATUS_SUCCESS);
+}
+
+/**@brief A transfer requested on the reliable characteristic arrives complete and in order over
+ *        a link that loses frames, every lost frame is sent again once and no received frame is
+ *        sent again by the acknowledgements that follow its retransmission.
+ */
+static void test_lossy_transfer_completes(void)
+{
+    sim_central_t central;
+
+    sim_app_start(app_main);
+    memset(&m_central, 0, sizeof(m_central));
+    m_central.handle = sim_char_find(ESTC_CHAR_RELIABLE_UUID_16);
+    CHECK(m_central.handle != BLE_GATT_HANDLE_INVALID);
+
+    sim_central_default(&central);
+    central.rx_handler = arq_rx_handler;
+    central.p_context  = &m_central;
+
+    uint16_t conn_handle = sim_connect(&central);
+    CHECK_EQ(sim_subscribe(conn_handle, m_central.handle, BLE_GATT_HVX_NOTIFICATION), BLE_GATT_STATUS_SUCCESS);
+    m_central.max_segment = sim_conn_att_mtu(conn_handle) - ESTC_TX_ATT_HEADER_LEN - ESTC_ARQ_SEQ_LEN;
+
+    uint8_t request[sizeof(uint32_t)];
+    (void)uint32_encode(TEST_ARQ_BYTES, request);
+    CHECK_EQ(sim_write(conn_handle, m_central.handle, BLE_GATTS_OP_WRITE_REQ, request, sizeof(request)),
+             BLE_GATT_STATUS_SUCCESS);
+
+    // The central acknowledges what it has every 10 ms
+    uint32_t received = 0;
+    for (uint32_t step = 0; step < 3000 && received < TEST_ARQ_BYTES; step++)
+    {
+        sim_time_advance_ms(10);
+        arq_ack_write(conn_handle, &m_central);
+
+        received = 0;
+        for (uint16_t seq = 0; seq < m_central.expected; seq++)
+        {
+            received += m_central.segment_len[seq];
+        }
+    }
+
+    CHECK_EQ(received, TEST_ARQ_BYTES);
+    for (uint32_t i = 0; i < TEST_ARQ_BYTES; i++)
+    {
+        CHECK_EQ(m_central.data[i], (uint8_t)i);
+    }
+
+    uint32_t lost = 0;
+    for (uint16_t seq = 0; seq < m_central.frames; seq++)
+    {
+        CHECK(m_central.dropped[seq] <= 1);
+        lost += m_central.dropped[seq];
+    }
+    CHECK(lost > 0);
+    CHECK_EQ(m_central.duplicates, 0);
+
+    // Nothing is sent once everything is acknowledged
+    uint32_t frames = sim_rx_count();
+    sim_time_advance_ms(2000);
+    CHECK_EQ(sim_rx_count(), frames);
+}
+
+/**@brief Data written to characteristic 1 is never taken as an acknowledgement, even when it
+ *        has the shape of one while frames are in flight.
+ */
+static void test_ack_shaped_data_is_not_an_ack(void)
+{
+    sim_app_start(app_main);
+    uint16_t char1    = sim_char_find(ESTC_CHAR_1_UUID_16);
+    uint16_t reliable = sim_char_find(ESTC_CHAR_RELIABLE_UUID_16);
+
+    uint16_t conn_handle = sim_connect(NULL);
+    CHECK_EQ(sim_subscribe(conn_handle, reliable, BLE_GATT_HVX_NOTIFICATION), BLE_GATT_STATUS_SUCCESS);
+
+    uint8_t request[sizeof(uint32_t)];
+    (void)uint32_encode(TEST_ARQ_BYTES, request);
+    CHECK_EQ(sim_write(conn_handle, reliable, BLE_GATTS_OP_WRITE_REQ, request, sizeof(request)),
+             BLE_GATT_STATUS_SUCCESS);
+
+    // Shaped like an acknowledgement of the first frame
+    uint8_t data[ESTC_ARQ_ACK_LEN] = {ESTC_ARQ_ACK_OPCODE, 1, 0, 0, 0};
+    CHECK_EQ(sim_write(conn_handle, char1, BLE_GATTS_OP_WRITE_CMD, data, sizeof(data)), BLE_GATT_STATUS_SUCCESS);
+
+    // Without acknowledgements the first frame is sent again after the retransmission timeout
+    sim_time_advance_ms(ESTC_ARQ_RTO_MS * 2);
+    uint32_t copies = 0;
+    for (uint32_t i = 0; i < sim_rx_count(); i++)
+    {
+        sim_rx_t const *rx = sim_rx_get(i);
+        if (rx->handle == reliable && 0 == uint16_decode(rx->data))
+        {
+            copies++;
+        }
+    }
+    CHECK(copies > 1);
+}
+
+int main(void)
+{
+    int test_failures = 0;
+
+    RUN_TEST(test_lossy_transfer_completes);
+    RUN_TEST(test_ack_shaped_data_is_not_an_ack);
+
+    return test_failures ? 1 : 0;
+}
@@ -0,0 +1,195 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "app_util.h"
+#include "estc_service.h"
+#include "estc_throughput.h"
+#include "test.h"
+
+int app_main(void);
+
+#define TEST_BENCH_BYTES    50000   /**< Data bytes of every run. */
+#define TEST_HVN_QUEUE_SIZE 8       /**< APP_HVN_TX_QUEUE_SIZE of the application. */
+
+/**@brief Link settings of one benchmark run. */
+typedef struct
+{
+    uint16_t att_mtu;               /**< ATT MTU the central accepts. */
+    uint8_t  data_length;           /**< LL payload the central accepts. */
+    uint8_t  phys;                  /**< PHYs the central supports. */
+    uint16_t conn_interval;         /**< Connection interval the central keeps (in 1.25 ms units). */
+} bench_config_t;
+
+/**@brief What the central stand-in saw of a run. */
+typedef struct
+{
+    uint16_t data_handle;           /**< Handle of the benchmark data characteristic. */
+    uint16_t report_handle;         /**< Handle of the benchmark report characteristic. */
+    uint32_t bytes;                 /**< Data bytes received. */
+    uint32_t packets;               /**< Data packets received. */
+    uint32_t events;                /**< Connection events that delivered data packets. */
+    uint64_t last_event_ns;         /**< Time of the last event with data packets, UINT64_MAX before the first. */
+    bool     report_received;       /**< The report was notified. */
+    uint8_t  report[ESTC_BENCH_REPORT_LEN];
+} bench_central_t;
+
+static bench_central_t m_central;
+
+static void bench_rx_handler(sim_rx_t const *p_rx, void *p_context)
+{
+    bench_central_t *central = (bench_central_t *)p_context;
+
+    if (p_rx->handle == central->data_handle)
+    {
+        if (p_rx->time_ns != central->last_event_ns)
+        {
+            central->events++;
+            central->last_event_ns = p_rx->time_ns;
+        }
+        central->packets++;
+        central->bytes += p_rx->len - ESTC_BENCH_SEQ_LEN - ESTC_BENCH_CRC_LEN;
+    }
+    else if (p_rx->handle == central->report_handle && p_rx->len == ESTC_BENCH_REPORT_LEN)
+    {
+        memcpy(central->report, p_rx->data, sizeof(central->report));
+        central->report_received = true;
+    }
+}
+
+static bool bench_report_received(void)
+{
+    return m_central.report_received;
+}
+
+static bench_config_t const *m_config;
+
+/**@brief Runs the benchmark as the central stand-in with the settings in m_config and prints
+ *        the report of the firmware next to what the central measured and what
+ *        estc_throughput_estimate predicts for the link.
+ */
+static void test_bench_report(void)
+{
+    bench_config_t const *config = m_config;
+    sim_central_t central;
+
+    sim_app_start(app_main);
+
+    memset(&m_central, 0, sizeof(m_central));
+    m_central.last_event_ns = UINT64_MAX;
+    m_central.data_handle   = sim_char_find(ESTC_CHAR_BENCH_DATA_UUID_16);
+    m_central.report_handle = sim_char_find(ESTC_CHAR_BENCH_REPORT_UUID_16);
+
+    // The central keeps its interval, so the run measures the configured one
+    sim_central_default(&central);
+    central.att_mtu                       = config->att_mtu;
+    central.data_length                   = config->data_length;
+    central.phys                          = config->phys;
+    central.accept_conn_params            = false;
+    central.conn_params.min_conn_interval = config->conn_interval;
+    central.conn_params.max_conn_interval = config->conn_interval;
+    central.rx_handler                    = bench_rx_handler;
+    central.p_context                     = &m_central;
+
+    uint16_t conn_handle = sim_connect(&central);
+    CHECK(conn_handle != BLE_CONN_HANDLE_INVALID);
+    CHECK_EQ(sim_subscribe(conn_handle, m_central.data_handle, BLE_GATT_HVX_NOTIFICATION), BLE_GATT_STATUS_SUCCESS);
+    CHECK_EQ(sim_subscribe(conn_handle, m_central.report_handle, BLE_GATT_HVX_NOTIFICATION), BLE_GATT_STATUS_SUCCESS);
+
+    uint8_t request[sizeof(uint32_t)];
+    (void)uint32_encode(TEST_BENCH_BYTES, request);
+    uint64_t start_ns = sim_now_ns();
+    CHECK_EQ(sim_write(conn_handle, m_central.report_handle, BLE_GATTS_OP_WRITE_REQ, request, sizeof(request)),
+             BLE_GATT_STATUS_SUCCESS);
+    CHECK(sim_run_until(bench_report_received, 60ULL * 1000000000ULL));
+
+    estc_bench_report_t report;
+    report.bytes                 = uint32_decode(&m_central.report[0]);
+    report.packets               = uint32_decode(&m_central.report[4]);
+    report.elapsed_ms            = uint32_decode(&m_central.report[8]);
+    report.bytes_per_second      = uint32_decode(&m_central.report[12]);
+    report.packets_per_event_x10 = uint16_decode(&m_central.report[16]);
+
+    uint32_t elapsed_ms  = (uint32_t)((m_central.last_event_ns - start_ns) / 1000000);
+    uint32_t central_bps = (uint32_t)(((uint64_t)m_central.bytes * 1000) / elapsed_ms);
+
+    estc_throughput_params_t   params;
+    estc_throughput_estimate_t estimate;
+    params.att_mtu         = sim_conn_att_mtu(conn_handle);
+    params.data_length     = sim_conn_data_length(conn_handle);
+    params.phy             = sim_conn_phy(conn_handle);
+    params.conn_interval   = config->conn_interval;
+    params.event_length    = NRF_SDH_BLE_GAP_EVENT_LENGTH;
+    params.event_extension = true;
+    params.tx_queue_size   = TEST_HVN_QUEUE_SIZE;
+    estc_throughput_estimate(&params, &estimate);
+
+    printf("       MTU %3d, DL %3d, %s, %5.2f ms: %6d bytes/s, %2d.%d packets/event, %5d ms"
+           " (central %6d bytes/s, %5d ms; predicted %d packets/event)\n",
+           params.att_mtu, params.data_length, (BLE_GAP_PHY_2MBPS == params.phy) ? "2M" : "1M",
+           config->conn_interval * 1.25, report.bytes_per_second,
+           report.packets_per_event_x10 / 10, report.packets_per_event_x10 % 10, report.elapsed_ms,
+           central_bps, elapsed_ms, estimate.notifications_per_event);
+
+    // Both ends agree on what was sent and how long it took
+    CHECK_EQ(report.bytes, TEST_BENCH_BYTES);
+    CHECK_EQ(m_central.bytes, TEST_BENCH_BYTES);
+    CHECK_EQ(report.packets, m_central.packets);
+    CHECK(report.elapsed_ms + 1 >= elapsed_ms && report.elapsed_ms <= elapsed_ms + 1);
+    CHECK_EQ(report.packets_per_event_x10, (m_central.packets * 10) / m_central.events);
+
+    // Full connection events, only the last one may be shorter
+    uint32_t events = CEIL_DIV(report.packets, estimate.notifications_per_event);
+    CHECK_EQ(report.packets_per_event_x10, (report.packets * 10) / events);
+}
+
+int main(void)
+{
+    static const bench_config_t configs[] =
+    {
+        { BLE_GATT_ATT_MTU_DEFAULT, BLE_GAP_DATA_LENGTH_DEFAULT, BLE_GAP_PHY_1MBPS, MSEC_TO_UNITS(30, UNIT_1_25_MS) },
+        { 247, 251, BLE_GAP_PHY_1MBPS, MSEC_TO_UNITS(30, UNIT_1_25_MS) },
+        { 247, 251, BLE_GAP_PHY_1MBPS | BLE_GAP_PHY_2MBPS, MSEC_TO_UNITS(30, UNIT_1_25_MS) },
+        { 247, 251, BLE_GAP_PHY_1MBPS, MSEC_TO_UNITS(7.5, UNIT_1_25_MS) },
+        { 247, 251, BLE_GAP_PHY_1MBPS, MSEC_TO_UNITS(50, UNIT_1_25_MS) },
+        { 247, 27, BLE_GAP_PHY_1MBPS, MSEC_TO_UNITS(15, UNIT_1_25_MS) },
+    };
+    int test_failures = 0;
+
+    for (uint32_t i = 0; i < ARRAY_SIZE(configs); i++)
+    {
+        m_config = &configs[i];
+        RUN_TEST(test_bench_report);
+    }
+
+    return test_failures ? 1 : 0;
+}
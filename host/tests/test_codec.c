@@ -0,0 +1,296 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "app_util.h"
+#include "estc_codec.h"
+#include "estc_service.h"
+#include "sample_decode.h"
+#include "sensorsim.h"
+#include "test.h"
+
+int app_main(void);
+
+#define TEST_TRACE_LEN      4096    /**< Samples in a trace. */
+#define TEST_BLOCK_LEN      64      /**< Values per bit-packed block in the benchmark. */
+#define TEST_BENCH_RUNS     200     /**< Encodings of each trace timed in the benchmark. */
+
+static uint32_t m_random = 1;   /**< State of the trace generator. */
+
+/**@brief Function for getting a pseudo-random number, the same sequence in every run. */
+static uint32_t random_next(void)
+{
+    m_random = m_random * 1103515245 + 12345;
+    return m_random >> 8;
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**@brief Values at the edges of every coding come back unchanged, truncated input is rejected.
+ */
+static void test_codec_round_trip(void)
+{
+    static int32_t const  signed_values[]   = { 0, 1, -1, 63, -64, 64, INT32_MAX, INT32_MIN };
+    static uint32_t const unsigned_values[] = { 0, 1, 127, 128, 16383, 16384, 0x0FFFFFFF, 0x10000000, UINT32_MAX };
+    uint8_t  buffer[ESTC_CODEC_VARINT_MAX_LEN + 1];
+    uint32_t value;
+
+    for (uint32_t i = 0; i < ARRAY_SIZE(signed_values); i++)
+    {
+        CHECK_EQ(estc_codec_zigzag_decode(estc_codec_zigzag_encode(signed_values[i])), signed_values[i]);
+        CHECK((uint64_t)estc_codec_zigzag_encode(signed_values[i]) <= 2 * (uint64_t)llabs(signed_values[i]));
+    }
+
+    for (uint32_t i = 0; i < ARRAY_SIZE(unsigned_values); i++)
+    {
+        uint8_t len = estc_codec_varint_encode(unsigned_values[i], buffer);
+        CHECK_EQ(len, estc_codec_varint_len(unsigned_values[i]));
+        CHECK_EQ(estc_codec_varint_decode(buffer, len, &value), len);
+        CHECK_EQ(value, unsigned_values[i]);
+        CHECK_EQ(estc_codec_varint_decode(buffer, len - 1, &value), 0);
+    }
+
+    for (uint8_t width = 0; width <= 32; width++)
+    {
+        uint32_t values[TEST_BLOCK_LEN];
+        uint32_t decoded[TEST_BLOCK_LEN];
+        uint8_t  block[1 + TEST_BLOCK_LEN * sizeof(uint32_t)];
+        uint32_t mask = (width < 32) ? ((1UL << width) - 1) : UINT32_MAX;
+
+        for (uint32_t i = 0; i < TEST_BLOCK_LEN; i++)
+        {
+            values[i] = (random_next() ^ (random_next() << 16)) & mask;
+        }
+        uint16_t len = estc_codec_block_encode(values, TEST_BLOCK_LEN, width, block);
+        CHECK_EQ(len, estc_codec_block_len(width, TEST_BLOCK_LEN));
+        CHECK_EQ(estc_codec_block_decode(block, len, decoded, TEST_BLOCK_LEN), len);
+        CHECK_EQ(memcmp(values, decoded, sizeof(values)), 0);
+        CHECK_EQ(estc_codec_block_decode(block, len - 1, decoded, TEST_BLOCK_LEN), 0);
+    }
+}
+
+/**@brief Function for coding a trace as zigzag deltas, as varints or in bit-packed blocks.
+ *
+ * @return Encoded length (in bytes).
+ */
+static uint32_t trace_encode(uint16_t const *trace, bool block, uint8_t *out)
+{
+    uint32_t deltas[TEST_BLOCK_LEN];
+    uint32_t len = 0;
+
+    for (uint32_t start = 0; start < TEST_TRACE_LEN; start += TEST_BLOCK_LEN)
+    {
+        uint32_t bits = 0;
+        for (uint32_t i = 0; i < TEST_BLOCK_LEN; i++)
+        {
+            int32_t reference = (start + i > 0) ? trace[start + i - 1] : 0;
+            deltas[i] = estc_codec_zigzag_encode((int32_t)trace[start + i] - reference);
+            bits |= deltas[i];
+        }
+
+        if (block)
+        {
+            len += estc_codec_block_encode(deltas, TEST_BLOCK_LEN, estc_codec_bit_width(bits), &out[len]);
+        }
+        else
+        {
+            for (uint32_t i = 0; i < TEST_BLOCK_LEN; i++)
+            {
+                len += estc_codec_varint_encode(deltas[i], &out[len]);
+            }
+        }
+    }
+
+    return len;
+}
+
+/**@brief Function for checking that an encoded trace decodes to the original samples. */
+static void trace_check(uint16_t const *trace, bool block, uint8_t const *in, uint32_t len)
+{
+    uint32_t deltas[TEST_BLOCK_LEN];
+    uint32_t pos   = 0;
+    int32_t  value = 0;
+
+    for (uint32_t start = 0; start < TEST_TRACE_LEN; start += TEST_BLOCK_LEN)
+    {
+        if (block)
+        {
+            uint16_t used = estc_codec_block_decode(&in[pos], len - pos, deltas, TEST_BLOCK_LEN);
+            CHECK(used > 0);
+            pos += used;
+        }
+        else
+        {
+            for (uint32_t i = 0; i < TEST_BLOCK_LEN; i++)
+            {
+                uint8_t used = estc_codec_varint_decode(&in[pos], len - pos, &deltas[i]);
+                CHECK(used > 0);
+                pos += used;
+            }
+        }
+
+        for (uint32_t i = 0; i < TEST_BLOCK_LEN; i++)
+        {
+            value += estc_codec_zigzag_decode(deltas[i]);
+            CHECK_EQ(value, trace[start + i]);
+        }
+    }
+    CHECK_EQ(pos, len);
+}
+
+/**@brief Function for timing, checking and printing the codings of a trace.
+ *
+ * @return Size of the fixed 2-byte samples over the size of the varint coding, times 10.
+ */
+static uint32_t trace_bench(char const *name, uint16_t const *trace)
+{
+    static uint8_t encoded[TEST_TRACE_LEN * ESTC_CODEC_VARINT_MAX_LEN];
+    uint32_t fixed_len = TEST_TRACE_LEN * sizeof(uint16_t);
+    uint32_t ratio_x10[2];
+    uint32_t ns_x10[2];
+
+    for (uint32_t mode = 0; mode < 2; mode++)
+    {
+        uint32_t len   = 0;
+        uint64_t start = now_ns();
+        for (uint32_t run = 0; run < TEST_BENCH_RUNS; run++)
+        {
+            len = trace_encode(trace, 1 == mode, encoded);
+        }
+        uint64_t elapsed = now_ns() - start;
+
+        trace_check(trace, 1 == mode, encoded, len);
+        ratio_x10[mode] = fixed_len * 10 / len;
+        ns_x10[mode]    = (uint32_t)(elapsed * 10 / ((uint64_t)TEST_BENCH_RUNS * TEST_TRACE_LEN));
+    }
+
+    printf("       %-18s varint %2d.%dx, %d.%d ns per sample; block %2d.%dx, %d.%d ns per sample\n", name,
+           ratio_x10[0] / 10, ratio_x10[0] % 10, ns_x10[0] / 10, ns_x10[0] % 10,
+           ratio_x10[1] / 10, ratio_x10[1] % 10, ns_x10[1] / 10, ns_x10[1] % 10);
+    return ratio_x10[0];
+}
+
+/**@brief Compression ratio and encode time on traces like the sensors produce: the simulated
+ *        sensor of the application, a slow random walk and full-scale noise.
+ */
+static void test_codec_benchmark(void)
+{
+    static uint16_t trace[TEST_TRACE_LEN];
+
+    sensorsim_cfg_t   cfg = { .min = 0, .max = 4095, .incr = 37, .start_at_max = false };
+    sensorsim_state_t state;
+    sensorsim_init(&state, &cfg);
+    for (uint32_t i = 0; i < TEST_TRACE_LEN; i++)
+    {
+        trace[i] = (uint16_t)sensorsim_measure(&state, &cfg);
+    }
+    CHECK(trace_bench("triangle, step 37", trace) >= 10);
+
+    int32_t value = 2048;
+    for (uint32_t i = 0; i < TEST_TRACE_LEN; i++)
+    {
+        value    = MAX(0, MIN(4095, value + (int32_t)(random_next() % 7) - 3));
+        trace[i] = (uint16_t)value;
+    }
+    CHECK(trace_bench("random walk, +-3", trace) >= 18);
+
+    for (uint32_t i = 0; i < TEST_TRACE_LEN; i++)
+    {
+        trace[i] = (uint16_t)(random_next() % 4096);
+    }
+    (void)trace_bench("12-bit noise", trace);
+}
+
+/**@brief Every characteristic 3 packet of the application decodes completely, in sequence, into
+ *        summaries that are consistent in themselves.
+ */
+static void test_app_packets_decode(void)
+{
+    static sample_packet_t packet;
+
+    sim_app_start(app_main);
+    uint16_t char3 = sim_char_find(ESTC_CHAR_3_UUID_16);
+    uint16_t conn_handle = sim_connect(NULL);
+    CHECK_EQ(sim_subscribe(conn_handle, char3, BLE_GATT_HVX_NOTIFICATION), BLE_GATT_STATUS_SUCCESS);
+    sim_time_advance_ms(10000);
+
+    uint32_t packets = 0;
+    uint32_t records = 0;
+    uint32_t bytes   = 0;
+    for (uint32_t i = 0; i < sim_rx_count(); i++)
+    {
+        sim_rx_t const *rx = sim_rx_get(i);
+        if (rx->handle != char3)
+        {
+            continue;
+        }
+
+        CHECK(sample_packet_decode(rx->data, rx->len, &packet));
+        CHECK_EQ(packet.kind, ESTC_SAMPLER_KIND_SUMMARY);
+        CHECK_EQ(packet.seq, (uint8_t)packets);
+        for (uint8_t r = 0; r < packet.count; r++)
+        {
+            uint16_t const *values = packet.records[r].values;
+            CHECK(r == 0 || packet.records[r].ticks > packet.records[r - 1].ticks);
+            CHECK(values[0] <= values[2] && values[2] <= values[1]);
+            CHECK(values[0] <= values[3] && values[3] <= values[1]);
+            CHECK(values[1] <= 4095);
+        }
+
+        packets++;
+        records += packet.count;
+        bytes   += rx->len;
+    }
+    CHECK(packets > 10);
+
+    uint32_t fixed = packets * ESTC_SAMPLER_HEADER_LEN + records * ESTC_SAMPLER_SUMMARY_LEN;
+    printf("       characteristic 3: %d records in %d packets, %d bytes instead of %d fixed\n",
+           records, packets, bytes, fixed);
+    CHECK(bytes < fixed);
+}
+
+int main(void)
+{
+    int test_failures = 0;
+
+    RUN_TEST(test_codec_round_trip);
+    RUN_TEST(test_codec_benchmark);
+    RUN_TEST(test_app_packets_decode);
+
+    return test_failures ? 1 : 0;
+}
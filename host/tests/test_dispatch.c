@@ -0,0 +1,182 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "app_util.h"
+#include "estc_service.h"
+#include "nrf_sdh_ble.h"
+#include "test.h"
+
+int app_main(void);
+
+#define TEST_REPLAY_WRITES  100000  /**< Writes replayed per measured attribute. */
+#define TEST_REPLAY_RUNS    5       /**< Measurements of each attribute, the fastest one counts. */
+
+/* Defined by the linker, the observers the application registered */
+extern nrf_sdh_ble_evt_observer_t __start_sdh_ble_observers[] __attribute__((weak));
+extern nrf_sdh_ble_evt_observer_t __stop_sdh_ble_observers[] __attribute__((weak));
+
+/**@brief Function for finding the ESTC service instance of the application through its observer. */
+static ble_estc_service_t * service_get(void)
+{
+    for (nrf_sdh_ble_evt_observer_t *p_obs = __start_sdh_ble_observers; p_obs < __stop_sdh_ble_observers; p_obs++)
+    {
+        if (estc_ble_service_on_ble_event == p_obs->handler)
+        {
+            return (ble_estc_service_t *)p_obs->p_context;
+        }
+    }
+
+    CHECK(false);
+    return NULL;
+}
+
+static union
+{
+    ble_evt_t evt;
+    uint8_t   raw[sizeof(ble_evt_t) + BLE_GATT_ATT_MTU_DEFAULT];
+} m_write;
+
+/**@brief Function for building a write event as the SoftDevice reports it. */
+static ble_evt_t const * write_evt(uint16_t conn_handle, uint16_t handle, uint8_t op, uint8_t const *data, uint16_t len)
+{
+    CHECK(len <= BLE_GATT_ATT_MTU_DEFAULT);
+
+    memset(&m_write, 0, sizeof(m_write));
+    m_write.evt.header.evt_id                  = BLE_GATTS_EVT_WRITE;
+    m_write.evt.evt.gatts_evt.conn_handle      = conn_handle;
+    m_write.evt.evt.gatts_evt.params.write.handle = handle;
+    m_write.evt.evt.gatts_evt.params.write.op  = op;
+    m_write.evt.evt.gatts_evt.params.write.len = len;
+    memcpy(m_write.evt.evt.gatts_evt.params.write.data, data, len);
+
+    return &m_write.evt;
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**@brief Function for measuring the time the service takes to dispatch a write to an attribute.
+ *
+ * @return Fastest average over TEST_REPLAY_RUNS runs (in nanoseconds per event).
+ */
+static uint32_t dispatch_ns(ble_estc_service_t *service, ble_evt_t const *evt)
+{
+    uint64_t best = UINT64_MAX;
+
+    for (uint32_t run = 0; run < TEST_REPLAY_RUNS; run++)
+    {
+        uint64_t start = now_ns();
+        for (uint32_t i = 0; i < TEST_REPLAY_WRITES; i++)
+        {
+            estc_ble_service_on_ble_event(evt, service);
+        }
+        best = MIN(best, now_ns() - start);
+    }
+
+    return (uint32_t)(best / TEST_REPLAY_WRITES);
+}
+
+/**@brief Replayed writes reach the handler of their attribute, writes to attributes outside the
+ *        service are ignored.
+ */
+static void test_writes_reach_their_handlers(void)
+{
+    sim_app_start(app_main);
+    ble_estc_service_t *service = service_get();
+    uint16_t conn_handle = sim_connect(NULL);
+    uint8_t  data[16]    = {0};
+    uint8_t  cccd[2]     = {BLE_GATT_HVX_NOTIFICATION, 0};
+
+    for (uint32_t i = 0; i < 100; i++)
+    {
+        estc_ble_service_on_ble_event(write_evt(conn_handle, service->echo_handle.value_handle,
+                                                BLE_GATTS_OP_WRITE_CMD, data, sizeof(data)), service);
+        estc_ble_service_on_ble_event(write_evt(conn_handle, service->characterstic1_handle.value_handle,
+                                                BLE_GATTS_OP_WRITE_CMD, data, sizeof(data)), service);
+    }
+    CHECK_EQ(service->echo_probes, 100);
+    CHECK_EQ(service->ingest_bytes + service->ingest_overflow_bytes, 100 * sizeof(data));
+
+    CHECK(!estc_ble_service_is_subscribed(service, service->characterstic3_handle.value_handle));
+    estc_ble_service_on_ble_event(write_evt(conn_handle, service->characterstic3_handle.cccd_handle,
+                                            BLE_GATTS_OP_WRITE_REQ, cccd, sizeof(cccd)), service);
+    CHECK(estc_ble_service_is_subscribed(service, service->characterstic3_handle.value_handle));
+
+    // Below the service and past its last attribute
+    estc_ble_service_on_ble_event(write_evt(conn_handle, service->service_handle - 1,
+                                            BLE_GATTS_OP_WRITE_CMD, data, sizeof(data)), service);
+    estc_ble_service_on_ble_event(write_evt(conn_handle, service->reliable_handle.cccd_handle + 1,
+                                            BLE_GATTS_OP_WRITE_CMD, data, sizeof(data)), service);
+    CHECK_EQ(service->echo_probes, 100);
+    CHECK_EQ(service->ingest_bytes + service->ingest_overflow_bytes, 100 * sizeof(data));
+}
+
+/**@brief Dispatching a write takes the same time for the first and the last attribute of the
+ *        service, the lookup is a table index and not a search.
+ */
+static void test_dispatch_cost(void)
+{
+    sim_app_start(app_main);
+    ble_estc_service_t *service = service_get();
+    uint16_t conn_handle = sim_connect(NULL);
+    uint8_t  data[4]     = {0};
+
+    // Characteristic declarations have no write handler, only the lookup and the activity differ
+    uint16_t first = service->characterstic1_handle.value_handle - 1;
+    uint16_t last  = service->reliable_handle.value_handle - 1;
+    CHECK(last > first);
+
+    uint32_t first_ns   = dispatch_ns(service, write_evt(conn_handle, first, BLE_GATTS_OP_WRITE_CMD, data, sizeof(data)));
+    uint32_t last_ns    = dispatch_ns(service, write_evt(conn_handle, last, BLE_GATTS_OP_WRITE_CMD, data, sizeof(data)));
+    uint32_t foreign_ns = dispatch_ns(service, write_evt(conn_handle, service->service_handle - 1,
+                                                         BLE_GATTS_OP_WRITE_CMD, data, sizeof(data)));
+
+    printf("       dispatch of %d writes: handle %d %d ns, handle %d %d ns, other service %d ns per event\n",
+           TEST_REPLAY_WRITES, first, first_ns, last, last_ns, foreign_ns);
+    CHECK(last_ns <= 2 * first_ns + 50);
+}
+
+int main(void)
+{
+    int test_failures = 0;
+
+    RUN_TEST(test_writes_reach_their_handlers);
+    RUN_TEST(test_dispatch_cost);
+
+    return test_failures ? 1 : 0;
+}
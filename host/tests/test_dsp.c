@@ -0,0 +1,364 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#include <math.h>
+#include <string.h>
+#include <time.h>
+
+#include "app_util.h"
+#include "estc_dsp.h"
+#include "estc_service.h"
+#include "test.h"
+
+int app_main(void);
+
+#define TEST_SAMPLE_PERIOD_NS   10000000ULL     /**< SAMPLE_RATE_HZ of the application. */
+#define TEST_DC                 2000.0          /**< Offset of the test signal. */
+
+/**@brief Features computed in double precision from the definition. */
+typedef struct
+{
+    double rms;
+    double peak;
+    double band_energy[ESTC_DSP_BAND_COUNT];
+} reference_t;
+
+/**@brief Tone of the test signal, on an exact FFT bin so it does not leak into the others. */
+typedef struct
+{
+    uint16_t bin;
+    double   amplitude;
+} tone_t;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**@brief Function for generating a window of the offset plus the tones. */
+static void window_generate(tone_t const *tones, uint8_t count, double *window)
+{
+    for (uint16_t n = 0; n < ESTC_DSP_FFT_LEN; n++)
+    {
+        window[n] = TEST_DC;
+        for (uint8_t t = 0; t < count; t++)
+        {
+            window[n] += tones[t].amplitude * sin(2.0 * M_PI * tones[t].bin * n / ESTC_DSP_FFT_LEN);
+        }
+    }
+}
+
+/**@brief Function for computing the features of a window with a naive DFT of the mean-free
+ *        samples, bins 1 to N/2 - 1 split evenly into the bands.
+ */
+static void reference_compute(double const *window, reference_t *reference)
+{
+    double mean = 0.0;
+    double sum  = 0.0;
+
+    memset(reference, 0, sizeof(*reference));
+    for (uint16_t n = 0; n < ESTC_DSP_FFT_LEN; n++)
+    {
+        mean += window[n] / ESTC_DSP_FFT_LEN;
+        sum  += window[n] * window[n];
+        reference->peak = fmax(reference->peak, fabs(window[n]));
+    }
+    reference->rms = sqrt(sum / ESTC_DSP_FFT_LEN);
+
+    for (uint16_t k = 1; k < ESTC_DSP_FFT_LEN / 2; k++)
+    {
+        double re = 0.0;
+        double im = 0.0;
+        for (uint16_t n = 0; n < ESTC_DSP_FFT_LEN; n++)
+        {
+            re += (window[n] - mean) * cos(2.0 * M_PI * k * n / ESTC_DSP_FFT_LEN);
+            im -= (window[n] - mean) * sin(2.0 * M_PI * k * n / ESTC_DSP_FFT_LEN);
+        }
+        reference->band_energy[k / (ESTC_DSP_FFT_LEN / 2 / ESTC_DSP_BAND_COUNT)] += re * re + im * im;
+    }
+}
+
+/**@brief Function for passing a window through the feature extraction.
+ */
+static void window_analyze(estc_dsp_t *dsp, double const *window, estc_dsp_features_t *features)
+{
+    for (uint16_t n = 0; n < ESTC_DSP_FFT_LEN; n++)
+    {
+        CHECK_EQ(estc_dsp_add(dsp, (float32_t)window[n], features), ESTC_DSP_FFT_LEN - 1 == n);
+    }
+}
+
+/**@brief Function for comparing the features of one format with the reference.
+ *
+ * @param[in] value_error   Largest error of the RMS and the peak, in sample units.
+ * @param[in] energy_error  Largest relative error of a band holding at least 1% of the energy.
+ * @param[in] share_error   Largest error of an encoded band share.
+ */
+static void features_compare(estc_dsp_features_t const *features, reference_t const *reference,
+                             double value_error, double energy_error, uint8_t share_error)
+{
+    uint8_t packet[ESTC_DSP_FEATURES_LEN];
+    double  total = 0.0;
+
+    CHECK(fabs(features->rms - reference->rms) <= value_error);
+    CHECK(fabs(features->peak - reference->peak) <= value_error);
+
+    for (uint8_t band = 0; band < ESTC_DSP_BAND_COUNT; band++)
+    {
+        total += reference->band_energy[band];
+    }
+    CHECK_EQ(estc_dsp_features_encode(features, 7, packet), ESTC_DSP_FEATURES_LEN);
+    CHECK_EQ(packet[0], 7);
+    for (uint8_t band = 0; band < ESTC_DSP_BAND_COUNT; band++)
+    {
+        double share = reference->band_energy[band] / total;
+        if (share >= 0.01)
+        {
+            CHECK(fabs(features->band_energy[band] - reference->band_energy[band]) <=
+                  energy_error * reference->band_energy[band]);
+        }
+        CHECK(labs((long)packet[5 + band] - lround(share * UINT8_MAX)) <= share_error);
+    }
+}
+
+static tone_t const m_tones[] =
+{
+    { 5,  1200.0 },     // Band 0
+    { 40, 600.0 },      // Band 2
+    { 70, 300.0 },      // Band 4
+};
+
+/**@brief The float format matches the definition to rounding.
+ */
+static void test_f32_reference(void)
+{
+    static estc_dsp_t   dsp;
+    double              window[ESTC_DSP_FFT_LEN];
+    reference_t         reference;
+    estc_dsp_features_t features;
+
+    CHECK_EQ(estc_dsp_init(&dsp, ESTC_DSP_FORMAT_F32), NRF_SUCCESS);
+    window_generate(m_tones, ARRAY_SIZE(m_tones), window);
+    reference_compute(window, &reference);
+
+    window_analyze(&dsp, window, &features);
+    features_compare(&features, &reference, 0.01, 0.001, 0);
+    CHECK_EQ(dsp.windows, 1);
+
+    // The next window starts empty
+    window_analyze(&dsp, window, &features);
+    features_compare(&features, &reference, 0.01, 0.001, 0);
+}
+
+/**@brief The Q15 format is within its resolution of the definition, samples beyond the full
+ *        scale saturate.
+ */
+static void test_q15_reference(void)
+{
+    static estc_dsp_t   dsp;
+    double              window[ESTC_DSP_FFT_LEN];
+    reference_t         reference;
+    estc_dsp_features_t features;
+
+    CHECK_EQ(estc_dsp_init(&dsp, ESTC_DSP_FORMAT_Q15), NRF_SUCCESS);
+    window_generate(m_tones, ARRAY_SIZE(m_tones), window);
+    reference_compute(window, &reference);
+
+    // One Q15 step is an eighth of a sample unit, the weakest tone loses up to a tenth of its
+    // energy to the truncated squares
+    window_analyze(&dsp, window, &features);
+    features_compare(&features, &reference, 0.5, 0.1, 2);
+
+    for (uint16_t n = 0; n < ESTC_DSP_FFT_LEN; n++)
+    {
+        window[n] = (n % 2) ? 2.0 * ESTC_DSP_Q15_FULL_SCALE : 0.0;
+    }
+    window_analyze(&dsp, window, &features);
+    CHECK(fabs(features.peak - ESTC_DSP_Q15_FULL_SCALE) <= 0.5);
+}
+
+/**@brief A reset drops the partial window.
+ */
+static void test_reset(void)
+{
+    static estc_dsp_t   dsp;
+    double              window[ESTC_DSP_FFT_LEN];
+    reference_t         reference;
+    estc_dsp_features_t features;
+
+    CHECK_EQ(estc_dsp_init(&dsp, ESTC_DSP_FORMAT_F32), NRF_SUCCESS);
+    window_generate(m_tones, ARRAY_SIZE(m_tones), window);
+    reference_compute(window, &reference);
+
+    for (uint16_t n = 0; n < 100; n++)
+    {
+        CHECK(!estc_dsp_add(&dsp, 5000.0f, &features));
+    }
+    estc_dsp_reset(&dsp);
+
+    window_analyze(&dsp, window, &features);
+    features_compare(&features, &reference, 0.01, 0.001, 0);
+}
+
+/**@brief Prints the time of one window analysis in each format; the DWT cycles of
+ *        estc_dsp_benchmark only count on the target.
+ */
+static void test_benchmark(void)
+{
+    static estc_dsp_t   dsp;
+    static estc_dsp_format_t const formats[] = { ESTC_DSP_FORMAT_F32, ESTC_DSP_FORMAT_Q15 };
+    double              window[ESTC_DSP_FFT_LEN];
+    estc_dsp_features_t features;
+
+    window_generate(m_tones, ARRAY_SIZE(m_tones), window);
+    for (uint8_t f = 0; f < ARRAY_SIZE(formats); f++)
+    {
+        uint64_t best_ns = UINT64_MAX;
+
+        CHECK_EQ(estc_dsp_init(&dsp, formats[f]), NRF_SUCCESS);
+        for (uint8_t run = 0; run < 5; run++)
+        {
+            for (uint16_t n = 0; n < ESTC_DSP_FFT_LEN - 1; n++)
+            {
+                CHECK(!estc_dsp_add(&dsp, (float32_t)window[n], &features));
+            }
+            uint64_t start_ns = now_ns();
+            CHECK(estc_dsp_add(&dsp, (float32_t)window[ESTC_DSP_FFT_LEN - 1], &features));
+            best_ns = MIN(best_ns, now_ns() - start_ns);
+        }
+        printf("       %s: %llu ns per window of %d samples (host kernels)\n",
+               (ESTC_DSP_FORMAT_Q15 == formats[f]) ? "q15" : "f32", (unsigned long long)best_ns, ESTC_DSP_FFT_LEN);
+    }
+
+    // The benchmark leaves the instance empty in its own format
+    estc_dsp_benchmark_t benchmark;
+    CHECK(!estc_dsp_add(&dsp, 1.0f, &features));
+    CHECK_EQ(estc_dsp_benchmark(&dsp, &benchmark), NRF_SUCCESS);
+    CHECK_EQ(dsp.format, ESTC_DSP_FORMAT_Q15);
+    CHECK_EQ(dsp.count, 0);
+    CHECK_EQ(dsp.windows, 0);
+    CHECK(DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk);
+    CHECK(CoreDebug->DEMCR & CoreDebug_DEMCR_TRCENA_Msk);
+}
+
+static uint16_t m_features_handle;
+
+static bool features_received(void)
+{
+    for (uint32_t i = 0; i < sim_rx_count(); i++)
+    {
+        if (sim_rx_get(i)->handle == m_features_handle)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**@brief Function for checking that the first features packet after a subscription covers a
+ *        whole window of samples taken since then.
+ */
+static void features_first_check(uint64_t subscribed_ns)
+{
+    CHECK(sim_run_until(features_received, 10ULL * 1000000000ULL));
+    for (uint32_t i = 0; i < sim_rx_count(); i++)
+    {
+        sim_rx_t const *rx = sim_rx_get(i);
+        if (rx->handle == m_features_handle)
+        {
+            CHECK_EQ(rx->len, ESTC_DSP_FEATURES_LEN);
+            CHECK(rx->time_ns - subscribed_ns >= ESTC_DSP_FFT_LEN * TEST_SAMPLE_PERIOD_NS);
+            CHECK(uint16_decode(&rx->data[3]) <= ESTC_DSP_Q15_FULL_SCALE);
+            return;
+        }
+    }
+}
+
+/**@brief The application feeds the feature extraction only while the features are subscribed,
+ *        not for the characteristic 3 samples alone.
+ */
+static void test_features_need_subscription(void)
+{
+    sim_app_start(app_main);
+
+    uint16_t conn_handle = sim_connect(NULL);
+    CHECK(conn_handle != BLE_CONN_HANDLE_INVALID);
+    m_features_handle = sim_char_find(ESTC_CHAR_FEATURES_UUID_16);
+    CHECK(m_features_handle != 0);
+
+    // Ten seconds of samples for characteristic 3 only
+    CHECK_EQ(sim_subscribe(conn_handle, sim_char_find(ESTC_CHAR_3_UUID_16), BLE_GATT_HVX_NOTIFICATION),
+             BLE_GATT_STATUS_SUCCESS);
+    sim_time_advance_ms(10000);
+    CHECK(!features_received());
+
+    uint64_t subscribed_ns = sim_now_ns();
+    CHECK_EQ(sim_subscribe(conn_handle, m_features_handle, BLE_GATT_HVX_NOTIFICATION), BLE_GATT_STATUS_SUCCESS);
+    features_first_check(subscribed_ns);
+
+    // A window cut short by unsubscribing is not completed by the next subscriber
+    sim_time_advance_ms(1500);
+    CHECK_EQ(sim_subscribe(conn_handle, m_features_handle, 0), BLE_GATT_STATUS_SUCCESS);
+    sim_time_advance_ms(100);
+    sim_rx_clear();
+    subscribed_ns = sim_now_ns();
+    CHECK_EQ(sim_subscribe(conn_handle, m_features_handle, BLE_GATT_HVX_NOTIFICATION), BLE_GATT_STATUS_SUCCESS);
+    features_first_check(subscribed_ns);
+}
+
+/**@brief With every optional characteristic, the service still fits the configured attribute table.
+ */
+static void test_attr_table_fits(void)
+{
+    sim_app_start(app_main);
+
+    printf("       attribute table with the benchmark and features: %u of %u bytes\n",
+           sim_attr_tab_used(), sim_attr_tab_size());
+    CHECK_EQ(sim_attr_tab_size(), NRF_SDH_BLE_GATTS_ATTR_TAB_SIZE);
+    CHECK_EQ(sim_calls_failed("sd_ble_gatts_characteristic_add"), 0);
+    CHECK(sim_char_find(ESTC_CHAR_BENCH_DATA_UUID_16) != BLE_GATT_HANDLE_INVALID);
+    CHECK(sim_char_find(ESTC_CHAR_FEATURES_UUID_16) != BLE_GATT_HANDLE_INVALID);
+}
+
+int main(void)
+{
+    int test_failures = 0;
+
+    RUN_TEST(test_f32_reference);
+    RUN_TEST(test_q15_reference);
+    RUN_TEST(test_reset);
+    RUN_TEST(test_benchmark);
+    RUN_TEST(test_features_need_subscription);
+    RUN_TEST(test_attr_table_fits);
+
+    return test_failures ? 1 : 0;
+}
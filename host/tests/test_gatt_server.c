@@ -0,0 +1,206 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#include <string.h>
+
+#include "ble_hci.h"
+#include "estc_service.h"
+#include "test.h"
+
+int app_main(void);
+
+static void test_service_registered(void)
+{
+    sim_app_start(app_main);
+
+    CHECK(sim_service_find(ESTC_SERVICE_UUID_16) != BLE_GATT_HANDLE_INVALID);
+    CHECK(sim_char_find(ESTC_CHAR_1_UUID_16) != BLE_GATT_HANDLE_INVALID);
+    CHECK(sim_char_find(ESTC_CHAR_2_UUID_16) != BLE_GATT_HANDLE_INVALID);
+    CHECK(sim_char_find(ESTC_CHAR_3_UUID_16) != BLE_GATT_HANDLE_INVALID);
+    CHECK(sim_char_find(ESTC_CHAR_ECHO_UUID_16) != BLE_GATT_HANDLE_INVALID);
+    CHECK(sim_char_props(sim_char_find(ESTC_CHAR_3_UUID_16)).notify);
+    CHECK(sim_advertising());
+
+    // Values start with their initial value only, not padded to a fixed length
+    uint8_t value[NRF_SDH_BLE_GATT_MAX_MTU_SIZE];
+    CHECK_EQ(sim_attr_value(sim_char_find(ESTC_CHAR_1_UUID_16), value, sizeof(value)), 6);
+    CHECK(0 == memcmp(value, "Andrew", 6));
+    CHECK_EQ(sim_attr_value(sim_char_find(ESTC_CHAR_2_UUID_16), value, sizeof(value)), 1);
+    CHECK_EQ(sim_attr_value(sim_char_find(ESTC_CHAR_ECHO_UUID_16), value, sizeof(value)), 0);
+    CHECK_EQ(sim_attr_value(sim_char_find(ESTC_CHAR_RELIABLE_UUID_16), value, sizeof(value)), 0);
+}
+
+/**@brief The service fits the configured attribute table with room to spare.
+ */
+static void test_attr_table_fits(void)
+{
+    sim_app_start(app_main);
+
+    printf("       attribute table: %u of %u bytes\n", sim_attr_tab_used(), sim_attr_tab_size());
+    CHECK_EQ(sim_attr_tab_size(), NRF_SDH_BLE_GATTS_ATTR_TAB_SIZE);
+    CHECK_EQ(sim_calls_failed("sd_ble_gatts_characteristic_add"), 0);
+    CHECK(sim_attr_tab_used() <= NRF_SDH_BLE_GATTS_ATTR_TAB_SIZE);
+}
+
+static void test_connect_negotiates_mtu_and_data_length(void)
+{
+    sim_app_start(app_main);
+
+    uint16_t conn_handle = sim_connect(NULL);
+
+    CHECK(conn_handle != BLE_CONN_HANDLE_INVALID);
+    CHECK_EQ(sim_conn_att_mtu(conn_handle), NRF_SDH_BLE_GATT_MAX_MTU_SIZE);
+    CHECK_EQ(sim_conn_data_length(conn_handle), NRF_SDH_BLE_GAP_DATA_LENGTH);
+}
+
+static void test_three_centrals(void)
+{
+    sim_app_start(app_main);
+
+    for (uint32_t i = 0; i < NRF_SDH_BLE_PERIPHERAL_LINK_COUNT; i++)
+    {
+        CHECK(sim_advertising());
+        CHECK(sim_connect(NULL) != BLE_CONN_HANDLE_INVALID);
+    }
+    CHECK(!sim_advertising());
+    CHECK_EQ(sim_calls_failed("sd_ble_gap_adv_start"), 0);
+
+    sim_disconnect(1, BLE_HCI_REMOTE_USER_TERMINATED_CONNECTION);
+    CHECK(sim_advertising());
+}
+
+static void test_echo_probe(void)
+{
+    sim_app_start(app_main);
+
+    uint16_t conn_handle = sim_connect(NULL);
+    uint16_t echo        = sim_char_find(ESTC_CHAR_ECHO_UUID_16);
+    uint8_t  probe[4]    = {1, 2, 3, 4};
+
+    CHECK_EQ(sim_subscribe(conn_handle, echo, BLE_GATT_HVX_NOTIFICATION), BLE_GATT_STATUS_SUCCESS);
+    CHECK_EQ(sim_write(conn_handle, echo, BLE_GATTS_OP_WRITE_CMD, probe, sizeof(probe)), BLE_GATT_STATUS_SUCCESS);
+    sim_conn_event(conn_handle);
+
+    CHECK_EQ(sim_rx_count(), 1);
+    CHECK_EQ(sim_rx_get(0)->handle, echo);
+    CHECK_EQ(sim_rx_get(0)->len, ESTC_ECHO_HEADER_LEN + sizeof(probe));
+}
+
+/**@brief A quiet link falls back to the idle profile and stops waking the CPU for the policy,
+ *        traffic in either direction keeps it on the busy profile.
+ */
+static void test_conn_policy_follows_traffic(void)
+{
+    sim_app_start(app_main);
+
+    uint16_t conn_handle = sim_connect(NULL);
+    uint16_t echo        = sim_char_find(ESTC_CHAR_ECHO_UUID_16);
+    uint16_t char3       = sim_char_find(ESTC_CHAR_3_UUID_16);
+    uint8_t  probe[4]    = {1, 2, 3, 4};
+
+    // A write switches to the busy profile, two seconds without traffic to the idle one
+    CHECK_EQ(sim_write(conn_handle, echo, BLE_GATTS_OP_WRITE_CMD, probe, sizeof(probe)), BLE_GATT_STATUS_SUCCESS);
+    sim_time_advance_ms(1000);
+    CHECK_EQ(sim_conn_params(conn_handle).slave_latency, 0);
+    sim_time_advance_ms(2000);
+    CHECK_EQ(sim_conn_params(conn_handle).slave_latency, 4);
+
+    // The idle timeout is not armed again until there is traffic
+    sim_time_advance_ms(60000);
+    uint32_t timers = sim_timers_running();
+    sim_time_advance_ms(60000);
+    CHECK_EQ(sim_conn_params(conn_handle).slave_latency, 4);
+    CHECK_EQ(sim_timers_running(), timers);
+    CHECK_EQ(sim_write(conn_handle, echo, BLE_GATTS_OP_WRITE_CMD, probe, sizeof(probe)), BLE_GATT_STATUS_SUCCESS);
+    CHECK_EQ(sim_timers_running(), timers + 1);
+    sim_time_advance_ms(60000);
+    CHECK_EQ(sim_timers_running(), timers);
+
+    // Notifications count as traffic as well
+    CHECK_EQ(sim_subscribe(conn_handle, char3, BLE_GATT_HVX_NOTIFICATION), BLE_GATT_STATUS_SUCCESS);
+    sim_time_advance_ms(5000);
+    CHECK_EQ(sim_conn_params(conn_handle).slave_latency, 0);
+    CHECK_EQ(sim_subscribe(conn_handle, char3, 0), BLE_GATT_STATUS_SUCCESS);
+    sim_time_advance_ms(3000);
+    CHECK_EQ(sim_conn_params(conn_handle).slave_latency, 4);
+}
+
+/**@brief A central that does not grant the busy profile keeps the link on its own parameters,
+ *        the policy stops asking for the profile but still gets the idle one.
+ */
+static void test_busy_profile_rejected_keeps_link(void)
+{
+    sim_central_t central;
+
+    sim_app_start(app_main);
+    sim_central_default(&central);
+    central.min_conn_interval = MSEC_TO_UNITS(30, UNIT_1_25_MS);
+
+    uint16_t conn_handle = sim_connect(&central);
+    uint16_t echo        = sim_char_find(ESTC_CHAR_ECHO_UUID_16);
+    uint8_t  probe[4]    = {1, 2, 3, 4};
+
+    // Traffic every second keeps the busy profile requested until the module gives up
+    for (uint32_t i = 0; i < 150; i++)
+    {
+        CHECK_EQ(sim_write(conn_handle, echo, BLE_GATTS_OP_WRITE_CMD, probe, sizeof(probe)), BLE_GATT_STATUS_SUCCESS);
+        sim_time_advance_ms(1000);
+    }
+    CHECK(sim_connected(conn_handle));
+    CHECK_EQ(sim_calls("sd_ble_gap_disconnect"), 0);
+    CHECK(sim_conn_params(conn_handle).max_conn_interval >= central.min_conn_interval);
+    CHECK_EQ(sim_conn_params(conn_handle).slave_latency, 0);
+
+    // The rejected profile is not requested again, the idle one is granted
+    uint32_t updates = sim_calls("sd_ble_gap_conn_param_update");
+    sim_time_advance_ms(3000);
+    CHECK_EQ(sim_calls("sd_ble_gap_conn_param_update"), updates + 1);
+    CHECK_EQ(sim_conn_params(conn_handle).slave_latency, 4);
+
+    CHECK_EQ(sim_write(conn_handle, echo, BLE_GATTS_OP_WRITE_CMD, probe, sizeof(probe)), BLE_GATT_STATUS_SUCCESS);
+    sim_time_advance_ms(1000);
+    CHECK_EQ(sim_calls("sd_ble_gap_conn_param_update"), updates + 1);
+    CHECK(sim_connected(conn_handle));
+}
+
+int main(void)
+{
+    int test_failures = 0;
+
+    RUN_TEST(test_service_registered);
+    RUN_TEST(test_attr_table_fits);
+    RUN_TEST(test_connect_negotiates_mtu_and_data_length);
+    RUN_TEST(test_three_centrals);
+    RUN_TEST(test_echo_probe);
+    RUN_TEST(test_conn_policy_follows_traffic);
+    RUN_TEST(test_busy_profile_rejected_keeps_link);
+
+    return test_failures ? 1 : 0;
+}
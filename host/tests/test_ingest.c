@@ -0,0 +1,198 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "app_util.h"
+#include "estc_service.h"
+#include "nrf_sdh_ble.h"
+#include "test.h"
+
+int app_main(void);
+
+#define TEST_INGEST_BYTES       (256 * 1024)    /**< Data the central pushes in a run. */
+#define TEST_WRITES_PER_EVENT   6               /**< Write Without Response packets the central sends per connection event. */
+#define TEST_INGEST_BUFFER_SIZE 2048            /**< ESTC_INGEST_BUFFER_SIZE of the service. */
+
+/* Defined by the linker, the observers the application registered */
+extern nrf_sdh_ble_evt_observer_t __start_sdh_ble_observers[] __attribute__((weak));
+extern nrf_sdh_ble_evt_observer_t __stop_sdh_ble_observers[] __attribute__((weak));
+
+static uint32_t m_received;     /**< Bytes the ingest handler got. */
+static bool     m_in_order;     /**< Every byte matched the pattern the central wrote. */
+
+/**@brief Function for finding the ESTC service instance of the application through its observer. */
+static ble_estc_service_t * service_get(void)
+{
+    for (nrf_sdh_ble_evt_observer_t *p_obs = __start_sdh_ble_observers; p_obs < __stop_sdh_ble_observers; p_obs++)
+    {
+        if (estc_ble_service_on_ble_event == p_obs->handler)
+        {
+            return (ble_estc_service_t *)p_obs->p_context;
+        }
+    }
+
+    CHECK(false);
+    return NULL;
+}
+
+/**@brief Ingest handler checking the data against the pattern of the generator. */
+static void ingest_handler(uint8_t const *data, uint32_t len)
+{
+    for (uint32_t i = 0; i < len; i++)
+    {
+        m_in_order = m_in_order && (data[i] == (uint8_t)(m_received + i));
+    }
+    m_received += len;
+}
+
+/**@brief Function for filling a write with the pattern of the generator, the low byte of the stream offset. */
+static void pattern_fill(uint8_t *data, uint16_t len, uint32_t offset)
+{
+    for (uint16_t i = 0; i < len; i++)
+    {
+        data[i] = (uint8_t)(offset + i);
+    }
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**@brief A central writing full packets without response every connection event gets all data
+ *        through in order, the main loop drains the buffer between connection events.
+ */
+static void test_ingest_at_link_speed(void)
+{
+    static uint8_t data[NRF_SDH_BLE_GATT_MAX_MTU_SIZE];
+
+    sim_app_start(app_main);
+    ble_estc_service_t *service = service_get();
+    service->ingest_handler = ingest_handler;
+    m_received = 0;
+    m_in_order = true;
+
+    uint16_t conn_handle = sim_connect(NULL);
+    uint16_t char1       = sim_char_find(ESTC_CHAR_1_UUID_16);
+    uint16_t payload     = sim_conn_att_mtu(conn_handle) - ESTC_TX_ATT_HEADER_LEN;
+
+    uint64_t start_ns = sim_now_ns();
+    uint64_t wall_ns  = now_ns();
+    uint32_t sent     = 0;
+    uint32_t writes   = 0;
+    while (sent < TEST_INGEST_BYTES)
+    {
+        for (uint32_t i = 0; i < TEST_WRITES_PER_EVENT && sent < TEST_INGEST_BYTES; i++)
+        {
+            uint16_t len = (uint16_t)MIN(payload, TEST_INGEST_BYTES - sent);
+            pattern_fill(data, len, sent);
+            CHECK_EQ(sim_write(conn_handle, char1, BLE_GATTS_OP_WRITE_CMD, data, len), BLE_GATT_STATUS_SUCCESS);
+            sent += len;
+            writes++;
+        }
+        sim_time_advance_ns((uint64_t)sim_conn_params(conn_handle).max_conn_interval * 1250000ULL);
+    }
+    wall_ns = now_ns() - wall_ns;
+
+    uint32_t elapsed_ms = (uint32_t)((sim_now_ns() - start_ns) / 1000000);
+    printf("       ingest: %d bytes in %d writes, %d ms, %d bytes/s, %d bytes dropped, %d ns per write on the host\n",
+           sent, writes, elapsed_ms, (uint32_t)(((uint64_t)sent * 1000) / MAX(elapsed_ms, 1)),
+           service->ingest_overflow_bytes, (uint32_t)(wall_ns / writes));
+
+    CHECK_EQ(service->ingest_bytes, TEST_INGEST_BYTES);
+    CHECK_EQ(service->ingest_overflow_bytes, 0);
+    CHECK_EQ(m_received, TEST_INGEST_BYTES);
+    CHECK(m_in_order);
+}
+
+/**@brief Writes arriving while the main loop does not run fill the buffer, the rest is counted as
+ *        dropped, and the buffer takes data again once the main loop drained it.
+ */
+static void test_ingest_overflow_counted(void)
+{
+    static union
+    {
+        ble_evt_t evt;
+        uint8_t   raw[sizeof(ble_evt_t) + NRF_SDH_BLE_GATT_MAX_MTU_SIZE];
+    } write;
+
+    sim_app_start(app_main);
+    ble_estc_service_t *service = service_get();
+    service->ingest_handler = ingest_handler;
+    m_received = 0;
+    m_in_order = true;
+
+    uint16_t conn_handle = sim_connect(NULL);
+    uint16_t payload     = sim_conn_att_mtu(conn_handle) - ESTC_TX_ATT_HEADER_LEN;
+
+    // Events replayed straight into the service, the main loop gets no chance to drain in between
+    memset(&write, 0, sizeof(write));
+    write.evt.header.evt_id                     = BLE_GATTS_EVT_WRITE;
+    write.evt.evt.gatts_evt.conn_handle         = conn_handle;
+    write.evt.evt.gatts_evt.params.write.handle = service->characterstic1_handle.value_handle;
+    write.evt.evt.gatts_evt.params.write.op     = BLE_GATTS_OP_WRITE_CMD;
+    write.evt.evt.gatts_evt.params.write.len    = payload;
+
+    uint32_t sent = 0;
+    for (uint32_t i = 0; i < 2 * TEST_INGEST_BUFFER_SIZE / payload + 1; i++)
+    {
+        pattern_fill(write.evt.evt.gatts_evt.params.write.data, payload, sent);
+        estc_ble_service_on_ble_event(&write.evt, service);
+        sent += payload;
+    }
+    CHECK_EQ(service->ingest_bytes, TEST_INGEST_BUFFER_SIZE);
+    CHECK_EQ(service->ingest_overflow_bytes, sent - TEST_INGEST_BUFFER_SIZE);
+
+    sim_process();
+    CHECK_EQ(m_received, TEST_INGEST_BUFFER_SIZE);
+    CHECK(m_in_order);
+
+    pattern_fill(write.evt.evt.gatts_evt.params.write.data, payload, TEST_INGEST_BUFFER_SIZE);
+    estc_ble_service_on_ble_event(&write.evt, service);
+    CHECK_EQ(service->ingest_bytes, TEST_INGEST_BUFFER_SIZE + payload);
+    sim_process();
+    CHECK_EQ(m_received, TEST_INGEST_BUFFER_SIZE + payload);
+    CHECK(m_in_order);
+}
+
+int main(void)
+{
+    int test_failures = 0;
+
+    RUN_TEST(test_ingest_at_link_speed);
+    RUN_TEST(test_ingest_overflow_counted);
+
+    return test_failures ? 1 : 0;
+}
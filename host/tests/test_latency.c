@@ -0,0 +1,155 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "app_util.h"
+#include "estc_service.h"
+#include "test.h"
+
+int app_main(void);
+
+#define TEST_BUSY_PROBES    2000    /**< Probes sent back to back. */
+#define TEST_IDLE_PROBES    200     /**< Probes sent after the link went quiet. */
+#define TEST_IDLE_GAP_MS    3000    /**< Time between probes on a quiet link, longer than the idle timeout. */
+#define TEST_BUSY_GAP_US    20000   /**< Longest time between probes sent back to back. */
+
+static uint32_t m_random = 1;   /**< State of the generator of the probe times. */
+
+/**@brief Function for getting a pseudo-random number below @p limit, the same sequence in every run. */
+static uint32_t random_below(uint32_t limit)
+{
+    m_random = m_random * 1103515245 + 12345;
+    return (m_random >> 8) % limit;
+}
+
+static bool echo_received(void)
+{
+    return sim_rx_count() > 0;
+}
+
+/**@brief Function for sending a probe and waiting for its echo.
+ *
+ * @details The write waits for the next connection event the peripheral listens to, the echo
+ *          arrives at the event the SoftDevice sends it in.
+ *
+ * @return Round trip time (in microseconds).
+ */
+static uint32_t probe_send(uint16_t conn_handle, uint16_t echo, uint32_t seq)
+{
+    ble_gap_conn_params_t params = sim_conn_params(conn_handle);
+    uint64_t sent_ns = sim_now_ns();
+    uint8_t  data[sizeof(uint32_t)];
+
+    sim_time_advance_ns(sim_conn_listen_ns(conn_handle) - sent_ns);
+    sim_rx_clear();
+    (void)uint32_encode(seq, data);
+    CHECK_EQ(sim_write(conn_handle, echo, BLE_GATTS_OP_WRITE_CMD, data, sizeof(data)), BLE_GATT_STATUS_SUCCESS);
+    CHECK(sim_run_until(echo_received, 1000000000ULL));
+
+    sim_rx_t const *rx = sim_rx_get(0);
+    CHECK_EQ(rx->handle, echo);
+    CHECK_EQ(rx->len, ESTC_ECHO_HEADER_LEN + sizeof(data));
+    CHECK_EQ(uint32_decode(&rx->data[ESTC_ECHO_HEADER_LEN]), seq);
+    // The probe is echoed from the BLE event handler, no tick passes in between
+    CHECK_EQ(uint32_decode(&rx->data[4]), uint32_decode(&rx->data[0]));
+
+    // At most one round of the events the peripheral listens to, and the echo goes out in the same one
+    uint32_t rtt_us = (uint32_t)((rx->time_ns - sent_ns) / 1000);
+    CHECK(rtt_us <= (uint32_t)params.max_conn_interval * 1250 * (params.slave_latency + 1));
+    return rtt_us;
+}
+
+static int compare_u32(void const *a, void const *b)
+{
+    uint32_t x = *(uint32_t const *)a;
+    uint32_t y = *(uint32_t const *)b;
+    return (x > y) - (x < y);
+}
+
+/**@brief Function for printing the percentiles of the round trip times.
+ *
+ * @return Median round trip time (in microseconds).
+ */
+static uint32_t percentiles_print(char const *name, uint32_t *rtt_us, uint32_t count)
+{
+    qsort(rtt_us, count, sizeof(rtt_us[0]), compare_u32);
+
+    uint32_t p50 = rtt_us[count * 50 / 100];
+    uint32_t p99 = rtt_us[count * 99 / 100];
+    printf("       %s: %d probes, p50 %d.%02d ms, p99 %d.%02d ms, max %d.%02d ms\n", name, count,
+           p50 / 1000, p50 % 1000 / 10, p99 / 1000, p99 % 1000 / 10,
+           rtt_us[count - 1] / 1000, rtt_us[count - 1] % 1000 / 10);
+    return p50;
+}
+
+/**@brief Probes on a quiet link wait for the idle interval and slave latency, probes back to back
+ *        keep the link on the busy profile and come back within one short interval.
+ */
+static void test_echo_latency_percentiles(void)
+{
+    static uint32_t idle_us[TEST_IDLE_PROBES];
+    static uint32_t busy_us[TEST_BUSY_PROBES];
+
+    sim_app_start(app_main);
+    uint16_t conn_handle = sim_connect(NULL);
+    uint16_t echo        = sim_char_find(ESTC_CHAR_ECHO_UUID_16);
+    CHECK_EQ(sim_subscribe(conn_handle, echo, BLE_GATT_HVX_NOTIFICATION), BLE_GATT_STATUS_SUCCESS);
+
+    uint32_t seq = 0;
+    for (uint32_t i = 0; i < TEST_IDLE_PROBES; i++)
+    {
+        sim_time_advance_ms(TEST_IDLE_GAP_MS + random_below(1000));
+        CHECK(sim_conn_params(conn_handle).slave_latency > 0);
+        idle_us[i] = probe_send(conn_handle, echo, seq++);
+    }
+
+    for (uint32_t i = 0; i < TEST_BUSY_PROBES; i++)
+    {
+        sim_time_advance_ns((uint64_t)random_below(TEST_BUSY_GAP_US) * 1000);
+        busy_us[i] = probe_send(conn_handle, echo, seq++);
+    }
+    CHECK_EQ(sim_conn_params(conn_handle).slave_latency, 0);
+
+    uint32_t idle_p50 = percentiles_print("echo on a quiet link", idle_us, TEST_IDLE_PROBES);
+    uint32_t busy_p50 = percentiles_print("echo back to back", busy_us, TEST_BUSY_PROBES);
+    CHECK(busy_p50 < idle_p50);
+}
+
+int main(void)
+{
+    int test_failures = 0;
+
+    RUN_TEST(test_echo_latency_percentiles);
+
+    return test_failures ? 1 : 0;
+}
@@ -0,0 +1,292 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#include <string.h>
+#include <time.h>
+
+#include "app_util.h"
+#include "estc_codec.h"
+#include "estc_sampler.h"
+#include "estc_service.h"
+#include "nrf_atfifo.h"
+#include "nrf_sdh_ble.h"
+#include "test.h"
+
+int app_main(void);
+
+#define TEST_WINDOW_TICKS       APP_TIMER_TICKS(100)    /**< One summary per window of 10 samples at 100 Hz. */
+#define TEST_RECORDS_MAX        1024                    /**< Most summary records a test decodes. */
+#define TEST_COST_RATE_HZ       1000                    /**< Sampling rate of the CPU time harness. */
+#define TEST_COST_BATCH_MS      20                      /**< Time between two runs of the packer, so each run is long enough for clock(). */
+#define TEST_COST_SAMPLES       20000                   /**< Samples the harness takes. */
+#define TEST_COST_FIFO_SIZE     32
+
+NRF_ATFIFO_DEF(m_cost_fifo, estc_sample_t, TEST_COST_FIFO_SIZE);
+
+/* Defined by the linker, the observers the application registered */
+extern nrf_sdh_ble_evt_observer_t __start_sdh_ble_observers[] __attribute__((weak));
+extern nrf_sdh_ble_evt_observer_t __stop_sdh_ble_observers[] __attribute__((weak));
+
+/**@brief Function for finding the ESTC service instance of the application through its observer. */
+static ble_estc_service_t * service_get(void)
+{
+    for (nrf_sdh_ble_evt_observer_t *p_obs = __start_sdh_ble_observers; p_obs < __stop_sdh_ble_observers; p_obs++)
+    {
+        if (estc_ble_service_on_ble_event == p_obs->handler)
+        {
+            return (ble_estc_service_t *)p_obs->p_context;
+        }
+    }
+
+    CHECK(false);
+    return NULL;
+}
+
+/**@brief Function for decoding the RTC ticks of the records of the delta coded summary packets
+ *        received on a connection.
+ *
+ * @return Number of records decoded.
+ */
+static uint32_t summary_ticks_decode(uint16_t conn_handle, uint16_t handle, uint32_t *ticks)
+{
+    uint32_t count = 0;
+
+    for (uint32_t i = 0; i < sim_rx_count(); i++)
+    {
+        sim_rx_t const *rx = sim_rx_get(i);
+        if (rx->conn_handle != conn_handle || rx->handle != handle)
+        {
+            continue;
+        }
+
+        CHECK(rx->len > ESTC_SAMPLER_HEADER_LEN);
+        CHECK_EQ(rx->data[1], ESTC_SAMPLER_FORMAT(ESTC_SAMPLER_KIND_SUMMARY, ESTC_SAMPLER_ENCODING_DELTA));
+
+        uint32_t record_ticks = uint32_decode(&rx->data[3]);
+        uint16_t offset       = ESTC_SAMPLER_HEADER_LEN;
+        for (uint8_t r = 0; r < rx->data[2]; r++)
+        {
+            for (uint8_t field = 0; field <= 4; field++)
+            {
+                uint32_t value;
+                uint8_t  len = estc_codec_varint_decode(&rx->data[offset], rx->len - offset, &value);
+                CHECK(len > 0);
+                offset += len;
+                if (0 == field)
+                {
+                    record_ticks += value;
+                }
+            }
+            CHECK(count < TEST_RECORDS_MAX);
+            ticks[count++] = record_ticks;
+        }
+        CHECK_EQ(offset, rx->len);
+    }
+
+    return count;
+}
+
+/**@brief Summaries of 10 samples at 100 Hz are 100 ms apart, or a whole number of windows apart
+ *        when windows within the deadband are left out.
+ */
+static void test_sampling_period(void)
+{
+    static uint32_t ticks[TEST_RECORDS_MAX];
+
+    sim_app_start(app_main);
+    uint16_t char3 = sim_char_find(ESTC_CHAR_3_UUID_16);
+
+    uint16_t conn_handle = sim_connect(NULL);
+    CHECK_EQ(sim_subscribe(conn_handle, char3, BLE_GATT_HVX_NOTIFICATION), BLE_GATT_STATUS_SUCCESS);
+    sim_time_advance_ms(10000);
+
+    uint32_t count = summary_ticks_decode(conn_handle, char3, ticks);
+    CHECK(count > 50);
+    for (uint32_t i = 1; i < count; i++)
+    {
+        uint32_t spacing = ticks[i] - ticks[i - 1];
+        uint32_t windows = ROUNDED_DIV(spacing, TEST_WINDOW_TICKS);
+        CHECK(windows > 0);
+        CHECK(100 * spacing >= 99 * windows * TEST_WINDOW_TICKS);
+        CHECK(100 * spacing <= 101 * windows * TEST_WINDOW_TICKS);
+    }
+}
+
+/**@brief The sampling timer only runs while a central is subscribed to characteristic 3.
+ */
+static void test_timer_follows_subscription(void)
+{
+    sim_app_start(app_main);
+    uint16_t char3 = sim_char_find(ESTC_CHAR_3_UUID_16);
+    uint32_t idle  = sim_timers_running();
+
+    uint16_t conn_handle = sim_connect(NULL);
+    sim_time_advance_ms(60000);
+    CHECK_EQ(sim_timers_running(), idle);
+
+    CHECK_EQ(sim_subscribe(conn_handle, char3, BLE_GATT_HVX_NOTIFICATION), BLE_GATT_STATUS_SUCCESS);
+    sim_time_advance_ms(1000);
+    uint32_t received = sim_rx_count();
+    CHECK(received > 0);
+
+    // The notifications keep the connection policy timer armed next to the sampling timer
+    CHECK_EQ(sim_timers_running(), idle + 2);
+
+    // After unsubscribing, the sampling timer stops and the connection policy timer expires, so
+    // only the timers running before the connection are left
+    CHECK_EQ(sim_subscribe(conn_handle, char3, 0), BLE_GATT_STATUS_SUCCESS);
+    sim_time_advance_ms(10000);
+    CHECK_EQ(sim_timers_running(), idle);
+    CHECK_EQ(sim_rx_count(), received);
+
+    CHECK_EQ(sim_subscribe(conn_handle, char3, BLE_GATT_HVX_NOTIFICATION), BLE_GATT_STATUS_SUCCESS);
+    sim_time_advance_ms(1000);
+    CHECK(sim_rx_count() > received);
+}
+
+/**@brief Records staged while only a central with a large ATT MTU was subscribed are staged again
+ *        when one with the smallest ATT MTU subscribes, so both receive every packet after that.
+ */
+static void test_smaller_mtu_subscribes_mid_packet(void)
+{
+    sim_app_start(app_main);
+    uint16_t char3 = sim_char_find(ESTC_CHAR_3_UUID_16);
+
+    uint16_t large = sim_connect(NULL);
+    CHECK_EQ(sim_subscribe(large, char3, BLE_GATT_HVX_NOTIFICATION), BLE_GATT_STATUS_SUCCESS);
+
+    sim_central_t central;
+    sim_central_default(&central);
+    central.att_mtu = BLE_GATT_ATT_MTU_DEFAULT;
+    uint16_t small = sim_connect(&central);
+    CHECK_EQ(sim_conn_att_mtu(small), BLE_GATT_ATT_MTU_DEFAULT);
+
+    // Subscribe while a packet is being staged, at varying points of it
+    uint32_t packets = 0;
+    for (uint32_t step = 0; step < 8; step++)
+    {
+        sim_time_advance_ms(1000 + 30 * step);
+        sim_rx_clear();
+        CHECK_EQ(sim_subscribe(small, char3, BLE_GATT_HVX_NOTIFICATION), BLE_GATT_STATUS_SUCCESS);
+        sim_time_advance_ms(1000);
+        CHECK_EQ(sim_subscribe(small, char3, 0), BLE_GATT_STATUS_SUCCESS);
+
+        uint8_t  large_seq[64];
+        uint8_t  small_seq[64];
+        uint32_t large_count = 0;
+        uint32_t small_count = 0;
+        for (uint32_t i = 0; i < sim_rx_count(); i++)
+        {
+            sim_rx_t const *rx = sim_rx_get(i);
+            if (rx->handle != char3)
+            {
+                continue;
+            }
+            if (rx->conn_handle == small)
+            {
+                CHECK(rx->len <= BLE_GATT_ATT_MTU_DEFAULT - ESTC_TX_ATT_HEADER_LEN);
+                CHECK(small_count < ARRAY_SIZE(small_seq));
+                small_seq[small_count++] = rx->data[0];
+            }
+            else
+            {
+                CHECK(large_count < ARRAY_SIZE(large_seq));
+                large_seq[large_count++] = rx->data[0];
+            }
+        }
+
+        CHECK(small_count > 0);
+        CHECK(large_count >= small_count);
+        CHECK_EQ(memcmp(large_seq, small_seq, small_count), 0);
+        packets += small_count;
+    }
+    CHECK(packets > 0);
+}
+
+/**@brief Runs a sampler at 1 kHz on the service of the application and prints the CPU time
+ *        estc_sampler_process takes per sample. The host has no cycle counter, so the time is
+ *        measured with clock(); on the target, ESTC_SAMPLER_PROFILE counts the DWT cycles of the
+ *        timer handler and the packer instead.
+ */
+static void test_cpu_time_per_sample_at_1khz(void)
+{
+    static estc_sampler_t sampler;
+    estc_sampler_init_t   init = {0};
+
+    sim_app_start(app_main);
+    uint16_t char3 = sim_char_find(ESTC_CHAR_3_UUID_16);
+
+    // Raw samples, every one of them is packed and sent
+    init.rate_hz         = TEST_COST_RATE_HZ;
+    init.max_latency_ms  = 200;
+    init.sensor_cfg.min  = 0;
+    init.sensor_cfg.max  = 4095;
+    init.sensor_cfg.incr = 37;
+    init.encoding        = ESTC_SAMPLER_ENCODING_DELTA;
+    CHECK_EQ(NRF_ATFIFO_INIT(m_cost_fifo), NRF_SUCCESS);
+    CHECK_EQ(estc_sampler_init(&sampler, service_get(), m_cost_fifo, &init), NRF_SUCCESS);
+    CHECK_EQ(estc_sampler_start(&sampler), NRF_SUCCESS);
+
+    uint16_t conn_handle = sim_connect(NULL);
+    CHECK_EQ(sim_subscribe(conn_handle, char3, BLE_GATT_HVX_NOTIFICATION), BLE_GATT_STATUS_SUCCESS);
+    estc_sampler_process(&sampler);
+
+    clock_t cpu = 0;
+    while (sampler.samples_taken < TEST_COST_SAMPLES)
+    {
+        sim_time_advance_ms(TEST_COST_BATCH_MS);
+
+        clock_t start = clock();
+        estc_sampler_process(&sampler);
+        cpu += clock() - start;
+    }
+
+    double ns_per_sample = 1e9 * cpu / CLOCKS_PER_SEC / sampler.samples_taken;
+    printf("       %u samples at %d Hz, %u packets: %.0f ns of CPU per sample to pack (host, clock())\n",
+           (unsigned)sampler.samples_taken, TEST_COST_RATE_HZ, (unsigned)sampler.packets_sent, ns_per_sample);
+
+    // The timer kept its rate and the packer kept up with it
+    CHECK_EQ(sampler.samples_overrun, 0);
+    CHECK_EQ(sampler.packets_failed, 0);
+    CHECK(sampler.packets_sent > 0);
+    CHECK(sampler.samples_taken <= TEST_COST_SAMPLES + TEST_COST_BATCH_MS);
+}
+
+int main(void)
+{
+    int test_failures = 0;
+
+    RUN_TEST(test_sampling_period);
+    RUN_TEST(test_timer_follows_subscription);
+    RUN_TEST(test_smaller_mtu_subscribes_mid_packet);
+    RUN_TEST(test_cpu_time_per_sample_at_1khz);
+
+    return test_failures ? 1 : 0;
+}
@@ -0,0 +1,69 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#include "ble_hci.h"
+#include "estc_service.h"
+#include "test.h"
+
+int app_main(void);
+
+static void test_service_registered(void)
+{
+    sim_app_start(app_main);
+
+    CHECK(sim_service_find(ESTC_SERVICE_UUID) != BLE_GATT_HANDLE_INVALID);
+    CHECK_EQ(sim_calls("sd_ble_uuid_vs_add"), 1);
+    CHECK_EQ(sim_calls_failed("sd_ble_gatts_service_add"), 0);
+    CHECK(sim_advertising());
+}
+
+static void test_reconnect(void)
+{
+    sim_app_start(app_main);
+
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        uint16_t conn_handle = sim_connect(NULL);
+        CHECK(conn_handle != BLE_CONN_HANDLE_INVALID);
+        sim_disconnect(conn_handle, BLE_HCI_REMOTE_USER_TERMINATED_CONNECTION);
+        CHECK(sim_advertising());
+    }
+    CHECK_EQ(sim_calls_failed("sd_ble_gap_adv_start"), 0);
+}
+
+int main(void)
+{
+    int test_failures = 0;
+
+    RUN_TEST(test_service_registered);
+    RUN_TEST(test_reconnect);
+
+    return test_failures ? 1 : 0;
+}
@@ -0,0 +1,193 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#include <string.h>
+
+#include "app_util.h"
+#include "crc16.h"
+#include "estc_service.h"
+#include "test.h"
+
+int app_main(void);
+
+#define TEST_HVN_QUEUE_SIZE 8       /**< APP_HVN_TX_QUEUE_SIZE of the application. */
+
+/**@brief Function for checking the benchmark packets in the received log.
+ *
+ * @return Data bytes received, all packets in sequence with valid pattern and CRC.
+ */
+static uint32_t bench_packets_check(uint16_t conn_handle, uint16_t handle)
+{
+    uint16_t seq   = 0;
+    uint32_t bytes = 0;
+
+    for (uint32_t i = 0; i < sim_rx_count(); i++)
+    {
+        sim_rx_t const *rx = sim_rx_get(i);
+        if (rx->conn_handle != conn_handle || rx->handle != handle)
+        {
+            continue;
+        }
+
+        CHECK(rx->len > ESTC_BENCH_SEQ_LEN + ESTC_BENCH_CRC_LEN);
+        uint16_t data_len = rx->len - ESTC_BENCH_SEQ_LEN - ESTC_BENCH_CRC_LEN;
+
+        CHECK_EQ(uint16_decode(rx->data), seq);
+        CHECK_EQ(uint16_decode(&rx->data[rx->len - ESTC_BENCH_CRC_LEN]),
+                 crc16_compute(rx->data, rx->len - ESTC_BENCH_CRC_LEN, NULL));
+        for (uint16_t j = 0; j < data_len; j++)
+        {
+            CHECK_EQ(rx->data[ESTC_BENCH_SEQ_LEN + j], (uint8_t)(seq + j));
+        }
+
+        seq++;
+        bytes += data_len;
+    }
+
+    return bytes;
+}
+
+/**@brief The sender refills the SoftDevice queue from the completions of every connection event,
+ *        so the queue is full before each event until the last packets, and the data arrives
+ *        complete and in order.
+ */
+static void test_bench_keeps_queue_saturated(void)
+{
+    sim_app_start(app_main);
+    uint16_t data   = sim_char_find(ESTC_CHAR_BENCH_DATA_UUID_16);
+    uint16_t report = sim_char_find(ESTC_CHAR_BENCH_REPORT_UUID_16);
+
+    uint16_t conn_handle = sim_connect(NULL);
+    CHECK_EQ(sim_subscribe(conn_handle, data, BLE_GATT_HVX_NOTIFICATION), BLE_GATT_STATUS_SUCCESS);
+    CHECK_EQ(sim_subscribe(conn_handle, report, BLE_GATT_HVX_NOTIFICATION), BLE_GATT_STATUS_SUCCESS);
+
+    uint16_t payload = sim_conn_att_mtu(conn_handle) - ESTC_TX_ATT_HEADER_LEN
+                     - ESTC_BENCH_SEQ_LEN - ESTC_BENCH_CRC_LEN;
+    uint32_t packets = 100;
+    uint32_t bytes   = packets * payload - payload / 2;
+    uint8_t  request[sizeof(uint32_t)];
+    (void)uint32_encode(bytes, request);
+    CHECK_EQ(sim_write(conn_handle, report, BLE_GATTS_OP_WRITE_REQ, request, sizeof(request)), BLE_GATT_STATUS_SUCCESS);
+
+    uint32_t sent  = 0;
+    uint32_t events = 0;
+    while (sent < packets)
+    {
+        CHECK_EQ(sim_conn_hvn_queued(conn_handle), MIN(TEST_HVN_QUEUE_SIZE, packets - sent));
+        sent += sim_conn_event(conn_handle);
+        CHECK(++events < packets);
+    }
+    sim_conn_event(conn_handle);
+
+    CHECK_EQ(bench_packets_check(conn_handle, data), bytes);
+    CHECK_EQ(sim_calls_failed("sd_ble_gatts_hvx"), 0);
+
+    // The report follows the last packet
+    sim_rx_t const *last = sim_rx_get(sim_rx_count() - 1);
+    CHECK_EQ(last->handle, report);
+    CHECK_EQ(last->len, ESTC_BENCH_REPORT_LEN);
+    CHECK_EQ(uint32_decode(&last->data[0]), bytes);
+    CHECK_EQ(uint32_decode(&last->data[4]), packets);
+}
+
+/**@brief Characteristic 3 sample packets arrive in sequence, none lost while the central keeps up.
+ */
+static void test_samples_in_order(void)
+{
+    sim_app_start(app_main);
+    uint16_t char3 = sim_char_find(ESTC_CHAR_3_UUID_16);
+
+    uint16_t conn_handle = sim_connect(NULL);
+    CHECK_EQ(sim_subscribe(conn_handle, char3, BLE_GATT_HVX_NOTIFICATION), BLE_GATT_STATUS_SUCCESS);
+    sim_time_advance_ms(10000);
+
+    uint32_t received = 0;
+    uint8_t  seq      = 0;
+    for (uint32_t i = 0; i < sim_rx_count(); i++)
+    {
+        sim_rx_t const *rx = sim_rx_get(i);
+        if (rx->handle != char3)
+        {
+            continue;
+        }
+        if (received > 0)
+        {
+            CHECK_EQ(rx->data[0], (uint8_t)(seq + 1));
+        }
+        seq = rx->data[0];
+        received++;
+    }
+    CHECK(received > 10);
+}
+
+static uint16_t m_report_handle;
+
+static bool bench_report_received(void)
+{
+    return sim_rx_count() > 0 && sim_rx_get(sim_rx_count() - 1)->handle == m_report_handle;
+}
+
+/**@brief Samples that the link carries easily keep the link on 1M PHY, a benchmark that keeps the
+ *        notification queue full moves it to 2M PHY.
+ */
+static void test_saturated_queue_selects_2m_phy(void)
+{
+    sim_app_start(app_main);
+    uint16_t char3  = sim_char_find(ESTC_CHAR_3_UUID_16);
+    uint16_t data   = sim_char_find(ESTC_CHAR_BENCH_DATA_UUID_16);
+    m_report_handle = sim_char_find(ESTC_CHAR_BENCH_REPORT_UUID_16);
+
+    uint16_t conn_handle = sim_connect(NULL);
+    CHECK_EQ(sim_subscribe(conn_handle, char3, BLE_GATT_HVX_NOTIFICATION), BLE_GATT_STATUS_SUCCESS);
+    sim_time_advance_ms(3000);
+    CHECK_EQ(sim_conn_phy(conn_handle), BLE_GAP_PHY_1MBPS);
+
+    CHECK_EQ(sim_subscribe(conn_handle, data, BLE_GATT_HVX_NOTIFICATION), BLE_GATT_STATUS_SUCCESS);
+    CHECK_EQ(sim_subscribe(conn_handle, m_report_handle, BLE_GATT_HVX_NOTIFICATION), BLE_GATT_STATUS_SUCCESS);
+
+    uint8_t request[sizeof(uint32_t)];
+    (void)uint32_encode(20000, request);
+    CHECK_EQ(sim_write(conn_handle, m_report_handle, BLE_GATTS_OP_WRITE_REQ, request, sizeof(request)),
+             BLE_GATT_STATUS_SUCCESS);
+    CHECK(sim_run_until(bench_report_received, 30ULL * 1000000000ULL));
+    CHECK_EQ(sim_conn_phy(conn_handle), BLE_GAP_PHY_2MBPS);
+    CHECK_EQ(sim_calls_failed("sd_ble_gap_phy_update"), 0);
+}
+
+int main(void)
+{
+    int test_failures = 0;
+
+    RUN_TEST(test_bench_keeps_queue_saturated);
+    RUN_TEST(test_samples_in_order);
+    RUN_TEST(test_saturated_queue_selects_2m_phy);
+
+    return test_failures ? 1 : 0;
+}
@@ -0,0 +1,247 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#include "ble_hci.h"
+#include "estc_service.h"
+#include "nrf_sdh_ble.h"
+#include "test.h"
+
+int app_main(void);
+
+#define TEST_CENTRALS       NRF_SDH_BLE_PERIPHERAL_LINK_COUNT
+#define TEST_HVN_QUEUE_SIZE 8       /**< APP_HVN_TX_QUEUE_SIZE of the application. */
+#define TEST_FANOUT_QUEUE   4       /**< ESTC_FANOUT_QUEUE_LEN of the service. */
+#define TEST_SAMPLE_LEN     20      /**< Samples every link takes in one notification. */
+#define TEST_SAMPLE_MS      2       /**< Period of the samples, faster than the slow central drains them. */
+#define TEST_SAMPLES        1000
+
+/* Defined by the linker, the observers the application registered */
+extern nrf_sdh_ble_evt_observer_t __start_sdh_ble_observers[] __attribute__((weak));
+extern nrf_sdh_ble_evt_observer_t __stop_sdh_ble_observers[] __attribute__((weak));
+
+/**@brief Function for finding the ESTC service instance of the application through its observer. */
+static ble_estc_service_t * service_get(void)
+{
+    for (nrf_sdh_ble_evt_observer_t *p_obs = __start_sdh_ble_observers; p_obs < __stop_sdh_ble_observers; p_obs++)
+    {
+        if (estc_ble_service_on_ble_event == p_obs->handler)
+        {
+            return (ble_estc_service_t *)p_obs->p_context;
+        }
+    }
+
+    CHECK(false);
+    return NULL;
+}
+
+static uint32_t rx_count(uint16_t conn_handle, uint16_t handle)
+{
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < sim_rx_count(); i++)
+    {
+        if (sim_rx_get(i)->conn_handle == conn_handle && sim_rx_get(i)->handle == handle)
+        {
+            count++;
+        }
+    }
+    return count;
+}
+
+static void probes_write(uint16_t conn_handle, uint16_t echo, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint8_t probe = (uint8_t)i;
+        CHECK_EQ(sim_write(conn_handle, echo, BLE_GATTS_OP_WRITE_CMD, &probe, 1), BLE_GATT_STATUS_SUCCESS);
+    }
+}
+
+/**@brief Echo probes and characteristic 3 samples share the queue of each link, the credits
+ *        never let a sender call into the SoftDevice with the queue full and all come back.
+ */
+static void test_credits_shared_by_senders(void)
+{
+    uint16_t conn_handles[TEST_CENTRALS];
+
+    sim_app_start(app_main);
+    uint16_t char3 = sim_char_find(ESTC_CHAR_3_UUID_16);
+    uint16_t echo  = sim_char_find(ESTC_CHAR_ECHO_UUID_16);
+
+    for (uint32_t i = 0; i < TEST_CENTRALS; i++)
+    {
+        conn_handles[i] = sim_connect(NULL);
+        CHECK(conn_handles[i] != BLE_CONN_HANDLE_INVALID);
+        CHECK_EQ(sim_subscribe(conn_handles[i], char3, BLE_GATT_HVX_NOTIFICATION), BLE_GATT_STATUS_SUCCESS);
+        CHECK_EQ(sim_subscribe(conn_handles[i], echo, BLE_GATT_HVX_NOTIFICATION), BLE_GATT_STATUS_SUCCESS);
+    }
+
+    // More probes than queue slots, the rest are dropped without a SoftDevice call
+    for (uint32_t i = 0; i < TEST_CENTRALS; i++)
+    {
+        probes_write(conn_handles[i], echo, TEST_HVN_QUEUE_SIZE + 4);
+        CHECK_EQ(sim_conn_hvn_queued(conn_handles[i]), TEST_HVN_QUEUE_SIZE);
+    }
+    CHECK_EQ(sim_calls_failed("sd_ble_gatts_hvx"), 0);
+
+    // Samples wait for credits and follow the probes out
+    sim_time_advance_ms(3000);
+
+    uint32_t samples = rx_count(conn_handles[0], char3);
+    CHECK(samples > 0);
+    for (uint32_t i = 0; i < TEST_CENTRALS; i++)
+    {
+        CHECK_EQ(rx_count(conn_handles[i], echo), TEST_HVN_QUEUE_SIZE);
+        CHECK_EQ(rx_count(conn_handles[i], char3), samples);
+        CHECK_EQ(sim_conn_hvn_queued(conn_handles[i]), 0);
+    }
+    CHECK_EQ(sim_calls_failed("sd_ble_gatts_hvx"), 0);
+
+    // Every credit came back
+    sim_rx_clear();
+    for (uint32_t i = 0; i < TEST_CENTRALS; i++)
+    {
+        probes_write(conn_handles[i], echo, TEST_HVN_QUEUE_SIZE);
+        CHECK_EQ(sim_conn_hvn_queued(conn_handles[i]), TEST_HVN_QUEUE_SIZE);
+
+        // The samples keep the links on a short interval, which may take more than one event
+        for (uint32_t events = 0; sim_conn_hvn_queued(conn_handles[i]) > 0; events++)
+        {
+            CHECK(events < TEST_HVN_QUEUE_SIZE);
+            sim_conn_event(conn_handles[i]);
+        }
+        CHECK_EQ(rx_count(conn_handles[i], echo), TEST_HVN_QUEUE_SIZE);
+    }
+    CHECK_EQ(sim_calls_failed("sd_ble_gatts_hvx"), 0);
+}
+
+/**@brief Credits of a link are reset on disconnect, a new central on the same connection index
+ *        starts with a full queue.
+ */
+static void test_credits_reset_on_disconnect(void)
+{
+    sim_app_start(app_main);
+    uint16_t echo = sim_char_find(ESTC_CHAR_ECHO_UUID_16);
+
+    uint16_t conn_handle = sim_connect(NULL);
+    CHECK_EQ(sim_subscribe(conn_handle, echo, BLE_GATT_HVX_NOTIFICATION), BLE_GATT_STATUS_SUCCESS);
+    probes_write(conn_handle, echo, TEST_HVN_QUEUE_SIZE);
+    sim_disconnect(conn_handle, BLE_HCI_REMOTE_USER_TERMINATED_CONNECTION);
+
+    conn_handle = sim_connect(NULL);
+    CHECK_EQ(sim_subscribe(conn_handle, echo, BLE_GATT_HVX_NOTIFICATION), BLE_GATT_STATUS_SUCCESS);
+    sim_rx_clear();
+    probes_write(conn_handle, echo, TEST_HVN_QUEUE_SIZE);
+    CHECK_EQ(sim_conn_hvn_queued(conn_handle), TEST_HVN_QUEUE_SIZE);
+    sim_conn_event(conn_handle);
+    CHECK_EQ(rx_count(conn_handle, echo), TEST_HVN_QUEUE_SIZE);
+    CHECK_EQ(sim_calls_failed("sd_ble_gatts_hvx"), 0);
+}
+
+/**@brief Function for connecting a central that keeps the connection interval it starts with.
+ */
+static uint16_t central_connect(uint16_t conn_interval)
+{
+    sim_central_t central;
+
+    sim_central_default(&central);
+    central.accept_conn_params            = false;
+    central.conn_params.min_conn_interval = conn_interval;
+    central.conn_params.max_conn_interval = conn_interval;
+    return sim_connect(&central);
+}
+
+/**@brief A central on a long connection interval loses samples, the centrals on a short one
+ *        still get every sample: the slow link never holds back the others.
+ */
+static void test_fanout_slow_central_does_not_starve_fast(void)
+{
+    uint16_t conn_handles[TEST_CENTRALS];
+    estc_fanout_stats_t stats[TEST_CENTRALS];
+    uint8_t sample[TEST_SAMPLE_LEN] = {0};
+
+    sim_app_start(app_main);
+    ble_estc_service_t *service = service_get();
+    uint16_t char3 = sim_char_find(ESTC_CHAR_3_UUID_16);
+
+    // The last central is the slow one
+    for (uint32_t i = 0; i < TEST_CENTRALS; i++)
+    {
+        uint16_t interval = (i < TEST_CENTRALS - 1) ? MSEC_TO_UNITS(7.5, UNIT_1_25_MS) : MSEC_TO_UNITS(100, UNIT_1_25_MS);
+        conn_handles[i] = central_connect(interval);
+        CHECK(conn_handles[i] != BLE_CONN_HANDLE_INVALID);
+        CHECK_EQ(sim_subscribe(conn_handles[i], char3, BLE_GATT_HVX_NOTIFICATION), BLE_GATT_STATUS_SUCCESS);
+    }
+
+    for (uint32_t i = 0; i < TEST_SAMPLES; i++)
+    {
+        sample[0] = (uint8_t)i;
+        CHECK_EQ(estc_ble_service_sample_publish(service, sample, sizeof(sample)), NRF_SUCCESS);
+        sim_time_advance_ms(TEST_SAMPLE_MS);
+    }
+
+    // Let every queue drain
+    sim_time_advance_ms(1000);
+
+    for (uint32_t i = 0; i < TEST_CENTRALS; i++)
+    {
+        CHECK_EQ(estc_ble_service_sample_stats_get(service, conn_handles[i], &stats[i]), NRF_SUCCESS);
+        printf("       link %u, %s: %u samples delivered, %u dropped\n", (unsigned)i,
+               (i < TEST_CENTRALS - 1) ? "7.5 ms" : "100 ms", (unsigned)stats[i].delivered, (unsigned)stats[i].dropped);
+
+        // Every sample reached the central or was counted as dropped
+        CHECK_EQ(stats[i].delivered, rx_count(conn_handles[i], char3));
+        CHECK_EQ(stats[i].delivered + stats[i].dropped, stats[0].delivered + stats[0].dropped);
+        CHECK(stats[i].delivered + stats[i].dropped >= TEST_SAMPLES);
+    }
+
+    // The fast links lose nothing, the slow one loses most, a queue full at a time
+    uint32_t slow = TEST_CENTRALS - 1;
+    for (uint32_t i = 0; i < slow; i++)
+    {
+        CHECK_EQ(stats[i].dropped, 0);
+        CHECK_EQ(stats[i].delivered, stats[0].delivered);
+    }
+    CHECK(stats[slow].dropped > stats[slow].delivered);
+    CHECK(stats[slow].delivered >= (TEST_SAMPLES * TEST_SAMPLE_MS / 100) * TEST_FANOUT_QUEUE / 2);
+    CHECK_EQ(sim_calls_failed("sd_ble_gatts_hvx"), 0);
+
+    CHECK_EQ(estc_ble_service_sample_stats_get(service, BLE_CONN_HANDLE_INVALID, &stats[0]), NRF_ERROR_NOT_FOUND);
+}
+
+int main(void)
+{
+    int test_failures = 0;
+
+    RUN_TEST(test_credits_shared_by_senders);
+    RUN_TEST(test_credits_reset_on_disconnect);
+    RUN_TEST(test_fanout_slow_central_does_not_starve_fast);
+
+    return test_failures ? 1 : 0;
+}
@@ -0,0 +1,159 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#include <time.h>
+
+#include "app_timer.h"
+#include "ble_hci.h"
+#include "test.h"
+
+#define APP_ADV_DURATION_MS             180000  /**< APP_ADV_DURATION of the application. */
+#define FIRST_CONN_PARAMS_UPDATE_MS     5000    /**< FIRST_CONN_PARAMS_UPDATE_DELAY of the application. */
+#define NEXT_CONN_PARAMS_UPDATE_MS      30000   /**< NEXT_CONN_PARAMS_UPDATE_DELAY of the application. */
+#define MAX_CONN_PARAMS_UPDATE_COUNT    3       /**< MAX_CONN_PARAMS_UPDATE_COUNT of the application. */
+#define TICKS_TOLERANCE                 4       /**< Timers start on the tick grid, each restart may add one. */
+
+int app_main(void);
+
+static uint16_t m_conn_handle;
+
+static bool disconnected(void)
+{
+    return !sim_connected(m_conn_handle);
+}
+
+static uint64_t ms_to_ticks(uint64_t ms)
+{
+    return APP_TIMER_TICKS(ms);
+}
+
+static void test_adv_timeout_enters_system_off(void)
+{
+    sim_app_start(app_main);
+
+    sim_time_advance_ms(APP_ADV_DURATION_MS - 1);
+    CHECK(sim_advertising());
+    CHECK(!sim_system_off());
+
+    CHECK(sim_run_until(sim_system_off, 10000000000ULL));
+    CHECK_EQ(sim_now_ticks(), ms_to_ticks(APP_ADV_DURATION_MS));
+    CHECK_EQ(sim_bsp_indication(), BSP_INDICATE_IDLE);
+    printf("       advertising timed out, System OFF after %llu ticks\n", (unsigned long long)sim_now_ticks());
+}
+
+static void test_conn_params_rejected_disconnects(void)
+{
+    sim_central_t central;
+
+    sim_app_start(app_main);
+    sim_central_default(&central);
+    central.accept_conn_params = false;
+    m_conn_handle = sim_connect(&central);
+
+    CHECK(sim_run_until(disconnected, 300000000000ULL));
+
+    // Every request is answered at its instant, each retry waits from the answer
+    uint64_t instant_ms  = SIM_LL_INSTANT_EVENTS * central.conn_params.max_conn_interval * 5 / 4;
+    uint64_t expected_ms = FIRST_CONN_PARAMS_UPDATE_MS +
+                           (MAX_CONN_PARAMS_UPDATE_COUNT - 1) * NEXT_CONN_PARAMS_UPDATE_MS +
+                           MAX_CONN_PARAMS_UPDATE_COUNT * instant_ms + NEXT_CONN_PARAMS_UPDATE_MS;
+
+    CHECK(sim_now_ticks() >= ms_to_ticks(expected_ms));
+    CHECK(sim_now_ticks() <= ms_to_ticks(expected_ms) + TICKS_TOLERANCE);
+    CHECK_EQ(sim_calls("sd_ble_gap_conn_param_update"), MAX_CONN_PARAMS_UPDATE_COUNT);
+    CHECK_EQ(sim_calls("sd_ble_gap_disconnect"), 1);
+    printf("       parameters rejected, disconnected after %llu ticks\n", (unsigned long long)sim_now_ticks());
+
+    sim_process();
+    CHECK(sim_advertising());
+}
+
+static void test_conn_params_accepted(void)
+{
+    sim_app_start(app_main);
+    m_conn_handle = sim_connect(NULL);
+
+    sim_time_advance_ms(FIRST_CONN_PARAMS_UPDATE_MS + 1000);
+    CHECK_EQ(sim_calls("sd_ble_gap_conn_param_update"), 1);
+    CHECK_EQ(sim_conn_params(m_conn_handle).max_conn_interval, MSEC_TO_UNITS(100, UNIT_1_25_MS));
+
+    sim_time_advance_ms(10 * NEXT_CONN_PARAMS_UPDATE_MS);
+    CHECK(sim_connected(m_conn_handle));
+    CHECK_EQ(sim_calls("sd_ble_gap_conn_param_update"), 1);
+}
+
+static void test_hours_of_reconnect_cycles(void)
+{
+    struct timespec start;
+    struct timespec end;
+    uint32_t        cycles = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    sim_app_start(app_main);
+
+    // A central comes by every few minutes for 12 hours
+    while (sim_now_ns() < 12ULL * 3600 * 1000000000ULL)
+    {
+        sim_time_advance_ms(60000 + (cycles % 7) * 10000);
+        CHECK(sim_advertising());
+
+        m_conn_handle = sim_connect(NULL);
+        CHECK(m_conn_handle != BLE_CONN_HANDLE_INVALID);
+        sim_time_advance_ms(5 * 60000);
+        CHECK(sim_connected(m_conn_handle));
+
+        sim_disconnect(m_conn_handle, BLE_HCI_REMOTE_USER_TERMINATED_CONNECTION);
+        cycles++;
+    }
+
+    // Then nobody does, so the device goes to sleep
+    CHECK(sim_run_until(sim_system_off, 2ULL * APP_ADV_DURATION_MS * 1000000ULL));
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    uint64_t wall_us = (end.tv_sec - start.tv_sec) * 1000000ULL + (end.tv_nsec - start.tv_nsec) / 1000;
+
+    CHECK_EQ(sim_calls("sd_ble_gap_conn_param_update"), cycles);
+    CHECK_EQ(sim_calls_failed("sd_ble_gap_adv_start"), 0);
+    CHECK(wall_us < 1000000);
+    printf("       %u reconnect cycles, System OFF after %llu ticks, %llu us of wall time\n",
+           (unsigned)cycles, (unsigned long long)sim_now_ticks(), (unsigned long long)wall_us);
+}
+
+int main(void)
+{
+    int test_failures = 0;
+
+    RUN_TEST(test_adv_timeout_enters_system_off);
+    RUN_TEST(test_conn_params_rejected_disconnects);
+    RUN_TEST(test_conn_params_accepted);
+    RUN_TEST(test_hours_of_reconnect_cycles);
+
+    return test_failures ? 1 : 0;
+}
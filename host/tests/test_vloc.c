@@ -0,0 +1,158 @@
+/**
+ * Copyright 2022 Evgeniy Morozov
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE
+*/
+
+#include <string.h>
+
+#include "ble_hci.h"
+#include "estc_service.h"
+#include "nrf_sdh_ble.h"
+#include "test.h"
+
+int app_main(void);
+
+/* Defined by the linker, the observers the application registered */
+extern nrf_sdh_ble_evt_observer_t __start_sdh_ble_observers[] __attribute__((weak));
+extern nrf_sdh_ble_evt_observer_t __stop_sdh_ble_observers[] __attribute__((weak));
+
+/**@brief Function for finding the ESTC service instance of the application through its observer. */
+static ble_estc_service_t * service_get(void)
+{
+    for (nrf_sdh_ble_evt_observer_t *p_obs = __start_sdh_ble_observers; p_obs < __stop_sdh_ble_observers; p_obs++)
+    {
+        if (estc_ble_service_on_ble_event == p_obs->handler)
+        {
+            return (ble_estc_service_t *)p_obs->p_context;
+        }
+    }
+
+    CHECK(false);
+    return NULL;
+}
+
+/**@brief A read arriving between value_begin and value_commit waits for the commit and sees
+ *        the new value only, on every link that asked.
+ */
+static void test_read_waits_for_commit(void)
+{
+    sim_app_start(app_main);
+
+    ble_estc_service_t *service = service_get();
+    uint16_t conn_a = sim_connect(NULL);
+    uint16_t conn_b = sim_connect(NULL);
+    uint16_t char1  = sim_char_find(ESTC_CHAR_1_UUID_16);
+    uint8_t  value[NRF_SDH_BLE_GATT_MAX_MTU_SIZE];
+    uint16_t len;
+
+    uint8_t *buffer = estc_ble_service_value_begin(service, char1);
+    CHECK(NULL != buffer);
+    memcpy(buffer, "Ne", 2);
+
+    // Half of the new value is in the buffer the SoftDevice reads from
+    len = sizeof(value);
+    CHECK(!sim_read(conn_a, char1, value, &len));
+    len = sizeof(value);
+    CHECK(!sim_read(conn_b, char1, value, &len));
+
+    memcpy(&buffer[2], "w value", 7);
+    CHECK_EQ(estc_ble_service_value_commit(service, char1, 9), NRF_SUCCESS);
+
+    len = sizeof(value);
+    CHECK(sim_read_result(conn_a, value, &len));
+    CHECK_EQ(len, 9);
+    CHECK(0 == memcmp(value, "New value", 9));
+    len = sizeof(value);
+    CHECK(sim_read_result(conn_b, value, &len));
+    CHECK_EQ(len, 9);
+    CHECK(0 == memcmp(value, "New value", 9));
+
+    // The commit only updated the length, the value already was in place
+    CHECK_EQ(sim_attr_value(char1, value, sizeof(value)), 9);
+    CHECK(0 == memcmp(value, "New value", 9));
+
+    // Outside of a write, the read is authorized right away
+    len = sizeof(value);
+    CHECK(sim_read(conn_a, char1, value, &len));
+    CHECK_EQ(len, 9);
+}
+
+/**@brief A read deferred on a link that disconnects is not answered on the commit.
+ */
+static void test_deferred_read_dropped_on_disconnect(void)
+{
+    sim_app_start(app_main);
+
+    ble_estc_service_t *service = service_get();
+    uint16_t conn_handle = sim_connect(NULL);
+    uint16_t char1       = sim_char_find(ESTC_CHAR_1_UUID_16);
+    uint8_t  value[NRF_SDH_BLE_GATT_MAX_MTU_SIZE];
+    uint16_t len         = sizeof(value);
+
+    uint8_t *buffer = estc_ble_service_value_begin(service, char1);
+    CHECK(!sim_read(conn_handle, char1, value, &len));
+    sim_disconnect(conn_handle, BLE_HCI_REMOTE_USER_TERMINATED_CONNECTION);
+
+    uint32_t replies = sim_calls("sd_ble_gatts_rw_authorize_reply");
+    memcpy(buffer, "Gone", 4);
+    CHECK_EQ(estc_ble_service_value_commit(service, char1, 4), NRF_SUCCESS);
+    CHECK_EQ(sim_calls("sd_ble_gatts_rw_authorize_reply"), replies);
+}
+
+/**@brief Only the characteristics written in two phases authorize their reads.
+ */
+static void test_other_reads_not_authorized(void)
+{
+    sim_app_start(app_main);
+
+    ble_estc_service_t *service = service_get();
+    uint16_t conn_handle = sim_connect(NULL);
+    uint16_t char2       = sim_char_find(ESTC_CHAR_2_UUID_16);
+    uint8_t  value[NRF_SDH_BLE_GATT_MAX_MTU_SIZE];
+    uint16_t len         = sizeof(value);
+
+    uint32_t replies = sim_calls("sd_ble_gatts_rw_authorize_reply");
+    CHECK(sim_read(conn_handle, char2, value, &len));
+    CHECK_EQ(len, 1);
+    CHECK_EQ(value[0], 'X');
+    CHECK_EQ(sim_calls("sd_ble_gatts_rw_authorize_reply"), replies);
+
+    CHECK(NULL == estc_ble_service_value_begin(service, char2));
+    CHECK_EQ(estc_ble_service_value_commit(service, char2, 1), NRF_ERROR_INVALID_PARAM);
+}
+
+int main(void)
+{
+    int test_failures = 0;
+
+    RUN_TEST(test_read_waits_for_commit);
+    RUN_TEST(test_deferred_read_dropped_on_disconnect);
+    RUN_TEST(test_other_reads_not_authorized);
+
+    return test_failures ? 1 : 0;
+}